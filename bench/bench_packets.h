@@ -0,0 +1,74 @@
+#ifndef BENCH_PACKETS_H
+#define BENCH_PACKETS_H
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+/**
+ * @brief Synthetic IP traffic for the benchmarks
+ *
+ * Packets have valid IPv4 / IPv6 headers and TCP or UDP ports; payload
+ * bytes are random. Checksums are left zero, nothing here verifies them.
+ */
+namespace BenchPackets {
+
+    inline void writeU16(uint8_t* p, uint16_t value) {
+        p[0] = static_cast<uint8_t>(value >> 8);
+        p[1] = static_cast<uint8_t>(value & 0xFF);
+    }
+
+    inline void writeU32(uint8_t* p, uint32_t value) {
+        writeU16(p, static_cast<uint16_t>(value >> 16));
+        writeU16(p + 2, static_cast<uint16_t>(value & 0xFFFF));
+    }
+
+    /**
+     * @param srcIP Source address (Host Byte Order)
+     * @param dstIP Destination address (Host Byte Order)
+     * @param protocol 6 (TCP) or 17 (UDP)
+     */
+    inline std::vector<uint8_t> ipv4(uint32_t srcIP, uint32_t dstIP, uint8_t protocol, uint16_t srcPort,
+                                     uint16_t dstPort, size_t length, std::mt19937& rng) {
+        std::vector<uint8_t> packet(length);
+        for (auto& b : packet) b = static_cast<uint8_t>(rng());
+        packet[0] = 0x45;
+        packet[1] = 0;
+        writeU16(&packet[2], static_cast<uint16_t>(length));
+        writeU16(&packet[6], 0x4000);
+        packet[8] = 64;
+        packet[9] = protocol;
+        writeU32(&packet[12], srcIP);
+        writeU32(&packet[16], dstIP);
+        writeU16(&packet[20], srcPort);
+        writeU16(&packet[22], dstPort);
+        if (protocol == 6) packet[32] = 0x50;
+        return packet;
+    }
+
+    /**
+     * @param host Last 32 bits of the fd00::/64 source and destination addresses
+     */
+    inline std::vector<uint8_t> ipv6(uint32_t srcHost, uint32_t dstHost, uint8_t protocol, uint16_t srcPort,
+                                     uint16_t dstPort, size_t length, std::mt19937& rng) {
+        std::vector<uint8_t> packet(length);
+        for (auto& b : packet) b = static_cast<uint8_t>(rng());
+        packet[0] = 0x60;
+        packet[1] = packet[2] = packet[3] = 0;
+        writeU16(&packet[4], static_cast<uint16_t>(length - 40));
+        packet[6] = protocol;
+        packet[7] = 64;
+        memset(&packet[8], 0, 32);
+        packet[8] = packet[24] = 0xFD;
+        writeU32(&packet[20], srcHost);
+        writeU32(&packet[36], dstHost);
+        writeU16(&packet[40], srcPort);
+        writeU16(&packet[42], dstPort);
+        if (protocol == 6) packet[52] = 0x50;
+        return packet;
+    }
+
+} // namespace BenchPackets
+
+#endif // BENCH_PACKETS_H
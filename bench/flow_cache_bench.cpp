@@ -0,0 +1,119 @@
+// Cost of the forwarding decision on the TUN read path, with and without the
+// flow cache. The uncached variant repeats what the bridge does on a miss for
+// an IPv4 packet: routing table lookup under the routing mutex and the
+// broadcast checks (the FakeIP fallback is a Steam call and is left out).
+
+#include "bench_packets.h"
+#include "vpn/flow_cache.h"
+#include "vpn/packet_classifier.h"
+
+#include <benchmark/benchmark.h>
+#include <map>
+#include <mutex>
+
+namespace {
+
+    constexpr uint32_t LOCAL_IP = 0x0A000001;       // 10.0.0.1
+    constexpr uint32_t PEER_BASE = 0x0A000100;      // 10.0.1.0
+    constexpr int ROOM_PEERS = 250;
+
+    struct Traffic {
+        std::vector<std::vector<uint8_t>> packets;
+        std::vector<PacketMeta> meta;
+        std::map<uint32_t, uint64_t> routes;
+        std::mutex routesMutex;
+
+        explicit Traffic(int flows) {
+            std::mt19937 rng(flows);
+            for (int i = 0; i < ROOM_PEERS; ++i) {
+                routes[PEER_BASE + i] = 76561198000000000ULL + i;
+            }
+            for (int i = 0; i < flows; ++i) {
+                packets.push_back(BenchPackets::ipv4(LOCAL_IP, PEER_BASE + i % ROOM_PEERS, 17,
+                                                     static_cast<uint16_t>(20000 + i), 443, 1200, rng));
+            }
+            meta.resize(packets.size());
+            for (size_t i = 0; i < packets.size(); ++i) {
+                PacketClassifier::classify(packets[i].data(), packets[i].size(), meta[i]);
+            }
+        }
+
+        uint8_t resolve(const PacketMeta& m, uint64_t& peer) {
+            {
+                std::lock_guard<std::mutex> lock(routesMutex);
+                auto it = routes.find(m.dstIP);
+                if (it != routes.end()) {
+                    peer = it->second;
+                    return FlowCache::FLOW_UNICAST;
+                }
+            }
+            if (m.dstIP == 0xFFFFFFFF || m.dstIP == 0xA9FEFFFF) return FlowCache::FLOW_BROADCAST;
+            return FlowCache::FLOW_DROP;
+        }
+    };
+
+    void BM_ResolveUncached(benchmark::State& state) {
+        Traffic traffic(static_cast<int>(state.range(0)));
+        size_t i = 0;
+        for (auto _ : state) {
+            uint64_t peer = 0;
+            benchmark::DoNotOptimize(traffic.resolve(traffic.meta[i], peer));
+            benchmark::DoNotOptimize(peer);
+            if (++i == traffic.meta.size()) i = 0;
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_FlowCacheLookup(benchmark::State& state) {
+        Traffic traffic(static_cast<int>(state.range(0)));
+        FlowCache cache;
+        const uint32_t generation = 1;
+        size_t i = 0;
+        for (auto _ : state) {
+            FlowKey key;
+            FlowCache::buildKey(traffic.meta[i], traffic.packets[i].data(), key);
+            FlowCache::Entry* flow = cache.lookup(key, generation);
+            if (!flow) {
+                uint64_t peer = 0;
+                uint8_t flags = traffic.resolve(traffic.meta[i], peer);
+                flow = cache.insert(key, generation, peer, traffic.meta[i].dscp, flags);
+            }
+            benchmark::DoNotOptimize(flow);
+            if (++i == traffic.meta.size()) i = 0;
+        }
+        state.SetItemsProcessed(state.iterations());
+        state.counters["hit_rate"] = static_cast<double>(cache.hits()) /
+                                     static_cast<double>(cache.hits() + cache.misses());
+    }
+
+    // Route changes every `range(1)` packets invalidate every cached flow
+    void BM_FlowCacheChurn(benchmark::State& state) {
+        Traffic traffic(static_cast<int>(state.range(0)));
+        FlowCache cache;
+        const int64_t bumpEvery = state.range(1);
+        uint32_t generation = 1;
+        int64_t sent = 0;
+        size_t i = 0;
+        for (auto _ : state) {
+            if (++sent % bumpEvery == 0) generation++;
+            FlowKey key;
+            FlowCache::buildKey(traffic.meta[i], traffic.packets[i].data(), key);
+            FlowCache::Entry* flow = cache.lookup(key, generation);
+            if (!flow) {
+                uint64_t peer = 0;
+                uint8_t flags = traffic.resolve(traffic.meta[i], peer);
+                flow = cache.insert(key, generation, peer, traffic.meta[i].dscp, flags);
+            }
+            benchmark::DoNotOptimize(flow);
+            if (++i == traffic.meta.size()) i = 0;
+        }
+        state.SetItemsProcessed(state.iterations());
+        state.counters["hit_rate"] = static_cast<double>(cache.hits()) /
+                                     static_cast<double>(cache.hits() + cache.misses());
+    }
+
+} // anonymous namespace
+
+BENCHMARK(BM_ResolveUncached)->Arg(16)->Arg(1024)->Arg(16384);
+BENCHMARK(BM_FlowCacheLookup)->Arg(16)->Arg(1024)->Arg(16384);
+BENCHMARK(BM_FlowCacheChurn)->Args({1024, 1000})->Args({1024, 100000});
@@ -0,0 +1,82 @@
+// Prometheus rendering of a core snapshot for lobbies up to the Steam limit of
+// 250 members, with and without the per-stage latency histograms. Scrapes only
+// render when the snapshot changed, so this is the cost paid once per
+// snapshot interval on the event loop.
+
+#include "core/metrics_exporter.h"
+#include "core/connect_tool_core.h"
+
+#include <benchmark/benchmark.h>
+#include <random>
+
+namespace {
+
+    constexpr uint64_t STEAM_ID_BASE = 76561198000000000ULL;
+
+    CoreSnapshot makeSnapshot(size_t peerCount) {
+        std::mt19937_64 rng(peerCount);
+        CoreSnapshot snapshot;
+        snapshot.inLobby = true;
+        snapshot.vpnEnabled = true;
+        snapshot.directUdpEnabled = true;
+        snapshot.vpnStats.packetsSent = rng();
+        snapshot.vpnStats.bytesSent = rng();
+        snapshot.receivePoll.batchSize = 64;
+
+        for (size_t i = 0; i < peerCount; ++i) {
+            uint64_t steamId = STEAM_ID_BASE + i;
+            CoreSnapshot::Member member;
+            member.steamId = CSteamID(steamId);
+            member.name = "Player \"" + std::to_string(i) + "\"";   // Needs escaping
+            member.connection.ping = static_cast<int>(rng() % 200);
+            snapshot.members.push_back(std::move(member));
+
+            PeerStatsTable::Snapshot peer{};
+            peer.steamId = steamId;
+            peer.txPackets = rng() % 100000000;
+            peer.txBytes = peer.txPackets * 900;
+            peer.rxPackets = rng() % 100000000;
+            peer.rxBytes = peer.rxPackets * 900;
+            for (auto& drop : peer.drops) drop = rng() % 1000;
+            peer.txBytesPerSec = static_cast<double>(rng() % 10000000);
+            peer.rxBytesPerSec = static_cast<double>(rng() % 10000000);
+            peer.link.connected = true;
+            peer.link.ping = static_cast<int>(rng() % 200);
+            peer.link.qualityLocal = 0.99f;
+            peer.link.qualityRemote = 0.98f;
+            peer.link.pendingBytes = static_cast<int>(rng() % 65536);
+            peer.link.path = PeerLinkMetrics::Path::Relayed;
+            snapshot.peers.push_back(peer);
+        }
+        return snapshot;
+    }
+
+    void BM_RenderSnapshot(benchmark::State& state) {
+        CoreSnapshot snapshot = makeSnapshot(static_cast<size_t>(state.range(0)));
+        size_t size = 0;
+        for (auto _ : state) {
+            std::string body = MetricsExporter::renderSnapshot(snapshot, nullptr, size);
+            size = body.size();
+            benchmark::DoNotOptimize(body.data());
+        }
+        state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(size));
+        state.counters["body_kb"] = static_cast<double>(size) / 1024;
+    }
+
+    void BM_RenderSnapshotWithStages(benchmark::State& state) {
+        CoreSnapshot snapshot = makeSnapshot(static_cast<size_t>(state.range(0)));
+        StageTimings::Snapshot stages{};
+        size_t size = 0;
+        for (auto _ : state) {
+            std::string body = MetricsExporter::renderSnapshot(snapshot, &stages, size);
+            size = body.size();
+            benchmark::DoNotOptimize(body.data());
+        }
+        state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(size));
+        state.counters["body_kb"] = static_cast<double>(size) / 1024;
+    }
+
+} // anonymous namespace
+
+BENCHMARK(BM_RenderSnapshot)->Arg(0)->Arg(8)->Arg(64)->Arg(250)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_RenderSnapshotWithStages)->Arg(250)->Unit(benchmark::kMicrosecond);
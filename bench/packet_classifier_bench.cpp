@@ -0,0 +1,207 @@
+// TUN read batches through PacketClassifier::classifyBatch and an AVX2
+// gather kernel. The kernel gathers four IPv4 headers at a time; IPv6 packets
+// always take the scalar path, so the mix shows how much of a batch it covers.
+// It lost to the scalar loop on the machines measured so far, so it is only
+// kept here for comparison and is not part of the data path.
+
+#include "bench_packets.h"
+#include "vpn/cpu_features.h"
+#include "vpn/packet_classifier.h"
+
+#include <benchmark/benchmark.h>
+#include <cstring>
+
+namespace {
+
+    constexpr size_t BATCH = 32;    // SteamVpnBridge TUN read batch
+
+#ifdef VPN_SIMD_X86
+
+    constexpr uint8_t IP_PROTO_TCP = 6;
+    constexpr uint8_t IP_PROTO_UDP = 17;
+
+    // 64-bit lane masks -> 32-bit lane masks
+    VPN_TARGET_AVX2
+    inline __m128i narrowMask(__m256i mask64) {
+        const __m256i pack = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+        return _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(mask64, pack));
+    }
+
+    // Four IPv4 packets per step. Lanes that are not complete IPv4 headers are
+    // left for the scalar path. Every gather is masked so nothing beyond a
+    // packet's length is read.
+    VPN_TARGET_AVX2
+    size_t classifyAvx2Block(const uint8_t* const* packets, const size_t* lengths, PacketMeta* out) {
+        const uint8_t* base = packets[0];
+        const __m256i baseVec = _mm256_set1_epi64x(reinterpret_cast<long long>(base));
+        const __m256i ptrs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(packets));
+        const __m256i lens = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lengths));
+        const __m256i offsets = _mm256_sub_epi64(ptrs, baseVec);
+        const int* gatherBase = reinterpret_cast<const int*>(base);
+
+        const __m128i zero = _mm_setzero_si128();
+        __m128i lenOk = narrowMask(_mm256_cmpgt_epi64(lens, _mm256_set1_epi64x(19)));
+
+        __m128i w0 = _mm256_mask_i64gather_epi32(zero, gatherBase, offsets, lenOk, 1);
+        __m128i version = _mm_and_si128(_mm_srli_epi32(w0, 4), _mm_set1_epi32(0x0F));
+        __m128i ihl = _mm_and_si128(w0, _mm_set1_epi32(0x0F));
+        __m128i v4 = _mm_and_si128(lenOk, _mm_cmpeq_epi32(version, _mm_set1_epi32(4)));
+        v4 = _mm_and_si128(v4, _mm_cmpgt_epi32(ihl, _mm_set1_epi32(4)));
+
+        if (_mm_movemask_ps(_mm_castsi128_ps(v4)) == 0) return 0;
+
+        __m128i w4 = _mm256_mask_i64gather_epi32(zero, gatherBase + 1, offsets, v4, 1);
+        __m128i w8 = _mm256_mask_i64gather_epi32(zero, gatherBase + 2, offsets, v4, 1);
+        __m128i src = _mm256_mask_i64gather_epi32(zero, gatherBase + 3, offsets, v4, 1);
+        __m128i dst = _mm256_mask_i64gather_epi32(zero, gatherBase + 4, offsets, v4, 1);
+
+        // Network -> host byte order
+        const __m128i bswap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        src = _mm_shuffle_epi8(src, bswap);
+        dst = _mm_shuffle_epi8(dst, bswap);
+
+        __m128i dscp = _mm_and_si128(_mm_srli_epi32(w0, 10), _mm_set1_epi32(0x3F));
+        __m128i protocol = _mm_and_si128(_mm_srli_epi32(w8, 8), _mm_set1_epi32(0xFF));
+        __m128i headerLen = _mm_slli_epi32(ihl, 2);
+
+        // Ports: TCP/UDP, first fragment, header + 4 bytes present
+        __m128i fragOffset = _mm_and_si128(_mm_srli_epi32(w4, 16), _mm_set1_epi32(0xFF1F));
+        __m128i portsOk = _mm_and_si128(v4, _mm_cmpeq_epi32(fragOffset, zero));
+        __m128i isTcp = _mm_cmpeq_epi32(protocol, _mm_set1_epi32(IP_PROTO_TCP));
+        __m128i isUdp = _mm_cmpeq_epi32(protocol, _mm_set1_epi32(IP_PROTO_UDP));
+        portsOk = _mm_and_si128(portsOk, _mm_or_si128(isTcp, isUdp));
+        __m256i headerLen64 = _mm256_cvtepu32_epi64(headerLen);
+        __m256i portsEnd = _mm256_add_epi64(headerLen64, _mm256_set1_epi64x(4));
+        __m128i portsFit = narrowMask(_mm256_cmpgt_epi64(_mm256_add_epi64(lens, _mm256_set1_epi64x(1)), portsEnd));
+        portsOk = _mm_and_si128(portsOk, portsFit);
+        __m128i ports = _mm256_mask_i64gather_epi32(zero, gatherBase, _mm256_add_epi64(offsets, headerLen64),
+                                                    portsOk, 1);
+        ports = _mm_shuffle_epi8(ports, bswap);  // srcPort in high half, dstPort in low half
+
+        alignas(16) uint32_t laneV4[4], laneSrc[4], laneDst[4], lanePorts[4], laneProto[4], laneDscp[4], laneLen[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(laneV4), v4);
+        _mm_store_si128(reinterpret_cast<__m128i*>(laneSrc), src);
+        _mm_store_si128(reinterpret_cast<__m128i*>(laneDst), dst);
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanePorts), ports);
+        _mm_store_si128(reinterpret_cast<__m128i*>(laneProto), protocol);
+        _mm_store_si128(reinterpret_cast<__m128i*>(laneDscp), dscp);
+        _mm_store_si128(reinterpret_cast<__m128i*>(laneLen), headerLen);
+
+        size_t done = 0;
+        for (int lane = 0; lane < 4; ++lane) {
+            if (!laneV4[lane]) continue;
+            PacketMeta& meta = out[lane];
+            meta.srcIP = laneSrc[lane];
+            meta.dstIP = laneDst[lane];
+            meta.srcPort = static_cast<uint16_t>(lanePorts[lane] >> 16);
+            meta.dstPort = static_cast<uint16_t>(lanePorts[lane] & 0xFFFF);
+            meta.version = 4;
+            meta.protocol = static_cast<uint8_t>(laneProto[lane]);
+            meta.dscp = static_cast<uint8_t>(laneDscp[lane]);
+            meta.headerLength = static_cast<uint8_t>(laneLen[lane]);
+            done |= static_cast<size_t>(1) << lane;
+        }
+        return done;
+    }
+
+    void classifyBatchGather(const uint8_t* const* packets, const size_t* lengths, size_t count, PacketMeta* out) {
+        static_assert(sizeof(const uint8_t*) == sizeof(long long) && sizeof(size_t) == sizeof(long long),
+                      "AVX2 classifier expects 64-bit pointers");
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            size_t done = classifyAvx2Block(packets + i, lengths + i, out + i);
+            for (size_t lane = 0; lane < 4; ++lane) {
+                if (!(done & (static_cast<size_t>(1) << lane))) {
+                    PacketClassifier::classify(packets[i + lane], lengths[i + lane], out[i + lane]);
+                }
+            }
+        }
+        for (; i < count; ++i) {
+            PacketClassifier::classify(packets[i], lengths[i], out[i]);
+        }
+    }
+
+#endif // VPN_SIMD_X86
+
+    // false if the CPU lacks AVX2 and the scalar path was used
+    bool classifyBatchAvx2(const uint8_t* const* packets, const size_t* lengths, size_t count, PacketMeta* out) {
+#ifdef VPN_SIMD_X86
+        static const bool supported = CpuFeatures::supportsAvx2();
+        if (supported) {
+            classifyBatchGather(packets, lengths, count, out);
+            return true;
+        }
+#endif
+        PacketClassifier::classifyBatch(packets, lengths, count, out);
+        return false;
+    }
+
+    struct Batch {
+        std::vector<std::vector<uint8_t>> storage;
+        std::vector<const uint8_t*> packets;
+        std::vector<size_t> lengths;
+        std::vector<PacketMeta> meta;
+
+        // ipv6Percent of the packets are IPv6, sizes alternate between ACK-sized and full
+        explicit Batch(int ipv6Percent) {
+            std::mt19937 rng(ipv6Percent);
+            for (size_t i = 0; i < BATCH; ++i) {
+                size_t length = (i % 3 == 0) ? 1200 : 64;
+                uint8_t protocol = (i & 1) ? 6 : 17;
+                bool v6 = static_cast<int>(rng() % 100) < ipv6Percent;
+                storage.push_back(v6 ? BenchPackets::ipv6(1, 2 + static_cast<uint32_t>(i), protocol, 40000, 443,
+                                                          length, rng)
+                                     : BenchPackets::ipv4(0x0A000001, 0x0A000100 + static_cast<uint32_t>(i),
+                                                          protocol, 40000, 443, length, rng));
+            }
+            for (const auto& packet : storage) {
+                packets.push_back(packet.data());
+                lengths.push_back(packet.size());
+            }
+            meta.resize(BATCH);
+        }
+    };
+
+    void BM_ClassifyBatchAvx2(benchmark::State& state) {
+        Batch batch(static_cast<int>(state.range(0)));
+        std::vector<PacketMeta> expected(BATCH);
+        PacketClassifier::classifyBatch(batch.packets.data(), batch.lengths.data(), BATCH, expected.data());
+        bool avx2 = classifyBatchAvx2(batch.packets.data(), batch.lengths.data(), BATCH, batch.meta.data());
+        if (memcmp(expected.data(), batch.meta.data(), BATCH * sizeof(PacketMeta)) != 0) {
+            state.SkipWithError("AVX2 kernel output differs from classifyBatch");
+            return;
+        }
+        for (auto _ : state) {
+            classifyBatchAvx2(batch.packets.data(), batch.lengths.data(), BATCH, batch.meta.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * BATCH);
+        if (!avx2) state.SetLabel("no avx2, scalar fallback");
+    }
+
+    void BM_ClassifyBatch(benchmark::State& state) {
+        Batch batch(static_cast<int>(state.range(0)));
+        for (auto _ : state) {
+            PacketClassifier::classifyBatch(batch.packets.data(), batch.lengths.data(), BATCH, batch.meta.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * BATCH);
+    }
+
+    // One call per packet, as the read loop did before batching
+    void BM_ClassifyPerPacket(benchmark::State& state) {
+        Batch batch(static_cast<int>(state.range(0)));
+        for (auto _ : state) {
+            for (size_t i = 0; i < BATCH; ++i) {
+                PacketClassifier::classify(batch.packets[i], batch.lengths[i], batch.meta[i]);
+            }
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * BATCH);
+    }
+
+} // anonymous namespace
+
+BENCHMARK(BM_ClassifyBatchAvx2)->Arg(0)->Arg(50)->Arg(100);
+BENCHMARK(BM_ClassifyBatch)->Arg(0)->Arg(50)->Arg(100);
+BENCHMARK(BM_ClassifyPerPacket)->Arg(0)->Arg(50)->Arg(100);
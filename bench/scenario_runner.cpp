@@ -0,0 +1,204 @@
+// Goodput and one-way latency through EmulatedTransport for every scenario in
+// a scenario file. A paced sender pushes fixed-size unreliable messages from one
+// in-process endpoint to another and backs off on pending bytes the way the
+// bridge does (networking.send_pending_limit_kb); the receiver records latency
+// from the send timestamp carried in each message.
+//
+// Usage: bench_scenarios [scenarios.json] [--scenario NAME] [--seconds N]
+//                        [--rate-mbit N] [--size BYTES] [--pending-kb N]
+
+#include "transport/emulated_transport.h"
+#include "transport/in_process_transport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef CONNECTTOOL_SCENARIO_FILE
+#define CONNECTTOOL_SCENARIO_FILE "network_scenarios.json"
+#endif
+
+namespace {
+
+    constexpr PeerId SENDER_ID = 1;
+    constexpr PeerId RECEIVER_ID = 2;
+
+    struct Options {
+        std::string file = CONNECTTOOL_SCENARIO_FILE;
+        std::string scenario;
+        double seconds = 5.0;
+        double rateMbit = 20.0;
+        uint32_t size = 1200;
+        int pendingKb = 128;
+    };
+
+    struct Probe {
+        uint64_t sequence;
+        int64_t sentUs;
+    };
+
+    struct Result {
+        uint64_t offered = 0;       // messages the pacer wanted to send
+        uint64_t sent = 0;          // accepted by the emulator
+        uint64_t delivered = 0;     // unique messages received
+        uint64_t duplicates = 0;
+        uint64_t reordered = 0;     // arrived after a higher sequence
+        double goodputMbit = 0.0;
+        std::vector<int64_t> latencyUs;
+    };
+
+    bool parseArgs(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+            const char* v = nullptr;
+            if (arg == "--scenario" && (v = value())) options.scenario = v;
+            else if (arg == "--seconds" && (v = value())) options.seconds = std::atof(v);
+            else if (arg == "--rate-mbit" && (v = value())) options.rateMbit = std::atof(v);
+            else if (arg == "--size" && (v = value())) options.size = static_cast<uint32_t>(std::atoi(v));
+            else if (arg == "--pending-kb" && (v = value())) options.pendingKb = std::atoi(v);
+            else if (arg.compare(0, 2, "--") != 0) options.file = arg;
+            else return false;
+        }
+        return options.seconds > 0 && options.rateMbit > 0 && options.size >= sizeof(Probe) &&
+               options.pendingKb > 0;
+    }
+
+    int64_t percentile(const std::vector<int64_t>& sorted, double p) {
+        if (sorted.empty()) return 0;
+        size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    Result run(const NetworkScenario& scenario, const Options& options) {
+        auto hub = std::make_shared<InProcessHub>();
+        InProcessTransport sender(hub, SENDER_ID, 0x0A000001);
+        InProcessTransport receiver(hub, RECEIVER_ID, 0x0A000002);
+        Result result;
+        std::atomic<bool> receiving{true};
+        int64_t firstSentUs = 0;
+        int64_t lastReceivedUs = 0;
+
+        std::thread receiveThread([&]() {
+            std::vector<bool> seen;
+            uint64_t highest = 0;
+            TransportMessage batch[64];
+            for (;;) {
+                int count = receiver.receiveBatch(batch, 64);
+                if (count == 0) {
+                    if (!receiving.load()) break;
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                    continue;
+                }
+                for (int i = 0; i < count; ++i) {
+                    Probe probe;
+                    memcpy(&probe, batch[i].data, sizeof(probe));
+                    if (probe.sequence >= seen.size()) seen.resize(probe.sequence * 2 + 1024);
+                    if (seen[probe.sequence]) {
+                        result.duplicates++;
+                        continue;
+                    }
+                    seen[probe.sequence] = true;
+                    if (probe.sequence < highest) result.reordered++;
+                    highest = std::max(highest, probe.sequence);
+                    result.delivered++;
+                    result.latencyUs.push_back(batch[i].receivedAtUs - probe.sentUs);
+                    lastReceivedUs = std::max(lastReceivedUs, batch[i].receivedAtUs);
+                }
+                receiver.release(batch, count);
+            }
+        });
+
+        {
+            // Destroyed before the receiver stops, so everything scheduled is handed over
+            EmulatedTransport emulated(&sender, scenario);
+            std::vector<uint8_t> payload(options.size, 0xA5);
+            const double bytesPerUs = options.rateMbit * 1e6 / 8 / 1e6;
+            const int pendingLimit = options.pendingKb * 1024;
+
+            firstSentUs = transportTimestampUs();
+            const int64_t endUs = firstSentUs + static_cast<int64_t>(options.seconds * 1e6);
+            for (int64_t now = firstSentUs; now < endUs; now = transportTimestampUs()) {
+                uint64_t due = static_cast<uint64_t>(static_cast<double>(now - firstSentUs) * bytesPerUs /
+                                                     options.size);
+                while (result.offered < due) {
+                    result.offered++;
+                    // Same policy as the bridge once its backpressure wait runs out: drop
+                    if (emulated.getPendingSendBytes(RECEIVER_ID) > pendingLimit) continue;
+                    Probe probe{result.sent, transportTimestampUs()};
+                    memcpy(payload.data(), &probe, sizeof(probe));
+                    if (emulated.sendToPeer(RECEIVER_ID, payload.data(), options.size,
+                                            TRANSPORT_SEND_NO_NAGLE | TRANSPORT_SEND_NO_DELAY)) {
+                        result.sent++;
+                    }
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            // Let queued and delayed messages land (bounded for pathological scenarios)
+            const int64_t drainDeadline = transportTimestampUs() + 10 * 1000 * 1000;
+            while (emulated.getPendingSendBytes(RECEIVER_ID) > 0 && transportTimestampUs() < drainDeadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        }
+        receiving.store(false);
+        receiveThread.join();
+
+        if (lastReceivedUs > firstSentUs) {
+            result.goodputMbit = static_cast<double>(result.delivered) * options.size * 8 /
+                                 static_cast<double>(lastReceivedUs - firstSentUs);
+        }
+        std::sort(result.latencyUs.begin(), result.latencyUs.end());
+        return result;
+    }
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        fprintf(stderr, "usage: %s [scenarios.json] [--scenario NAME] [--seconds N] [--rate-mbit N] "
+                        "[--size BYTES] [--pending-kb N]\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<NetworkScenario> scenarios;
+    std::string error;
+    if (!NetworkScenario::loadFromFile(options.file, scenarios, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    printf("offered %.1f Mbit/s, %u-byte messages, %.1f s per scenario, pending limit %d KB\n\n",
+           options.rateMbit, options.size, options.seconds, options.pendingKb);
+    printf("%-20s %9s %9s %7s %6s %6s %10s %8s %8s %8s %8s\n", "scenario", "sent", "delivered", "loss%",
+           "dup", "reord", "goodput", "p50 ms", "p90 ms", "p99 ms", "max ms");
+
+    bool found = false;
+    for (const auto& scenario : scenarios) {
+        if (!options.scenario.empty() && scenario.name != options.scenario) continue;
+        found = true;
+        Result r = run(scenario, options);
+        double loss = r.sent ? 100.0 * (1.0 - static_cast<double>(r.delivered) / r.sent) : 0.0;
+        printf("%-20s %9llu %9llu %7.2f %6llu %6llu %10.2f %8.2f %8.2f %8.2f %8.2f\n", scenario.name.c_str(),
+               static_cast<unsigned long long>(r.sent), static_cast<unsigned long long>(r.delivered), loss,
+               static_cast<unsigned long long>(r.duplicates), static_cast<unsigned long long>(r.reordered),
+               r.goodputMbit, percentile(r.latencyUs, 0.50) / 1000.0, percentile(r.latencyUs, 0.90) / 1000.0,
+               percentile(r.latencyUs, 0.99) / 1000.0, percentile(r.latencyUs, 1.0) / 1000.0);
+        if (r.offered > r.sent) {
+            printf("%-20s %llu messages refused (sender backpressure or emulator queue limit)\n", "",
+                   static_cast<unsigned long long>(r.offered - r.sent));
+        }
+    }
+    if (!found) {
+        fprintf(stderr, "no scenario named '%s'\n", options.scenario.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,395 @@
+// Messages per second and CPU cost of the two Steam backends between two real
+// Steam clients. The Messages backend sends one message per SendMessageToUser
+// call (SteamTransport); the Sockets backend copies messages into
+// AllocateMessage buffers and submits them with one SendMessages call per batch
+// (SteamSocketsTransport). The raw APIs are used directly so the benchmark does
+// not need the networking manager or a lobby.
+//
+// Run the receiver first, then point the sender at the receiver's Steam ID.
+// Both sides must use the same backend:
+//   bench_steam_backends --backend sockets
+//   bench_steam_backends --backend sockets --peer 7656119... [--seconds N]
+//                        [--size BYTES] [--batch N] [--rate-kb N] [--pending-kb N]
+//
+// CPU is process time (all threads, including Steam's), reported per message
+// and as a share of one core.
+
+#include <steam_api.h>
+#include <isteamnetworkingmessages.h>
+#include <isteamnetworkingsockets.h>
+#include <isteamnetworkingutils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <ctime>
+#endif
+
+namespace {
+
+    constexpr int CHANNEL = 0;          // Messages channel / Sockets virtual port
+    constexpr int RECEIVE_BATCH = 256;
+    constexpr double RECEIVER_IDLE_SECONDS = 5.0;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        bool sockets = false;
+        uint64_t peer = 0;              // 0: receive
+        double seconds = 10.0;
+        uint32_t size = 1200;
+        int batch = 64;
+        int rateKb = 100 * 1024;        // SendRateMin/Max, KB/s
+        int pendingKb = 512;
+    };
+
+    struct Counters {
+        uint64_t messages = 0;
+        uint64_t bytes = 0;
+        uint64_t failures = 0;
+        uint64_t calls = 0;             // Steam send calls
+    };
+
+    double cpuSeconds() {
+#ifdef _WIN32
+        FILETIME created, exited, kernel, user;
+        if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return 0.0;
+        auto toSeconds = [](const FILETIME& t) {
+            return static_cast<double>((static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime) * 1e-7;
+        };
+        return toSeconds(kernel) + toSeconds(user);
+#else
+        timespec ts;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) * 1e-9;
+#endif
+    }
+
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    bool parseArgs(int argc, char** argv, Options& options) {
+        bool backend = false;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+            const char* v = nullptr;
+            if (arg == "--backend" && (v = value())) {
+                backend = true;
+                if (strcmp(v, "sockets") == 0) options.sockets = true;
+                else if (strcmp(v, "messages") != 0) return false;
+            }
+            else if (arg == "--peer" && (v = value())) options.peer = std::strtoull(v, nullptr, 10);
+            else if (arg == "--seconds" && (v = value())) options.seconds = std::atof(v);
+            else if (arg == "--size" && (v = value())) options.size = static_cast<uint32_t>(std::atoi(v));
+            else if (arg == "--batch" && (v = value())) options.batch = std::atoi(v);
+            else if (arg == "--rate-kb" && (v = value())) options.rateKb = std::atoi(v);
+            else if (arg == "--pending-kb" && (v = value())) options.pendingKb = std::atoi(v);
+            else return false;
+        }
+        return backend && options.seconds > 0 && options.size > 0 &&
+               options.size <= k_cbMaxSteamNetworkingSocketsMessageSizeSend && options.batch > 0 &&
+               options.rateKb > 0 && options.pendingKb > 0;
+    }
+
+    void report(const char* what, const Counters& counters, double wall, double cpu) {
+        if (wall <= 0) return;
+        printf("%s %llu messages in %.2f s: %.0f msg/s, %.2f Mbit/s", what,
+               static_cast<unsigned long long>(counters.messages), wall, counters.messages / wall,
+               static_cast<double>(counters.bytes) * 8 / wall / 1e6);
+        if (counters.calls) printf(", %.1f msg per send call", static_cast<double>(counters.messages) / counters.calls);
+        if (counters.failures) printf(", %llu failed", static_cast<unsigned long long>(counters.failures));
+        printf("\n    CPU %.2f s (%.0f%% of one core), %.2f us per message\n", cpu, 100.0 * cpu / wall,
+               counters.messages ? cpu * 1e6 / counters.messages : 0.0);
+    }
+
+    // Accepts Messages sessions and Sockets connections from any peer; both sides
+    // of the benchmark are under the operator's control.
+    class Acceptor {
+    public:
+        HSteamNetConnection connection = k_HSteamNetConnection_Invalid;
+        bool connected = false;
+        bool closed = false;
+
+    private:
+        STEAM_CALLBACK(Acceptor, OnSessionRequest, SteamNetworkingMessagesSessionRequest_t);
+        STEAM_CALLBACK(Acceptor, OnConnectionStatusChanged, SteamNetConnectionStatusChangedCallback_t);
+    };
+
+    void Acceptor::OnSessionRequest(SteamNetworkingMessagesSessionRequest_t* pParam) {
+        SteamNetworkingMessages()->AcceptSessionWithUser(pParam->m_identityRemote);
+    }
+
+    void Acceptor::OnConnectionStatusChanged(SteamNetConnectionStatusChangedCallback_t* pParam) {
+        ISteamNetworkingSockets* sockets = SteamNetworkingSockets();
+        switch (pParam->m_info.m_eState) {
+            case k_ESteamNetworkingConnectionState_Connecting:
+                if (pParam->m_info.m_hListenSocket != k_HSteamListenSocket_Invalid) {
+                    sockets->AcceptConnection(pParam->m_hConn);
+                    connection = pParam->m_hConn;
+                }
+                break;
+            case k_ESteamNetworkingConnectionState_Connected:
+                connected = true;
+                break;
+            case k_ESteamNetworkingConnectionState_ClosedByPeer:
+            case k_ESteamNetworkingConnectionState_ProblemDetectedLocally:
+                fprintf(stderr, "connection closed: %s\n", pParam->m_info.m_szEndDebug);
+                sockets->CloseConnection(pParam->m_hConn, 0, nullptr, false);
+                closed = true;
+                break;
+            default:
+                break;
+        }
+    }
+
+    SteamNetworkingIdentity identityFor(uint64_t peer) {
+        SteamNetworkingIdentity identity;
+        identity.SetSteamID(CSteamID(peer));
+        return identity;
+    }
+
+    void configureRate(const Options& options) {
+        ISteamNetworkingUtils* utils = SteamNetworkingUtils();
+        int rate = options.rateKb * 1024;
+        utils->SetGlobalConfigValueInt32(k_ESteamNetworkingConfig_SendRateMin, rate);
+        utils->SetGlobalConfigValueInt32(k_ESteamNetworkingConfig_SendRateMax, rate);
+        utils->SetGlobalConfigValueInt32(k_ESteamNetworkingConfig_SendBufferSize, options.pendingKb * 2 * 1024);
+    }
+
+    int pendingBytes(const Options& options, const Acceptor& acceptor) {
+        SteamNetConnectionRealTimeStatus_t status;
+        if (options.sockets) {
+            EResult result = SteamNetworkingSockets()->GetConnectionRealTimeStatus(acceptor.connection, &status, 0,
+                                                                                   nullptr);
+            if (result != k_EResultOK || status.m_eState != k_ESteamNetworkingConnectionState_Connected) return -1;
+        } else {
+            ESteamNetworkingConnectionState state =
+                SteamNetworkingMessages()->GetSessionConnectionInfo(identityFor(options.peer), nullptr, &status);
+            if (state != k_ESteamNetworkingConnectionState_Connected) return -1;
+        }
+        return status.m_cbPendingReliable + status.m_cbPendingUnreliable;
+    }
+
+    // Opens the session or connection and waits until it is up
+    bool connect(const Options& options, Acceptor& acceptor) {
+        SteamNetworkingIdentity identity = identityFor(options.peer);
+        if (options.sockets) {
+            acceptor.connection = SteamNetworkingSockets()->ConnectP2P(identity, CHANNEL, 0, nullptr);
+            if (acceptor.connection == k_HSteamNetConnection_Invalid) return false;
+        } else {
+            // Unreliable messages do not open a session; say hello reliably first
+            const char hello = 0;
+            SteamNetworkingMessages()->SendMessageToUser(identity, &hello, 1, k_nSteamNetworkingSend_Reliable, CHANNEL);
+        }
+
+        Clock::time_point start = Clock::now();
+        while (secondsSince(start) < 30.0 && !acceptor.closed) {
+            SteamAPI_RunCallbacks();
+            if (pendingBytes(options, acceptor) >= 0) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        return false;
+    }
+
+    int runSender(const Options& options, Acceptor& acceptor) {
+        printf("connecting to %llu...\n", static_cast<unsigned long long>(options.peer));
+        if (!connect(options, acceptor)) {
+            fprintf(stderr, "could not connect\n");
+            return 1;
+        }
+
+        ISteamNetworkingMessages* messages = SteamNetworkingMessages();
+        ISteamNetworkingSockets* sockets = SteamNetworkingSockets();
+        ISteamNetworkingUtils* utils = SteamNetworkingUtils();
+        SteamNetworkingIdentity identity = identityFor(options.peer);
+        const int pendingLimit = options.pendingKb * 1024;
+        const int flags = k_nSteamNetworkingSend_UnreliableNoNagle;
+
+        std::vector<uint8_t> payload(options.size, 0xA5);
+        std::vector<SteamNetworkingMessage_t*> batch(options.batch);
+        std::vector<int64> results(options.batch);
+        Counters counters;
+
+        double cpuStart = cpuSeconds();
+        Clock::time_point start = Clock::now();
+        Clock::time_point nextCallbacks = start;
+        while (secondsSince(start) < options.seconds) {
+            if (Clock::now() >= nextCallbacks) {
+                SteamAPI_RunCallbacks();
+                nextCallbacks = Clock::now() + std::chrono::milliseconds(10);
+            }
+            int pending = pendingBytes(options, acceptor);
+            if (pending < 0) {
+                fprintf(stderr, "connection lost\n");
+                break;
+            }
+            if (pending > pendingLimit) {
+                // Same backoff as the bridge: wait for the send queue to drain
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                continue;
+            }
+
+            if (!options.sockets) {
+                for (int i = 0; i < options.batch; ++i) {
+                    EResult result = messages->SendMessageToUser(identity, payload.data(), options.size, flags, CHANNEL);
+                    counters.calls++;
+                    if (result != k_EResultOK) {
+                        counters.failures++;
+                        continue;
+                    }
+                    counters.messages++;
+                    counters.bytes += options.size;
+                }
+                continue;
+            }
+
+            int count = 0;
+            for (; count < options.batch; ++count) {
+                SteamNetworkingMessage_t* message = utils->AllocateMessage(static_cast<int>(options.size));
+                if (!message) break;
+                memcpy(message->m_pData, payload.data(), options.size);
+                message->m_conn = acceptor.connection;
+                message->m_nFlags = flags;
+                batch[count] = message;
+            }
+            if (count == 0) {
+                counters.failures++;
+                continue;
+            }
+            sockets->SendMessages(count, batch.data(), results.data());
+            counters.calls++;
+            for (int i = 0; i < count; ++i) {
+                if (results[i] < 0) {
+                    counters.failures++;
+                    continue;
+                }
+                counters.messages++;
+                counters.bytes += options.size;
+            }
+        }
+        double wall = secondsSince(start);
+        double cpu = cpuSeconds() - cpuStart;
+
+        report(options.sockets ? "sockets sent" : "messages sent", counters, wall, cpu);
+
+        // Let the last queued messages go out before tearing the session down
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        if (options.sockets) {
+            sockets->CloseConnection(acceptor.connection, 0, "done", true);
+        } else {
+            messages->CloseSessionWithUser(identity);
+        }
+        return 0;
+    }
+
+    int runReceiver(const Options& options, Acceptor& acceptor) {
+        ISteamNetworkingMessages* messages = SteamNetworkingMessages();
+        ISteamNetworkingSockets* sockets = SteamNetworkingSockets();
+        HSteamListenSocket listenSocket = k_HSteamListenSocket_Invalid;
+        if (options.sockets) {
+            listenSocket = sockets->CreateListenSocketP2P(CHANNEL, 0, nullptr);
+            if (listenSocket == k_HSteamListenSocket_Invalid) {
+                fprintf(stderr, "could not create P2P listen socket\n");
+                return 1;
+            }
+        }
+        printf("waiting on %s backend, local Steam ID %llu\n", options.sockets ? "sockets" : "messages",
+               static_cast<unsigned long long>(SteamUser()->GetSteamID().ConvertToUint64()));
+
+        SteamNetworkingMessage_t* incoming[RECEIVE_BATCH];
+        Counters counters;
+        Counters interval;
+        Clock::time_point first;
+        Clock::time_point last;
+        Clock::time_point nextReport;
+        double cpuFirst = 0.0;
+        double cpuReport = 0.0;
+
+        for (;;) {
+            SteamAPI_RunCallbacks();
+            int count = 0;
+            if (options.sockets) {
+                if (acceptor.connection != k_HSteamNetConnection_Invalid) {
+                    count = sockets->ReceiveMessagesOnConnection(acceptor.connection, incoming, RECEIVE_BATCH);
+                }
+            } else {
+                count = messages->ReceiveMessagesOnChannel(CHANNEL, incoming, RECEIVE_BATCH);
+            }
+
+            Clock::time_point now = Clock::now();
+            for (int i = 0; i < std::max(count, 0); ++i) {
+                // The reliable hello is not part of the measurement
+                if (incoming[i]->m_cbSize > 1) {
+                    counters.messages++;
+                    counters.bytes += incoming[i]->m_cbSize;
+                    interval.messages++;
+                    interval.bytes += incoming[i]->m_cbSize;
+                }
+                incoming[i]->Release();
+            }
+
+            if (count > 0) {
+                if (counters.messages > 0 && first == Clock::time_point{}) {
+                    first = now;
+                    nextReport = now + std::chrono::seconds(1);
+                    cpuFirst = cpuReport = cpuSeconds();
+                }
+                last = now;
+            }
+            if (first != Clock::time_point{} && now >= nextReport) {
+                double cpu = cpuSeconds();
+                printf("  %.0f msg/s, %.2f Mbit/s, CPU %.0f%%\n", static_cast<double>(interval.messages),
+                       static_cast<double>(interval.bytes) * 8 / 1e6, 100.0 * (cpu - cpuReport));
+                interval = Counters{};
+                cpuReport = cpu;
+                nextReport += std::chrono::seconds(1);
+            }
+
+            bool idle = first != Clock::time_point{} &&
+                        std::chrono::duration<double>(now - last).count() > RECEIVER_IDLE_SECONDS;
+            if (idle || (options.sockets && acceptor.closed && counters.messages > 0)) break;
+            if (count <= 0) std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+
+        double wall = std::chrono::duration<double>(last - first).count();
+        report(options.sockets ? "sockets received" : "messages received", counters, wall,
+               cpuSeconds() - cpuFirst);
+        if (listenSocket != k_HSteamListenSocket_Invalid) sockets->CloseListenSocket(listenSocket);
+        return 0;
+    }
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        fprintf(stderr, "usage: %s --backend messages|sockets [--peer STEAMID] [--seconds N] [--size BYTES] "
+                        "[--batch N] [--rate-kb N] [--pending-kb N]\n", argv[0]);
+        return 2;
+    }
+    if (!SteamAPI_Init()) {
+        fprintf(stderr, "SteamAPI_Init() failed (is Steam running, is steam_appid.txt present?)\n");
+        return 1;
+    }
+    SteamNetworkingUtils()->InitRelayNetworkAccess();
+    configureRate(options);
+
+    int result;
+    {
+        Acceptor acceptor;
+        result = options.peer ? runSender(options, acceptor) : runReceiver(options, acceptor);
+    }
+    SteamAPI_Shutdown();
+    return result;
+}
@@ -171,6 +171,7 @@ ConfigManager::ConfigManager() {
         // IPv6 支持
         "https://v6.gh-proxy.org/https://raw.githubusercontent.com/Ayndpa/ConnectTool/tun/config/default_config.json"
     };
+    publish();
 }
 
 bool ConfigManager::loadFromRemote() {
@@ -189,6 +190,7 @@ bool ConfigManager::loadFromRemote() {
         if (!jsonContent.empty()) {
             if (parseJson(jsonContent)) {
                 loaded_ = true;
+                publish();
                 std::cout << "[ConfigManager] Configuration loaded successfully from: " << url << std::endl;
                 return true;
             } else {
@@ -237,6 +239,50 @@ AppConfig& ConfigManager::getConfigMutable() {
     return config_;
 }
 
+void ConfigManager::publish() {
+    std::atomic_store(&snapshot_, std::shared_ptr<const AppConfig>(std::make_shared<AppConfig>(config_)));
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void ConfigManager::update(const AppConfig& config) {
+    config_ = config;
+    publish();
+}
+
+std::shared_ptr<const AppConfig> ConfigManager::snapshot() const {
+    return std::atomic_load(&snapshot_);
+}
+
+bool ConfigManager::validateLive(const AppConfig& config, std::string& error) {
+    auto inRange = [&error](const char* name, int64_t value, int64_t min, int64_t max) {
+        if (value >= min && value <= max) return true;
+        error = std::string(name) + " must be between " + std::to_string(min) + " and " + std::to_string(max);
+        return false;
+    };
+
+    const auto& net = config.networking;
+    if (config.vpn.default_mtu != 0 && !inRange("vpn.default_mtu", config.vpn.default_mtu, 576, 9000)) return false;
+    if (!inRange("networking.send_rate_mb", net.send_rate_mb, 1, 1024)) return false;
+    if (!inRange("networking.send_buffer_size_mb", net.send_buffer_size_mb, 1, 1024)) return false;
+    if (!inRange("networking.nagle_time", net.nagle_time, 0, 20000)) return false;
+    if (!inRange("networking.rx_inflight_limit_kb", net.rx_inflight_limit_kb, 64, 1024 * 1024)) return false;
+    if (!inRange("networking.poll_min_interval_us", net.poll_min_interval_us, 10, 100000)) return false;
+    if (!inRange("networking.poll_max_interval_us", net.poll_max_interval_us, net.poll_min_interval_us, 1000000)) {
+        return false;
+    }
+    if (!inRange("networking.poll_time_budget_us", net.poll_time_budget_us, 50, 100000)) return false;
+    if (!inRange("networking.spin_budget_us", net.spin_budget_us, 0, 1000000)) return false;
+    if (net.spin_hint != "pause" && net.spin_hint != "yield" && net.spin_hint != "none") {
+        error = "networking.spin_hint must be pause, yield or none";
+        return false;
+    }
+    if (!inRange("networking.send_pending_limit_kb", net.send_pending_limit_kb, 16, 64 * 1024)) return false;
+    if (!inRange("networking.send_backpressure_wait_ms", net.send_backpressure_wait_ms, 0, 1000)) return false;
+    if (!inRange("networking.send_credit_kb", net.send_credit_kb, 1, net.send_pending_limit_kb)) return false;
+    if (!inRange("networking.packet_trace_sample_every", net.packet_trace_sample_every, 0, INT32_MAX)) return false;
+    return true;
+}
+
 bool ConfigManager::parseJson(const std::string& jsonContent) {
     try {
         simdjson::ondemand::parser parser;
@@ -314,6 +360,57 @@ bool ConfigManager::parseJson(const std::string& jsonContent) {
             
             auto callbackInterval = networkingSection["steam_callback_interval_ms"].get_int64();
             if (!callbackInterval.error()) config_.networking.steam_callback_interval_ms = static_cast<int>(callbackInterval.value());
+
+            auto transportBackend = networkingSection["transport_backend"].get_string();
+            if (!transportBackend.error()) config_.networking.transport_backend = std::string(transportBackend.value());
+
+            auto receiveMode = networkingSection["receive_mode"].get_string();
+            if (!receiveMode.error()) config_.networking.receive_mode = std::string(receiveMode.value());
+
+            auto busyPollCpu = networkingSection["busy_poll_cpu"].get_int64();
+            if (!busyPollCpu.error()) config_.networking.busy_poll_cpu = static_cast<int>(busyPollCpu.value());
+
+            auto spinBudget = networkingSection["spin_budget_us"].get_int64();
+            if (!spinBudget.error()) config_.networking.spin_budget_us = spinBudget.value();
+
+            auto spinHint = networkingSection["spin_hint"].get_string();
+            if (!spinHint.error()) config_.networking.spin_hint = std::string(spinHint.value());
+
+            auto rxInflightLimit = networkingSection["rx_inflight_limit_kb"].get_int64();
+            if (!rxInflightLimit.error()) config_.networking.rx_inflight_limit_kb = static_cast<int>(rxInflightLimit.value());
+
+            auto pollMinInterval = networkingSection["poll_min_interval_us"].get_int64();
+            if (!pollMinInterval.error()) config_.networking.poll_min_interval_us = static_cast<int>(pollMinInterval.value());
+
+            auto pollMaxInterval = networkingSection["poll_max_interval_us"].get_int64();
+            if (!pollMaxInterval.error()) config_.networking.poll_max_interval_us = static_cast<int>(pollMaxInterval.value());
+
+            auto pollTimeBudget = networkingSection["poll_time_budget_us"].get_int64();
+            if (!pollTimeBudget.error()) config_.networking.poll_time_budget_us = static_cast<int>(pollTimeBudget.value());
+
+            auto sendPendingLimit = networkingSection["send_pending_limit_kb"].get_int64();
+            if (!sendPendingLimit.error()) config_.networking.send_pending_limit_kb = static_cast<int>(sendPendingLimit.value());
+
+            auto backpressureWait = networkingSection["send_backpressure_wait_ms"].get_int64();
+            if (!backpressureWait.error()) config_.networking.send_backpressure_wait_ms = static_cast<int>(backpressureWait.value());
+
+            auto sendCredit = networkingSection["send_credit_kb"].get_int64();
+            if (!sendCredit.error()) config_.networking.send_credit_kb = static_cast<int>(sendCredit.value());
+
+            auto traceSampleEvery = networkingSection["packet_trace_sample_every"].get_int64();
+            if (!traceSampleEvery.error()) config_.networking.packet_trace_sample_every = static_cast<int>(traceSampleEvery.value());
+
+            auto directUdpEnabled = networkingSection["direct_udp_enabled"].get_bool();
+            if (!directUdpEnabled.error()) config_.networking.direct_udp_enabled = directUdpEnabled.value();
+
+            auto directUdpPort = networkingSection["direct_udp_port"].get_int64();
+            if (!directUdpPort.error()) config_.networking.direct_udp_port = static_cast<int>(directUdpPort.value());
+
+            auto lanDiscoveryEnabled = networkingSection["lan_discovery_enabled"].get_bool();
+            if (!lanDiscoveryEnabled.error()) config_.networking.lan_discovery_enabled = lanDiscoveryEnabled.value();
+
+            auto lanDiscoveryPort = networkingSection["lan_discovery_port"].get_int64();
+            if (!lanDiscoveryPort.error()) config_.networking.lan_discovery_port = static_cast<int>(lanDiscoveryPort.value());
         }
         
         // 解析 server 部分
@@ -324,6 +421,9 @@ bool ConfigManager::parseJson(const std::string& jsonContent) {
             
             auto pathUnix = serverSection["unix_socket_path_unix"].get_string();
             if (!pathUnix.error()) config_.server.unix_socket_path_unix = std::string(pathUnix.value());
+
+            auto metricsPort = serverSection["metrics_port"].get_int64();
+            if (!metricsPort.error()) config_.server.metrics_port = static_cast<int>(metricsPort.value());
         }
         
         return true;
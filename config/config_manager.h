@@ -2,6 +2,7 @@
 #define CONFIG_MANAGER_H
 
 #include <string>
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -52,12 +53,41 @@ struct AppConfig {
         int send_buffer_size_mb = 4;
         int nagle_time = 0;
         int steam_callback_interval_ms = 10;
+        // Steam 传输后端："messages"（ISteamNetworkingMessages）或 "sockets"（ISteamNetworkingSockets P2P 连接）
+        // 房间内所有成员必须使用相同的后端
+        std::string transport_backend = "messages";
+        // 接收模式："adaptive"（Asio 定时器自适应轮询）或 "busy_poll"（专用线程忙轮询，低延迟、占用一个核心）
+        std::string receive_mode = "adaptive";
+        int busy_poll_cpu = -1;                     // 忙轮询线程绑定的 CPU，-1 表示不绑定
+        int64_t spin_budget_us = 1000;              // 最后一条消息之后持续自旋的时间
+        std::string spin_hint = "pause";            // 空轮询后的提示："pause"、"yield" 或 "none"
+        int rx_inflight_limit_kb = 2048;            // 已接收但尚未写入 TUN 的消息占用的内存上限
+        // 自适应轮询：有消息时使用最小间隔，空闲时逐步增加到最大间隔；单次唤醒最多接收 poll_time_budget_us
+        int poll_min_interval_us = 100;
+        int poll_max_interval_us = 1000;
+        int poll_time_budget_us = 500;
+        // 发送背压：待发送字节超过上限时最多等待 send_backpressure_wait_ms 后丢包；
+        // 每次查询待发送字节后，同一流最多发送 send_credit_kb 再查询
+        int send_pending_limit_kb = 128;
+        int send_backpressure_wait_ms = 50;
+        int send_credit_kb = 16;
+        // 抽样包追踪：每 N 个发往节点的 IP 包追踪一个，0 表示关闭（旧版本节点会丢弃被追踪的包）
+        int packet_trace_sample_every = 0;
+        // 直连 UDP（经 Steam 交换候选地址打洞，失败时回退到 Steam），默认关闭
+        bool direct_udp_enabled = false;
+        int direct_udp_port = 0;                    // 0 表示由系统分配
+        bool lan_discovery_enabled = false;         // 局域网信标发现（需启用直连 UDP），默认关闭
+        int lan_discovery_port = 47300;             // 同一局域网内需一致
+        // 网络仿真（仅用于测试，通过命令行 --netem-file / --netem-scenario 设置）
+        std::string emulation_scenario_file = "";   // 场景文件路径，为空时不启用
+        std::string emulation_scenario = "";        // 场景名称，为空时使用第一个
     } networking;
 
     // 服务器配置
     struct {
         std::string unix_socket_path_windows = "connect_tool.sock";
         std::string unix_socket_path_unix = "/tmp/connect_tool.sock";
+        int metrics_port = 0;                       // Prometheus 抓取端口（仅监听 127.0.0.1），0 表示不启用
     } server;
 };
 
@@ -98,14 +128,42 @@ public:
 
     /**
      * @brief 获取当前配置（只读）
+     * @note 启动之后只在事件循环线程上读取；其他线程使用 snapshot() 或 ConfigCache
      */
     const AppConfig& getConfig() const;
 
     /**
-     * @brief 获取当前配置（可修改）
+     * @brief 获取当前配置（可修改），修改后需调用 publish()
      */
     AppConfig& getConfigMutable();
 
+    /**
+     * @brief 以不可变快照的形式发布当前配置
+     */
+    void publish();
+
+    /**
+     * @brief 替换当前配置并发布（事件循环线程）
+     * @note 调用方负责先用 validateLive 校验，并应用需要主动生效的设置
+     */
+    void update(const AppConfig& config);
+
+    /**
+     * @brief 最近一次发布的配置快照，任意线程可调用
+     */
+    std::shared_ptr<const AppConfig> snapshot() const;
+
+    /**
+     * @brief 发布代数，每次 publish() 加一
+     */
+    uint64_t generation() const { return generation_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 校验运行时可修改的配置项的取值范围
+     * @return false 时 error 为第一个不合法的配置项
+     */
+    static bool validateLive(const AppConfig& config, std::string& error);
+
     /**
      * @brief 检查配置是否已加载
      */
@@ -130,6 +188,40 @@ private:
     bool loaded_ = false;
     std::string lastError_;
     std::vector<std::string> configUrls_;  // 备用 URL 列表
+
+    // 用 std::atomic_store 替换，std::atomic_load 读取
+    std::shared_ptr<const AppConfig> snapshot_;
+    std::atomic<uint64_t> generation_{0};
+};
+
+/**
+ * @brief 热路径线程持有的配置缓存
+ *
+ * 每个线程一个实例。refresh() 平时只读一次发布代数，
+ * 只有配置重新发布后才读取快照，因此数据路径上不加锁。
+ */
+class ConfigCache {
+public:
+    /**
+     * @brief 检查是否有新发布的配置
+     * @return true 表示配置已更新（首次调用总是 true）
+     */
+    bool refresh() {
+        ConfigManager& manager = ConfigManager::instance();
+        uint64_t generation = manager.generation();
+        if (config_ && generation == generation_) return false;
+        // 先读代数再读快照：两者之间的发布只会让下次再读一次
+        config_ = manager.snapshot();
+        generation_ = generation;
+        return true;
+    }
+
+    const AppConfig& get() const { return *config_; }
+    const AppConfig* operator->() const { return config_.get(); }
+
+private:
+    std::shared_ptr<const AppConfig> config_;
+    uint64_t generation_ = 0;
 };
 
 #endif // CONFIG_MANAGER_H
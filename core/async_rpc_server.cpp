@@ -0,0 +1,876 @@
+#include "async_rpc_server.h"
+#include "connect_tool_core.h"
+#include "stats_sampler.h"
+#include "stage_timing.h"
+#include "config/config_manager.h"
+#include "vpn/vpn_utils.h"
+#include <algorithm>
+#include <iostream>
+
+using grpc::ServerContext;
+using grpc::Status;
+
+using connecttool::ConnectToolService;
+using connecttool::CreateLobbyRequest;
+using connecttool::CreateLobbyResponse;
+using connecttool::JoinLobbyRequest;
+using connecttool::JoinLobbyResponse;
+using connecttool::LeaveLobbyRequest;
+using connecttool::LeaveLobbyResponse;
+using connecttool::GetLobbyInfoRequest;
+using connecttool::GetLobbyInfoResponse;
+using connecttool::GetFriendLobbiesRequest;
+using connecttool::GetFriendLobbiesResponse;
+using connecttool::InviteFriendRequest;
+using connecttool::InviteFriendResponse;
+using connecttool::GetVPNStatusRequest;
+using connecttool::GetVPNStatusResponse;
+using connecttool::GetVPNRoutingTableRequest;
+using connecttool::GetVPNRoutingTableResponse;
+using connecttool::GetVersionRequest;
+using connecttool::GetVersionResponse;
+using connecttool::GetPeerStatsRequest;
+using connecttool::GetPeerStatsResponse;
+using connecttool::GetStageTimingsRequest;
+using connecttool::GetStageTimingsResponse;
+using connecttool::SetPacketTracingRequest;
+using connecttool::SetPacketTracingResponse;
+using connecttool::DumpPacketTraceRequest;
+using connecttool::DumpPacketTraceResponse;
+using connecttool::DumpFlightRecorderRequest;
+using connecttool::DumpFlightRecorderResponse;
+using connecttool::SetConfigRequest;
+using connecttool::SetConfigResponse;
+using connecttool::LiveConfig;
+using connecttool::WatchStatsRequest;
+using connecttool::StatsUpdate;
+using connecttool::CaptureRequest;
+using connecttool::CaptureBatch;
+
+namespace {
+
+    void fillVpnStats(const SteamVpnBridge::Statistics& stats, connecttool::VPNStats* statsProto) {
+        statsProto->set_packets_sent(stats.packetsSent);
+        statsProto->set_bytes_sent(stats.bytesSent);
+        statsProto->set_packets_received(stats.packetsReceived);
+        statsProto->set_bytes_received(stats.bytesReceived);
+        statsProto->set_packets_dropped(stats.packetsDropped);
+        statsProto->set_tcp_mss_clamped(stats.tcpMssClamped);
+        statsProto->set_oversize_packets(stats.oversizePackets);
+        statsProto->set_icmp_frag_needed_sent(stats.icmpFragNeededSent);
+        statsProto->set_ipv6_unroutable(stats.ipv6Unroutable);
+        statsProto->set_flow_cache_hits(stats.flowCacheHits);
+        statsProto->set_flow_cache_misses(stats.flowCacheMisses);
+        statsProto->set_rx_queue_drops(stats.rxQueueDrops);
+        statsProto->set_rx_queue_high_water(stats.rxQueueHighWater);
+        statsProto->set_rx_queue_depth(stats.rxQueueDepth);
+        statsProto->set_rx_queue_capacity(stats.rxQueueCapacity);
+        statsProto->set_tun_write_batches(stats.tunWriteBatches);
+        statsProto->set_rx_inflight_bytes(stats.rxInFlightBytes);
+        statsProto->set_rx_inflight_peak_bytes(stats.rxInFlightPeakBytes);
+        statsProto->set_rx_inflight_limit_bytes(stats.rxInFlightLimitBytes);
+        statsProto->set_rx_inflight_rejected(stats.rxInFlightRejected);
+    }
+
+    const char* pathName(PeerLinkMetrics::Path path) {
+        switch (path) {
+            case PeerLinkMetrics::Path::Steam: return "steam";
+            case PeerLinkMetrics::Path::Relayed: return "relay";
+            case PeerLinkMetrics::Path::DirectUdp: return "direct_udp";
+            case PeerLinkMetrics::Path::Lan: return "lan";
+            case PeerLinkMetrics::Path::Unknown: break;
+        }
+        return "unknown";
+    }
+
+    // Both lists are sorted by steamId
+    void addPeerChanges(const std::vector<StatsSampler::PeerSample>& current,
+                        const std::vector<StatsSampler::PeerSample>* previous, StatsUpdate* update) {
+        size_t j = 0;
+        for (const auto& peer : current) {
+            if (previous) {
+                while (j < previous->size() && (*previous)[j].steamId < peer.steamId) {
+                    update->add_departed_peers(std::to_string((*previous)[j++].steamId));
+                }
+                if (j < previous->size() && (*previous)[j].steamId == peer.steamId) {
+                    if ((*previous)[j++] == peer) continue;
+                }
+            }
+            auto* metrics = update->add_peers();
+            metrics->set_steam_id(std::to_string(peer.steamId));
+            metrics->set_name(peer.name);
+            metrics->set_ping(peer.ping);
+            metrics->set_relay_info(peer.relayInfo);
+            metrics->set_latency_saved_ms(peer.latencySavedMs);
+        }
+        while (previous && j < previous->size()) {
+            update->add_departed_peers(std::to_string((*previous)[j++].steamId));
+        }
+    }
+
+    // Copies the fields set in live over config
+    void mergeLiveConfig(const LiveConfig& live, AppConfig& config) {
+        auto& net = config.networking;
+        if (live.has_default_mtu()) config.vpn.default_mtu = live.default_mtu();
+        if (live.has_send_rate_mb()) net.send_rate_mb = live.send_rate_mb();
+        if (live.has_send_buffer_size_mb()) net.send_buffer_size_mb = live.send_buffer_size_mb();
+        if (live.has_nagle_time()) net.nagle_time = live.nagle_time();
+        if (live.has_rx_inflight_limit_kb()) net.rx_inflight_limit_kb = live.rx_inflight_limit_kb();
+        if (live.has_send_pending_limit_kb()) net.send_pending_limit_kb = live.send_pending_limit_kb();
+        if (live.has_send_backpressure_wait_ms()) net.send_backpressure_wait_ms = live.send_backpressure_wait_ms();
+        if (live.has_send_credit_kb()) net.send_credit_kb = live.send_credit_kb();
+        if (live.has_poll_min_interval_us()) net.poll_min_interval_us = live.poll_min_interval_us();
+        if (live.has_poll_max_interval_us()) net.poll_max_interval_us = live.poll_max_interval_us();
+        if (live.has_poll_time_budget_us()) net.poll_time_budget_us = live.poll_time_budget_us();
+        if (live.has_spin_budget_us()) net.spin_budget_us = live.spin_budget_us();
+        if (live.has_spin_hint()) net.spin_hint = live.spin_hint();
+        if (live.has_packet_trace_sample_every()) net.packet_trace_sample_every = live.packet_trace_sample_every();
+    }
+
+    void fillLiveConfig(const AppConfig& config, LiveConfig* live) {
+        const auto& net = config.networking;
+        live->set_default_mtu(config.vpn.default_mtu);
+        live->set_send_rate_mb(net.send_rate_mb);
+        live->set_send_buffer_size_mb(net.send_buffer_size_mb);
+        live->set_nagle_time(net.nagle_time);
+        live->set_rx_inflight_limit_kb(net.rx_inflight_limit_kb);
+        live->set_send_pending_limit_kb(net.send_pending_limit_kb);
+        live->set_send_backpressure_wait_ms(net.send_backpressure_wait_ms);
+        live->set_send_credit_kb(net.send_credit_kb);
+        live->set_poll_min_interval_us(net.poll_min_interval_us);
+        live->set_poll_max_interval_us(net.poll_max_interval_us);
+        live->set_poll_time_budget_us(net.poll_time_budget_us);
+        live->set_spin_budget_us(net.spin_budget_us);
+        live->set_spin_hint(net.spin_hint);
+        live->set_packet_trace_sample_every(net.packet_trace_sample_every);
+    }
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+// Calls
+// ---------------------------------------------------------------------------
+
+class AsyncRpcServer::Call {
+public:
+    explicit Call(AsyncRpcServer& server)
+        : server_(server)
+        , tag_{this, false}
+        , doneTag_{this, true} {}
+    virtual ~Call() = default;
+
+    // Completion of the operation started with tag_
+    virtual void proceed(bool ok) = 0;
+    // Call finished or was cancelled (only for calls that use doneTag_)
+    virtual void onDone() {}
+
+protected:
+    AsyncRpcServer& server_;
+    ServerContext context_;
+    Tag tag_;
+    Tag doneTag_;
+};
+
+/**
+ * One outstanding instance per method waits for the next request; when it
+ * arrives a replacement is queued, the handler runs and the reply is sent.
+ */
+template <typename Request, typename Response>
+class AsyncRpcServer::UnaryCall : public Call {
+public:
+    using RequestFn = void (ConnectToolService::AsyncService::*)(
+        ServerContext*, Request*, grpc::ServerAsyncResponseWriter<Response>*,
+        grpc::CompletionQueue*, grpc::ServerCompletionQueue*, void*);
+    using HandlerFn = Status (AsyncRpcServer::*)(const Request&, Response*);
+
+    static void listen(AsyncRpcServer& server, RequestFn requestFn, HandlerFn handler) {
+        new UnaryCall(server, requestFn, handler);
+    }
+
+    void proceed(bool ok) override {
+        if (!ok || finished_ || server_.draining_) {
+            delete this;
+            return;
+        }
+        listen(server_, requestFn_, handler_);
+
+        Response reply;
+        Status status = (server_.*handler_)(request_, &reply);
+        finished_ = true;
+        responder_.Finish(reply, status, &tag_);
+    }
+
+private:
+    UnaryCall(AsyncRpcServer& server, RequestFn requestFn, HandlerFn handler)
+        : Call(server)
+        , responder_(&context_)
+        , requestFn_(requestFn)
+        , handler_(handler) {
+        (server_.service_.*requestFn_)(&context_, &request_, &responder_, server_.cq_.get(), server_.cq_.get(), &tag_);
+    }
+
+    Request request_;
+    grpc::ServerAsyncResponseWriter<Response> responder_;
+    RequestFn requestFn_;
+    HandlerFn handler_;
+    bool finished_ = false;
+};
+
+/**
+ * WatchStats stream. Updates are paced by an Asio timer on the event loop and
+ * read from the shared sampler; at most one write is in flight. The stream
+ * ends when the client cancels (done tag), the object is freed once no write
+ * or timer callback can still reference it.
+ */
+class AsyncRpcServer::WatchStatsCall : public Call {
+public:
+    static void listen(AsyncRpcServer& server) {
+        new WatchStatsCall(server);
+    }
+
+    void proceed(bool ok) override {
+        if (!started_) {
+            if (!ok) {
+                // Never matched a client, the done tag will not fire
+                delete this;
+                return;
+            }
+            started_ = true;
+            if (server_.draining_) return;  // Wait for the done tag
+            listen(server_);
+
+            interval_ = StatsSampler::clampInterval(request_.interval_ms());
+            subscription_ = std::make_unique<StatsSampler::Subscription>(*server_.sampler_, interval_);
+            nextUpdate_ = std::chrono::steady_clock::now();
+            scheduleUpdate(std::chrono::milliseconds(0));
+            return;
+        }
+
+        // Write completed; on failure the done tag follows
+        writePending_ = false;
+        if (done_) {
+            release();
+        } else if (ok) {
+            auto now = std::chrono::steady_clock::now();
+            scheduleUpdate(nextUpdate_ > now ? nextUpdate_ - now : std::chrono::steady_clock::duration::zero());
+        }
+    }
+
+    void onDone() override {
+        done_ = true;
+        timer_.cancel();
+        if (!writePending_) release();
+    }
+
+private:
+    // Retry delay while the sampler has nothing newer than the last update
+    static constexpr std::chrono::milliseconds kRetry{10};
+
+    explicit WatchStatsCall(AsyncRpcServer& server)
+        : Call(server)
+        , writer_(&context_)
+        , timer_(server.io_) {
+        context_.AsyncNotifyWhenDone(&doneTag_);
+        server_.service_.RequestWatchStats(&context_, &request_, &writer_, server_.cq_.get(), server_.cq_.get(), &tag_);
+    }
+
+    void scheduleUpdate(std::chrono::steady_clock::duration delay) {
+        timer_.expires_after(delay);
+        timer_.async_wait([this](const asio::error_code& ec) {
+            if (!ec && !done_) sendUpdate();
+        });
+    }
+
+    void sendUpdate() {
+        auto sample = server_.sampler_->latest();
+        if (!sample || (previous_ && sample->sequence <= previous_->sequence)) {
+            scheduleUpdate(kRetry);
+            return;
+        }
+
+        StatsUpdate update;
+        update.set_sequence(sample->sequence);
+        update.set_timestamp_ms(sample->timestampMs);
+        update.set_is_delta(previous_ != nullptr);
+        update.set_vpn_enabled(sample->vpnEnabled);
+        if (previous_) {
+            update.set_elapsed_ms(static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                sample->sampledAt - previous_->sampledAt).count()));
+            fillVpnStats(StatsSampler::counterDelta(sample->vpn, previous_->vpn), update.mutable_vpn());
+        } else {
+            fillVpnStats(sample->vpn, update.mutable_vpn());
+        }
+        addPeerChanges(sample->peers, previous_ ? &previous_->peers : nullptr, &update);
+
+        writePending_ = true;
+        writer_.Write(update, &tag_);
+        previous_ = std::move(sample);
+
+        auto now = std::chrono::steady_clock::now();
+        nextUpdate_ += interval_;
+        if (nextUpdate_ < now) nextUpdate_ = now + interval_;
+    }
+
+    void release() {
+        if (server_.draining_) {
+            delete this;
+            return;
+        }
+        // A cancelled timer still queues its handler, free the call after it
+        asio::post(server_.io_, [this]() { delete this; });
+    }
+
+    WatchStatsRequest request_;
+    grpc::ServerAsyncWriter<StatsUpdate> writer_;
+    asio::steady_timer timer_;
+    std::unique_ptr<StatsSampler::Subscription> subscription_;
+    std::shared_ptr<const StatsSampler::Sample> previous_;
+    std::chrono::milliseconds interval_{0};
+    std::chrono::steady_clock::time_point nextUpdate_;
+    bool started_ = false;
+    bool writePending_ = false;
+    bool done_ = false;
+};
+
+constexpr std::chrono::milliseconds AsyncRpcServer::WatchStatsCall::kRetry;
+
+/**
+ * Capture stream. The filter is compiled once and installed as a capture
+ * session on the bridge, which queues matching packets from the data path;
+ * an Asio timer drains the session into batches with at most one write in
+ * flight. A slow client only makes the session queues overflow and drop.
+ * Lifetime follows WatchStatsCall, the session is closed as soon as the
+ * stream ends.
+ */
+class AsyncRpcServer::CaptureCall : public Call {
+public:
+    static void listen(AsyncRpcServer& server) {
+        new CaptureCall(server);
+    }
+
+    ~CaptureCall() override {
+        closeSession();
+    }
+
+    void proceed(bool ok) override {
+        if (!started_) {
+            if (!ok) {
+                // Never matched a client, the done tag will not fire
+                delete this;
+                return;
+            }
+            started_ = true;
+            if (server_.draining_) return;  // Wait for the done tag
+            listen(server_);
+            start();
+            return;
+        }
+
+        // Write or Finish completed; on failure the done tag follows
+        writePending_ = false;
+        if (done_) {
+            release();
+        } else if (ok && !finished_) {
+            schedulePoll(lastBatchFull_ ? std::chrono::milliseconds(0) : kPollInterval);
+        }
+    }
+
+    void onDone() override {
+        done_ = true;
+        timer_.cancel();
+        closeSession();
+        if (!writePending_) release();
+    }
+
+private:
+    static constexpr std::chrono::milliseconds kPollInterval{20};
+    static constexpr size_t kMaxBatch = 256;
+
+    explicit CaptureCall(AsyncRpcServer& server)
+        : Call(server)
+        , writer_(&context_)
+        , timer_(server.io_) {
+        context_.AsyncNotifyWhenDone(&doneTag_);
+        server_.service_.RequestCapture(&context_, &request_, &writer_, server_.cq_.get(), server_.cq_.get(), &tag_);
+    }
+
+    void start() {
+        CaptureFilter filter;
+        std::string error;
+        if (!CaptureFilter::compile(request_.filter(), filter, error)) {
+            finish(Status(grpc::StatusCode::INVALID_ARGUMENT, "Invalid capture filter: " + error));
+            return;
+        }
+        sessionId_ = server_.core_->openCapture(filter, request_.snaplen());
+        if (sessionId_ < 0) {
+            finish(Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "Too many captures running"));
+            return;
+        }
+        std::cout << "[AsyncRpcServer] Capture started: \"" << request_.filter() << "\"" << std::endl;
+        records_.reset(new PacketCapture::Record[kMaxBatch]);
+        schedulePoll(std::chrono::milliseconds(0));
+    }
+
+    void schedulePoll(std::chrono::milliseconds delay) {
+        timer_.expires_after(delay);
+        timer_.async_wait([this](const asio::error_code& ec) {
+            if (!ec && !done_) sendBatch();
+        });
+    }
+
+    void sendBatch() {
+        uint64_t dropped = 0;
+        size_t count = server_.core_->pollCapture(sessionId_, records_.get(), kMaxBatch, &dropped);
+        if (count == 0 && dropped == 0) {
+            schedulePoll(kPollInterval);
+            return;
+        }
+
+        CaptureBatch batch;
+        batch.set_dropped(dropped);
+        for (size_t i = 0; i < count; ++i) {
+            const PacketCapture::Record& record = records_[i];
+            auto* packet = batch.add_packets();
+            packet->set_timestamp_us(record.timestampUs);
+            packet->set_outbound(record.direction == CaptureDirection::Outbound);
+            packet->set_peer(std::to_string(record.peer));
+            packet->set_length(record.length);
+            packet->set_data(record.data, record.captured);
+        }
+        lastBatchFull_ = count == kMaxBatch;
+
+        writePending_ = true;
+        writer_.Write(batch, &tag_);
+    }
+
+    void finish(const Status& status) {
+        finished_ = true;
+        writePending_ = true;
+        writer_.Finish(status, &tag_);
+    }
+
+    void closeSession() {
+        if (sessionId_ < 0) return;
+        server_.core_->closeCapture(sessionId_);
+        sessionId_ = -1;
+    }
+
+    void release() {
+        if (server_.draining_) {
+            delete this;
+            return;
+        }
+        // A cancelled timer still queues its handler, free the call after it
+        asio::post(server_.io_, [this]() { delete this; });
+    }
+
+    CaptureRequest request_;
+    grpc::ServerAsyncWriter<CaptureBatch> writer_;
+    asio::steady_timer timer_;
+    std::unique_ptr<PacketCapture::Record[]> records_;
+    int sessionId_ = -1;
+    bool started_ = false;
+    bool writePending_ = false;
+    bool finished_ = false;
+    bool lastBatchFull_ = false;
+    bool done_ = false;
+};
+
+constexpr std::chrono::milliseconds AsyncRpcServer::CaptureCall::kPollInterval;
+constexpr size_t AsyncRpcServer::CaptureCall::kMaxBatch;
+
+/**
+ * SetConfig. Changing the TUN MTU runs netsh on Windows, which can take
+ * seconds, so that step runs on configThread_ and the rest of the change and
+ * the reply are completed on the event loop afterwards. A second request while
+ * one is pending is rejected. If the event loop stops first the call is never
+ * finished and is dropped with the server. The request is merged into the
+ * published config again right before it is applied, so changes published in
+ * the meantime (SetPacketTracing) are kept.
+ */
+class AsyncRpcServer::SetConfigCall : public Call {
+public:
+    static void listen(AsyncRpcServer& server) {
+        new SetConfigCall(server);
+    }
+
+    void proceed(bool ok) override {
+        if (!ok || finished_ || server_.draining_) {
+            delete this;
+            return;
+        }
+        listen(server_);
+        start();
+    }
+
+private:
+    explicit SetConfigCall(AsyncRpcServer& server)
+        : Call(server)
+        , responder_(&context_) {
+        server_.service_.RequestSetConfig(&context_, &request_, &responder_, server_.cq_.get(), server_.cq_.get(), &tag_);
+    }
+
+    void start() {
+        if (server_.configPending_) {
+            finish(false, "Another configuration change is in progress");
+            return;
+        }
+        AppConfig config = mergedConfig();
+
+        // Rejected before the MTU is touched, applyConfig only fails validation
+        std::string error;
+        if (!ConfigManager::validateLive(config, error)) {
+            finish(false, error);
+            return;
+        }
+        int mtu = server_.core_->pendingTunMtu(config);
+        if (mtu == 0) {
+            apply();
+            return;
+        }
+
+        server_.configPending_ = true;
+        // The previous change posted its result already, the thread is exiting
+        if (server_.configThread_ && server_.configThread_->joinable()) {
+            server_.configThread_->join();
+        }
+        server_.configThread_ = std::make_unique<std::thread>([this, mtu]() {
+            bool ok = server_.core_->setTunDeviceMtu(mtu);
+            asio::post(server_.io_, [this, ok]() {
+                server_.configPending_ = false;
+                if (ok) {
+                    apply();
+                } else {
+                    finish(false, "Failed to set TUN device MTU");
+                }
+            });
+        });
+    }
+
+    AppConfig mergedConfig() const {
+        AppConfig config = ConfigManager::instance().getConfig();
+        mergeLiveConfig(request_.config(), config);
+        return config;
+    }
+
+    void apply() {
+        std::string error;
+        bool success = server_.core_->applyConfig(mergedConfig(), error);
+        finish(success, success ? "Configuration applied" : error);
+    }
+
+    void finish(bool success, const std::string& message) {
+        SetConfigResponse reply;
+        reply.set_success(success);
+        reply.set_message(message);
+        fillLiveConfig(ConfigManager::instance().getConfig(), reply.mutable_config());
+        reply.set_tun_mtu(server_.core_->getTunMtu());
+        finished_ = true;
+        responder_.Finish(reply, Status::OK, &tag_);
+    }
+
+    SetConfigRequest request_;
+    grpc::ServerAsyncResponseWriter<SetConfigResponse> responder_;
+    bool finished_ = false;
+};
+
+// ---------------------------------------------------------------------------
+// Server
+// ---------------------------------------------------------------------------
+
+AsyncRpcServer::AsyncRpcServer(asio::io_context& io, ConnectToolCore* core, StatsSampler* sampler)
+    : io_(io)
+    , core_(core)
+    , sampler_(sampler)
+    , draining_(false) {
+}
+
+AsyncRpcServer::~AsyncRpcServer() {
+    shutdown();
+}
+
+bool AsyncRpcServer::start(const std::string& address) {
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort(address, grpc::InsecureServerCredentials());
+    builder.RegisterService(&service_);
+    cq_ = builder.AddCompletionQueue();
+    server_ = builder.BuildAndStart();
+    if (!server_) {
+        std::cerr << "[AsyncRpcServer] Failed to start gRPC server on " << address << std::endl;
+        return false;
+    }
+
+    registerCalls();
+    pollThread_ = std::make_unique<std::thread>(&AsyncRpcServer::pollCompletionQueue, this);
+    return true;
+}
+
+void AsyncRpcServer::shutdown() {
+    if (!server_) return;
+
+    draining_ = true;
+    // Cancel whatever is still in flight right away
+    server_->Shutdown(std::chrono::system_clock::now());
+    cq_->Shutdown();
+    if (pollThread_ && pollThread_->joinable()) {
+        pollThread_->join();
+    }
+    pollThread_.reset();
+    // The VPN is shut down after this, a pending MTU change must be done by then
+    if (configThread_ && configThread_->joinable()) {
+        configThread_->join();
+    }
+    configThread_.reset();
+    server_.reset();
+    cq_.reset();
+}
+
+void AsyncRpcServer::registerCalls() {
+    using Service = ConnectToolService::AsyncService;
+    UnaryCall<GetVersionRequest, GetVersionResponse>::listen(
+        *this, &Service::RequestGetVersion, &AsyncRpcServer::GetVersion);
+    UnaryCall<CreateLobbyRequest, CreateLobbyResponse>::listen(
+        *this, &Service::RequestCreateLobby, &AsyncRpcServer::CreateLobby);
+    UnaryCall<JoinLobbyRequest, JoinLobbyResponse>::listen(
+        *this, &Service::RequestJoinLobby, &AsyncRpcServer::JoinLobby);
+    UnaryCall<LeaveLobbyRequest, LeaveLobbyResponse>::listen(
+        *this, &Service::RequestLeaveLobby, &AsyncRpcServer::LeaveLobby);
+    UnaryCall<GetLobbyInfoRequest, GetLobbyInfoResponse>::listen(
+        *this, &Service::RequestGetLobbyInfo, &AsyncRpcServer::GetLobbyInfo);
+    UnaryCall<GetFriendLobbiesRequest, GetFriendLobbiesResponse>::listen(
+        *this, &Service::RequestGetFriendLobbies, &AsyncRpcServer::GetFriendLobbies);
+    UnaryCall<InviteFriendRequest, InviteFriendResponse>::listen(
+        *this, &Service::RequestInviteFriend, &AsyncRpcServer::InviteFriend);
+    UnaryCall<GetVPNStatusRequest, GetVPNStatusResponse>::listen(
+        *this, &Service::RequestGetVPNStatus, &AsyncRpcServer::GetVPNStatus);
+    UnaryCall<GetVPNRoutingTableRequest, GetVPNRoutingTableResponse>::listen(
+        *this, &Service::RequestGetVPNRoutingTable, &AsyncRpcServer::GetVPNRoutingTable);
+    UnaryCall<GetPeerStatsRequest, GetPeerStatsResponse>::listen(
+        *this, &Service::RequestGetPeerStats, &AsyncRpcServer::GetPeerStats);
+    UnaryCall<GetStageTimingsRequest, GetStageTimingsResponse>::listen(
+        *this, &Service::RequestGetStageTimings, &AsyncRpcServer::GetStageTimings);
+    UnaryCall<SetPacketTracingRequest, SetPacketTracingResponse>::listen(
+        *this, &Service::RequestSetPacketTracing, &AsyncRpcServer::SetPacketTracing);
+    UnaryCall<DumpPacketTraceRequest, DumpPacketTraceResponse>::listen(
+        *this, &Service::RequestDumpPacketTrace, &AsyncRpcServer::DumpPacketTrace);
+    UnaryCall<DumpFlightRecorderRequest, DumpFlightRecorderResponse>::listen(
+        *this, &Service::RequestDumpFlightRecorder, &AsyncRpcServer::DumpFlightRecorder);
+    WatchStatsCall::listen(*this);
+    CaptureCall::listen(*this);
+    SetConfigCall::listen(*this);
+}
+
+void AsyncRpcServer::pollCompletionQueue() {
+    void* rawTag;
+    bool ok;
+    while (cq_->Next(&rawTag, &ok)) {
+        Tag* tag = static_cast<Tag*>(rawTag);
+        if (draining_) {
+            // The event loop has stopped, clean up here
+            dispatch(tag, ok);
+        } else {
+            asio::post(io_, [this, tag, ok]() { dispatch(tag, ok); });
+        }
+    }
+}
+
+void AsyncRpcServer::dispatch(Tag* tag, bool ok) {
+    if (tag->done) {
+        tag->call->onDone();
+    } else {
+        tag->call->proceed(ok);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Handlers, all on the event loop thread
+// ---------------------------------------------------------------------------
+
+Status AsyncRpcServer::GetVersion(const GetVersionRequest& request, GetVersionResponse* reply) {
+    reply->set_version(APP_VERSION_STRING);
+    return Status::OK;
+}
+
+Status AsyncRpcServer::CreateLobby(const CreateLobbyRequest& request, CreateLobbyResponse* reply) {
+    std::string lobbyId;
+    bool success = core_->createLobby(lobbyId);
+    reply->set_success(success);
+    reply->set_lobby_id(lobbyId);
+    return Status::OK;
+}
+
+Status AsyncRpcServer::JoinLobby(const JoinLobbyRequest& request, JoinLobbyResponse* reply) {
+    bool success = core_->joinLobby(request.lobby_id());
+    reply->set_success(success);
+    reply->set_message(success ? "Join request sent" : "Failed to join lobby");
+    return Status::OK;
+}
+
+Status AsyncRpcServer::LeaveLobby(const LeaveLobbyRequest& request, LeaveLobbyResponse* reply) {
+    core_->leaveLobby();
+    reply->set_success(true);
+    return Status::OK;
+}
+
+Status AsyncRpcServer::GetLobbyInfo(const GetLobbyInfoRequest& request, GetLobbyInfoResponse* reply) {
+    auto snapshot = core_->getSnapshot();
+    reply->set_is_in_lobby(snapshot->inLobby);
+    if (snapshot->inLobby) {
+        reply->set_lobby_id(std::to_string(snapshot->lobbyId.ConvertToUint64()));
+        for (const auto& memberInfo : snapshot->members) {
+            auto* member = reply->add_members();
+            member->set_steam_id(std::to_string(memberInfo.steamId.ConvertToUint64()));
+            member->set_name(memberInfo.name);
+            member->set_ping(memberInfo.connection.ping);
+            member->set_relay_info(memberInfo.connection.relayInfo);
+            member->set_latency_saved_ms(memberInfo.connection.latencySavedMs);
+        }
+    }
+    return Status::OK;
+}
+
+Status AsyncRpcServer::GetFriendLobbies(const GetFriendLobbiesRequest& request, GetFriendLobbiesResponse* reply) {
+    auto lobbies = core_->getFriendLobbies();
+    for (const auto& lobby : lobbies) {
+        auto* friendLobby = reply->add_lobbies();
+        friendLobby->set_steam_id(std::to_string(lobby.friendID.ConvertToUint64()));
+        friendLobby->set_name(lobby.friendName);
+        friendLobby->set_lobby_id(std::to_string(lobby.lobbyID.ConvertToUint64()));
+    }
+    return Status::OK;
+}
+
+Status AsyncRpcServer::InviteFriend(const InviteFriendRequest& request, InviteFriendResponse* reply) {
+    bool success = core_->inviteFriend(request.friend_steam_id());
+    reply->set_success(success);
+    return Status::OK;
+}
+
+Status AsyncRpcServer::GetVPNStatus(const GetVPNStatusRequest& request, GetVPNStatusResponse* reply) {
+    auto snapshot = core_->getSnapshot();
+    reply->set_enabled(snapshot->vpnEnabled);
+    reply->set_local_ip(snapshot->localIP);
+    reply->set_local_ipv6(snapshot->localIPv6);
+    reply->set_device_name(snapshot->tunDeviceName);
+
+    fillVpnStats(snapshot->vpnStats, reply->mutable_stats());
+
+    const auto& poll = snapshot->receivePoll;
+    auto* pollProto = reply->mutable_receive_poll();
+    pollProto->set_wakeups(poll.wakeups);
+    pollProto->set_empty_polls(poll.emptyPolls);
+    pollProto->set_messages(poll.messages);
+    pollProto->set_receive_calls(poll.receiveCalls);
+    pollProto->set_budget_exhausted(poll.budgetExhausted);
+    pollProto->set_total_poll_time_us(poll.totalPollTimeUs);
+    pollProto->set_max_poll_time_us(poll.maxPollTimeUs);
+    pollProto->set_batch_size(poll.batchSize);
+    pollProto->set_busy_poll(poll.busyPoll);
+    int lastBucket = LatencyHistogram::kBucketCount - 1;
+    while (lastBucket >= 0 && poll.queueDelay.counts[lastBucket] == 0) --lastBucket;
+    for (int i = 0; i <= lastBucket; ++i) {
+        auto* bucket = pollProto->add_queue_delay();
+        bucket->set_upper_bound_us(LatencyHistogram::Snapshot::bucketUpperBoundUs(i));
+        bucket->set_count(poll.queueDelay.counts[i]);
+    }
+    pollProto->set_queue_delay_p50_us(poll.queueDelay.percentileUs(50));
+    pollProto->set_queue_delay_p99_us(poll.queueDelay.percentileUs(99));
+    pollProto->set_queue_delay_max_us(poll.queueDelay.maxUs);
+
+    return Status::OK;
+}
+
+Status AsyncRpcServer::GetVPNRoutingTable(const GetVPNRoutingTableRequest& request, GetVPNRoutingTableResponse* reply) {
+    auto snapshot = core_->getSnapshot();
+    for (const auto& entry : snapshot->routes) {
+        auto* route = reply->add_routes();
+        route->set_ip(entry.first);
+        route->set_name(entry.second.name);
+        route->set_is_local(entry.second.isLocal);
+        if (!VpnUtils::isIpv6Unspecified(entry.second.ipv6Address)) {
+            route->set_ipv6(VpnUtils::ipv6ToString(entry.second.ipv6Address));
+        }
+    }
+    return Status::OK;
+}
+
+Status AsyncRpcServer::GetPeerStats(const GetPeerStatsRequest& request, GetPeerStatsResponse* reply) {
+    auto snapshot = core_->getSnapshot();
+    for (const auto& peer : snapshot->peers) {
+        auto* stats = reply->add_peers();
+        stats->set_steam_id(std::to_string(peer.steamId));
+        for (const auto& member : snapshot->members) {
+            if (member.steamId.ConvertToUint64() == peer.steamId) {
+                stats->set_name(member.name);
+                break;
+            }
+        }
+        stats->set_tx_packets(peer.txPackets);
+        stats->set_tx_bytes(peer.txBytes);
+        stats->set_rx_packets(peer.rxPackets);
+        stats->set_rx_bytes(peer.rxBytes);
+        stats->set_tx_packets_per_sec(peer.txPacketsPerSec);
+        stats->set_tx_bytes_per_sec(peer.txBytesPerSec);
+        stats->set_rx_packets_per_sec(peer.rxPacketsPerSec);
+        stats->set_rx_bytes_per_sec(peer.rxBytesPerSec);
+
+        auto* drops = stats->mutable_drops();
+        drops->set_backpressure(peer.drops[static_cast<size_t>(PeerDropReason::Backpressure)]);
+        drops->set_send_failed(peer.drops[static_cast<size_t>(PeerDropReason::SendFailed)]);
+        drops->set_rx_queue_full(peer.drops[static_cast<size_t>(PeerDropReason::RxQueueFull)]);
+        drops->set_rx_inflight_limit(peer.drops[static_cast<size_t>(PeerDropReason::RxInFlightLimit)]);
+
+        stats->set_connected(peer.link.connected);
+        stats->set_ping(peer.link.ping);
+        stats->set_quality_local(peer.link.qualityLocal);
+        stats->set_quality_remote(peer.link.qualityRemote);
+        stats->set_pending_bytes(peer.link.pendingBytes);
+        stats->set_out_bytes_per_sec(peer.link.outBytesPerSec);
+        stats->set_in_bytes_per_sec(peer.link.inBytesPerSec);
+        stats->set_path(pathName(peer.link.path));
+    }
+    return Status::OK;
+}
+
+Status AsyncRpcServer::GetStageTimings(const GetStageTimingsRequest& request, GetStageTimingsResponse* reply) {
+    reply->set_enabled(StageTimings::enabled());
+    if (!StageTimings::enabled()) return Status::OK;
+
+    auto stages = StageTimings::instance().snapshot();
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const auto& histogram = stages[i];
+        auto* timing = reply->add_stages();
+        timing->set_stage(stageName(static_cast<DataPathStage>(i)));
+        timing->set_count(histogram.totalCount());
+        timing->set_mean_ns(histogram.mean());
+        timing->set_min_ns(histogram.min());
+        timing->set_p50_ns(histogram.valueAtPercentile(50));
+        timing->set_p90_ns(histogram.valueAtPercentile(90));
+        timing->set_p99_ns(histogram.valueAtPercentile(99));
+        timing->set_p999_ns(histogram.valueAtPercentile(99.9));
+        timing->set_max_ns(histogram.max);
+    }
+    return Status::OK;
+}
+
+Status AsyncRpcServer::SetPacketTracing(const SetPacketTracingRequest& request, SetPacketTracingResponse* reply) {
+    core_->setPacketTraceSampleEvery(request.sample_every());
+    reply->set_sample_every(core_->getPacketTraceSampleEvery());
+    return Status::OK;
+}
+
+Status AsyncRpcServer::DumpPacketTrace(const DumpPacketTraceRequest& request, DumpPacketTraceResponse* reply) {
+    size_t events = 0;
+    reply->set_chrome_trace_json(core_->dumpPacketTrace(request.clear(), &events));
+    reply->set_events(events);
+    reply->set_sample_every(core_->getPacketTraceSampleEvery());
+    return Status::OK;
+}
+
+Status AsyncRpcServer::DumpFlightRecorder(const DumpFlightRecorderRequest& request, DumpFlightRecorderResponse* reply) {
+    size_t packets = 0;
+    reply->set_pcapng(core_->dumpFlightRecorder(&packets));
+    reply->set_packets(packets);
+    return Status::OK;
+}
+
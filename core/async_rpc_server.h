@@ -0,0 +1,101 @@
+#ifndef ASYNC_RPC_SERVER_H
+#define ASYNC_RPC_SERVER_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <asio.hpp>
+#include <grpcpp/grpcpp.h>
+
+#include "protos/connect_tool.grpc.pb.h"
+
+class ConnectToolCore;
+class StatsSampler;
+
+/**
+ * @brief 基于 CompletionQueue 的异步 gRPC 服务
+ *
+ * 一个轮询线程阻塞在 CompletionQueue::Next 上，只负责把完成事件投递到 Asio 事件循环；
+ * 所有 RPC 处理（包括对 Steam API 的调用）都在事件循环线程上执行，
+ * 与 SteamAPI_RunCallbacks 同一线程，因此不需要全局锁。
+ *
+ * 生命周期：start() 之后在事件循环中处理请求；事件循环停止后调用 shutdown()，
+ * 此时剩余的完成事件在轮询线程上直接清理。
+ */
+class AsyncRpcServer {
+public:
+    AsyncRpcServer(asio::io_context& io, ConnectToolCore* core, StatsSampler* sampler);
+    ~AsyncRpcServer();
+
+    AsyncRpcServer(const AsyncRpcServer&) = delete;
+    AsyncRpcServer& operator=(const AsyncRpcServer&) = delete;
+
+    /**
+     * @brief 监听地址并开始接受请求
+     * @return true 成功，false 失败
+     */
+    bool start(const std::string& address);
+
+    /**
+     * @brief 停止服务并释放所有进行中的调用（需在事件循环停止后调用）
+     */
+    void shutdown();
+
+private:
+    class Call;
+    template <typename Request, typename Response> class UnaryCall;
+    class WatchStatsCall;
+    class CaptureCall;
+    class SetConfigCall;
+
+    /**
+     * @brief 完成事件标签，事件触发时调用 call->proceed 或 call->onDone
+     */
+    struct Tag {
+        Call* call;
+        bool done;  // AsyncNotifyWhenDone 的标签
+    };
+
+    void registerCalls();
+    void pollCompletionQueue();
+    void dispatch(Tag* tag, bool ok);
+
+    // 处理函数（事件循环线程）
+    grpc::Status GetVersion(const connecttool::GetVersionRequest& request, connecttool::GetVersionResponse* reply);
+    grpc::Status CreateLobby(const connecttool::CreateLobbyRequest& request, connecttool::CreateLobbyResponse* reply);
+    grpc::Status JoinLobby(const connecttool::JoinLobbyRequest& request, connecttool::JoinLobbyResponse* reply);
+    grpc::Status LeaveLobby(const connecttool::LeaveLobbyRequest& request, connecttool::LeaveLobbyResponse* reply);
+    grpc::Status GetLobbyInfo(const connecttool::GetLobbyInfoRequest& request, connecttool::GetLobbyInfoResponse* reply);
+    grpc::Status GetFriendLobbies(const connecttool::GetFriendLobbiesRequest& request,
+                                  connecttool::GetFriendLobbiesResponse* reply);
+    grpc::Status InviteFriend(const connecttool::InviteFriendRequest& request, connecttool::InviteFriendResponse* reply);
+    grpc::Status GetVPNStatus(const connecttool::GetVPNStatusRequest& request, connecttool::GetVPNStatusResponse* reply);
+    grpc::Status GetVPNRoutingTable(const connecttool::GetVPNRoutingTableRequest& request,
+                                    connecttool::GetVPNRoutingTableResponse* reply);
+    grpc::Status GetPeerStats(const connecttool::GetPeerStatsRequest& request, connecttool::GetPeerStatsResponse* reply);
+    grpc::Status GetStageTimings(const connecttool::GetStageTimingsRequest& request,
+                                 connecttool::GetStageTimingsResponse* reply);
+    grpc::Status SetPacketTracing(const connecttool::SetPacketTracingRequest& request,
+                                  connecttool::SetPacketTracingResponse* reply);
+    grpc::Status DumpPacketTrace(const connecttool::DumpPacketTraceRequest& request,
+                                 connecttool::DumpPacketTraceResponse* reply);
+    grpc::Status DumpFlightRecorder(const connecttool::DumpFlightRecorderRequest& request,
+                                    connecttool::DumpFlightRecorderResponse* reply);
+
+    asio::io_context& io_;
+    ConnectToolCore* core_;
+    StatsSampler* sampler_;
+
+    connecttool::ConnectToolService::AsyncService service_;
+    std::unique_ptr<grpc::ServerCompletionQueue> cq_;
+    std::unique_ptr<grpc::Server> server_;
+    std::unique_ptr<std::thread> pollThread_;
+    std::atomic<bool> draining_;
+
+    // 修改 TUN MTU 会阻塞（netsh），SetConfig 在此线程上执行该步骤；同一时间只允许一个修改
+    std::unique_ptr<std::thread> configThread_;
+    bool configPending_ = false;  // 仅在事件循环线程访问
+};
+
+#endif // ASYNC_RPC_SERVER_H
@@ -2,7 +2,8 @@
 #include <iostream>
 #include <algorithm>
 
-ConnectToolCore::ConnectToolCore() {
+ConnectToolCore::ConnectToolCore()
+    : snapshot(std::make_shared<const CoreSnapshot>()) {
 }
 
 ConnectToolCore::~ConnectToolCore() {
@@ -26,20 +27,27 @@ bool ConnectToolCore::initSteam() {
     roomManager = std::make_unique<SteamRoomManager>(steamManager.get());
     steamManager->setRoomManager(roomManager.get());
     
-    vpnBridge = std::make_unique<SteamVpnBridge>(steamManager.get());
+    vpnBridge = std::make_unique<SteamVpnBridge>(steamManager->getTransport());
     steamManager->setVpnBridge(vpnBridge.get());
 
     steamManager->startMessageHandler();
     steamInitialized = true;
+    refreshSnapshot();
     return true;
 }
 
 void ConnectToolCore::shutdown() {
+    // 先停止接收线程，之后不会再有消息进入 VPN 桥的接收队列
+    if (steamManager) {
+        steamManager->stopMessageHandler();
+    }
     if (vpnBridge) {
+        // 销毁 VPN 桥会把接收队列中的消息归还传输层，必须在传输层和 Steam API 关闭之前完成
         vpnBridge->stop();
+        if (steamManager) steamManager->setVpnBridge(nullptr);
+        vpnBridge.reset();
     }
     if (steamManager) {
-        steamManager->stopMessageHandler();
         steamManager->shutdown();
         steamManager.reset();
     }
@@ -52,7 +60,87 @@ void ConnectToolCore::shutdown() {
 void ConnectToolCore::update() {
     if (steamInitialized) {
         SteamAPI_RunCallbacks();
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastPeerStatsSample >= kPeerStatsInterval) {
+            lastPeerStatsSample = now;
+            samplePeerStats();
+        }
+        if (now - lastSnapshot >= kSnapshotInterval) {
+            lastSnapshot = now;
+            refreshSnapshot();
+        }
+    }
+}
+
+void ConnectToolCore::refreshSnapshot() {
+    std::shared_ptr<const CoreSnapshot> previous = getSnapshot();
+    auto next = std::make_shared<CoreSnapshot>();
+    next->takenAt = std::chrono::steady_clock::now();
+    next->timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    std::vector<CSteamID> memberIds;
+    next->inLobby = isInLobby();
+    if (next->inLobby) {
+        next->lobbyId = getCurrentLobbyId();
+        memberIds = getLobbyMembers();
+    }
+
+    uint32_t routeGeneration = vpnBridge ? vpnBridge->getRouteGeneration() : 0;
+    if (memberDetailsDue(*previous, *next, memberIds, routeGeneration)) {
+        lastMemberDetails = next->takenAt;
+        lastRouteGeneration = routeGeneration;
+        for (const auto& memberID : memberIds) {
+            CoreSnapshot::Member member;
+            member.steamId = memberID;
+            member.name = SteamFriends() ? SteamFriends()->GetFriendPersonaName(memberID) : "";
+            member.connection = getMemberConnectionInfo(memberID);
+            next->members.push_back(std::move(member));
+        }
+        next->routes = getVPNRoutingTable();
+    } else {
+        next->members = previous->members;
+        next->routes = previous->routes;
+    }
+
+    next->vpnEnabled = isVPNEnabled();
+    next->localIP = getLocalVPNIP();
+    next->localIPv6 = getLocalVPNIPv6();
+    next->tunDeviceName = getTunDeviceName();
+    next->vpnStats = getVPNStatistics();
+    next->receivePoll = getReceivePollStatistics();
+    next->peers = getPeerStatistics();
+    if (steamManager) {
+        next->directUdpEnabled = steamManager->getDirectUdpStatistics(next->directUdp);
+        next->socketsBackend = steamManager->getSocketsStatistics(next->sockets);
+    }
+
+    std::atomic_store(&snapshot, std::shared_ptr<const CoreSnapshot>(std::move(next)));
+}
+
+bool ConnectToolCore::memberDetailsDue(const CoreSnapshot& previous, const CoreSnapshot& next,
+                                       const std::vector<CSteamID>& memberIds, uint32_t routeGeneration) const {
+    if (liveMemberDetails.load(std::memory_order_relaxed)) return true;
+    if (next.takenAt - lastMemberDetails >= kPeerStatsInterval) return true;
+    if (routeGeneration != lastRouteGeneration) return true;
+    if (next.inLobby != previous.inLobby || next.lobbyId != previous.lobbyId) return true;
+    if (memberIds.size() != previous.members.size()) return true;
+    for (size_t i = 0; i < memberIds.size(); ++i) {
+        if (memberIds[i] != previous.members[i].steamId) return true;
+    }
+    return false;
+}
+
+void ConnectToolCore::samplePeerStats() {
+    if (!vpnBridge || !steamManager || !isInLobby()) return;
+
+    CSteamID self = SteamUser() ? SteamUser()->GetSteamID() : CSteamID();
+    for (const auto& memberID : getLobbyMembers()) {
+        if (memberID == self) continue;
+        vpnBridge->updatePeerLink(memberID, steamManager->getPeerLinkMetrics(memberID));
     }
+    vpnBridge->samplePeerRates();
 }
 
 bool ConnectToolCore::createLobby(std::string& outLobbyId) {
@@ -127,27 +215,145 @@ std::string ConnectToolCore::getLocalVPNIP() const {
     return "";
 }
 
+std::string ConnectToolCore::getLocalVPNIPv6() const {
+    if (vpnBridge) return vpnBridge->getLocalIPv6();
+    return "";
+}
+
 std::string ConnectToolCore::getTunDeviceName() const {
     if (vpnBridge) return vpnBridge->getTunDeviceName();
     return "";
 }
 
+int ConnectToolCore::getTunMtu() const {
+    if (vpnBridge) return vpnBridge->getTunMtu();
+    return 0;
+}
+
 SteamVpnBridge::Statistics ConnectToolCore::getVPNStatistics() const {
     if (vpnBridge) return vpnBridge->getStatistics();
     return {};
 }
 
+SteamMessageHandler::PollStatistics ConnectToolCore::getReceivePollStatistics() const {
+    if (steamManager && steamManager->getMessageHandler()) {
+        return steamManager->getMessageHandler()->getPollStatistics();
+    }
+    return {};
+}
+
 std::map<uint32_t, RouteEntry> ConnectToolCore::getVPNRoutingTable() const {
     if (vpnBridge) return vpnBridge->getRoutingTable();
     return {};
 }
+
+std::vector<PeerStatsTable::Snapshot> ConnectToolCore::getPeerStatistics() const {
+    if (vpnBridge) return vpnBridge->getPeerStatistics();
+    return {};
+}
+
+void ConnectToolCore::setPacketTraceSampleEvery(uint32_t every) {
+    if (vpnBridge) vpnBridge->setTraceSampleEvery(every);
+    // Keep the published config in line, SetConfig starts from it
+    AppConfig config = ConfigManager::instance().getConfig();
+    config.networking.packet_trace_sample_every = static_cast<int>(std::min<uint32_t>(every, INT32_MAX));
+    ConfigManager::instance().update(config);
+}
+
+uint32_t ConnectToolCore::getPacketTraceSampleEvery() const {
+    if (vpnBridge) return vpnBridge->getTraceSampleEvery();
+    return 0;
+}
+
+std::string ConnectToolCore::dumpPacketTrace(bool clear, size_t* eventCount) {
+    if (!vpnBridge) {
+        *eventCount = 0;
+        return "";
+    }
+    CSteamID self = SteamUser() ? SteamUser()->GetSteamID() : CSteamID();
+    return vpnBridge->dumpPacketTrace(self.ConvertToUint64(), clear, eventCount);
+}
+
+std::string ConnectToolCore::dumpFlightRecorder(size_t* recordCount) {
+    if (!vpnBridge) {
+        *recordCount = 0;
+        return "";
+    }
+    return vpnBridge->dumpFlightRecorder(recordCount);
+}
+
+int ConnectToolCore::openCapture(const CaptureFilter& filter, uint32_t snaplen) {
+    if (!vpnBridge) return -1;
+    return vpnBridge->openCapture(filter, snaplen);
+}
+
+void ConnectToolCore::closeCapture(int session) {
+    if (vpnBridge) vpnBridge->closeCapture(session);
+}
+
+size_t ConnectToolCore::pollCapture(int session, PacketCapture::Record* out, size_t maxRecords, uint64_t* dropped) {
+    if (!vpnBridge) {
+        *dropped = 0;
+        return 0;
+    }
+    return vpnBridge->pollCapture(session, out, maxRecords, dropped);
+}
+
+bool ConnectToolCore::applyConfig(const AppConfig& config, std::string& error) {
+    if (!ConfigManager::validateLive(config, error)) return false;
+
+    ConfigManager& configManager = ConfigManager::instance();
+    const AppConfig& current = configManager.getConfig();
+
+    // The only step that can fail goes first, so a rejected change leaves everything as it was
+    if (vpnBridge && config.vpn.default_mtu != current.vpn.default_mtu &&
+        vpnBridge->reconfigureMtu(config.vpn.default_mtu) < 0) {
+        error = "Failed to set TUN device MTU";
+        return false;
+    }
+
+    const auto& net = config.networking;
+    const auto& old = current.networking;
+    if (steamManager && (net.send_rate_mb != old.send_rate_mb || net.send_buffer_size_mb != old.send_buffer_size_mb ||
+                         net.nagle_time != old.nagle_time)) {
+        steamManager->applySteamConfig(config);
+    }
+    if (vpnBridge) {
+        vpnBridge->setRxInFlightLimit(static_cast<size_t>(net.rx_inflight_limit_kb) * 1024);
+        if (net.packet_trace_sample_every != old.packet_trace_sample_every) {
+            vpnBridge->setTraceSampleEvery(static_cast<uint32_t>(net.packet_trace_sample_every));
+        }
+    }
+
+    configManager.update(config);
+    std::cout << "[ConnectToolCore] Configuration updated" << std::endl;
+    return true;
+}
+
+int ConnectToolCore::pendingTunMtu(const AppConfig& config) {
+    if (!vpnBridge || config.vpn.default_mtu == ConfigManager::instance().getConfig().vpn.default_mtu) return 0;
+    return vpnBridge->pendingTunMtu(config.vpn.default_mtu);
+}
+
+bool ConnectToolCore::setTunDeviceMtu(int mtu) {
+    return vpnBridge && vpnBridge->setTunDeviceMtu(mtu);
+}
+
 ConnectToolCore::MemberConnectionInfo ConnectToolCore::getMemberConnectionInfo(const CSteamID& memberID) {
     int ping = 0;
     std::string relayInfo = "-";
+    int latencySavedMs = 0;
 
     if (steamManager) {
         ping = steamManager->getPeerPing(memberID);
         relayInfo = steamManager->getPeerConnectionType(memberID);
+
+        DirectUdpTransport::PeerPathInfo path;
+        if (steamManager->getPeerPathInfo(memberID, path) &&
+            path.kind != DirectUdpTransport::PathKind::Steam && path.directRttMs >= 0) {
+            ping = path.directRttMs;
+            latencySavedMs = path.latencySavedMs;
+        }
     }
-    return {ping, relayInfo};
+    return {ping, relayInfo, latencySavedMs};
 }
@@ -1,15 +1,19 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
 #include <mutex>
+#include <chrono>
 
 #include "../steam/steam_networking_manager.h"
 #include "../steam/steam_room_manager.h"
 #include "../steam/steam_vpn_bridge.h"
 #include "../steam/steam_utils.h"
 
+struct CoreSnapshot;
+
 class ConnectToolCore {
 public:
     ConnectToolCore();
@@ -34,21 +38,115 @@ public:
     // VPN Monitoring
     bool isVPNEnabled() const;
     std::string getLocalVPNIP() const;
+    std::string getLocalVPNIPv6() const;
     std::string getTunDeviceName() const;
+    int getTunMtu() const;     // 0 when the VPN is not running
     SteamVpnBridge::Statistics getVPNStatistics() const;
+    SteamMessageHandler::PollStatistics getReceivePollStatistics() const;
     std::map<uint32_t, RouteEntry> getVPNRoutingTable() const;
+    std::vector<PeerStatsTable::Snapshot> getPeerStatistics() const;
+
+    // Sampled packet tracing (0 disables), dumped in Chrome trace format
+    void setPacketTraceSampleEvery(uint32_t every);
+    uint32_t getPacketTraceSampleEvery() const;
+    std::string dumpPacketTrace(bool clear, size_t* eventCount);
+
+    // Recent packet headers from the always-on flight recorder, as pcapng
+    std::string dumpFlightRecorder(size_t* recordCount);
+
+    // Live packet capture sessions; openCapture returns -1 when none is free
+    int openCapture(const CaptureFilter& filter, uint32_t snaplen);
+    void closeCapture(int session);
+    size_t pollCapture(int session, PacketCapture::Record* out, size_t maxRecords, uint64_t* dropped);
+
+    // Validates the live-changeable settings of config, applies them (Steam
+    // global config, TUN MTU, receive budget, trace sampling) and publishes it.
+    // Poll and backpressure settings are picked up from the published config by
+    // the data path threads. On failure nothing is published and error says why.
+    bool applyConfig(const AppConfig& config, std::string& error);
+
+    // Changing the TUN MTU blocks (netsh on Windows), so callers on the event
+    // loop can do it first on another thread: pendingTunMtu returns the MTU the
+    // device has to be switched to for config (0 if none), setTunDeviceMtu sets
+    // it. applyConfig then finds nothing left to change. Leaving the lobby waits
+    // for a running setTunDeviceMtu; shutdown() must not run concurrently with it.
+    int pendingTunMtu(const AppConfig& config);
+    bool setTunDeviceMtu(int mtu);
 
     // Helper to get connection info for a member
     struct MemberConnectionInfo {
-        int ping;
+        int ping;               // 当前路径的 RTT（直连时为直连 RTT）
         std::string relayInfo;
+        int latencySavedMs;     // 直连相对 Steam 节省的 RTT
     };
     MemberConnectionInfo getMemberConnectionInfo(const CSteamID& memberID);
 
+    // Latest published state, safe to call from any thread without locking.
+    // Refreshed by update() every kSnapshotInterval; never null.
+    std::shared_ptr<const CoreSnapshot> getSnapshot() const { return std::atomic_load(&snapshot); }
+
+    // Member details and routes cost Steam calls per member, so they are only
+    // rebuilt when the lobby or routes change and once per kPeerStatsInterval.
+    // While live, every refresh rebuilds them (set by the stats sampler while it
+    // has subscribers). Safe to call from any thread.
+    void setLiveMemberDetails(bool live) { liveMemberDetails.store(live, std::memory_order_relaxed); }
+
 private:
+    static constexpr std::chrono::milliseconds kSnapshotInterval{100};
+    void refreshSnapshot();
+    bool memberDetailsDue(const CoreSnapshot& previous, const CoreSnapshot& next,
+                          const std::vector<CSteamID>& memberIds, uint32_t routeGeneration) const;
+
+    // Link metrics are polled from Steam once per interval, not per packet
+    static constexpr std::chrono::seconds kPeerStatsInterval{1};
+    void samplePeerStats();
+
     std::unique_ptr<SteamNetworkingManager> steamManager;
     std::unique_ptr<SteamRoomManager> roomManager;
     std::unique_ptr<SteamVpnBridge> vpnBridge;
 
     bool steamInitialized = false;
+    std::chrono::steady_clock::time_point lastPeerStatsSample;
+    std::chrono::steady_clock::time_point lastSnapshot;
+    std::chrono::steady_clock::time_point lastMemberDetails;
+    uint32_t lastRouteGeneration = 0;
+    std::atomic<bool> liveMemberDetails{false};
+
+    // Swapped with std::atomic_store, read with std::atomic_load
+    std::shared_ptr<const CoreSnapshot> snapshot;
+};
+
+/**
+ * Immutable view of the core's lobby, VPN and statistics state.
+ *
+ * Built on the Steam callback thread and published as a whole, so readers
+ * (RPC handlers, the stats sampler) never take core locks or call into Steam.
+ */
+struct CoreSnapshot {
+    struct Member {
+        CSteamID steamId;
+        std::string name;
+        ConnectToolCore::MemberConnectionInfo connection;
+    };
+
+    std::chrono::steady_clock::time_point takenAt;
+    int64_t timestampMs = 0;    // Unix time
+
+    bool inLobby = false;
+    CSteamID lobbyId;
+    std::vector<Member> members;
+
+    bool vpnEnabled = false;
+    std::string localIP;
+    std::string localIPv6;
+    std::string tunDeviceName;
+    SteamVpnBridge::Statistics vpnStats{};
+    SteamMessageHandler::PollStatistics receivePoll{};
+    std::map<uint32_t, RouteEntry> routes;
+    std::vector<PeerStatsTable::Snapshot> peers;
+
+    bool directUdpEnabled = false;
+    DirectUdpTransport::Statistics directUdp{};
+    bool socketsBackend = false;
+    SteamSocketsTransport::Statistics sockets{};
 };
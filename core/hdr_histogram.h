@@ -0,0 +1,168 @@
+#ifndef HDR_HISTOGRAM_H
+#define HDR_HISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+ * @brief 对数-线性分桶的高动态范围直方图（纳秒）
+ *
+ * 小于 2^kSubBucketBits 的值精确记录；之后每个 2 倍区间分为 kSubBucketHalf 个等宽桶，
+ * 相对误差小于 1/kSubBucketHalf（约 3%）。范围上限 2^kMaxMagnitude ns（约 18 分钟），更大的值计入最后一个桶。
+ *
+ * 单写者：record 只用 relaxed load/store，不使用原子读改写，
+ * 每个实例只能由一个线程记录；任意线程都可以通过 snapshot 读取近似一致的副本。
+ */
+class HdrHistogram {
+public:
+    static constexpr int kSubBucketBits = 6;
+    static constexpr int kSubBucketCount = 1 << kSubBucketBits;
+    static constexpr int kSubBucketHalf = kSubBucketCount / 2;
+    static constexpr int kMaxMagnitude = 40;
+    static constexpr int kBucketCount = kSubBucketCount + (kMaxMagnitude - kSubBucketBits) * kSubBucketHalf;
+
+    /**
+     * @brief 直方图副本，可合并多个线程的数据
+     */
+    struct Snapshot {
+        std::vector<uint64_t> counts = std::vector<uint64_t>(kBucketCount, 0);
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t max = 0;
+
+        void merge(const Snapshot& other) {
+            for (int i = 0; i < kBucketCount; ++i) {
+                counts[i] += other.counts[i];
+            }
+            count += other.count;
+            sum += other.sum;
+            max = std::max(max, other.max);
+        }
+
+        /**
+         * @brief 最小值（所在桶的下界）
+         */
+        uint64_t min() const {
+            for (int i = 0; i < kBucketCount; ++i) {
+                if (counts[i]) return lowestValue(i);
+            }
+            return 0;
+        }
+
+        /**
+         * @brief 百分位数（所在桶的上界，不超过最大值），p 取 0~100
+         */
+        uint64_t valueAtPercentile(double p) const {
+            uint64_t total = totalCount();
+            if (total == 0) return 0;
+            uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(total));
+            if (rank >= total) rank = total - 1;
+            uint64_t seen = 0;
+            for (int i = 0; i < kBucketCount; ++i) {
+                seen += counts[i];
+                if (seen > rank) return std::min(highestValue(i), max);
+            }
+            return max;
+        }
+
+        /**
+         * @brief 小于 limit 的样本数（limit 为 2 的幂时是精确值）
+         */
+        uint64_t countBelow(uint64_t limit) const {
+            uint64_t below = 0;
+            for (int i = 0; i < kBucketCount && highestValue(i) < limit; ++i) {
+                below += counts[i];
+            }
+            return below;
+        }
+
+        // 计数器为 relaxed 读取，以各桶之和为准
+        uint64_t totalCount() const {
+            uint64_t total = 0;
+            for (uint64_t c : counts) total += c;
+            return total;
+        }
+
+        double mean() const {
+            return count ? static_cast<double>(sum) / static_cast<double>(count) : 0.0;
+        }
+    };
+
+    void record(uint64_t value) {
+        bump(counts_[indexFor(value)], 1);
+        bump(count_, 1);
+        bump(sum_, value);
+        if (value > max_.load(std::memory_order_relaxed)) {
+            max_.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    Snapshot snapshot() const {
+        Snapshot snapshot;
+        addTo(snapshot);
+        return snapshot;
+    }
+
+    /**
+     * @brief 将当前计数累加到 snapshot（合并多个线程时避免临时副本）
+     */
+    void addTo(Snapshot& snapshot) const {
+        for (int i = 0; i < kBucketCount; ++i) {
+            snapshot.counts[i] += counts_[i].load(std::memory_order_relaxed);
+        }
+        snapshot.count += count_.load(std::memory_order_relaxed);
+        snapshot.sum += sum_.load(std::memory_order_relaxed);
+        snapshot.max = std::max(snapshot.max, max_.load(std::memory_order_relaxed));
+    }
+
+    static int indexFor(uint64_t value) {
+        if (value < static_cast<uint64_t>(kSubBucketCount)) return static_cast<int>(value);
+        int magnitude = highestBit(value);
+        if (magnitude >= kMaxMagnitude) return kBucketCount - 1;
+        int shift = magnitude - (kSubBucketBits - 1);
+        return kSubBucketCount + (magnitude - kSubBucketBits) * kSubBucketHalf +
+               static_cast<int>(value >> shift) - kSubBucketHalf;
+    }
+
+    static uint64_t lowestValue(int index) {
+        if (index < kSubBucketCount) return static_cast<uint64_t>(index);
+        int offset = index - kSubBucketCount;
+        int shift = offset / kSubBucketHalf + 1;
+        return static_cast<uint64_t>(offset % kSubBucketHalf + kSubBucketHalf) << shift;
+    }
+
+    static uint64_t highestValue(int index) {
+        if (index < kSubBucketCount) return static_cast<uint64_t>(index);
+        int shift = (index - kSubBucketCount) / kSubBucketHalf + 1;
+        return lowestValue(index) + (static_cast<uint64_t>(1) << shift) - 1;
+    }
+
+private:
+    static void bump(std::atomic<uint64_t>& counter, uint64_t delta) {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    static int highestBit(uint64_t value) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return static_cast<int>(index);
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    std::array<std::atomic<uint64_t>, kBucketCount> counts_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+#endif // HDR_HISTOGRAM_H
@@ -0,0 +1,105 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+ * @brief 以 2 的幂分桶的延迟直方图（微秒）
+ *
+ * 桶 0 记录 0us，桶 i（i >= 1）记录 [2^(i-1), 2^i) us，最后一个桶收纳更大的值。
+ * 记录端无锁（relaxed 原子操作），读取端通过 snapshot 获取近似一致的副本。
+ */
+class LatencyHistogram {
+public:
+    static constexpr int kBucketCount = 32;
+
+    /**
+     * @brief 直方图副本
+     */
+    struct Snapshot {
+        std::array<uint64_t, kBucketCount> counts{};
+        uint64_t count = 0;
+        uint64_t sumUs = 0;
+        uint64_t maxUs = 0;
+
+        /**
+         * @brief 桶的上界（不含）
+         */
+        static uint64_t bucketUpperBoundUs(int bucket) {
+            return static_cast<uint64_t>(1) << bucket;
+        }
+
+        /**
+         * @brief 百分位数（返回所在桶的上界，不超过最大值），p 取 0~100
+         */
+        uint64_t percentileUs(double p) const {
+            if (count == 0) return 0;
+            uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(count));
+            if (rank >= count) rank = count - 1;
+            uint64_t seen = 0;
+            for (int i = 0; i < kBucketCount; ++i) {
+                seen += counts[i];
+                if (seen > rank) return std::min(bucketUpperBoundUs(i), maxUs);
+            }
+            return maxUs;
+        }
+
+        double meanUs() const {
+            return count ? static_cast<double>(sumUs) / static_cast<double>(count) : 0.0;
+        }
+    };
+
+    void record(uint64_t us) {
+        counts_[bucketFor(us)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sumUs_.fetch_add(us, std::memory_order_relaxed);
+        uint64_t max = maxUs_.load(std::memory_order_relaxed);
+        while (us > max && !maxUs_.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+        }
+    }
+
+    Snapshot snapshot() const {
+        Snapshot snapshot;
+        for (int i = 0; i < kBucketCount; ++i) {
+            snapshot.counts[i] = counts_[i].load(std::memory_order_relaxed);
+        }
+        snapshot.count = count_.load(std::memory_order_relaxed);
+        snapshot.sumUs = sumUs_.load(std::memory_order_relaxed);
+        snapshot.maxUs = maxUs_.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    void reset() {
+        for (auto& bucket : counts_) bucket.store(0, std::memory_order_relaxed);
+        count_.store(0, std::memory_order_relaxed);
+        sumUs_.store(0, std::memory_order_relaxed);
+        maxUs_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static int bucketFor(uint64_t us) {
+        if (us == 0) return 0;
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, us);
+        int bucket = static_cast<int>(index) + 1;
+#else
+        int bucket = 64 - __builtin_clzll(us);
+#endif
+        return bucket < kBucketCount ? bucket : kBucketCount - 1;
+    }
+
+    std::array<std::atomic<uint64_t>, kBucketCount> counts_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sumUs_{0};
+    std::atomic<uint64_t> maxUs_{0};
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -0,0 +1,580 @@
+#include "metrics_exporter.h"
+#include "connect_tool_core.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdio>
+#include <iostream>
+#include <string_view>
+
+namespace {
+
+    // 单个连接等待完整请求的时间
+    constexpr std::chrono::seconds kRequestTimeout{5};
+    constexpr size_t kMaxRequestSize = 8192;
+
+    // 编译期拼接的指标族头部
+#define METRIC_HEADER(name, type, help) "# HELP " name " " help "\n# TYPE " name " " type "\n"
+    // 只有一个样本的指标：头部 + 指标名，后面直接跟值
+#define METRIC_SCALAR(name, type, help) METRIC_HEADER(name, type, help) name " "
+
+    template <typename Stats>
+    struct ScalarMetric {
+        std::string_view prefix;
+        uint64_t Stats::*field;
+    };
+
+    using BridgeStats = SteamVpnBridge::Statistics;
+    const ScalarMetric<BridgeStats> kBridgeMetrics[] = {
+        {METRIC_SCALAR("connecttool_vpn_packets_sent_total", "counter", "IP packets sent to peers."),
+         &BridgeStats::packetsSent},
+        {METRIC_SCALAR("connecttool_vpn_packets_received_total", "counter", "IP packets received from peers."),
+         &BridgeStats::packetsReceived},
+        {METRIC_SCALAR("connecttool_vpn_bytes_sent_total", "counter", "IP bytes sent to peers."),
+         &BridgeStats::bytesSent},
+        {METRIC_SCALAR("connecttool_vpn_bytes_received_total", "counter", "IP bytes received from peers."),
+         &BridgeStats::bytesReceived},
+        {METRIC_SCALAR("connecttool_vpn_packets_dropped_total", "counter", "Packets dropped by the bridge."),
+         &BridgeStats::packetsDropped},
+        {METRIC_SCALAR("connecttool_vpn_tcp_mss_clamped_total", "counter", "TCP SYN segments with a clamped MSS."),
+         &BridgeStats::tcpMssClamped},
+        {METRIC_SCALAR("connecttool_vpn_oversize_packets_total", "counter", "Packets larger than the tunnel MTU."),
+         &BridgeStats::oversizePackets},
+        {METRIC_SCALAR("connecttool_vpn_icmp_frag_needed_sent_total", "counter",
+                       "Locally generated ICMP fragmentation-needed / packet-too-big replies."),
+         &BridgeStats::icmpFragNeededSent},
+        {METRIC_SCALAR("connecttool_vpn_ipv6_unroutable_total", "counter", "IPv6 packets without a route."),
+         &BridgeStats::ipv6Unroutable},
+        {METRIC_SCALAR("connecttool_vpn_flow_cache_hits_total", "counter", "Forwarding decision cache hits."),
+         &BridgeStats::flowCacheHits},
+        {METRIC_SCALAR("connecttool_vpn_flow_cache_misses_total", "counter", "Forwarding decision cache misses."),
+         &BridgeStats::flowCacheMisses},
+        {METRIC_SCALAR("connecttool_tun_rx_queue_drops_total", "counter", "Inbound packets dropped on a full TUN write queue."),
+         &BridgeStats::rxQueueDrops},
+        {METRIC_SCALAR("connecttool_tun_rx_queue_depth", "gauge", "Packets waiting in the TUN write queue."),
+         &BridgeStats::rxQueueDepth},
+        {METRIC_SCALAR("connecttool_tun_rx_queue_high_water", "gauge", "Highest TUN write queue occupancy."),
+         &BridgeStats::rxQueueHighWater},
+        {METRIC_SCALAR("connecttool_tun_rx_queue_capacity", "gauge", "TUN write queue capacity."),
+         &BridgeStats::rxQueueCapacity},
+        {METRIC_SCALAR("connecttool_tun_write_batches_total", "counter", "Batched TUN writes."),
+         &BridgeStats::tunWriteBatches},
+        {METRIC_SCALAR("connecttool_rx_inflight_bytes", "gauge", "Received bytes not yet written to TUN."),
+         &BridgeStats::rxInFlightBytes},
+        {METRIC_SCALAR("connecttool_rx_inflight_peak_bytes", "gauge", "Peak received bytes not yet written to TUN."),
+         &BridgeStats::rxInFlightPeakBytes},
+        {METRIC_SCALAR("connecttool_rx_inflight_limit_bytes", "gauge", "In-flight receive budget."),
+         &BridgeStats::rxInFlightLimitBytes},
+        {METRIC_SCALAR("connecttool_rx_inflight_rejected_total", "counter",
+                       "Inbound packets dropped over the in-flight receive budget."),
+         &BridgeStats::rxInFlightRejected},
+    };
+
+    using PollStats = SteamMessageHandler::PollStatistics;
+    const ScalarMetric<PollStats> kPollMetrics[] = {
+        {METRIC_SCALAR("connecttool_receive_wakeups_total", "counter", "Receive poll wakeups."),
+         &PollStats::wakeups},
+        {METRIC_SCALAR("connecttool_receive_empty_polls_total", "counter", "Receive poll wakeups without messages."),
+         &PollStats::emptyPolls},
+        {METRIC_SCALAR("connecttool_receive_messages_total", "counter", "Messages received from the transport."),
+         &PollStats::messages},
+        {METRIC_SCALAR("connecttool_receive_calls_total", "counter", "Transport receiveBatch calls."),
+         &PollStats::receiveCalls},
+        {METRIC_SCALAR("connecttool_receive_budget_exhausted_total", "counter",
+                       "Receive poll wakeups that ran out of time with messages pending."),
+         &PollStats::budgetExhausted},
+    };
+
+    using DirectStats = DirectUdpTransport::Statistics;
+    const ScalarMetric<DirectStats> kDirectUdpMetrics[] = {
+        {METRIC_SCALAR("connecttool_direct_udp_packets_sent_total", "counter", "Packets sent over direct UDP."),
+         &DirectStats::directPacketsSent},
+        {METRIC_SCALAR("connecttool_direct_udp_packets_received_total", "counter", "Packets received over direct UDP."),
+         &DirectStats::directPacketsReceived},
+        {METRIC_SCALAR("connecttool_direct_udp_bytes_sent_total", "counter", "Bytes sent over direct UDP."),
+         &DirectStats::directBytesSent},
+        {METRIC_SCALAR("connecttool_direct_udp_bytes_received_total", "counter", "Bytes received over direct UDP."),
+         &DirectStats::directBytesReceived},
+        {METRIC_SCALAR("connecttool_direct_udp_fallback_packets_total", "counter",
+                       "IP packets sent through Steam for lack of a direct path."),
+         &DirectStats::fallbackPacketsSent},
+        {METRIC_SCALAR("connecttool_direct_udp_invalid_datagrams_total", "counter", "Datagrams with a bad token or format."),
+         &DirectStats::invalidDatagrams},
+        {METRIC_SCALAR("connecttool_direct_udp_paths_established_total", "counter", "Direct paths established."),
+         &DirectStats::pathsEstablished},
+        {METRIC_SCALAR("connecttool_direct_udp_paths_lost_total", "counter", "Direct paths lost."),
+         &DirectStats::pathsLost},
+        {METRIC_SCALAR("connecttool_lan_beacons_sent_total", "counter", "LAN discovery beacons sent."),
+         &DirectStats::beaconsSent},
+        {METRIC_SCALAR("connecttool_lan_beacons_received_total", "counter", "LAN discovery beacons received."),
+         &DirectStats::beaconsReceived},
+        {METRIC_SCALAR("connecttool_lan_peers_verified_total", "counter", "Peers confirmed to share the LAN."),
+         &DirectStats::lanPeersVerified},
+    };
+
+    using SocketsStats = SteamSocketsTransport::Statistics;
+    const ScalarMetric<SocketsStats> kSocketsMetrics[] = {
+        {METRIC_SCALAR("connecttool_steam_messages_sent_total", "counter", "Messages sent on Steam connections."),
+         &SocketsStats::messagesSent},
+        {METRIC_SCALAR("connecttool_steam_messages_received_total", "counter", "Messages received on Steam connections."),
+         &SocketsStats::messagesReceived},
+        {METRIC_SCALAR("connecttool_steam_send_batches_total", "counter", "SendMessages calls."),
+         &SocketsStats::sendBatches},
+        {METRIC_SCALAR("connecttool_steam_send_failures_total", "counter", "Messages rejected by SendMessages."),
+         &SocketsStats::sendFailures},
+        {METRIC_SCALAR("connecttool_steam_allocation_failures_total", "counter", "AllocateMessage failures."),
+         &SocketsStats::allocationFailures},
+        {METRIC_SCALAR("connecttool_steam_connections_opened_total", "counter", "Steam connections opened."),
+         &SocketsStats::connectionsOpened},
+        {METRIC_SCALAR("connecttool_steam_connections_closed_total", "counter", "Steam connections closed."),
+         &SocketsStats::connectionsClosed},
+    };
+
+    void appendUint(std::string& out, uint64_t value) {
+        char buffer[24];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+
+    // 微秒值以秒输出，不经过浮点格式化
+    void appendSeconds(std::string& out, uint64_t us) {
+        appendUint(out, us / 1000000);
+        char frac[8];
+        std::snprintf(frac, sizeof(frac), ".%06u", static_cast<unsigned>(us % 1000000));
+        out += frac;
+    }
+
+    void appendNanoseconds(std::string& out, uint64_t ns) {
+        appendUint(out, ns / 1000000000);
+        char frac[12];
+        std::snprintf(frac, sizeof(frac), ".%09u", static_cast<unsigned>(ns % 1000000000));
+        out += frac;
+    }
+
+    void appendFixed(std::string& out, double value, int precision) {
+        char buffer[48];
+        int length = std::snprintf(buffer, sizeof(buffer), "%.*f", precision, value);
+        if (length > 0) out.append(buffer, std::min<size_t>(length, sizeof(buffer) - 1));
+    }
+
+    void appendEscaped(std::string& out, const std::string& value) {
+        for (char c : value) {
+            if (c == '\\' || c == '"') {
+                out += '\\';
+                out += c;
+            } else if (c == '\n') {
+                out += "\\n";
+            } else {
+                out += c;
+            }
+        }
+    }
+
+    template <typename Stats, size_t N>
+    void appendScalars(std::string& out, const ScalarMetric<Stats> (&metrics)[N], const Stats& stats) {
+        for (const auto& metric : metrics) {
+            out += metric.prefix;
+            appendUint(out, stats.*metric.field);
+            out += '\n';
+        }
+    }
+
+    void appendQueueDelay(std::string& out, const LatencyHistogram::Snapshot& histogram) {
+        static const auto kBucketLabels = []() {
+            // 桶 i 记录 [2^(i-1), 2^i) us，最后一个桶并入 +Inf
+            std::array<std::string, LatencyHistogram::kBucketCount - 1> labels;
+            for (size_t i = 0; i < labels.size(); ++i) {
+                std::string label = "connecttool_receive_queue_delay_seconds_bucket{le=\"";
+                appendSeconds(label, LatencyHistogram::Snapshot::bucketUpperBoundUs(static_cast<int>(i)));
+                label += "\"} ";
+                labels[i] = std::move(label);
+            }
+            return labels;
+        }();
+
+        out += METRIC_HEADER("connecttool_receive_queue_delay_seconds", "histogram",
+                             "Time received messages waited before the poll picked them up.");
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < kBucketLabels.size(); ++i) {
+            cumulative += histogram.counts[i];
+            out += kBucketLabels[i];
+            appendUint(out, cumulative);
+            out += '\n';
+        }
+        // 计数器为 relaxed 读取，_count 与 +Inf 取各桶之和以保持一致
+        cumulative += histogram.counts[LatencyHistogram::kBucketCount - 1];
+        out += "connecttool_receive_queue_delay_seconds_bucket{le=\"+Inf\"} ";
+        appendUint(out, cumulative);
+        out += "\nconnecttool_receive_queue_delay_seconds_sum ";
+        appendSeconds(out, histogram.sumUs);
+        out += "\nconnecttool_receive_queue_delay_seconds_count ";
+        appendUint(out, cumulative);
+        out += '\n';
+    }
+
+    void appendStageTimings(std::string& out, const StageTimings::Snapshot& stages) {
+        // 2^7 ns（128 ns）到 2^26 ns（约 67 ms）；HDR 桶边界落在 2 的幂上，累计值是精确的
+        constexpr int kFirstBound = 7;
+        constexpr int kLastBound = 26;
+        static const auto kBoundLabels = []() {
+            std::array<std::string, kLastBound - kFirstBound + 1> labels;
+            for (int k = kFirstBound; k <= kLastBound; ++k) {
+                std::string label = ",le=\"";
+                appendNanoseconds(label, static_cast<uint64_t>(1) << k);
+                label += "\"} ";
+                labels[k - kFirstBound] = std::move(label);
+            }
+            return labels;
+        }();
+
+        out += METRIC_HEADER("connecttool_stage_duration_seconds", "histogram", "Data path stage latency, by stage.");
+        for (size_t stage = 0; stage < stages.size(); ++stage) {
+            const auto& histogram = stages[stage];
+            std::string label = "{stage=\"";
+            label += stageName(static_cast<DataPathStage>(stage));
+            label += '"';
+
+            int index = 0;
+            uint64_t cumulative = 0;
+            for (int k = kFirstBound; k <= kLastBound; ++k) {
+                uint64_t limit = static_cast<uint64_t>(1) << k;
+                while (index < HdrHistogram::kBucketCount && HdrHistogram::highestValue(index) < limit) {
+                    cumulative += histogram.counts[index++];
+                }
+                out += "connecttool_stage_duration_seconds_bucket";
+                out += label;
+                out += kBoundLabels[k - kFirstBound];
+                appendUint(out, cumulative);
+                out += '\n';
+            }
+            uint64_t total = histogram.totalCount();
+            out += "connecttool_stage_duration_seconds_bucket";
+            out += label;
+            out += ",le=\"+Inf\"} ";
+            appendUint(out, total);
+            out += "\nconnecttool_stage_duration_seconds_sum";
+            out += label;
+            out += "} ";
+            appendNanoseconds(out, histogram.sum);
+            out += "\nconnecttool_stage_duration_seconds_count";
+            out += label;
+            out += "} ";
+            appendUint(out, total);
+            out += '\n';
+        }
+    }
+
+    const char* pathLabel(PeerLinkMetrics::Path path) {
+        switch (path) {
+            case PeerLinkMetrics::Path::Steam: return "steam";
+            case PeerLinkMetrics::Path::Relayed: return "relay";
+            case PeerLinkMetrics::Path::DirectUdp: return "direct_udp";
+            case PeerLinkMetrics::Path::Lan: return "lan";
+            case PeerLinkMetrics::Path::Unknown: break;
+        }
+        return "unknown";
+    }
+
+    const char* dropReasonLabel(size_t reason) {
+        switch (static_cast<PeerDropReason>(reason)) {
+            case PeerDropReason::Backpressure: return "backpressure";
+            case PeerDropReason::SendFailed: return "send_failed";
+            case PeerDropReason::RxQueueFull: return "rx_queue_full";
+            case PeerDropReason::RxInFlightLimit: return "rx_inflight_limit";
+            case PeerDropReason::Count: break;
+        }
+        return "unknown";
+    }
+
+    void appendPeers(std::string& out, const CoreSnapshot& snapshot) {
+        const auto& peers = snapshot.peers;
+        if (peers.empty()) return;
+
+        // 每个节点的标签只格式化一次，供所有指标族复用
+        std::vector<std::string> labels;
+        labels.reserve(peers.size());
+        for (const auto& peer : peers) {
+            std::string label = "{peer=\"";
+            appendUint(label, peer.steamId);
+            label += '"';
+            labels.push_back(std::move(label));
+        }
+
+        // 同一指标族的样本必须连续输出
+        auto counter = [&](std::string_view header, std::string_view name, uint64_t PeerStatsTable::Snapshot::*field) {
+            out += header;
+            for (size_t i = 0; i < peers.size(); ++i) {
+                out += name;
+                out += labels[i];
+                out += "} ";
+                appendUint(out, peers[i].*field);
+                out += '\n';
+            }
+        };
+        counter(METRIC_HEADER("connecttool_peer_tx_packets_total", "counter", "IP packets sent to the peer."),
+                "connecttool_peer_tx_packets_total", &PeerStatsTable::Snapshot::txPackets);
+        counter(METRIC_HEADER("connecttool_peer_tx_bytes_total", "counter", "IP bytes sent to the peer."),
+                "connecttool_peer_tx_bytes_total", &PeerStatsTable::Snapshot::txBytes);
+        counter(METRIC_HEADER("connecttool_peer_rx_packets_total", "counter", "IP packets received from the peer."),
+                "connecttool_peer_rx_packets_total", &PeerStatsTable::Snapshot::rxPackets);
+        counter(METRIC_HEADER("connecttool_peer_rx_bytes_total", "counter", "IP bytes received from the peer."),
+                "connecttool_peer_rx_bytes_total", &PeerStatsTable::Snapshot::rxBytes);
+
+        out += METRIC_HEADER("connecttool_peer_drops_total", "counter", "Packets to or from the peer dropped, by reason.");
+        for (size_t i = 0; i < peers.size(); ++i) {
+            for (size_t reason = 0; reason < static_cast<size_t>(PeerDropReason::Count); ++reason) {
+                out += "connecttool_peer_drops_total";
+                out += labels[i];
+                out += ",reason=\"";
+                out += dropReasonLabel(reason);
+                out += "\"} ";
+                appendUint(out, peers[i].drops[reason]);
+                out += '\n';
+            }
+        }
+
+        out += METRIC_HEADER("connecttool_peer_connected", "gauge", "Whether a session with the peer is up.");
+        for (size_t i = 0; i < peers.size(); ++i) {
+            out += "connecttool_peer_connected";
+            out += labels[i];
+            out += peers[i].link.connected ? "} 1\n" : "} 0\n";
+        }
+
+        out += METRIC_HEADER("connecttool_peer_path", "gauge", "Path currently used to reach the peer.");
+        for (size_t i = 0; i < peers.size(); ++i) {
+            out += "connecttool_peer_path";
+            out += labels[i];
+            out += ",path=\"";
+            out += pathLabel(peers[i].link.path);
+            out += "\"} 1\n";
+        }
+
+        // 未知的值（-1）不输出样本
+        out += METRIC_HEADER("connecttool_peer_ping_seconds", "gauge", "Round-trip time to the peer.");
+        for (size_t i = 0; i < peers.size(); ++i) {
+            if (peers[i].link.ping < 0) continue;
+            out += "connecttool_peer_ping_seconds";
+            out += labels[i];
+            out += "} ";
+            appendSeconds(out, static_cast<uint64_t>(peers[i].link.ping) * 1000);
+            out += '\n';
+        }
+
+        auto quality = [&](std::string_view header, std::string_view name, float PeerLinkMetrics::*field) {
+            out += header;
+            for (size_t i = 0; i < peers.size(); ++i) {
+                float value = peers[i].link.*field;
+                if (value < 0.0f) continue;
+                out += name;
+                out += labels[i];
+                out += "} ";
+                appendFixed(out, value, 3);
+                out += '\n';
+            }
+        };
+        quality(METRIC_HEADER("connecttool_peer_quality_local", "gauge", "Fraction of packets delivered, local view."),
+                "connecttool_peer_quality_local", &PeerLinkMetrics::qualityLocal);
+        quality(METRIC_HEADER("connecttool_peer_quality_remote", "gauge", "Fraction of packets delivered, remote view."),
+                "connecttool_peer_quality_remote", &PeerLinkMetrics::qualityRemote);
+
+        out += METRIC_HEADER("connecttool_peer_pending_bytes", "gauge", "Bytes queued for sending to the peer.");
+        for (size_t i = 0; i < peers.size(); ++i) {
+            out += "connecttool_peer_pending_bytes";
+            out += labels[i];
+            out += "} ";
+            appendUint(out, static_cast<uint64_t>(std::max(0, peers[i].link.pendingBytes)));
+            out += '\n';
+        }
+
+        out += METRIC_HEADER("connecttool_peer_info", "gauge", "Peer display name.");
+        for (size_t i = 0; i < peers.size(); ++i) {
+            for (const auto& member : snapshot.members) {
+                if (member.steamId.ConvertToUint64() != peers[i].steamId) continue;
+                out += "connecttool_peer_info";
+                out += labels[i];
+                out += ",name=\"";
+                appendEscaped(out, member.name);
+                out += "\"} 1\n";
+                break;
+            }
+        }
+    }
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+// HTTP 连接
+// ---------------------------------------------------------------------------
+
+class MetricsExporter::Session : public std::enable_shared_from_this<Session> {
+public:
+    Session(MetricsExporter& exporter, asio::ip::tcp::socket socket)
+        : exporter_(exporter)
+        , socket_(std::move(socket))
+        , timer_(socket_.get_executor())
+        , request_(kMaxRequestSize) {}
+
+    void start() {
+        auto self = shared_from_this();
+        timer_.expires_after(kRequestTimeout);
+        timer_.async_wait([self](const asio::error_code& ec) {
+            if (!ec) self->close();
+        });
+        asio::async_read_until(socket_, request_, "\r\n\r\n",
+            [self](const asio::error_code& ec, size_t) {
+                if (ec) {
+                    self->close();
+                    return;
+                }
+                self->respond();
+            });
+    }
+
+private:
+    void respond() {
+        std::istream stream(&request_);
+        std::string method, target;
+        stream >> method >> target;
+
+        std::string_view path(target);
+        path = path.substr(0, path.find('?'));
+        if (method == "GET" && path == "/metrics") {
+            body_ = exporter_.render();
+            header_ = "HTTP/1.1 200 OK\r\n"
+                      "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n";
+        } else {
+            body_ = std::make_shared<const std::string>("Not Found\n");
+            header_ = "HTTP/1.1 404 Not Found\r\n"
+                      "Content-Type: text/plain; charset=utf-8\r\n";
+        }
+        header_ += "Content-Length: ";
+        appendUint(header_, body_->size());
+        header_ += "\r\nConnection: close\r\n\r\n";
+
+        auto self = shared_from_this();
+        std::array<asio::const_buffer, 2> buffers{asio::buffer(header_), asio::buffer(*body_)};
+        asio::async_write(socket_, buffers, [self](const asio::error_code&, size_t) {
+            self->close();
+        });
+    }
+
+    void close() {
+        asio::error_code ignored;
+        timer_.cancel();
+        socket_.shutdown(asio::ip::tcp::socket::shutdown_both, ignored);
+        socket_.close(ignored);
+    }
+
+    MetricsExporter& exporter_;
+    asio::ip::tcp::socket socket_;
+    asio::steady_timer timer_;
+    asio::streambuf request_;
+    std::string header_;
+    std::shared_ptr<const std::string> body_;
+};
+
+// ---------------------------------------------------------------------------
+// MetricsExporter
+// ---------------------------------------------------------------------------
+
+MetricsExporter::MetricsExporter(asio::io_context& io, ConnectToolCore* core)
+    : io_(io)
+    , core_(core)
+    , acceptor_(io) {
+}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+bool MetricsExporter::start(uint16_t port) {
+    asio::error_code ec;
+    asio::ip::tcp::endpoint endpoint(asio::ip::address_v4::loopback(), port);
+    acceptor_.open(endpoint.protocol(), ec);
+    if (!ec) acceptor_.set_option(asio::ip::tcp::acceptor::reuse_address(true), ec);
+    if (!ec) acceptor_.bind(endpoint, ec);
+    if (!ec) acceptor_.listen(asio::socket_base::max_listen_connections, ec);
+    if (ec) {
+        std::cerr << "[MetricsExporter] Failed to listen on 127.0.0.1:" << port << ": " << ec.message() << std::endl;
+        asio::error_code ignored;
+        acceptor_.close(ignored);
+        return false;
+    }
+
+    std::cout << "[MetricsExporter] Serving metrics on http://127.0.0.1:" << port << "/metrics" << std::endl;
+    accept();
+    return true;
+}
+
+void MetricsExporter::stop() {
+    asio::error_code ignored;
+    acceptor_.close(ignored);
+}
+
+void MetricsExporter::accept() {
+    acceptor_.async_accept([this](const asio::error_code& ec, asio::ip::tcp::socket socket) {
+        if (ec == asio::error::operation_aborted || !acceptor_.is_open()) return;
+        if (!ec) {
+            std::make_shared<Session>(*this, std::move(socket))->start();
+        }
+        accept();
+    });
+}
+
+std::shared_ptr<const std::string> MetricsExporter::render() {
+    auto snapshot = core_->getSnapshot();
+    if (snapshot != renderedSnapshot_ || !body_) {
+        // 分阶段直方图在渲染时按需合并
+        std::unique_ptr<StageTimings::Snapshot> stages;
+        if (StageTimings::enabled()) {
+            stages = std::make_unique<StageTimings::Snapshot>(StageTimings::instance().snapshot());
+        }
+        body_ = std::make_shared<const std::string>(
+            renderSnapshot(*snapshot, stages.get(), body_ ? body_->size() : 0));
+        renderedSnapshot_ = std::move(snapshot);
+    }
+    return body_;
+}
+
+std::string MetricsExporter::renderSnapshot(const CoreSnapshot& snapshot, const StageTimings::Snapshot* stages,
+                                            size_t sizeHint) {
+    std::string out;
+    out.reserve(sizeHint ? sizeHint + sizeHint / 8 : 16 * 1024);
+
+    out += METRIC_SCALAR("connecttool_vpn_enabled", "gauge", "Whether the VPN bridge is running.");
+    out += snapshot.vpnEnabled ? "1\n" : "0\n";
+    out += METRIC_SCALAR("connecttool_lobby_members", "gauge", "Members in the current lobby.");
+    appendUint(out, snapshot.members.size());
+    out += '\n';
+
+    appendScalars(out, kBridgeMetrics, snapshot.vpnStats);
+
+    const auto& poll = snapshot.receivePoll;
+    appendScalars(out, kPollMetrics, poll);
+    out += METRIC_SCALAR("connecttool_receive_poll_seconds_total", "counter", "Time spent in receive polls.");
+    appendSeconds(out, poll.totalPollTimeUs);
+    out += '\n';
+    out += METRIC_SCALAR("connecttool_receive_poll_max_seconds", "gauge", "Longest single receive poll.");
+    appendSeconds(out, poll.maxPollTimeUs);
+    out += '\n';
+    out += METRIC_SCALAR("connecttool_receive_batch_size", "gauge", "Current receive batch size.");
+    appendUint(out, static_cast<uint64_t>(std::max(0, poll.batchSize)));
+    out += '\n';
+    out += METRIC_SCALAR("connecttool_receive_busy_poll", "gauge", "Whether the receive path busy-polls.");
+    out += poll.busyPoll ? "1\n" : "0\n";
+    appendQueueDelay(out, poll.queueDelay);
+
+    if (snapshot.directUdpEnabled) {
+        appendScalars(out, kDirectUdpMetrics, snapshot.directUdp);
+    }
+    if (snapshot.socketsBackend) {
+        appendScalars(out, kSocketsMetrics, snapshot.sockets);
+    }
+
+    if (stages) {
+        appendStageTimings(out, *stages);
+    }
+
+    appendPeers(out, snapshot);
+    return out;
+}
@@ -0,0 +1,69 @@
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <asio.hpp>
+
+#include "stage_timing.h"
+
+class ConnectToolCore;
+struct CoreSnapshot;
+
+/**
+ * @brief Prometheus 文本格式（0.0.4）抓取端点
+ *
+ * 在 127.0.0.1 上监听 HTTP，GET /metrics 返回桥接器、TUN 写队列、接收轮询、
+ * 传输层、数据路径各阶段延迟以及每个节点的计数器/仪表/直方图。
+ *
+ * 渲染只读取 ConnectToolCore 发布的快照，不访问数据面、不加锁；
+ * 指标族的 HELP/TYPE 头在编译期拼好，快照未更新时直接复用上一次的结果。
+ * 所有操作都在事件循环线程上执行。
+ */
+class MetricsExporter {
+public:
+    MetricsExporter(asio::io_context& io, ConnectToolCore* core);
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    /**
+     * @brief 在 127.0.0.1:port 上开始监听
+     * @return true 成功，false 失败
+     */
+    bool start(uint16_t port);
+
+    /**
+     * @brief 停止接受新连接
+     */
+    void stop();
+
+    /**
+     * @brief 渲染当前快照（同一快照只渲染一次）
+     */
+    std::shared_ptr<const std::string> render();
+
+    /**
+     * @brief 将快照渲染为 Prometheus 文本格式
+     * @param stages 分阶段延迟，nullptr 表示不输出
+     * @param sizeHint 用于预留容量
+     */
+    static std::string renderSnapshot(const CoreSnapshot& snapshot, const StageTimings::Snapshot* stages = nullptr,
+                                      size_t sizeHint = 0);
+
+private:
+    class Session;
+
+    void accept();
+
+    asio::io_context& io_;
+    ConnectToolCore* core_;
+    asio::ip::tcp::acceptor acceptor_;
+
+    std::shared_ptr<const CoreSnapshot> renderedSnapshot_;
+    std::shared_ptr<const std::string> body_;
+};
+
+#endif // METRICS_EXPORTER_H
@@ -0,0 +1,109 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/**
+ * @brief 无锁单生产者/单消费者环形队列
+ *
+ * 只允许一个线程调用 tryPush、一个线程调用 popBatch。容量向上取整为 2 的幂。
+ * 元素以移动方式进出队列，可以存放只能移动的类型（如 MessageHandle）。
+ * 生产者和消费者各自缓存对方的索引，只有在缓存显示队列满/空时才读取对方的原子变量，
+ * 两端的索引放在不同的缓存行上，避免伪共享。
+ */
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) {
+        size_t rounded = 1;
+        while (rounded < capacity) rounded <<= 1;
+        slots_.reset(new T[rounded]);
+        mask_ = rounded - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /**
+     * @brief 放入一个元素（生产者线程）
+     * @return false 表示队列已满
+     */
+    bool tryPush(const T& item) {
+        if (!hasRoom()) return false;
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        slots_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 移入一个元素（生产者线程），队列已满时 item 保持不变
+     */
+    bool tryPush(T&& item) {
+        if (!hasRoom()) return false;
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        slots_[tail & mask_] = std::move(item);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 取出最多 maxItems 个元素（消费者线程）
+     * @return 取出的元素数量
+     */
+    size_t popBatch(T* out, size_t maxItems) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (cachedTail_ == head) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (cachedTail_ == head) return 0;
+        }
+        size_t count = std::min(cachedTail_ - head, maxItems);
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = std::move(slots_[(head + i) & mask_]);
+        }
+        head_.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    /**
+     * @brief 当前元素数量（任意线程，近似值）
+     */
+    size_t size() const {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    static constexpr size_t kCacheLine = 64;
+
+    bool hasRoom() {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cachedHead_ > mask_) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail - cachedHead_ > mask_) return false;
+        }
+        return true;
+    }
+
+    std::unique_ptr<T[]> slots_;
+    size_t mask_;
+
+    // 消费者端
+    alignas(kCacheLine) std::atomic<size_t> head_{0};
+    size_t cachedTail_ = 0;
+
+    // 生产者端
+    alignas(kCacheLine) std::atomic<size_t> tail_{0};
+    size_t cachedHead_ = 0;
+};
+
+#endif // SPSC_RING_H
@@ -0,0 +1,60 @@
+#include "stage_timing.h"
+
+const char* stageName(DataPathStage stage) {
+    switch (stage) {
+        case DataPathStage::TxClassify: return "tx_classify";
+        case DataPathStage::TxRoute: return "tx_route";
+        case DataPathStage::TxSend: return "tx_send";
+        case DataPathStage::TxFlush: return "tx_flush";
+        case DataPathStage::RxReceive: return "rx_receive";
+        case DataPathStage::RxDispatch: return "rx_dispatch";
+        case DataPathStage::RxQueueWait: return "rx_queue_wait";
+        case DataPathStage::RxTunWrite: return "rx_tun_write";
+        case DataPathStage::Count: break;
+    }
+    return "unknown";
+}
+
+StageTimings& StageTimings::instance() {
+    static StageTimings inst;
+    return inst;
+}
+
+StageTimings::ThreadHistograms* StageTimings::local() {
+    // 线程退出时归还，直方图本身由 StageTimings 持有
+    struct Lease {
+        ThreadHistograms* histograms = nullptr;
+        ~Lease() {
+            if (histograms) histograms->owned.store(false, std::memory_order_release);
+        }
+    };
+    thread_local Lease lease;
+    if (!lease.histograms) {
+        lease.histograms = acquire();
+    }
+    return lease.histograms;
+}
+
+StageTimings::ThreadHistograms* StageTimings::acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& histograms : threads_) {
+        bool expected = false;
+        if (histograms->owned.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return histograms.get();
+        }
+    }
+    threads_.push_back(std::make_unique<ThreadHistograms>());
+    threads_.back()->owned.store(true, std::memory_order_relaxed);
+    return threads_.back().get();
+}
+
+StageTimings::Snapshot StageTimings::snapshot() const {
+    Snapshot merged;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& histograms : threads_) {
+        for (size_t i = 0; i < kStageCount; ++i) {
+            histograms->stages[i].addTo(merged[i]);
+        }
+    }
+    return merged;
+}
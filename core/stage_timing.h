@@ -0,0 +1,121 @@
+#ifndef STAGE_TIMING_H
+#define STAGE_TIMING_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "hdr_histogram.h"
+
+/**
+ * @brief 数据路径上计时的阶段
+ *
+ * 发送：TUN 读取线程；接收：轮询线程（RxReceive、RxDispatch）和 TUN 写线程（RxQueueWait、RxTunWrite）。
+ */
+enum class DataPathStage : uint8_t {
+    TxClassify = 0,     // 一批 TUN 读取的头部解析（每批）
+    TxRoute,            // MSS 钳制、超大包检查、转发决策（每包）
+    TxSend,             // 发送调用，不含背压等待（每包，广播为一次调用）
+    TxFlush,            // 传输层 flush（每批）
+    RxReceive,          // 收到消息的 receiveBatch 调用（每次调用）
+    RxDispatch,         // handleVpnMessage 中入队前的处理（每包）
+    RxQueueWait,        // 在接收队列中等待 TUN 写线程（每包）
+    RxTunWrite,         // TUN 批量写入（每批）
+    Count
+};
+
+const char* stageName(DataPathStage stage);
+
+/**
+ * @brief 按线程记录、按需合并的分阶段延迟直方图
+ *
+ * 每个记录线程第一次记录时领取一组独占的 HdrHistogram（线程退出后归还，供之后的线程复用，
+ * 计数继续累加），因此记录端只有单写者的 relaxed 操作；snapshot() 合并所有线程的数据。
+ *
+ * 使用 STAGE_SCOPE / STAGE_TIMESTAMP / STAGE_RECORD_SINCE 宏记录；
+ * 未定义 CONNECTTOOL_STAGE_TIMING 时这些宏为空，数据路径上没有任何计时代码。
+ */
+class StageTimings {
+public:
+    static constexpr size_t kStageCount = static_cast<size_t>(DataPathStage::Count);
+    using Snapshot = std::array<HdrHistogram::Snapshot, kStageCount>;
+
+    static StageTimings& instance();
+
+    /**
+     * @brief 编译时是否启用了分阶段计时
+     */
+    static constexpr bool enabled() {
+#ifdef CONNECTTOOL_STAGE_TIMING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static uint64_t now() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    void record(DataPathStage stage, uint64_t ns) {
+        local()->stages[static_cast<size_t>(stage)].record(ns);
+    }
+
+    /**
+     * @brief 合并所有线程的直方图（控制路径）
+     */
+    Snapshot snapshot() const;
+
+private:
+    struct ThreadHistograms {
+        std::array<HdrHistogram, kStageCount> stages;
+        std::atomic<bool> owned{false};
+    };
+
+    StageTimings() = default;
+    ThreadHistograms* local();
+    ThreadHistograms* acquire();
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadHistograms>> threads_;
+};
+
+/**
+ * @brief 作用域计时：析构时记录经过的时间
+ */
+class StageScope {
+public:
+    explicit StageScope(DataPathStage stage)
+        : stage_(stage)
+        , start_(StageTimings::now()) {}
+    ~StageScope() {
+        StageTimings::instance().record(stage_, StageTimings::now() - start_);
+    }
+
+    StageScope(const StageScope&) = delete;
+    StageScope& operator=(const StageScope&) = delete;
+
+private:
+    DataPathStage stage_;
+    uint64_t start_;
+};
+
+#ifdef CONNECTTOOL_STAGE_TIMING
+#define STAGE_TIMING_CONCAT_(a, b) a##b
+#define STAGE_TIMING_CONCAT(a, b) STAGE_TIMING_CONCAT_(a, b)
+#define STAGE_SCOPE(stage) StageScope STAGE_TIMING_CONCAT(stageScope_, __LINE__)(stage)
+#define STAGE_TIMESTAMP(var) const uint64_t var = StageTimings::now()
+#define STAGE_RECORD_SINCE(stage, var) StageTimings::instance().record(stage, StageTimings::now() - (var))
+#else
+#define STAGE_SCOPE(stage) ((void)0)
+#define STAGE_TIMESTAMP(var) ((void)0)
+#define STAGE_RECORD_SINCE(stage, var) ((void)0)
+#endif
+
+#endif // STAGE_TIMING_H
@@ -0,0 +1,133 @@
+#include "stats_sampler.h"
+#include <algorithm>
+
+constexpr std::chrono::milliseconds StatsSampler::kMinInterval;
+constexpr std::chrono::milliseconds StatsSampler::kMaxInterval;
+
+StatsSampler::Subscription::Subscription(StatsSampler& sampler, std::chrono::milliseconds interval)
+    : sampler_(sampler)
+    , interval_(interval) {
+    sampler_.addSubscriber(interval_);
+}
+
+StatsSampler::Subscription::~Subscription() {
+    sampler_.removeSubscriber(interval_);
+}
+
+StatsSampler::StatsSampler(asio::io_context& io, ConnectToolCore* core)
+    : timer_(io)
+    , core_(core) {
+}
+
+StatsSampler::~StatsSampler() {
+    timer_.cancel();
+}
+
+std::chrono::milliseconds StatsSampler::clampInterval(uint32_t intervalMs) {
+    if (intervalMs == 0) return std::chrono::milliseconds(1000);
+    return std::clamp(std::chrono::milliseconds(intervalMs), kMinInterval, kMaxInterval);
+}
+
+void StatsSampler::addSubscriber(std::chrono::milliseconds interval) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        intervals_.insert(interval.count());
+        core_->setLiveMemberDetails(true);
+    }
+    // Give the new watcher a sample right away and pick up a possibly shorter interval
+    asio::post(timer_.get_executor(), [this]() {
+        bool fresh;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            fresh = latest_ && std::chrono::steady_clock::now() - latest_->sampledAt < kMinInterval;
+        }
+        if (!fresh) takeSample();
+        scheduleNext();
+    });
+}
+
+void StatsSampler::removeSubscriber(std::chrono::milliseconds interval) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = intervals_.find(interval.count());
+    if (it != intervals_.end()) intervals_.erase(it);
+    if (intervals_.empty()) core_->setLiveMemberDetails(false);
+}
+
+void StatsSampler::scheduleNext() {
+    int64_t intervalMs;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (intervals_.empty()) return;  // 没有订阅者，停止采样
+        intervalMs = *intervals_.begin();
+    }
+    timer_.expires_after(std::chrono::milliseconds(intervalMs));
+    timer_.async_wait([this](const asio::error_code& ec) {
+        if (ec) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (intervals_.empty()) return;
+        }
+        takeSample();
+        scheduleNext();
+    });
+}
+
+void StatsSampler::takeSample() {
+    auto snapshot = core_->getSnapshot();
+    {
+        // Nothing new since the last sample
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (latest_ && latest_->sampledAt == snapshot->takenAt) return;
+    }
+
+    auto sample = std::make_shared<Sample>();
+    sample->sampledAt = snapshot->takenAt;
+    sample->timestampMs = snapshot->timestampMs;
+    sample->vpnEnabled = snapshot->vpnEnabled;
+    sample->vpn = snapshot->vpnStats;
+
+    for (const auto& member : snapshot->members) {
+        PeerSample peer;
+        peer.steamId = member.steamId.ConvertToUint64();
+        peer.name = member.name;
+        peer.ping = member.connection.ping;
+        peer.relayInfo = member.connection.relayInfo;
+        peer.latencySavedMs = member.connection.latencySavedMs;
+        sample->peers.push_back(std::move(peer));
+    }
+    std::sort(sample->peers.begin(), sample->peers.end(),
+              [](const PeerSample& a, const PeerSample& b) { return a.steamId < b.steamId; });
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sample->sequence = ++sequence_;
+        latest_ = std::move(sample);
+    }
+}
+
+std::shared_ptr<const StatsSampler::Sample> StatsSampler::latest() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return latest_;
+}
+
+SteamVpnBridge::Statistics StatsSampler::counterDelta(const SteamVpnBridge::Statistics& current,
+                                                      const SteamVpnBridge::Statistics& previous) {
+    auto sub = [](uint64_t now, uint64_t before) { return now >= before ? now - before : now; };
+
+    SteamVpnBridge::Statistics delta = current;
+    delta.packetsSent = sub(current.packetsSent, previous.packetsSent);
+    delta.packetsReceived = sub(current.packetsReceived, previous.packetsReceived);
+    delta.bytesSent = sub(current.bytesSent, previous.bytesSent);
+    delta.bytesReceived = sub(current.bytesReceived, previous.bytesReceived);
+    delta.packetsDropped = sub(current.packetsDropped, previous.packetsDropped);
+    delta.tcpMssClamped = sub(current.tcpMssClamped, previous.tcpMssClamped);
+    delta.oversizePackets = sub(current.oversizePackets, previous.oversizePackets);
+    delta.icmpFragNeededSent = sub(current.icmpFragNeededSent, previous.icmpFragNeededSent);
+    delta.ipv6Unroutable = sub(current.ipv6Unroutable, previous.ipv6Unroutable);
+    delta.flowCacheHits = sub(current.flowCacheHits, previous.flowCacheHits);
+    delta.flowCacheMisses = sub(current.flowCacheMisses, previous.flowCacheMisses);
+    delta.rxQueueDrops = sub(current.rxQueueDrops, previous.rxQueueDrops);
+    delta.tunWriteBatches = sub(current.tunWriteBatches, previous.tunWriteBatches);
+    delta.rxInFlightRejected = sub(current.rxInFlightRejected, previous.rxInFlightRejected);
+    return delta;
+}
@@ -0,0 +1,106 @@
+#ifndef STATS_SAMPLER_H
+#define STATS_SAMPLER_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include <asio.hpp>
+
+#include "connect_tool_core.h"
+
+/**
+ * @brief 共享统计采样器
+ *
+ * 在事件循环线程上按订阅者请求的最短间隔读取核心发布的 CoreSnapshot，
+ * 转换为不可变的 shared_ptr 发布，所有订阅者共享同一份采样。
+ * 采样不调用 Steam、不加锁，开销与订阅者数量无关，没有订阅者时停止采样。
+ * 采样频率受快照刷新间隔限制，快照未更新时不发布新采样。
+ * 有订阅者期间，核心每次刷新快照都重建成员信息（名称、延迟、连接类型）。
+ */
+class StatsSampler {
+public:
+    struct PeerSample {
+        uint64_t steamId;
+        std::string name;
+        int ping;
+        std::string relayInfo;
+        int latencySavedMs;
+
+        bool operator==(const PeerSample& other) const {
+            return steamId == other.steamId && ping == other.ping && latencySavedMs == other.latencySavedMs &&
+                   name == other.name && relayInfo == other.relayInfo;
+        }
+        bool operator!=(const PeerSample& other) const { return !(*this == other); }
+    };
+
+    struct Sample {
+        uint64_t sequence;          // 从 1 开始递增
+        int64_t timestampMs;        // Unix 时间（毫秒）
+        std::chrono::steady_clock::time_point sampledAt;
+        bool vpnEnabled;
+        SteamVpnBridge::Statistics vpn;
+        std::vector<PeerSample> peers;  // 按 steamId 排序
+    };
+
+    static constexpr std::chrono::milliseconds kMinInterval{100};
+    static constexpr std::chrono::milliseconds kMaxInterval{60000};
+
+    /**
+     * @brief 订阅期间采样器至少按 interval 采样
+     */
+    class Subscription {
+    public:
+        Subscription(StatsSampler& sampler, std::chrono::milliseconds interval);
+        ~Subscription();
+
+        Subscription(const Subscription&) = delete;
+        Subscription& operator=(const Subscription&) = delete;
+
+    private:
+        StatsSampler& sampler_;
+        std::chrono::milliseconds interval_;
+    };
+
+    StatsSampler(asio::io_context& io, ConnectToolCore* core);
+    ~StatsSampler();
+
+    StatsSampler(const StatsSampler&) = delete;
+    StatsSampler& operator=(const StatsSampler&) = delete;
+
+    /**
+     * @brief 将请求的间隔限制在 [kMinInterval, kMaxInterval]，0 表示 1 秒
+     */
+    static std::chrono::milliseconds clampInterval(uint32_t intervalMs);
+
+    /**
+     * @brief 最新采样（不阻塞），尚未采样时返回 nullptr
+     */
+    std::shared_ptr<const Sample> latest() const;
+
+    /**
+     * @brief 计算两次采样之间的计数器增量
+     * 队列深度、在途字节等瞬时值以及容量/上限保持当前的绝对值；计数器回退时（桥接器重建）取当前值
+     */
+    static SteamVpnBridge::Statistics counterDelta(const SteamVpnBridge::Statistics& current,
+                                                   const SteamVpnBridge::Statistics& previous);
+
+private:
+    void addSubscriber(std::chrono::milliseconds interval);
+    void removeSubscriber(std::chrono::milliseconds interval);
+    void takeSample();
+    void scheduleNext();
+
+    asio::steady_timer timer_;
+    ConnectToolCore* core_;
+
+    mutable std::mutex mutex_;
+    std::multiset<int64_t> intervals_;      // 订阅者请求的间隔（毫秒）
+    std::shared_ptr<const Sample> latest_;
+    uint64_t sequence_ = 0;
+};
+
+#endif // STATS_SAMPLER_H
@@ -1,21 +1,69 @@
 #include "steam_message_handler.h"
-#include "steam_networking_manager.h"
-#include "steam_vpn_bridge.h"
 #include "vpn/vpn_protocol.h"
+#include "core/stage_timing.h"
 #include <iostream>
-#include <cstring>
+#include <algorithm>
 #include <chrono>
-#include <steam_api.h>
-#include <isteamnetworkingmessages.h>
 
-SteamMessageHandler::SteamMessageHandler(ISteamNetworkingMessages* interface, 
-                                         SteamNetworkingManager* manager)
-    : m_pMessagesInterface_(interface)
-    , manager_(manager)
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+    // 将当前线程绑定到指定 CPU
+    bool pinCurrentThread(int cpu) {
+#ifdef _WIN32
+        return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpu) != 0;
+#elif defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)cpu;
+        return false;
+#endif
+    }
+
+    void spinWait(SteamMessageHandler::SpinHint hint) {
+        switch (hint) {
+            case SteamMessageHandler::SpinHint::Pause:
+#if defined(_WIN32)
+                YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#elif defined(__aarch64__)
+                __asm__ __volatile__("yield");
+#endif
+                break;
+            case SteamMessageHandler::SpinHint::Yield:
+                std::this_thread::yield();
+                break;
+            case SteamMessageHandler::SpinHint::None:
+                break;
+        }
+    }
+
+} // anonymous namespace
+
+SteamMessageHandler::SteamMessageHandler(TransportInterface* transport, MessageCallback onMessage)
+    : transport_(transport)
+    , onMessage_(std::move(onMessage))
     , internalIoContext_(std::make_unique<asio::io_context>())
     , ioContext_(internalIoContext_.get())
     , running_(false)
-    , currentPollInterval_(MIN_POLL_INTERVAL) {}
+    , currentPollInterval_(0)
+    , batchSize_(kMinBatchSize)
+    , avgMessagesPerWakeup_(0.0)
+    , busyPoll_(false)
+    , pollStats_{} {
+    refreshPollConfig();
+    currentPollInterval_ = minPollInterval_;
+}
 
 SteamMessageHandler::~SteamMessageHandler() {
     stop();
@@ -27,12 +75,26 @@ void SteamMessageHandler::setIoContext(asio::io_context* externalContext) {
     }
 }
 
+void SteamMessageHandler::setBusyPoll(const BusyPollOptions& options) {
+    if (!running_) {
+        busyPoll_ = true;
+        busyPollOptions_ = options;
+    }
+}
+
 void SteamMessageHandler::start() {
     if (running_) return;
     running_ = true;
     
     std::cout << "[SteamMessageHandler] Starting message handler..." << std::endl;
     
+    if (busyPoll_) {
+        std::cout << "[SteamMessageHandler] Busy-poll mode, spin budget "
+                  << spinBudget_.count() << "us" << std::endl;
+        ioThread_ = std::make_unique<std::thread>(&SteamMessageHandler::busyPollLoop, this);
+        return;
+    }
+    
     // 创建定时器
     pollTimer_ = std::make_unique<asio::steady_timer>(*ioContext_);
     
@@ -89,49 +151,174 @@ void SteamMessageHandler::runInternalLoop() {
     }
 }
 
+void SteamMessageHandler::busyPollLoop() {
+    if (busyPollOptions_.cpu >= 0) {
+        if (pinCurrentThread(busyPollOptions_.cpu)) {
+            std::cout << "[SteamMessageHandler] Receive thread pinned to CPU " << busyPollOptions_.cpu << std::endl;
+        } else {
+            std::cerr << "[SteamMessageHandler] Failed to pin receive thread to CPU " << busyPollOptions_.cpu << std::endl;
+        }
+    }
+    
+    auto lastActivity = std::chrono::steady_clock::now();
+    while (running_) {
+        int numMsgs = 0;
+        try {
+            bool backlog = false;
+            numMsgs = pollMessages(backlog);
+        } catch (const std::exception& e) {
+            std::cerr << "Exception in message handler loop: " << e.what() << std::endl;
+        }
+        
+        auto now = std::chrono::steady_clock::now();
+        if (numMsgs > 0) {
+            lastActivity = now;
+        } else if (now - lastActivity < spinBudget_) {
+            spinWait(spinHint_);
+        } else {
+            // 超出自旋预算：退回到最小轮询间隔
+            std::this_thread::sleep_for(minPollInterval_);
+        }
+    }
+}
+
 void SteamMessageHandler::schedulePoll() {
     if (!running_ || !pollTimer_) return;
     
     pollTimer_->expires_after(currentPollInterval_);
     pollTimer_->async_wait([this](const asio::error_code& ec) {
         if (!ec && running_) {
-            pollMessages();
+            bool backlog = false;
+            pollMessages(backlog);
+            if (backlog) {
+                postBacklogPoll();
+                return;
+            }
             schedulePoll();
         }
     });
 }
 
-void SteamMessageHandler::pollMessages() {
-    if (!m_pMessagesInterface_) return;
-    
-    // 从 ISteamNetworkingMessages 接收消息
-    ISteamNetworkingMessage* pIncomingMsgs[64];
-    int numMsgs = m_pMessagesInterface_->ReceiveMessagesOnChannel(VPN_CHANNEL, pIncomingMsgs, 64);
-    
-    for (int i = 0; i < numMsgs; ++i) {
-        ISteamNetworkingMessage* pIncomingMsg = pIncomingMsgs[i];
-        const uint8_t* data = (const uint8_t*)pIncomingMsg->m_pData;
-        size_t size = pIncomingMsg->m_cbSize;
-        CSteamID senderSteamID = pIncomingMsg->m_identityPeer.GetSteamID();
-
-        // Check if this is a VPN message
-        if (size >= sizeof(VpnMessageHeader)) {
-            // Forward other VPN messages to VPN bridge
-            if (manager_) {
-                SteamVpnBridge* bridge = manager_->getVpnBridge();
-                if (bridge) {
-                    bridge->handleVpnMessage(data, size, senderSteamID);
-                }
+void SteamMessageHandler::postBacklogPoll() {
+    // 仍有积压：让出执行权给其他处理器后立即继续，不经过定时器；取空后才回到定时轮询
+    asio::post(*ioContext_, [this]() {
+        if (!running_) return;
+        bool more = false;
+        pollMessages(more);
+        if (more) {
+            postBacklogPoll();
+        } else {
+            schedulePoll();
+        }
+    });
+}
+
+int SteamMessageHandler::pollMessages(bool& backlog) {
+    backlog = false;
+    if (!transport_) return 0;
+    refreshPollConfig();
+    
+    auto pollStart = std::chrono::steady_clock::now();
+    auto deadline = pollStart + pollTimeBudget_;
+    
+    // 从传输层批量接收消息，直到取空或用完时间预算
+    TransportMessage incoming[kMaxBatchSize];
+    int totalMsgs = 0;
+    int receiveCalls = 0;
+    while (true) {
+        STAGE_TIMESTAMP(receiveStart);
+        int numMsgs = transport_->receiveBatch(incoming, batchSize_);
+        receiveCalls++;
+        // 空轮询不计入，否则忙轮询时会淹没有效样本
+        if (numMsgs > 0) STAGE_RECORD_SINCE(DataPathStage::RxReceive, receiveStart);
+        
+        int64_t nowUs = numMsgs > 0 ? transportTimestampUs() : 0;
+        int toRelease = 0;
+        for (int i = 0; i < numMsgs; ++i) {
+            if (incoming[i].receivedAtUs > 0) {
+                queueDelay_.record(static_cast<uint64_t>(std::max<int64_t>(0, nowUs - incoming[i].receivedAtUs)));
+            }
+
+            // Check if this is a VPN message; the callback may take ownership of the handle
+            if (incoming[i].size >= sizeof(VpnMessageHeader) && onMessage_) {
+                MessageHandle handle(transport_, incoming[i]);
+                onMessage_(handle);
+                if (!handle) continue;
+                handle.detach();
             }
+            incoming[toRelease++] = incoming[i];
         }
+        transport_->release(incoming, toRelease);
+        totalMsgs += numMsgs;
         
-        pIncomingMsg->Release();
+        if (numMsgs == 0) break;
+        if (std::chrono::steady_clock::now() >= deadline) {
+            backlog = true;
+            break;
+        }
     }
     
+    updateBatchSize(totalMsgs);
+    
     // Adaptive polling: 有消息时缩短间隔，无消息时逐渐增加间隔
-    if (numMsgs > 0) {
-        currentPollInterval_ = MIN_POLL_INTERVAL;
+    if (totalMsgs > 0) {
+        currentPollInterval_ = minPollInterval_;
     } else {
-        currentPollInterval_ = std::min(currentPollInterval_ + POLL_INCREMENT, MAX_POLL_INTERVAL);
+        currentPollInterval_ = std::min(currentPollInterval_ + kPollIncrement, maxPollInterval_);
+    }
+    
+    auto elapsedUs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - pollStart).count());
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        pollStats_.wakeups++;
+        if (totalMsgs == 0) pollStats_.emptyPolls++;
+        if (backlog) pollStats_.budgetExhausted++;
+        pollStats_.messages += totalMsgs;
+        pollStats_.receiveCalls += receiveCalls;
+        pollStats_.totalPollTimeUs += elapsedUs;
+        pollStats_.maxPollTimeUs = std::max(pollStats_.maxPollTimeUs, elapsedUs);
+        pollStats_.batchSize = batchSize_;
+    }
+    return totalMsgs;
+}
+
+void SteamMessageHandler::updateBatchSize(int messagesThisWakeup) {
+    // 每次唤醒平均到达量的 EWMA（α = 1/8），批大小取不小于它的 2 的幂
+    avgMessagesPerWakeup_ += (messagesThisWakeup - avgMessagesPerWakeup_) / 8.0;
+    
+    int target = kMinBatchSize;
+    while (target < kMaxBatchSize && target < avgMessagesPerWakeup_) {
+        target *= 2;
+    }
+    batchSize_ = target;
+}
+
+void SteamMessageHandler::refreshPollConfig() {
+    if (!config_.refresh()) return;
+
+    const auto& net = config_->networking;
+    minPollInterval_ = std::chrono::microseconds(net.poll_min_interval_us);
+    maxPollInterval_ = std::chrono::microseconds(std::max(net.poll_max_interval_us, net.poll_min_interval_us));
+    pollTimeBudget_ = std::chrono::microseconds(net.poll_time_budget_us);
+    spinBudget_ = std::chrono::microseconds(net.spin_budget_us);
+    if (net.spin_hint == "yield") {
+        spinHint_ = SpinHint::Yield;
+    } else if (net.spin_hint == "none") {
+        spinHint_ = SpinHint::None;
+    } else {
+        spinHint_ = SpinHint::Pause;
+    }
+    currentPollInterval_ = std::min(std::max(currentPollInterval_, minPollInterval_), maxPollInterval_);
+}
+
+SteamMessageHandler::PollStatistics SteamMessageHandler::getPollStatistics() const {
+    PollStatistics stats;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats = pollStats_;
     }
+    stats.busyPoll = busyPoll_;
+    stats.queueDelay = queueDelay_.snapshot();
+    return stats;
 }
\ No newline at end of file
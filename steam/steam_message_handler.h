@@ -8,24 +8,38 @@
 // 标准库头文件
 #include <atomic>
 #include <chrono>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <thread>
 
 // 第三方库头文件
 #include <asio.hpp>
 
-// Steam 头文件 - 前向声明接口
-class ISteamNetworkingMessages;
-
-// 前向声明
-class SteamNetworkingManager;
+#include "../transport/transport_interface.h"
+#include "../transport/message_handle.h"
+#include "../core/latency_histogram.h"
+#include "../config/config_manager.h"
 
 /**
- * @brief Steam 网络消息处理器（ISteamNetworkingMessages 版本）
+ * @brief Steam 网络消息处理器
+ * 
+ * 从传输层（TransportInterface）批量接收消息并交给回调处理。
  * 
  * 使用 Asio 定时器实现高效的消息轮询，支持自适应轮询间隔：
- * - 有消息时：使用最小轮询间隔 (0.1ms) 保证低延迟
- * - 无消息时：逐步增加轮询间隔，最大到 1ms，减少 CPU 占用
+ * - 有消息时：使用最小轮询间隔（默认 0.1ms）保证低延迟
+ * - 无消息时：逐步增加轮询间隔，最大到最大轮询间隔（默认 1ms），减少 CPU 占用
+ * 
+ * 每次唤醒后持续接收直到传输层取空，或用完单次轮询的时间预算；
+ * 预算用完时立即重新投递轮询，不等待定时器。
+ * 单次接收的批大小按每次唤醒的平均到达量（EWMA）调整。
+ * 
+ * 可选的忙轮询模式（setBusyPoll）：在专用线程（可绑定 CPU）上持续轮询，
+ * 最后一条消息之后自旋一段时间再转为短暂休眠，以 CPU 占用换取更低的首包延迟。
+ * 两种模式都记录接收侧排队延迟（消息到达传输层至交给回调）的直方图。
+ * 
+ * 轮询间隔、时间预算和自旋参数取自已发布的配置（networking.poll_*、spin_*），
+ * 每次唤醒时检查配置是否重新发布，运行中修改无需重启。
  * 
  * 支持两种运行模式：
  * 1. 内部模式：创建独立的 io_context 和运行线程
@@ -33,13 +47,19 @@ class SteamNetworkingManager;
  */
 class SteamMessageHandler {
 public:
+    /**
+     * @brief 消息回调
+     * 回调可以移走句柄以在回调之后继续持有消息（句柄释放时归还给传输层）；
+     * 未移走的消息在回调返回后由处理器批量归还
+     */
+    using MessageCallback = std::function<void(MessageHandle& message)>;
+
     /**
      * @brief 构造函数
-     * @param interface Steam 消息接口指针
-     * @param manager   网络管理器指针
+     * @param transport 传输层指针
+     * @param onMessage 收到 VPN 消息时的回调
      */
-    SteamMessageHandler(ISteamNetworkingMessages* interface, 
-                        SteamNetworkingManager* manager);
+    SteamMessageHandler(TransportInterface* transport, MessageCallback onMessage);
     ~SteamMessageHandler();
 
     // 禁用拷贝和移动
@@ -72,15 +92,61 @@ public:
      */
     bool isRunning() const noexcept { return running_.load(std::memory_order_acquire); }
 
+    /**
+     * @brief 忙轮询时每次空轮询后的提示
+     */
+    enum class SpinHint {
+        None,   // 直接再次轮询
+        Pause,  // CPU pause/yield 指令，降低自旋功耗
+        Yield   // 让出时间片
+    };
+
+    /**
+     * @brief 忙轮询模式参数（自旋时间和提示取自配置，可运行中修改）
+     */
+    struct BusyPollOptions {
+        int cpu = -1;                                   // 绑定的 CPU 编号，-1 表示不绑定
+    };
+
+    /**
+     * @brief 启用忙轮询模式
+     * @note 必须在 start() 之前调用；启用后不使用 io_context，回调在专用线程上执行
+     */
+    void setBusyPoll(const BusyPollOptions& options);
+
+    /**
+     * @brief 轮询效率统计
+     */
+    struct PollStatistics {
+        uint64_t wakeups;           // 轮询唤醒次数
+        uint64_t emptyPolls;        // 没有收到任何消息的唤醒
+        uint64_t messages;          // 收到的消息总数
+        uint64_t receiveCalls;      // receiveBatch 调用次数
+        uint64_t budgetExhausted;   // 用完时间预算、仍有消息待接收的唤醒
+        uint64_t totalPollTimeUs;   // 轮询总耗时（微秒）
+        uint64_t maxPollTimeUs;     // 单次唤醒最长耗时（微秒）
+        int batchSize;              // 当前批大小
+        bool busyPoll;              // 是否为忙轮询模式
+        LatencyHistogram::Snapshot queueDelay;  // 接收侧排队延迟
+    };
+    PollStatistics getPollStatistics() const;
+
 private:
     // 轮询控制
     void schedulePoll();
-    void pollMessages();
+    // 有积压时直接投递下一次轮询，直到取空
+    void postBacklogPoll();
+    // 返回收到的消息数量；backlog 为 true 表示用完时间预算时仍有消息待接收
+    int pollMessages(bool& backlog);
     void runInternalLoop();
+    void busyPollLoop();
+    void updateBatchSize(int messagesThisWakeup);
+    // 配置重新发布后更新轮询参数（接收线程）
+    void refreshPollConfig();
 
-    // Steam 接口
-    ISteamNetworkingMessages* messagesInterface_;
-    SteamNetworkingManager* manager_;
+    // 传输层与消息回调
+    TransportInterface* transport_;
+    MessageCallback onMessage_;
 
     // Asio 组件
     std::unique_ptr<asio::io_context> internalIoContext_;
@@ -91,13 +157,28 @@ private:
     // 状态
     std::atomic<bool> running_{false};
     std::chrono::microseconds currentPollInterval_;
+    int batchSize_;
+    double avgMessagesPerWakeup_;
+    bool busyPoll_;
+    BusyPollOptions busyPollOptions_;
+
+    // 轮询参数，只在接收线程上读写
+    ConfigCache config_;
+    std::chrono::microseconds minPollInterval_{100};
+    std::chrono::microseconds maxPollInterval_{1000};
+    std::chrono::microseconds pollTimeBudget_{500};     // 单次唤醒最多接收的时间
+    std::chrono::microseconds spinBudget_{1000};        // 忙轮询：最后一条消息之后持续自旋的时间
+    SpinHint spinHint_ = SpinHint::Pause;
+
+    // 统计
+    PollStatistics pollStats_;
+    mutable std::mutex statsMutex_;
+    LatencyHistogram queueDelay_;
     
     // 常量
-    static constexpr int kVpnChannel = 0;
-    static constexpr auto kMinPollInterval = std::chrono::microseconds{100};   // 0.1ms
-    static constexpr auto kMaxPollInterval = std::chrono::microseconds{1000};  // 1ms
     static constexpr auto kPollIncrement = std::chrono::microseconds{100};     // 0.1ms
-    static constexpr int kMaxMessagesPerPoll = 64;
+    static constexpr int kMinBatchSize = 16;
+    static constexpr int kMaxBatchSize = 256;
 };
 
 #endif // STEAM_MESSAGE_HANDLER_H
\ No newline at end of file
@@ -1,8 +1,10 @@
 #include "steam_networking_manager.h"
 #include "steam_message_handler.h"
 #include "steam_room_manager.h"
+#include "steam_vpn_bridge.h"
 #include "config/config_manager.h"
 #include <iostream>
+#include <algorithm>
 #include <steam_api.h>
 #include <isteamnetworkingutils.h>
 
@@ -74,35 +76,8 @@ SteamNetworkingManager::~SteamNetworkingManager()
     shutdown();
 }
 
-bool SteamNetworkingManager::initialize()
+void SteamNetworkingManager::applySteamConfig(const AppConfig& config)
 {
-    instance = this;
-    
-    // Steam API should already be initialized before calling this
-    if (!SteamAPI_IsSteamRunning())
-    {
-        std::cerr << "Steam is not running" << std::endl;
-        return false;
-    }
-
-    // 仅输出错误级别日志
-    SteamNetworkingUtils()->SetDebugOutputFunction(k_ESteamNetworkingSocketsDebugOutputType_Error,
-                                                   [](ESteamNetworkingSocketsDebugOutputType nType, const char *pszMsg)
-                                                   {
-                                                       std::cerr << "[SteamNet Error] " << pszMsg << std::endl;
-                                                   });
-
-    // 允许 P2P (ICE) 直连
-    int32 nIceEnable = k_nSteamNetworkingConfig_P2P_Transport_ICE_Enable_Public;
-    SteamNetworkingUtils()->SetConfigValue(
-        k_ESteamNetworkingConfig_P2P_Transport_ICE_Enable,
-        k_ESteamNetworkingConfig_Global,
-        0,
-        k_ESteamNetworkingConfig_Int32,
-        &nIceEnable);
-
-    // 使用配置管理器中的设置
-    const auto& config = ConfigManager::instance().getConfig();
     int32 sendRate = config.networking.send_rate_mb * 1024 * 1024;  // MB/s -> bytes/s
     
     SteamNetworkingUtils()->SetConfigValue(
@@ -139,7 +114,39 @@ bool SteamNetworkingManager::initialize()
 
     std::cout << "[SteamNetworkingManager] Bandwidth optimization: SendRate=" 
               << (sendRate / 1024 / 1024) << " MB/s, SendBufferSize=" 
-              << (sendBufferSize / 1024 / 1024) << " MB" << std::endl;
+              << (sendBufferSize / 1024 / 1024) << " MB, NagleTime=" << nagleTime << "us" << std::endl;
+}
+
+bool SteamNetworkingManager::initialize()
+{
+    instance = this;
+    
+    // Steam API should already be initialized before calling this
+    if (!SteamAPI_IsSteamRunning())
+    {
+        std::cerr << "Steam is not running" << std::endl;
+        return false;
+    }
+
+    // 仅输出错误级别日志
+    SteamNetworkingUtils()->SetDebugOutputFunction(k_ESteamNetworkingSocketsDebugOutputType_Error,
+                                                   [](ESteamNetworkingSocketsDebugOutputType nType, const char *pszMsg)
+                                                   {
+                                                       std::cerr << "[SteamNet Error] " << pszMsg << std::endl;
+                                                   });
+
+    // 允许 P2P (ICE) 直连
+    int32 nIceEnable = k_nSteamNetworkingConfig_P2P_Transport_ICE_Enable_Public;
+    SteamNetworkingUtils()->SetConfigValue(
+        k_ESteamNetworkingConfig_P2P_Transport_ICE_Enable,
+        k_ESteamNetworkingConfig_Global,
+        0,
+        k_ESteamNetworkingConfig_Int32,
+        &nIceEnable);
+
+    // 使用配置管理器中的设置
+    const auto& config = ConfigManager::instance().getConfig();
+    applySteamConfig(config);
 
     // 初始化 relay 网络访问
     SteamNetworkingUtils()->InitRelayNetworkAccess();
@@ -152,8 +159,61 @@ bool SteamNetworkingManager::initialize()
         return false;
     }
 
-    // Initialize message handler
-    messageHandler_ = new SteamMessageHandler(m_pMessagesInterface, this);
+    // Initialize transport and message handler
+    transport_ = std::make_unique<SteamTransport>(this);
+    TransportInterface* baseTransport = transport_.get();
+    if (config.networking.transport_backend == "sockets") {
+        socketsTransport_ = std::make_unique<SteamSocketsTransport>(this);
+        if (socketsTransport_->start()) {
+            baseTransport = socketsTransport_.get();
+        } else {
+            std::cerr << "[SteamNetworkingManager] Falling back to the messages backend" << std::endl;
+            socketsTransport_.reset();
+        }
+    } else if (config.networking.transport_backend != "messages") {
+        std::cerr << "[SteamNetworkingManager] Unknown transport backend '" << config.networking.transport_backend
+                  << "', using messages" << std::endl;
+    }
+    if (config.networking.direct_udp_enabled) {
+        directTransport_ = std::make_unique<DirectUdpTransport>(
+            baseTransport, static_cast<uint16_t>(config.networking.direct_udp_port));
+        if (directTransport_->start()) {
+            baseTransport = directTransport_.get();
+            if (config.networking.lan_discovery_enabled) {
+                directTransport_->startLanDiscovery(static_cast<uint16_t>(config.networking.lan_discovery_port));
+            }
+        } else {
+            directTransport_.reset();
+        }
+    }
+    if (!config.networking.emulation_scenario_file.empty()) {
+        std::vector<NetworkScenario> scenarios;
+        std::string error;
+        if (!NetworkScenario::loadFromFile(config.networking.emulation_scenario_file, scenarios, error)) {
+            std::cerr << "[SteamNetworkingManager] " << error << std::endl;
+            return false;
+        }
+        const std::string& wanted = config.networking.emulation_scenario;
+        auto it = std::find_if(scenarios.begin(), scenarios.end(), [&wanted](const NetworkScenario& s) {
+            return wanted.empty() || s.name == wanted;
+        });
+        if (it == scenarios.end()) {
+            std::cerr << "[SteamNetworkingManager] Emulation scenario not found: " << wanted << std::endl;
+            return false;
+        }
+        emulatedTransport_ = std::make_unique<EmulatedTransport>(baseTransport, *it);
+    }
+    messageHandler_ = new SteamMessageHandler(getTransport(),
+        [this](MessageHandle& message) {
+            if (vpnBridge_) {
+                vpnBridge_->handleVpnMessage(message);
+            }
+        });
+    if (config.networking.receive_mode == "busy_poll") {
+        SteamMessageHandler::BusyPollOptions options;
+        options.cpu = config.networking.busy_poll_cpu;
+        messageHandler_->setBusyPoll(options);
+    }
 
     // Request FakeIP
     // Request 1 port. We don't strictly need ports for VPN tunnel, but it's good practice.
@@ -182,37 +242,13 @@ void SteamNetworkingManager::shutdown()
             m_pMessagesInterface->CloseSessionWithUser(identity);
         }
     }
+    if (socketsTransport_) {
+        socketsTransport_->close();
+    }
     
     SteamAPI_Shutdown();
 }
 
-bool SteamNetworkingManager::sendMessageToUser(CSteamID peerID, const void* data, uint32_t size, int flags)
-{
-    if (!m_pMessagesInterface) return false;
-    
-    SteamNetworkingIdentity identity;
-    identity.SetSteamID(peerID);
-    
-    EResult result = m_pMessagesInterface->SendMessageToUser(identity, data, size, flags, VPN_CHANNEL);
-    return result == k_EResultOK;
-}
-
-void SteamNetworkingManager::broadcastMessage(const void* data, uint32_t size, int flags)
-{
-    if (!m_pMessagesInterface) return;
-    
-    // 实时从房间获取成员列表
-    std::set<CSteamID> members = getRoomMembers();
-    std::cout << "[SteamNetworkingManager] Broadcasting to " << members.size() << " members" << std::endl;
-    
-    for (const auto& memberID : members) {
-        std::cout << "  -> " << memberID.ConvertToUint64() << std::endl;
-        SteamNetworkingIdentity identity;
-        identity.SetSteamID(memberID);
-        m_pMessagesInterface->SendMessageToUser(identity, data, size, flags, VPN_CHANNEL);
-    }
-}
-
 std::set<CSteamID> SteamNetworkingManager::getRoomMembers() const
 {
     if (!roomManager_) return std::set<CSteamID>();
@@ -225,15 +261,21 @@ bool SteamNetworkingManager::isInRoom() const
     return roomManager_->getCurrentLobby().IsValid();
 }
 
-int SteamNetworkingManager::getPeerPing(CSteamID peerID) const
+ESteamNetworkingConnectionState SteamNetworkingManager::getSessionInfo(CSteamID peerID, SteamNetConnectionInfo_t* info,
+                                                                       SteamNetConnectionRealTimeStatus_t* status) const
 {
-    if (!m_pMessagesInterface) return -1;
-    
+    if (socketsTransport_) return socketsTransport_->getConnectionInfo(peerID, info, status);
+    if (!m_pMessagesInterface) return k_ESteamNetworkingConnectionState_None;
+
     SteamNetworkingIdentity identity;
     identity.SetSteamID(peerID);
-    
+    return m_pMessagesInterface->GetSessionConnectionInfo(identity, info, status);
+}
+
+int SteamNetworkingManager::getPeerPing(CSteamID peerID) const
+{
     SteamNetConnectionRealTimeStatus_t status;
-    ESteamNetworkingConnectionState state = m_pMessagesInterface->GetSessionConnectionInfo(identity, nullptr, &status);
+    ESteamNetworkingConnectionState state = getSessionInfo(peerID, nullptr, &status);
     
     if (state == k_ESteamNetworkingConnectionState_Connected) {
         return status.m_nPing;
@@ -243,12 +285,7 @@ int SteamNetworkingManager::getPeerPing(CSteamID peerID) const
 
 bool SteamNetworkingManager::isPeerConnected(CSteamID peerID) const
 {
-    if (!m_pMessagesInterface) return false;
-    
-    SteamNetworkingIdentity identity;
-    identity.SetSteamID(peerID);
-    
-    ESteamNetworkingConnectionState state = m_pMessagesInterface->GetSessionConnectionInfo(identity, nullptr, nullptr);
+    ESteamNetworkingConnectionState state = getSessionInfo(peerID, nullptr, nullptr);
     return state == k_ESteamNetworkingConnectionState_Connected;
 }
 
@@ -256,11 +293,16 @@ std::string SteamNetworkingManager::getPeerConnectionType(CSteamID peerID) const
 {
     if (!m_pMessagesInterface) return "N/A";
     
-    SteamNetworkingIdentity identity;
-    identity.SetSteamID(peerID);
-    
+    if (directTransport_) {
+        switch (directTransport_->getPathKind(peerID.ConvertToUint64())) {
+            case DirectUdpTransport::PathKind::Lan: return "局域网";
+            case DirectUdpTransport::PathKind::Direct: return "UDP直连";
+            case DirectUdpTransport::PathKind::Steam: break;
+        }
+    }
+
     SteamNetConnectionInfo_t info;
-    ESteamNetworkingConnectionState state = m_pMessagesInterface->GetSessionConnectionInfo(identity, &info, nullptr);
+    ESteamNetworkingConnectionState state = getSessionInfo(peerID, &info, nullptr);
     
     if (state == k_ESteamNetworkingConnectionState_Connected) {
         if (info.m_nFlags & k_nSteamNetworkConnectionInfoFlags_Relayed) {
@@ -274,20 +316,62 @@ std::string SteamNetworkingManager::getPeerConnectionType(CSteamID peerID) const
     return "挂起";
 }
 
-int SteamNetworkingManager::getPendingSendBytes(CSteamID peerID) const
+bool SteamNetworkingManager::getPeerPathInfo(CSteamID peerID, DirectUdpTransport::PeerPathInfo& info) const
 {
-    if (!m_pMessagesInterface) return 0;
-    
-    SteamNetworkingIdentity identity;
-    identity.SetSteamID(peerID);
-    
+    if (!directTransport_) return false;
+    return directTransport_->getPeerPath(peerID.ConvertToUint64(), info);
+}
+
+bool SteamNetworkingManager::getDirectUdpStatistics(DirectUdpTransport::Statistics& stats) const
+{
+    if (!directTransport_) return false;
+    stats = directTransport_->getStatistics();
+    return true;
+}
+
+bool SteamNetworkingManager::getSocketsStatistics(SteamSocketsTransport::Statistics& stats) const
+{
+    if (!socketsTransport_) return false;
+    stats = socketsTransport_->getStatistics();
+    return true;
+}
+
+PeerLinkMetrics SteamNetworkingManager::getPeerLinkMetrics(CSteamID peerID)
+{
+    PeerLinkMetrics link;
+    SteamNetConnectionInfo_t info;
     SteamNetConnectionRealTimeStatus_t status;
-    ESteamNetworkingConnectionState state = m_pMessagesInterface->GetSessionConnectionInfo(identity, nullptr, &status);
-    
-    if (state == k_ESteamNetworkingConnectionState_Connected) {
-        return status.m_cbPendingReliable + status.m_cbPendingUnreliable;
+    if (getSessionInfo(peerID, &info, &status) == k_ESteamNetworkingConnectionState_Connected) {
+        link.connected = true;
+        link.ping = status.m_nPing;
+        link.qualityLocal = status.m_flConnectionQualityLocal;
+        link.qualityRemote = status.m_flConnectionQualityRemote;
+        link.outBytesPerSec = status.m_flOutBytesPerSec;
+        link.inBytesPerSec = status.m_flInBytesPerSec;
+        link.path = (info.m_nFlags & k_nSteamNetworkConnectionInfoFlags_Relayed)
+            ? PeerLinkMetrics::Path::Relayed : PeerLinkMetrics::Path::Steam;
     }
-    return 0;
+
+    DirectUdpTransport::PeerPathInfo path;
+    if (getPeerPathInfo(peerID, path) && path.kind != DirectUdpTransport::PathKind::Steam) {
+        link.connected = true;
+        link.path = path.kind == DirectUdpTransport::PathKind::Lan
+            ? PeerLinkMetrics::Path::Lan : PeerLinkMetrics::Path::DirectUdp;
+        if (path.directRttMs >= 0) link.ping = path.directRttMs;
+    }
+
+    if (TransportInterface* transport = getTransport()) {
+        link.pendingBytes = transport->getPendingSendBytes(peerID.ConvertToUint64());
+    }
+    return link;
+}
+
+TransportInterface* SteamNetworkingManager::getTransport()
+{
+    if (emulatedTransport_) return emulatedTransport_.get();
+    if (directTransport_) return directTransport_.get();
+    if (socketsTransport_) return socketsTransport_.get();
+    return transport_.get();
 }
 
 void SteamNetworkingManager::startMessageHandler()
@@ -11,6 +11,11 @@
 #include <steamnetworkingtypes.h>
 #include <steamnetworkingfakeip.h>
 #include "steam_message_handler.h"
+#include "steam_transport.h"
+#include "steam_sockets_transport.h"
+#include "../transport/direct_udp_transport.h"
+#include "../transport/emulated_transport.h"
+#include "../vpn/peer_stats.h"
 
 // Forward declarations
 class SteamNetworkingManager;
@@ -40,11 +45,8 @@ public:
     bool initialize();
     void shutdown();
 
-    // 发送消息给指定用户（使用 ISteamNetworkingMessages）
-    bool sendMessageToUser(CSteamID peerID, const void* data, uint32_t size, int flags);
-    
-    // 广播消息给房间内所有成员（实时从房间获取）
-    void broadcastMessage(const void* data, uint32_t size, int flags);
+    // 应用 Steam 全局网络配置（发送速率、发送缓冲区、Nagle），运行中可重复调用
+    void applySteamConfig(const AppConfig& config);
 
     // 获取房间内所有成员（实时从房间获取）
     std::set<CSteamID> getRoomMembers() const;
@@ -52,20 +54,33 @@ public:
     // 设置房间管理器
     void setRoomManager(SteamRoomManager* roomManager) { roomManager_ = roomManager; }
 
-    // 获取与指定用户的会话信息
+    // 获取与指定用户的会话信息（按所选后端查询 Messages 会话或 Sockets 连接）
+    ESteamNetworkingConnectionState getSessionInfo(CSteamID peerID, SteamNetConnectionInfo_t* info,
+                                                   SteamNetConnectionRealTimeStatus_t* status) const;
     int getPeerPing(CSteamID peerID) const;
     bool isPeerConnected(CSteamID peerID) const;
     std::string getPeerConnectionType(CSteamID peerID) const;
-    int getPendingSendBytes(CSteamID peerID) const;
+    // 直连 UDP 路径信息（未启用直连或从未通信返回 false）
+    bool getPeerPathInfo(CSteamID peerID, DirectUdpTransport::PeerPathInfo& info) const;
+    // 链路指标：会话状态、质量、速率、当前路径；待发送字节取自当前传输层（含直连/仿真层）
+    PeerLinkMetrics getPeerLinkMetrics(CSteamID peerID);
+    // 传输层统计（对应的传输层未启用时返回 false）
+    bool getDirectUdpStatistics(DirectUdpTransport::Statistics& stats) const;
+    bool getSocketsStatistics(SteamSocketsTransport::Statistics& stats) const;
 
     // Getters
     bool isInRoom() const;
     ISteamNetworkingMessages* getMessagesInterface() const { return m_pMessagesInterface; }
 
+    // 传输层（VPN 数据面通过它收发消息）
+    // 启用网络仿真时返回包装后的传输层
+    TransportInterface* getTransport();
+
     // Message handler
     void startMessageHandler();
     void stopMessageHandler();
     SteamMessageHandler* getMessageHandler() { return messageHandler_; }
+    const SteamMessageHandler* getMessageHandler() const { return messageHandler_; }
 
     // VPN Bridge
     void setVpnBridge(SteamVpnBridge* vpnBridge) { vpnBridge_ = vpnBridge; }
@@ -84,6 +99,12 @@ private:
     // 房间管理器（用于实时获取房间成员）
     SteamRoomManager* roomManager_;
 
+    // 传输层
+    std::unique_ptr<SteamTransport> transport_;
+    std::unique_ptr<SteamSocketsTransport> socketsTransport_;  // networking.transport_backend = "sockets"
+    std::unique_ptr<DirectUdpTransport> directTransport_;   // 可选，包装所选的 Steam 后端
+    std::unique_ptr<EmulatedTransport> emulatedTransport_;  // 可选，包装 directTransport_ 或 transport_
+
     // Message handler
     SteamMessageHandler* messageHandler_;
 
@@ -123,6 +123,10 @@ void SteamMatchmakingCallbacks::OnLobbyChatUpdate(LobbyChatUpdate_t *pCallback)
         if (affectedUser != mySteamID && roomManager_->getCurrentLobby().IsValid())
         {
             std::cout << "User joined, but we won't query them. Waiting for their IP Query." << std::endl;
+            // Membership changed: cached forwarding decisions (FakeIP fallback) may be stale
+            if (manager_->getVpnBridge()) {
+                manager_->getVpnBridge()->invalidateFlows();
+            }
             // DISABLE: To prevent "both sides sending", we let the new user initiate the query (via broadcast).
             // We will learn their IP from their Query, and respond with ours.
             /*
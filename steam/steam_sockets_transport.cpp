@@ -0,0 +1,293 @@
+#include "steam_sockets_transport.h"
+#include "steam_networking_manager.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <isteamnetworkingutils.h>
+
+namespace {
+
+    // 不超过此长度的不可靠消息走交互通道
+    constexpr uint32_t INTERACTIVE_MAX_SIZE = 320;
+
+    // 控制通道严格优先；交互与批量通道同一优先级，按 3:1 分享带宽
+    const int LANE_PRIORITIES[SteamSocketsTransport::LANE_COUNT] = {0, 1, 1};
+    const uint16 LANE_WEIGHTS[SteamSocketsTransport::LANE_COUNT] = {1, 3, 1};
+
+} // anonymous namespace
+
+SteamSocketsTransport::SteamSocketsTransport(SteamNetworkingManager* manager)
+    : SteamTransport(manager)
+    , listenSocket_(k_HSteamListenSocket_Invalid)
+    , pollGroup_(k_HSteamNetPollGroup_Invalid)
+    , pendingCount_(0)
+{
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+SteamSocketsTransport::~SteamSocketsTransport() {
+    close();
+}
+
+bool SteamSocketsTransport::start() {
+    ISteamNetworkingSockets* sockets = SteamNetworkingSockets();
+    if (!sockets) {
+        std::cerr << "[SteamSocketsTransport] ISteamNetworkingSockets not available" << std::endl;
+        return false;
+    }
+
+    pollGroup_ = sockets->CreatePollGroup();
+    listenSocket_ = sockets->CreateListenSocketP2P(SteamNetworkingManager::VPN_CHANNEL, 0, nullptr);
+    if (pollGroup_ == k_HSteamNetPollGroup_Invalid || listenSocket_ == k_HSteamListenSocket_Invalid) {
+        std::cerr << "[SteamSocketsTransport] Failed to create P2P listen socket" << std::endl;
+        close();
+        return false;
+    }
+
+    std::cout << "[SteamSocketsTransport] Listening on P2P virtual port "
+              << SteamNetworkingManager::VPN_CHANNEL << std::endl;
+    return true;
+}
+
+void SteamSocketsTransport::close() {
+    ISteamNetworkingSockets* sockets = SteamNetworkingSockets();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!sockets) {
+        connections_.clear();
+        pendingCount_ = 0;
+        return;
+    }
+
+    flushLocked();
+    for (const auto& pair : connections_) {
+        // linger：已排队的可靠消息仍会发出
+        sockets->CloseConnection(pair.second, k_ESteamNetConnectionEnd_App_Generic, "Shutdown", true);
+    }
+    connections_.clear();
+
+    if (listenSocket_ != k_HSteamListenSocket_Invalid) {
+        sockets->CloseListenSocket(listenSocket_);
+        listenSocket_ = k_HSteamListenSocket_Invalid;
+    }
+    if (pollGroup_ != k_HSteamNetPollGroup_Invalid) {
+        sockets->DestroyPollGroup(pollGroup_);
+        pollGroup_ = k_HSteamNetPollGroup_Invalid;
+    }
+}
+
+void SteamSocketsTransport::OnConnectionStatusChanged(SteamNetConnectionStatusChangedCallback_t* pCallback) {
+    ISteamNetworkingSockets* sockets = SteamNetworkingSockets();
+    if (!sockets) return;
+
+    HSteamNetConnection connection = pCallback->m_hConn;
+    const SteamNetConnectionInfo_t& info = pCallback->m_info;
+    CSteamID peer = info.m_identityRemote.GetSteamID();
+
+    switch (info.m_eState) {
+        case k_ESteamNetworkingConnectionState_Connecting: {
+            // 只处理对端发起、到达我们监听套接字的连接
+            if (listenSocket_ == k_HSteamListenSocket_Invalid || info.m_hListenSocket != listenSocket_) break;
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = connections_.find(peer);
+            if (it != connections_.end() && it->second != connection) {
+                // 双方同时发起连接：保留 SteamID 较小一方发起的连接，两端结论一致
+                if (getLocalId() < peer.ConvertToUint64()) {
+                    sockets->CloseConnection(connection, k_ESteamNetConnectionEnd_App_Generic, "Duplicate", false);
+                    break;
+                }
+                sockets->CloseConnection(it->second, k_ESteamNetConnectionEnd_App_Generic, "Duplicate", false);
+                stats_.connectionsClosed++;
+            }
+
+            if (sockets->AcceptConnection(connection) != k_EResultOK) {
+                sockets->CloseConnection(connection, k_ESteamNetConnectionEnd_App_Generic, "Accept failed", false);
+                if (it != connections_.end()) connections_.erase(it);
+                break;
+            }
+            configureConnection(connection);
+            connections_[peer] = connection;
+            stats_.connectionsOpened++;
+            std::cout << "[SteamSocketsTransport] Accepted connection from " << peer.ConvertToUint64() << std::endl;
+            break;
+        }
+        case k_ESteamNetworkingConnectionState_Connected:
+            std::cout << "[SteamSocketsTransport] Connected to " << peer.ConvertToUint64()
+                      << ((info.m_nFlags & k_nSteamNetworkConnectionInfoFlags_Relayed) ? " (relayed)" : " (direct)")
+                      << std::endl;
+            break;
+        case k_ESteamNetworkingConnectionState_ClosedByPeer:
+        case k_ESteamNetworkingConnectionState_ProblemDetectedLocally: {
+            std::cout << "[SteamSocketsTransport] Connection to " << peer.ConvertToUint64()
+                      << " closed: " << info.m_szEndDebug << std::endl;
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = connections_.find(peer);
+            if (it != connections_.end() && it->second == connection) {
+                // 下次发送时重新连接
+                connections_.erase(it);
+                stats_.connectionsClosed++;
+            }
+            sockets->CloseConnection(connection, 0, nullptr, false);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+HSteamNetConnection SteamSocketsTransport::connectionFor(CSteamID peer) {
+    auto it = connections_.find(peer);
+    if (it != connections_.end()) return it->second;
+
+    ISteamNetworkingSockets* sockets = SteamNetworkingSockets();
+    if (!sockets || listenSocket_ == k_HSteamListenSocket_Invalid) return k_HSteamNetConnection_Invalid;
+
+    SteamNetworkingIdentity identity;
+    identity.SetSteamID(peer);
+    HSteamNetConnection connection = sockets->ConnectP2P(identity, SteamNetworkingManager::VPN_CHANNEL, 0, nullptr);
+    if (connection == k_HSteamNetConnection_Invalid) return connection;
+
+    // 连接建立前提交的消息由 Steam 排队
+    configureConnection(connection);
+    connections_[peer] = connection;
+    stats_.connectionsOpened++;
+    std::cout << "[SteamSocketsTransport] Connecting to " << peer.ConvertToUint64() << std::endl;
+    return connection;
+}
+
+void SteamSocketsTransport::configureConnection(HSteamNetConnection connection) {
+    ISteamNetworkingSockets* sockets = SteamNetworkingSockets();
+    sockets->SetConnectionPollGroup(connection, pollGroup_);
+    if (sockets->ConfigureConnectionLanes(connection, LANE_COUNT, LANE_PRIORITIES, LANE_WEIGHTS) != k_EResultOK) {
+        std::cerr << "[SteamSocketsTransport] Failed to configure connection lanes" << std::endl;
+    }
+}
+
+uint16_t SteamSocketsTransport::selectLane(uint32_t size, int flags) {
+    if (flags & k_nSteamNetworkingSend_Reliable) return LANE_CONTROL;
+    return size <= INTERACTIVE_MAX_SIZE ? LANE_INTERACTIVE : LANE_BULK;
+}
+
+bool SteamSocketsTransport::queueMessage(HSteamNetConnection connection, const void* data, uint32_t size, int flags) {
+    SteamNetworkingMessage_t* message = SteamNetworkingUtils()->AllocateMessage(static_cast<int>(size));
+    if (!message) {
+        stats_.allocationFailures++;
+        return false;
+    }
+    memcpy(message->m_pData, data, size);
+    message->m_conn = connection;
+    message->m_nFlags = flags;
+    message->m_idxLane = selectLane(size, flags);
+
+    pending_[pendingCount_++] = message;
+    if (pendingCount_ == kMaxSendBatch) flushLocked();
+    return true;
+}
+
+void SteamSocketsTransport::flushLocked() {
+    if (pendingCount_ == 0) return;
+
+    int64 results[kMaxSendBatch];
+    SteamNetworkingSockets()->SendMessages(pendingCount_, pending_, results);
+
+    // 负值为 -EResult，消息已由 Steam 释放
+    int failures = static_cast<int>(std::count_if(results, results + pendingCount_,
+                                                  [](int64 result) { return result < 0; }));
+    stats_.messagesSent += pendingCount_ - failures;
+    stats_.sendFailures += failures;
+    stats_.sendBatches++;
+    pendingCount_ = 0;
+}
+
+bool SteamSocketsTransport::sendToPeer(PeerId peer, const void* data, uint32_t size, int flags) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    HSteamNetConnection connection = connectionFor(CSteamID(peer));
+    if (connection == k_HSteamNetConnection_Invalid) return false;
+
+    bool queued = queueMessage(connection, data, size, flags);
+    if (flags & k_nSteamNetworkingSend_Reliable) flushLocked();
+    return queued;
+}
+
+int SteamSocketsTransport::broadcast(const void* data, uint32_t size, int flags) {
+    std::set<CSteamID> members = manager_->getRoomMembers();
+    PeerId localId = getLocalId();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    int sent = 0;
+    for (const auto& memberID : members) {
+        if (memberID.ConvertToUint64() == localId) continue;
+        HSteamNetConnection connection = connectionFor(memberID);
+        if (connection != k_HSteamNetConnection_Invalid && queueMessage(connection, data, size, flags)) {
+            sent++;
+        }
+    }
+    flushLocked();
+    return sent;
+}
+
+void SteamSocketsTransport::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    flushLocked();
+}
+
+int SteamSocketsTransport::receiveBatch(TransportMessage* messages, int maxMessages) {
+    ISteamNetworkingSockets* sockets = SteamNetworkingSockets();
+    if (!sockets || pollGroup_ == k_HSteamNetPollGroup_Invalid || maxMessages <= 0) return 0;
+
+    // 接收循环频繁运行，顺带发出没有被调用方 flush 的消息
+    flush();
+
+    SteamNetworkingMessage_t* incoming[kMaxReceiveBatch];
+    int numMsgs = sockets->ReceiveMessagesOnPollGroup(pollGroup_, incoming, std::min(maxMessages, kMaxReceiveBatch));
+
+    int64_t clockOffset = numMsgs > 0 ? transportTimestampUs() - SteamNetworkingUtils()->GetLocalTimestamp() : 0;
+    for (int i = 0; i < numMsgs; ++i) {
+        messages[i].data = static_cast<uint8_t*>(incoming[i]->m_pData);
+        messages[i].size = static_cast<uint32_t>(incoming[i]->m_cbSize);
+        messages[i].sender = incoming[i]->m_identityPeer.GetSteamID().ConvertToUint64();
+        messages[i].handle = incoming[i];
+        messages[i].receivedAtUs = incoming[i]->m_usecTimeReceived + clockOffset;
+    }
+    if (numMsgs > 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.messagesReceived += numMsgs;
+    }
+    return std::max(numMsgs, 0);
+}
+
+HSteamNetConnection SteamSocketsTransport::findConnection(CSteamID peer) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = connections_.find(peer);
+    return it != connections_.end() ? it->second : k_HSteamNetConnection_Invalid;
+}
+
+ESteamNetworkingConnectionState SteamSocketsTransport::getConnectionInfo(
+    CSteamID peer, SteamNetConnectionInfo_t* info, SteamNetConnectionRealTimeStatus_t* status) const {
+    ISteamNetworkingSockets* sockets = SteamNetworkingSockets();
+    HSteamNetConnection connection = findConnection(peer);
+    if (!sockets || connection == k_HSteamNetConnection_Invalid) return k_ESteamNetworkingConnectionState_None;
+
+    SteamNetConnectionInfo_t connectionInfo;
+    if (!sockets->GetConnectionInfo(connection, &connectionInfo)) return k_ESteamNetworkingConnectionState_None;
+    if (info) *info = connectionInfo;
+    if (status) sockets->GetConnectionRealTimeStatus(connection, status, 0, nullptr);
+    return static_cast<ESteamNetworkingConnectionState>(connectionInfo.m_eState);
+}
+
+int SteamSocketsTransport::getPendingSendBytes(PeerId peer) const {
+    SteamNetConnectionRealTimeStatus_t status;
+    if (getConnectionInfo(CSteamID(peer), nullptr, &status) != k_ESteamNetworkingConnectionState_Connected) return 0;
+    return status.m_cbPendingReliable + status.m_cbPendingUnreliable;
+}
+
+int SteamSocketsTransport::getPeerRtt(PeerId peer) const {
+    SteamNetConnectionRealTimeStatus_t status;
+    if (getConnectionInfo(CSteamID(peer), nullptr, &status) != k_ESteamNetworkingConnectionState_Connected) return -1;
+    return status.m_nPing;
+}
+
+SteamSocketsTransport::Statistics SteamSocketsTransport::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
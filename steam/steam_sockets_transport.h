@@ -0,0 +1,102 @@
+#ifndef STEAM_SOCKETS_TRANSPORT_H
+#define STEAM_SOCKETS_TRANSPORT_H
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <steam_api.h>
+#include <isteamnetworkingsockets.h>
+#include "steam_transport.h"
+
+/**
+ * @brief 基于 ISteamNetworkingSockets P2P 连接的传输层实现
+ *
+ * 每个节点一条面向连接的 P2P 连接（虚拟端口为 VPN_CHANNEL），所有连接加入同一个
+ * 轮询组，一次 ReceiveMessagesOnPollGroup 取回所有节点的消息。
+ *
+ * 发送使用 AllocateMessage 分配的消息对象：数据写入后所有权交给 Steam，
+ * 排队的消息在 flush 时通过一次 SendMessages 提交（可靠消息立即提交）。
+ * 每条连接配置三条通道（lane）：控制消息优先，其余按权重分享带宽。
+ *
+ * 地址解析等与 SteamTransport 相同。房间内所有成员必须使用相同的后端。
+ */
+class SteamSocketsTransport : public SteamTransport {
+public:
+    /**
+     * @brief 连接通道
+     */
+    enum Lane : uint16_t {
+        LANE_CONTROL = 0,       // 可靠消息（握手、地址协商、心跳）
+        LANE_INTERACTIVE = 1,   // 小 IP 包（TCP ACK、游戏状态同步等）
+        LANE_BULK = 2,          // 大 IP 包
+        LANE_COUNT = 3
+    };
+
+    /**
+     * @brief 统计信息
+     */
+    struct Statistics {
+        uint64_t messagesSent;
+        uint64_t messagesReceived;
+        uint64_t sendBatches;           // SendMessages 调用次数
+        uint64_t sendFailures;          // SendMessages 返回失败的消息
+        uint64_t allocationFailures;    // AllocateMessage 失败
+        uint64_t connectionsOpened;
+        uint64_t connectionsClosed;
+    };
+
+    explicit SteamSocketsTransport(SteamNetworkingManager* manager);
+    ~SteamSocketsTransport() override;
+
+    /**
+     * @brief 创建 P2P 监听套接字和轮询组
+     */
+    bool start();
+
+    /**
+     * @brief 发出排队的消息并关闭所有连接（须在 SteamAPI_Shutdown 之前调用）
+     */
+    void close();
+
+    /**
+     * @brief 获取与指定节点的连接信息（与 GetSessionConnectionInfo 语义相同）
+     */
+    ESteamNetworkingConnectionState getConnectionInfo(CSteamID peer, SteamNetConnectionInfo_t* info,
+                                                      SteamNetConnectionRealTimeStatus_t* status) const;
+
+    Statistics getStatistics() const;
+
+    bool sendToPeer(PeerId peer, const void* data, uint32_t size, int flags) override;
+    int broadcast(const void* data, uint32_t size, int flags) override;
+    int receiveBatch(TransportMessage* messages, int maxMessages) override;
+    void flush() override;
+    int getPendingSendBytes(PeerId peer) const override;
+    int getPeerRtt(PeerId peer) const override;
+
+private:
+    STEAM_CALLBACK(SteamSocketsTransport, OnConnectionStatusChanged, SteamNetConnectionStatusChangedCallback_t);
+
+    // 以下函数需持有 mutex_
+    HSteamNetConnection connectionFor(CSteamID peer);
+    void configureConnection(HSteamNetConnection connection);
+    bool queueMessage(HSteamNetConnection connection, const void* data, uint32_t size, int flags);
+    void flushLocked();
+
+    HSteamNetConnection findConnection(CSteamID peer) const;
+    static uint16_t selectLane(uint32_t size, int flags);
+
+    HSteamListenSocket listenSocket_;
+    HSteamNetPollGroup pollGroup_;
+
+    mutable std::mutex mutex_;
+    std::map<CSteamID, HSteamNetConnection> connections_;
+
+    // 待提交的消息（所有权在 SendMessages 时交给 Steam）
+    static constexpr int kMaxSendBatch = 64;
+    SteamNetworkingMessage_t* pending_[kMaxSendBatch];
+    int pendingCount_;
+
+    Statistics stats_;
+};
+
+#endif // STEAM_SOCKETS_TRANSPORT_H
@@ -0,0 +1,121 @@
+#include "steam_transport.h"
+#include "steam_networking_manager.h"
+#include "steam_vpn_utils.h"
+#include <iostream>
+#include <algorithm>
+#include <isteamnetworkingutils.h>
+
+// 传输层的发送标志直接传给 Steam
+static_assert(TRANSPORT_SEND_UNRELIABLE == k_nSteamNetworkingSend_Unreliable, "send flag mismatch");
+static_assert(TRANSPORT_SEND_NO_NAGLE == k_nSteamNetworkingSend_NoNagle, "send flag mismatch");
+static_assert(TRANSPORT_SEND_NO_DELAY == k_nSteamNetworkingSend_NoDelay, "send flag mismatch");
+static_assert(TRANSPORT_SEND_RELIABLE == k_nSteamNetworkingSend_Reliable, "send flag mismatch");
+
+SteamTransport::SteamTransport(SteamNetworkingManager* manager)
+    : manager_(manager) {}
+
+ISteamNetworkingMessages* SteamTransport::messagesInterface() const {
+    return manager_ ? manager_->getMessagesInterface() : nullptr;
+}
+
+bool SteamTransport::sendToPeer(PeerId peer, const void* data, uint32_t size, int flags) {
+    ISteamNetworkingMessages* messages = messagesInterface();
+    if (!messages) return false;
+
+    SteamNetworkingIdentity identity;
+    identity.SetSteamID(CSteamID(peer));
+
+    EResult result = messages->SendMessageToUser(identity, data, size, flags,
+                                                 SteamNetworkingManager::VPN_CHANNEL);
+    return result == k_EResultOK;
+}
+
+int SteamTransport::broadcast(const void* data, uint32_t size, int flags) {
+    ISteamNetworkingMessages* messages = messagesInterface();
+    if (!messages) return 0;
+
+    // 实时从房间获取成员列表
+    std::set<CSteamID> members = manager_->getRoomMembers();
+    std::cout << "[SteamTransport] Broadcasting to " << members.size() << " members" << std::endl;
+
+    for (const auto& memberID : members) {
+        std::cout << "  -> " << memberID.ConvertToUint64() << std::endl;
+        SteamNetworkingIdentity identity;
+        identity.SetSteamID(memberID);
+        messages->SendMessageToUser(identity, data, size, flags, SteamNetworkingManager::VPN_CHANNEL);
+    }
+    return static_cast<int>(members.size());
+}
+
+int SteamTransport::receiveBatch(TransportMessage* messages, int maxMessages) {
+    ISteamNetworkingMessages* steamMessages = messagesInterface();
+    if (!steamMessages || maxMessages <= 0) return 0;
+
+    ISteamNetworkingMessage* incoming[kMaxReceiveBatch];
+    int numMsgs = steamMessages->ReceiveMessagesOnChannel(
+        SteamNetworkingManager::VPN_CHANNEL, incoming, std::min(maxMessages, kMaxReceiveBatch));
+
+    // Steam 的接收时间戳换算到本地时钟
+    int64_t clockOffset = numMsgs > 0 ? transportTimestampUs() - SteamNetworkingUtils()->GetLocalTimestamp() : 0;
+    for (int i = 0; i < numMsgs; ++i) {
+        messages[i].data = static_cast<uint8_t*>(incoming[i]->m_pData);
+        messages[i].size = static_cast<uint32_t>(incoming[i]->m_cbSize);
+        messages[i].sender = incoming[i]->m_identityPeer.GetSteamID().ConvertToUint64();
+        messages[i].handle = incoming[i];
+        messages[i].receivedAtUs = incoming[i]->m_usecTimeReceived + clockOffset;
+    }
+    return numMsgs;
+}
+
+void SteamTransport::release(TransportMessage* messages, int count) {
+    for (int i = 0; i < count; ++i) {
+        static_cast<ISteamNetworkingMessage*>(messages[i].handle)->Release();
+        messages[i].handle = nullptr;
+    }
+}
+
+int SteamTransport::getPendingSendBytes(PeerId peer) const {
+    ISteamNetworkingMessages* messages = messagesInterface();
+    if (!messages) return 0;
+
+    SteamNetworkingIdentity identity;
+    identity.SetSteamID(CSteamID(peer));
+
+    SteamNetConnectionRealTimeStatus_t status;
+    ESteamNetworkingConnectionState state = messages->GetSessionConnectionInfo(identity, nullptr, &status);
+
+    if (state == k_ESteamNetworkingConnectionState_Connected) {
+        return status.m_cbPendingReliable + status.m_cbPendingUnreliable;
+    }
+    return 0;
+}
+
+int SteamTransport::getPeerRtt(PeerId peer) const {
+    return manager_ ? manager_->getPeerPing(CSteamID(peer)) : -1;
+}
+
+PeerId SteamTransport::getLocalId() const {
+    return SteamUser() ? SteamUser()->GetSteamID().ConvertToUint64() : INVALID_PEER_ID;
+}
+
+uint32_t SteamTransport::getLocalAddress() const {
+    return manager_ ? manager_->getLocalFakeIP() : 0;
+}
+
+PeerId SteamTransport::resolveAddress(uint32_t ip) const {
+    if (!SteamNetworkingUtils()) return INVALID_PEER_ID;
+
+    SteamNetworkingIPAddr fakeIP;
+    fakeIP.SetIPv4(ip, 0); // Port 0
+
+    SteamNetworkingIdentity identity;
+    EResult result = SteamNetworkingUtils()->GetRealIdentityForFakeIP(fakeIP, &identity);
+    if (result == k_EResultOK) {
+        return identity.GetSteamID().ConvertToUint64();
+    }
+    return INVALID_PEER_ID;
+}
+
+int SteamTransport::getMtuDataSize() const {
+    return SteamVpnUtils::querySteamMtuDataSize();
+}
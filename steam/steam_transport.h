@@ -0,0 +1,41 @@
+#ifndef STEAM_TRANSPORT_H
+#define STEAM_TRANSPORT_H
+
+#include <steam_api.h>
+#include <isteamnetworkingmessages.h>
+#include "../transport/transport_interface.h"
+
+class SteamNetworkingManager;
+
+/**
+ * @brief 基于 ISteamNetworkingMessages 的传输层实现
+ *
+ * 所有消息使用 SteamNetworkingManager::VPN_CHANNEL 通道，
+ * 广播对象为当前房间内的成员。
+ */
+class SteamTransport : public TransportInterface {
+public:
+    explicit SteamTransport(SteamNetworkingManager* manager);
+
+    bool sendToPeer(PeerId peer, const void* data, uint32_t size, int flags) override;
+    int broadcast(const void* data, uint32_t size, int flags) override;
+    int receiveBatch(TransportMessage* messages, int maxMessages) override;
+    void release(TransportMessage* messages, int count) override;
+    int getPendingSendBytes(PeerId peer) const override;
+    int getPeerRtt(PeerId peer) const override;
+    PeerId getLocalId() const override;
+    uint32_t getLocalAddress() const override;
+    PeerId resolveAddress(uint32_t ip) const override;
+    int getMtuDataSize() const override;
+
+protected:
+    SteamNetworkingManager* manager_;
+
+    // 单次接收调用的最大消息数
+    static constexpr int kMaxReceiveBatch = 64;
+
+private:
+    ISteamNetworkingMessages* messagesInterface() const;
+};
+
+#endif // STEAM_TRANSPORT_H
@@ -1,13 +1,12 @@
 #include "steam_vpn_bridge.h"
-#include "steam_networking_manager.h"
 #include "config/config_manager.h"
-#include "steam_vpn_utils.h"
 #include "../vpn/vpn_utils.h"
 #include <iostream>
 #include <cstring>
 #include <vector>
 #include <thread>
 #include <chrono>
+#include <algorithm>
 
 #ifdef _WIN32
 #include <winsock2.h>
@@ -16,19 +15,50 @@
 #include <arpa/inet.h>
 #endif
 
-using namespace SteamVpnUtils;
 using namespace VpnUtils;
 
-SteamVpnBridge::SteamVpnBridge(SteamNetworkingManager* steamManager)
-    : steamManager_(steamManager)
+namespace {
+    constexpr size_t RX_QUEUE_CAPACITY = 1024;  // 在途字节数另由 rxBudget_ 限制
+    constexpr size_t RX_WRITE_BATCH = 32;
+    constexpr int RX_IDLE_SPINS = 64;           // 队列为空时让出 CPU 的次数，之后休眠等待唤醒
+    constexpr auto RX_IDLE_WAIT = std::chrono::milliseconds(1);
+
+    size_t hashIpv6Source(uint64_t peer, const Ipv6Address& address) {
+        uint64_t h = peer;
+        for (uint8_t byte : address) {
+            h = (h ^ byte) * 0x100000001B3ULL;
+        }
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+}
+
+SteamVpnBridge::SteamVpnBridge(TransportInterface* transport)
+    : transport_(transport)
     , running_(false)
+    , rxQueue_(RX_QUEUE_CAPACITY)
+    , rxBudget_(static_cast<size_t>(ConfigManager::instance().getConfig().networking.rx_inflight_limit_kb) * 1024)
+    , rxQueueHighWater_(0)
+    , writerSleeping_(false)
     , localIP_(0)
+    , localIPv6_{}
+    , tunMtu_(RECOMMENDED_MTU)
+    , tunMtu6_(IPV6_MIN_MTU)
+    , maxTcpMss_(calculateTcpMss(RECOMMENDED_MTU))
+    , maxTcpMss6_(calculateTcpMss(IPV6_MIN_MTU) - 20)
+    , maxPacketSize_(static_cast<int>(STEAM_UNRELIABLE_MSG_SIZE_LIMIT - sizeof(VpnMessageHeader)))
+    , routeGeneration_(0)
 {
     memset(&stats_, 0, sizeof(stats_));
+    stats_.rxQueueCapacity = rxQueue_.capacity();
+    stats_.rxInFlightLimitBytes = rxBudget_.maxBytes();
+    setTraceSampleEvery(static_cast<uint32_t>(
+        std::max(0, ConfigManager::instance().getConfig().networking.packet_trace_sample_every)));
 }
 
 SteamVpnBridge::~SteamVpnBridge() {
     stop();
+    // 停止后接收线程可能仍放入了少量消息
+    drainRxQueue();
 }
 
 bool SteamVpnBridge::start(const std::string& tunDeviceName,
@@ -39,23 +69,18 @@ bool SteamVpnBridge::start(const std::string& tunDeviceName,
         return false;
     }
 
-    // Retrieve Fake IP from manager
-    localIP_ = steamManager_->getLocalFakeIP();
+    // Retrieve Fake IP from the transport
+    localIP_ = transport_->getLocalAddress();
     if (localIP_ == 0) {
         std::cerr << "Cannot start VPN: No Fake IP assigned yet." << std::endl;
         return false;
     }
 
     const auto& config = ConfigManager::instance().getConfig();
-    int steamMtuDataSize = querySteamMtuDataSize();
-    int mtu = calculateTunMtu(steamMtuDataSize);
-    
-    if (config.vpn.default_mtu > 0 && config.vpn.default_mtu < mtu) {
-        std::cout << "[MTU] Using config MTU (" << config.vpn.default_mtu 
-                  << ") instead of calculated (" << mtu << ")" << std::endl;
-        mtu = config.vpn.default_mtu;
-    }
+    int mtu = selectTunMtu(config.vpn.default_mtu);
 
+    // A MTU change from a previous run may still hold the old device
+    std::lock_guard<std::mutex> deviceLock(tunDeviceMutex_);
     tunDevice_ = tun::create_tun();
     if (!tunDevice_) {
         std::cerr << "Failed to create TUN device" << std::endl;
@@ -76,6 +101,8 @@ bool SteamVpnBridge::start(const std::string& tunDeviceName,
 
     std::cout << "TUN device MTU set to: " << mtu << std::endl;
 
+    applyTunMtu(mtu);
+
     // Configure TUN IP
     // Use the assigned Fake IP.
     // For subnet, we use a standard /16 for 169.254.x.x or whatever Steam assigns.
@@ -90,10 +117,24 @@ bool SteamVpnBridge::start(const std::string& tunDeviceName,
         return false;
     }
 
+    // IPv6 ULA: shared /64 prefix from the app salt, interface ID from our Steam ID
+    PeerId localId = transport_->getLocalId();
+    uint64_t nodeKey = localId != INVALID_PEER_ID ? localId : localIP_;
+    localIPv6_ = deriveUlaAddress(config.protocol.app_secret_salt, nodeKey);
+    std::string localIPv6Str = ipv6ToString(localIPv6_);
+    if (tunDevice_->set_ipv6(localIPv6Str, 64)) {
+        std::cout << "TUN device configured with IPv6: " << localIPv6Str << "/64" << std::endl;
+    } else {
+        // Link-local IPv6 traffic is still forwarded, we just don't advertise a ULA
+        std::cout << "IPv6 ULA not configured on TUN device, continuing with IPv4 only" << std::endl;
+        localIPv6_ = Ipv6Address{};
+    }
+
     tunDevice_->set_non_blocking(false);
 
     running_ = true;
     tunReadThread_ = std::make_unique<std::thread>(&SteamVpnBridge::tunReadThread, this);
+    tunWriteThread_ = std::make_unique<std::thread>(&SteamVpnBridge::tunWriteThread, this);
     
     // Broadcast IP Query to discover peers
     // Retry a few times to ensure we catch members if the list populates slowly
@@ -117,17 +158,35 @@ void SteamVpnBridge::stop() {
     if (tunReadThread_ && tunReadThread_->joinable()) {
         tunReadThread_->join();
     }
+    {
+        std::lock_guard<std::mutex> lock(writerMutex_);
+        writerCv_.notify_one();
+    }
+    if (tunWriteThread_ && tunWriteThread_->joinable()) {
+        tunWriteThread_->join();
+    }
+    drainRxQueue();
 
-    if (tunDevice_) {
-        tunDevice_->close();
+    {
+        // Waits for a MTU change in progress on another thread
+        std::lock_guard<std::mutex> lock(tunDeviceMutex_);
+        if (tunDevice_) {
+            tunDevice_->close();
+        }
     }
 
     localIP_ = 0;
+    localIPv6_ = Ipv6Address{};
     
     {
         std::lock_guard<std::mutex> lock(routingMutex_);
         routingTable_.clear();
+        routingTableV6_.clear();
+        learnedV6Count_.clear();
     }
+    flowCache_.clear();
+    peerStats_.clear();
+    invalidateFlows();
 
     std::cout << "Steam VPN bridge stopped" << std::endl;
 }
@@ -137,6 +196,11 @@ std::string SteamVpnBridge::getLocalIP() const {
     return ipToString(localIP_);
 }
 
+std::string SteamVpnBridge::getLocalIPv6() const {
+    if (isIpv6Unspecified(localIPv6_)) return "Not assigned";
+    return ipv6ToString(localIPv6_);
+}
+
 std::string SteamVpnBridge::getTunDeviceName() const {
     if (tunDevice_ && tunDevice_->is_open()) {
         return tunDevice_->get_device_name();
@@ -144,112 +208,533 @@ std::string SteamVpnBridge::getTunDeviceName() const {
     return "N/A";
 }
 
+uint32_t SteamVpnBridge::getRouteGeneration() const {
+    return routeGeneration_.load(std::memory_order_acquire);
+}
+
 std::map<uint32_t, RouteEntry> SteamVpnBridge::getRoutingTable() const {
-    std::lock_guard<std::mutex> lock(routingMutex_);
     std::map<uint32_t, RouteEntry> result;
-    
-    for (const auto& pair : routingTable_) {
-        RouteEntry entry;
-        entry.ipAddress = pair.first;
-        entry.steamID = pair.second;
-        entry.isLocal = false;
-        // name and nodeId are not strictly tracked here, but could be added if needed
+    {
+        // Only copy under the lock, the data path contends for it
+        std::lock_guard<std::mutex> lock(routingMutex_);
+        for (const auto& pair : routingTable_) {
+            RouteEntry& entry = result[pair.first];
+            entry.ipAddress = pair.first;
+            entry.steamID = pair.second.steamID;
+            entry.isLocal = false;
+            entry.ipv6Address = pair.second.ipv6Address;
+        }
+    }
+
+    // name and nodeId are not strictly tracked here, but could be added if needed
+    for (auto& pair : result) {
         if (SteamFriends()) {
-            entry.name = SteamFriends()->GetFriendPersonaName(pair.second);
+            pair.second.name = SteamFriends()->GetFriendPersonaName(pair.second.steamID);
         } else {
-            entry.name = "Unknown";
+            pair.second.name = "Unknown";
         }
-        result[pair.first] = entry;
     }
     return result;
 }
 
 void SteamVpnBridge::tunReadThread() {
     std::cout << "TUN read thread started" << std::endl;
+    txConfig_.refresh();
     
     constexpr size_t BUFFER_SIZE = 16384;
-    std::vector<uint8_t> buffer(BUFFER_SIZE);
+    constexpr int BATCH_SIZE = 32;
+    std::vector<uint8_t> storage(BUFFER_SIZE * BATCH_SIZE);
+    uint8_t* buffers[BATCH_SIZE];
+    for (int i = 0; i < BATCH_SIZE; ++i) {
+        buffers[i] = storage.data() + i * BUFFER_SIZE;
+    }
+    size_t lengths[BATCH_SIZE];
+    PacketMeta metas[BATCH_SIZE];
     
     while (running_) {
-        int bytesRead = tunDevice_->read(buffer.data(), buffer.size());
-        
-        if (bytesRead > 0) {
-            uint32_t destIP = extractDestIP(buffer.data(), bytesRead);
-            
-            // 1. Try local routing table first
-            CSteamID targetSteamID = k_steamIDNil;
-            {
-                std::lock_guard<std::mutex> lock(routingMutex_);
-                auto it = routingTable_.find(destIP);
-                if (it != routingTable_.end()) {
-                    targetSteamID = it->second;
-                }
+        int count = tunDevice_->read_batch(buffers, BUFFER_SIZE, lengths, BATCH_SIZE);
+        if (count <= 0) continue;
+        // Backpressure limits follow the published config, checked once per batch
+        txConfig_.refresh();
+        int64_t readUs = TraceClock::now();
+        // Sampled packets share the batch's read and classify times
+        txTrace_.readUs = tracer_.sampleEvery() ? readUs : 0;
+
+        // Extract header fields for the whole batch in one pass
+        {
+            STAGE_SCOPE(DataPathStage::TxClassify);
+            PacketClassifier::classifyBatch(buffers, lengths, count, metas);
+        }
+        txTrace_.classifiedUs = txTrace_.readUs ? TraceClock::now() : 0;
+
+        for (int i = 0; i < count; ++i) {
+            flightRecorder_.record(FlightPoint::TunRead, readUs, 0, buffers[i], lengths[i]);
+            txTrace_.traceId = txTrace_.readUs ? tracer_.sample() : 0;
+            processTunPacket(buffers[i], lengths[i], metas[i]);
+        }
+        txTrace_.traceId = 0;
+
+        // Hand the whole batch to the transport at once
+        STAGE_SCOPE(DataPathStage::TxFlush);
+        transport_->flush();
+    }
+    
+    std::cout << "TUN read thread stopped" << std::endl;
+}
+
+void SteamVpnBridge::tunWriteThread() {
+    std::cout << "TUN write thread started" << std::endl;
+
+    RxPacket batch[RX_WRITE_BATCH];
+    const uint8_t* buffers[RX_WRITE_BATCH];
+    size_t lengths[RX_WRITE_BATCH];
+    int idleSpins = 0;
+
+    while (running_) {
+        size_t count = rxQueue_.popBatch(batch, RX_WRITE_BATCH);
+        if (count == 0) {
+            if (++idleSpins < RX_IDLE_SPINS) {
+                std::this_thread::yield();
+                continue;
+            }
+            // Publish that we are about to sleep, then re-check so a push racing with us is not missed
+            std::unique_lock<std::mutex> lock(writerMutex_);
+            writerSleeping_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (running_ && rxQueue_.empty()) {
+                writerCv_.wait_for(lock, RX_IDLE_WAIT);
             }
+            writerSleeping_.store(false, std::memory_order_relaxed);
+            idleSpins = 0;
+            continue;
+        }
+        idleSpins = 0;
 
-            // 2. If not found, try Steam's FakeIP resolution
-            if (targetSteamID == k_steamIDNil) {
-                SteamNetworkingIPAddr fakeIP;
-                fakeIP.SetIPv4(destIP, 0); // Port 0
-                
-                SteamNetworkingIdentity identity;
-                EResult result = SteamNetworkingUtils()->GetRealIdentityForFakeIP(fakeIP, &identity);
-                
-                if (result == k_EResultOK) {
-                    targetSteamID = identity.GetSteamID();
-                    // Cache it? Maybe not, let the protocol handle updates.
-                }
+        STAGE_TIMESTAMP(dequeuedNs);
+        uint64_t bytes = 0;
+        for (size_t i = 0; i < count; ++i) {
+            buffers[i] = batch[i].packet;
+            lengths[i] = batch[i].length;
+            bytes += batch[i].length;
+#ifdef CONNECTTOOL_STAGE_TIMING
+            StageTimings::instance().record(DataPathStage::RxQueueWait, dequeuedNs - batch[i].enqueuedNs);
+#endif
+        }
+        // Straight from the transport's buffers, then hand them back
+        {
+            STAGE_SCOPE(DataPathStage::RxTunWrite);
+            tunDevice_->write_batch(buffers, lengths, static_cast<int>(count));
+        }
+        int64_t writtenUs = TraceClock::now();
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t sender = batch[i].message.sender();
+            flightRecorder_.record(FlightPoint::TunWrite, writtenUs, sender, batch[i].packet, batch[i].length);
+            if (batch[i].traceId) {
+                tracer_.record(batch[i].traceId, TraceHop::TunWrite, writtenUs, sender,
+                               static_cast<uint32_t>(batch[i].length));
             }
-            
-            if (targetSteamID != k_steamIDNil) {
-                // Backpressure check
-                int pendingBytes = steamManager_->getPendingSendBytes(targetSteamID);
-                int retryCount = 0;
-                // Allow up to 128KB buffer, wait max 50ms
-                const int MAX_PENDING_BYTES = 128 * 1024; 
-                const int MAX_RETRIES = 50; 
-                
-                while (pendingBytes > MAX_PENDING_BYTES) { 
-                     if (retryCount >= MAX_RETRIES) {
-                         // std::cout << "[VPN] Dropping packet to " << targetSteamID.ConvertToUint64() 
-                         //           << " due to buffer overflow (" << pendingBytes << " bytes pending)" << std::endl;
-                         goto skip_send; 
-                     }
-                     
-                     std::this_thread::sleep_for(std::chrono::milliseconds(1));
-                     pendingBytes = steamManager_->getPendingSendBytes(targetSteamID);
-                     retryCount++;
-                }
+            batch[i].message.reset();
+        }
 
-                // Found a real identity
-                sendVpnMessage(VpnMessageType::IP_PACKET, buffer.data(), bytesRead, targetSteamID, false);
-                
-                {
-                    std::lock_guard<std::mutex> lock(statsMutex_);
-                    stats_.packetsSent++;
-                    stats_.bytesSent += bytesRead;
-                }
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.packetsReceived += count;
+        stats_.bytesReceived += bytes;
+        stats_.tunWriteBatches++;
+    }
+
+    std::cout << "TUN write thread stopped" << std::endl;
+}
+
+void SteamVpnBridge::drainRxQueue() {
+    RxPacket batch[RX_WRITE_BATCH];
+    size_t count;
+    while ((count = rxQueue_.popBatch(batch, RX_WRITE_BATCH)) > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            batch[i].message.reset();
+        }
+    }
+}
+
+void SteamVpnBridge::processTunPacket(uint8_t* packet, size_t length, const PacketMeta& meta) {
+    FlowCache::Entry* flow = nullptr;
+    FlowCache::Entry uncached;
+    {
+        STAGE_SCOPE(DataPathStage::TxRoute);
+
+        // Remote endpoints negotiate MSS from their own links; clamp it to the tunnel
+        uint16_t maxMss = (meta.version == 6 ? maxTcpMss6_ : maxTcpMss_).load(std::memory_order_relaxed);
+        if (clampTcpMss(packet, length, maxMss)) {
+            std::lock_guard<std::mutex> lock(statsMutex_);
+            stats_.tcpMssClamped++;
+        }
+
+        // Packets the transport cannot carry in one message would silently vanish;
+        // tell DF senders right away. IPv6 packets up to the minimum link MTU are
+        // always sent and left to Steam to fragment.
+        size_t limit = static_cast<size_t>(maxPacketSize_.load(std::memory_order_relaxed));
+        if (meta.version == 6) limit = std::max(limit, static_cast<size_t>(IPV6_MIN_MTU));
+        if (length > limit && handleOversizePacket(packet, length)) {
+            flightRecorder_.record(FlightPoint::SteamSend, TraceClock::now(), 0, packet, length, FlightDrop::Oversize);
+            return;
+        }
 
-                skip_send:;
+        // Established flows take a single hash probe; everything else is
+        // resolved once per route generation and cached
+        FlowKey key;
+        bool cacheable = FlowCache::buildKey(meta, packet, key);
+        uint32_t generation = routeGeneration_.load(std::memory_order_acquire);
+        flow = cacheable ? flowCache_.lookup(key, generation) : nullptr;
+
+        if (!flow) {
+            uint64_t peer = 0;
+            uint8_t flags = resolveFlow(packet, length, meta, peer);
+            // FakeIP resolution may start succeeding without a route change we can
+            // observe, so unresolved IPv4 destinations are resolved again next time
+            if (cacheable && flags != FlowCache::FLOW_DROP) {
+                flow = flowCache_.insert(key, generation, peer, meta.dscp, flags);
             } else {
-                // Unknown Fake IP or Broadcast
-                // Check for global broadcast (255.255.255.255) or Link-Local broadcast (169.254.255.255)
-                // Since FakeIP is 169.254.0.0/16, the broadcast is 169.254.255.255.
-                if (destIP == 0xFFFFFFFF || destIP == 0xA9FEFFFF) { // 255.255.255.255 or 169.254.255.255
-                     broadcastVpnMessage(VpnMessageType::IP_PACKET, buffer.data(), bytesRead, false);
-                     
-                     auto members = steamManager_->getRoomMembers();
-                     std::lock_guard<std::mutex> lock(statsMutex_);
-                     stats_.packetsSent += members.size();
-                     stats_.bytesSent += bytesRead * members.size();
-                }
+                uncached = FlowCache::Entry{};
+                uncached.peerSteamId = peer;
+                uncached.trafficClass = meta.dscp;
+                uncached.flags = flags;
+                flow = &uncached;
             }
         }
     }
+
+    dispatchFlow(*flow, packet, length);
+}
+
+uint8_t SteamVpnBridge::resolveFlow(const uint8_t* packet, size_t length, const PacketMeta& meta, uint64_t& peer) {
+    if (meta.version == 6) {
+        Ipv6Address destIP;
+        extractDestIPv6(packet, length, destIP);
+
+        // Multicast chatter (ND, MLD, mDNS, SSDP...) is not routable across the
+        // tunnel; flooding it to every peer only wastes bandwidth.
+        if (isIpv6Unicast(destIP)) {
+            std::lock_guard<std::mutex> lock(routingMutex_);
+            auto it = routingTableV6_.find(destIP);
+            if (it != routingTableV6_.end()) {
+                peer = it->second.steamID.ConvertToUint64();
+                return FlowCache::FLOW_UNICAST | FlowCache::FLOW_IPV6;
+            }
+        }
+        return FlowCache::FLOW_DROP | FlowCache::FLOW_IPV6;
+    }
+
+    uint32_t destIP = meta.dstIP;
     
-    std::cout << "TUN read thread stopped" << std::endl;
+    // 1. Try local routing table first
+    CSteamID targetSteamID = k_steamIDNil;
+    {
+        std::lock_guard<std::mutex> lock(routingMutex_);
+        auto it = routingTable_.find(destIP);
+        if (it != routingTable_.end()) {
+            targetSteamID = it->second.steamID;
+        }
+    }
+
+    // 2. If not found, let the transport resolve it (Steam FakeIP)
+    if (targetSteamID == k_steamIDNil) {
+        targetSteamID = CSteamID(transport_->resolveAddress(destIP));
+    }
+
+    if (targetSteamID != k_steamIDNil) {
+        peer = targetSteamID.ConvertToUint64();
+        return FlowCache::FLOW_UNICAST;
+    }
+
+    // Unknown Fake IP or Broadcast
+    // Check for global broadcast (255.255.255.255) or Link-Local broadcast (169.254.255.255)
+    // Since FakeIP is 169.254.0.0/16, the broadcast is 169.254.255.255.
+    if (destIP == 0xFFFFFFFF || destIP == 0xA9FEFFFF) { // 255.255.255.255 or 169.254.255.255
+        return FlowCache::FLOW_BROADCAST;
+    }
+    return FlowCache::FLOW_DROP;
 }
 
-void SteamVpnBridge::handleVpnMessage(const uint8_t* data, size_t length, CSteamID senderSteamID) {
+void SteamVpnBridge::dispatchFlow(FlowCache::Entry& flow, const uint8_t* packet, size_t length) {
+    if (flow.flags & FlowCache::FLOW_UNICAST) {
+        forwardToPeer(CSteamID(flow.peerSteamId), packet, length, flow.sendCredit);
+    } else if (flow.flags & FlowCache::FLOW_BROADCAST) {
+        int peers;
+        {
+            STAGE_SCOPE(DataPathStage::TxSend);
+            peers = broadcastVpnMessage(VpnMessageType::IP_PACKET, packet, length, false);
+        }
+        flightRecorder_.record(FlightPoint::SteamSend, TraceClock::now(), 0, packet, length);
+        capture_.offer(CaptureDirection::Outbound, 0, packet, length);
+        
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.packetsSent += peers;
+        stats_.bytesSent += length * peers;
+    } else {
+        flightRecorder_.record(FlightPoint::SteamSend, TraceClock::now(), 0, packet, length, FlightDrop::NoRoute);
+        if (flow.flags & FlowCache::FLOW_IPV6) {
+            // Unknown IPv4 destinations are ignored as before; IPv6 drops are accounted
+            std::lock_guard<std::mutex> lock(statsMutex_);
+            stats_.packetsDropped++;
+            stats_.ipv6Unroutable++;
+        }
+    }
+}
+
+bool SteamVpnBridge::forwardToPeer(CSteamID targetSteamID, const uint8_t* packet, size_t length,
+                                   uint32_t& sendCredit) {
+    // Pending bytes allowed before waiting (1ms per retry) and dropping, see networking.send_*;
+    // a flow may send up to MAX_SEND_CREDIT on one backpressure reading before asking Steam again
+    const auto& net = txConfig_->networking;
+    const int MAX_PENDING_BYTES = net.send_pending_limit_kb * 1024;
+    const int MAX_RETRIES = net.send_backpressure_wait_ms;
+    const int MAX_SEND_CREDIT = net.send_credit_kb * 1024;
+
+    if (sendCredit < length) {
+        // Backpressure check
+        int pendingBytes = transport_->getPendingSendBytes(targetSteamID.ConvertToUint64());
+        int retryCount = 0;
+        
+        while (pendingBytes > MAX_PENDING_BYTES) { 
+            if (retryCount >= MAX_RETRIES) {
+                sendCredit = 0;
+                flightRecorder_.record(FlightPoint::SteamSend, TraceClock::now(), targetSteamID.ConvertToUint64(),
+                                       packet, length, FlightDrop::Backpressure);
+                peerStats_.recordDrop(targetSteamID.ConvertToUint64(), PeerDropReason::Backpressure);
+                std::lock_guard<std::mutex> lock(statsMutex_);
+                stats_.packetsDropped++;
+                return false;
+            }
+            
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            pendingBytes = transport_->getPendingSendBytes(targetSteamID.ConvertToUint64());
+            retryCount++;
+        }
+        sendCredit = static_cast<uint32_t>(std::min(MAX_PENDING_BYTES - pendingBytes, MAX_SEND_CREDIT));
+    }
+    sendCredit = sendCredit > length ? sendCredit - static_cast<uint32_t>(length) : 0;
+
+    bool sent;
+    {
+        STAGE_SCOPE(DataPathStage::TxSend);
+        // A sampled packet that has no room for the trace extension goes out untraced
+        bool traced = txTrace_.traceId &&
+            length + sizeof(PacketTraceExtension) <= static_cast<size_t>(maxPacketSize_.load(std::memory_order_relaxed));
+        sent = traced ? sendTracedPacket(targetSteamID, packet, length)
+                      : sendVpnMessage(VpnMessageType::IP_PACKET, packet, length, targetSteamID, false);
+    }
+    flightRecorder_.record(FlightPoint::SteamSend, TraceClock::now(), targetSteamID.ConvertToUint64(), packet, length,
+                           sent ? FlightDrop::None : FlightDrop::SendFailed);
+    if (!sent) {
+        peerStats_.recordDrop(targetSteamID.ConvertToUint64(), PeerDropReason::SendFailed);
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.packetsDropped++;
+        return false;
+    }
+    peerStats_.recordSent(targetSteamID.ConvertToUint64(), length);
+    capture_.offer(CaptureDirection::Outbound, targetSteamID.ConvertToUint64(), packet, length);
+    
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    stats_.packetsSent++;
+    stats_.bytesSent += length;
+    return true;
+}
+
+bool SteamVpnBridge::sendTracedPacket(CSteamID targetSteamID, const uint8_t* packet, size_t length) {
+    PacketTraceExtension extension{txTrace_.traceId, TraceClock::now()};
+    std::vector<uint8_t> payload(sizeof(extension) + length);
+    memcpy(payload.data(), &extension, sizeof(extension));
+    memcpy(payload.data() + sizeof(extension), packet, length);
+
+    bool sent = sendVpnMessage(VpnMessageType::IP_PACKET_TRACED, payload.data(), payload.size(), targetSteamID, false);
+
+    // Hops are only kept for packets that actually left with their trace id
+    if (sent) {
+        uint64_t peer = targetSteamID.ConvertToUint64();
+        uint32_t bytes = static_cast<uint32_t>(length);
+        tracer_.record(extension.traceId, TraceHop::TunRead, txTrace_.readUs, peer, bytes);
+        tracer_.record(extension.traceId, TraceHop::Classify, txTrace_.classifiedUs, peer, bytes);
+        tracer_.record(extension.traceId, TraceHop::Enqueue, extension.sentAtUs, peer, bytes);
+        tracer_.record(extension.traceId, TraceHop::SteamSend, TraceClock::now(), peer, bytes);
+    }
+    return sent;
+}
+
+void SteamVpnBridge::learnIpv6Neighbor(const uint8_t* packet, size_t length, CSteamID senderSteamID) {
+    Ipv6Address sourceIP;
+    if (!extractSourceIPv6(packet, length, sourceIP) || !isIpv6Unicast(sourceIP)) {
+        return;
+    }
+
+    // Every packet of a known neighbor ends up here, so a source already checked
+    // under the current route generation skips the table and its lock. Any route
+    // change, including a peer leaving, bumps the generation.
+    uint64_t peer = senderSteamID.ConvertToUint64();
+    KnownIpv6Source& known = knownIpv6Sources_[hashIpv6Source(peer, sourceIP) & (KNOWN_IPV6_SOURCE_SLOTS - 1)];
+    uint32_t generation = routeGeneration_.load(std::memory_order_acquire);
+    if (known.peer == peer && known.generation == generation && known.address == sourceIP) return;
+
+    std::lock_guard<std::mutex> lock(routingMutex_);
+    // The generation was read before the table check, a route change racing it leaves the entry stale
+    known.peer = peer;
+    known.address = sourceIP;
+    known.generation = generation;
+
+    // A source address never takes over an existing route: announced addresses
+    // belong to their announcer, learned ones to the first peer that used them
+    // until it leaves. Otherwise any peer could redirect another peer's traffic.
+    if (routingTableV6_.count(sourceIP)) return;
+
+    size_t& learned = learnedV6Count_[senderSteamID];
+    if (learned >= MAX_IPV6_NEIGHBORS_PER_PEER) return;
+    learned++;
+
+    Ipv6Route& route = routingTableV6_[sourceIP];
+    route.steamID = senderSteamID;
+    route.learned = true;
+    invalidateFlows();
+    std::cout << "[VPN] Learned IPv6 neighbor: " << ipv6ToString(sourceIP)
+              << " -> " << senderSteamID.ConvertToUint64() << std::endl;
+}
+
+void SteamVpnBridge::setAdvertisedIpv4Route(uint32_t address, const Ipv6Address& ipv6Address, CSteamID steamID) {
+    Ipv4Route& route = routingTable_[address];
+    updateRoute(route.steamID, steamID);
+    // Older peers announce no IPv6 address, the route then has none
+    route.ipv6Address = isIpv6Unicast(ipv6Address) ? ipv6Address : Ipv6Address{};
+}
+
+void SteamVpnBridge::setAdvertisedIpv6Route(const Ipv6Address& address, CSteamID steamID) {
+    Ipv6Route& route = routingTableV6_[address];
+    if (route.learned) {
+        // The owner announced it after all, or a learned guess is corrected
+        size_t& learned = learnedV6Count_[route.steamID];
+        if (learned > 0) learned--;
+        route.learned = false;
+    }
+    updateRoute(route.steamID, steamID);
+}
+
+bool SteamVpnBridge::handleOversizePacket(const uint8_t* packet, size_t length) {
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.oversizePackets++;
+    }
+
+    // IPv6 routers never fragment, every IPv6 packet behaves as if DF were set
+    bool isIpv6 = getIpVersion(packet, length) == 6;
+    if (!isIpv6 && !isIpv4DontFragment(packet, length)) {
+        return false;
+    }
+
+    // ICMP type 3 code 4 / ICMPv6 Packet Too Big with the real tunnel MTU,
+    // so the sender adapts within one RTT
+    uint8_t reply[ICMPV6_ERROR_MAX_SIZE];
+    size_t replyLength = isIpv6
+        ? buildIcmpv6PacketTooBig(packet, length, static_cast<uint32_t>(tunMtu6_.load(std::memory_order_relaxed)),
+                                  reply, sizeof(reply))
+        : buildIcmpFragNeeded(packet, length, static_cast<uint16_t>(tunMtu_.load(std::memory_order_relaxed)),
+                              reply, sizeof(reply));
+    if (replyLength > 0) {
+        tunDevice_->write(reply, replyLength);
+    }
+
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    stats_.packetsDropped++;
+    if (replyLength > 0) stats_.icmpFragNeededSent++;
+    return true;
+}
+
+void SteamVpnBridge::handleVpnMessage(MessageHandle& message) {
+    VpnMessageHeader header;
+    if (message.size() < sizeof(VpnMessageHeader)) return;
+    memcpy(&header, message.data(), sizeof(VpnMessageHeader));
+    uint16_t payloadLength = ntohs(header.length);
+
+    // Control messages and packets arriving while stopped are handled inline
+    bool traced = header.type == VpnMessageType::IP_PACKET_TRACED;
+    if ((header.type != VpnMessageType::IP_PACKET && !traced) || !running_ ||
+        message.size() < sizeof(VpnMessageHeader) + payloadLength ||
+        (traced && payloadLength < sizeof(PacketTraceExtension))) {
+        handleVpnMessage(message.data(), message.size(), CSteamID(message.sender()));
+        return;
+    }
+    STAGE_SCOPE(DataPathStage::RxDispatch);
+
+    uint64_t sender = message.sender();
+    int64_t receivedUs = message.receivedAtUs() > 0 ? TraceClock::fromSteadyUs(message.receivedAtUs())
+                                                    : TraceClock::now();
+    uint8_t* payload = message.data() + sizeof(VpnMessageHeader);
+    PacketTraceExtension trace{};
+    if (traced) {
+        memcpy(&trace, payload, sizeof(trace));
+        payload += sizeof(trace);
+        payloadLength -= sizeof(trace);
+        tracer_.record(trace.traceId, TraceHop::SteamReceive, receivedUs, sender, payloadLength, trace.sentAtUs);
+    }
+
+    // Bound the transport buffers held by the TUN writer
+    if (!message.charge(rxBudget_)) {
+        flightRecorder_.record(FlightPoint::SteamReceive, receivedUs, sender, payload, payloadLength,
+                               FlightDrop::RxInFlightLimit);
+        peerStats_.recordDrop(sender, PeerDropReason::RxInFlightLimit);
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.packetsDropped++;
+        stats_.rxInFlightRejected++;
+        return;
+    }
+    // Recorded before the push: once queued, the TUN writer may release the message at any time
+    flightRecorder_.record(FlightPoint::SteamReceive, receivedUs, sender, payload, payloadLength);
+
+    // Parsing and in-place rewrites stay on the receive thread, only the TUN write is deferred
+    bool isIpv6 = getIpVersion(payload, payloadLength) == 6;
+    if (isIpv6) {
+        learnIpv6Neighbor(payload, payloadLength, CSteamID(message.sender()));
+    }
+    uint16_t maxMss = (isIpv6 ? maxTcpMss6_ : maxTcpMss_).load(std::memory_order_relaxed);
+    bool clamped = clampTcpMss(payload, payloadLength, maxMss);
+    // Captured as it will be written, and like the flight recorder before the push
+    capture_.offer(CaptureDirection::Inbound, sender, payload, payloadLength);
+
+    RxPacket item{std::move(message), payload, payloadLength};
+    item.traceId = trace.traceId;
+#ifdef CONNECTTOOL_STAGE_TIMING
+    item.enqueuedNs = StageTimings::now();
+#endif
+    // Taken before the push, the writer may record tun_write right after it
+    int64_t dispatchedUs = traced ? TraceClock::now() : 0;
+    if (!rxQueue_.tryPush(std::move(item))) {
+        flightRecorder_.markLastDropped(FlightPoint::SteamReceive, FlightDrop::RxQueueFull);
+        peerStats_.recordDrop(sender, PeerDropReason::RxQueueFull);
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.packetsDropped++;
+        stats_.rxQueueDrops++;
+        if (clamped) stats_.tcpMssClamped++;
+        return;
+    }
+
+    peerStats_.recordReceived(sender, payloadLength);
+    if (traced) {
+        tracer_.record(trace.traceId, TraceHop::Dispatch, dispatchedUs, sender, payloadLength);
+    }
+
+    uint64_t depth = rxQueue_.size();
+    if (depth > rxQueueHighWater_.load(std::memory_order_relaxed)) {
+        rxQueueHighWater_.store(depth, std::memory_order_relaxed);
+    }
+    if (clamped) {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.tcpMssClamped++;
+    }
+
+    // Pairs with the fence in tunWriteThread
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (writerSleeping_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(writerMutex_);
+        writerCv_.notify_one();
+    }
+}
+
+void SteamVpnBridge::handleVpnMessage(uint8_t* data, size_t length, CSteamID senderSteamID) {
     if (length < sizeof(VpnMessageHeader)) return;
 
     VpnMessageHeader header;
@@ -258,35 +743,57 @@ void SteamVpnBridge::handleVpnMessage(const uint8_t* data, size_t length, CSteam
 
     if (length < sizeof(VpnMessageHeader) + payloadLength) return;
 
-    const uint8_t* payload = data + sizeof(VpnMessageHeader);
+    uint8_t* payload = data + sizeof(VpnMessageHeader);
+
+    // Traced packets are delivered untraced on this path
+    if (header.type == VpnMessageType::IP_PACKET_TRACED) {
+        if (payloadLength < sizeof(PacketTraceExtension)) return;
+        payload += sizeof(PacketTraceExtension);
+        payloadLength -= sizeof(PacketTraceExtension);
+        header.type = VpnMessageType::IP_PACKET;
+    }
     
     switch (header.type) {
         case VpnMessageType::IP_PACKET: {
             if (tunDevice_) {
+                bool isIpv6 = getIpVersion(payload, payloadLength) == 6;
+                if (isIpv6) {
+                    learnIpv6Neighbor(payload, payloadLength, senderSteamID);
+                }
+
+                // The sender may run with a larger MTU, clamp again for our side
+                uint16_t maxMss = (isIpv6 ? maxTcpMss6_ : maxTcpMss_).load(std::memory_order_relaxed);
+                bool clamped = clampTcpMss(payload, payloadLength, maxMss);
+                capture_.offer(CaptureDirection::Inbound, senderSteamID.ConvertToUint64(), payload, payloadLength);
+
                 // Write directly to TUN
                 tunDevice_->write(payload, payloadLength);
                 
                 std::lock_guard<std::mutex> lock(statsMutex_);
                 stats_.packetsReceived++;
                 stats_.bytesReceived += payloadLength;
+                if (clamped) stats_.tcpMssClamped++;
             }
             break;
         }
         case VpnMessageType::IP_QUERY: {
-            if (payloadLength >= sizeof(IpQueryPayload)) {
-                IpQueryPayload query;
-                memcpy(&query, payload, sizeof(IpQueryPayload));
+            if (payloadLength >= IP_QUERY_PAYLOAD_V4_SIZE) {
+                // Older peers omit the IPv6 address, leave it zeroed
+                IpQueryPayload query{};
+                memcpy(&query, payload, std::min<size_t>(payloadLength, sizeof(IpQueryPayload)));
                 
                 // Learn sender's IP immediately
                 if (query.ipAddress != 0) {
                      std::lock_guard<std::mutex> lock(routingMutex_);
-                     routingTable_[query.ipAddress] = senderSteamID;
+                     setAdvertisedIpv4Route(query.ipAddress, query.ipv6Address, senderSteamID);
                      
-                     char szIP[64];
-                     SteamNetworkingIPAddr ipAddr;
-                     ipAddr.SetIPv4(query.ipAddress, 0);
-                     ipAddr.ToString(szIP, sizeof(szIP), false);
-                     std::cout << "[VPN] Learned IP from Query: " << szIP << " -> " << senderSteamID.ConvertToUint64() << std::endl;
+                     std::cout << "[VPN] Learned IP from Query: " << ipToString(query.ipAddress) << " -> " << senderSteamID.ConvertToUint64() << std::endl;
+                }
+                if (isIpv6Unicast(query.ipv6Address)) {
+                    std::lock_guard<std::mutex> lock(routingMutex_);
+                    setAdvertisedIpv6Route(query.ipv6Address, senderSteamID);
+                    std::cout << "[VPN] Learned IPv6 from Query: " << ipv6ToString(query.ipv6Address)
+                              << " -> " << senderSteamID.ConvertToUint64() << std::endl;
                 }
             }
 
@@ -295,19 +802,20 @@ void SteamVpnBridge::handleVpnMessage(const uint8_t* data, size_t length, CSteam
             break;
         }
         case VpnMessageType::IP_RESPONSE: {
-            if (payloadLength >= sizeof(IpResponsePayload)) {
-                IpResponsePayload response;
-                memcpy(&response, payload, sizeof(IpResponsePayload));
+            if (payloadLength >= IP_RESPONSE_PAYLOAD_V4_SIZE) {
+                // Older peers omit the IPv6 address, leave it zeroed
+                IpResponsePayload response{};
+                memcpy(&response, payload, std::min<size_t>(payloadLength, sizeof(IpResponsePayload)));
                 
                 std::lock_guard<std::mutex> lock(routingMutex_);
-                routingTable_[response.ipAddress] = senderSteamID;
-                
-                char szIP[64];
-                SteamNetworkingIPAddr ipAddr;
-                ipAddr.SetIPv4(response.ipAddress, 0);
-                ipAddr.ToString(szIP, sizeof(szIP), false);
+                setAdvertisedIpv4Route(response.ipAddress, response.ipv6Address, senderSteamID);
+                if (isIpv6Unicast(response.ipv6Address)) {
+                    setAdvertisedIpv6Route(response.ipv6Address, senderSteamID);
+                    std::cout << "[VPN] Learned IPv6 from Response: " << ipv6ToString(response.ipv6Address)
+                              << " -> " << senderSteamID.ConvertToUint64() << std::endl;
+                }
                 
-                std::cout << "[VPN] Learned IP from Response: " << szIP << " -> " << senderSteamID.ConvertToUint64() << std::endl;
+                std::cout << "[VPN] Learned IP from Response: " << ipToString(response.ipAddress) << " -> " << senderSteamID.ConvertToUint64() << std::endl;
             }
             break;
         }
@@ -316,31 +824,163 @@ void SteamVpnBridge::handleVpnMessage(const uint8_t* data, size_t length, CSteam
     }
 }
 
+void SteamVpnBridge::invalidateFlows() {
+    routeGeneration_.fetch_add(1, std::memory_order_release);
+}
+
+void SteamVpnBridge::updateRoute(CSteamID& slot, CSteamID steamID) {
+    if (slot != steamID) {
+        slot = steamID;
+        invalidateFlows();
+    }
+}
+
 void SteamVpnBridge::onUserJoined(CSteamID steamID) {
     std::cout << "User joined: " << steamID.ConvertToUint64() << std::endl;
+    peerStats_.addPeer(steamID.ConvertToUint64());
+    invalidateFlows();
     // Send IP Query to the new user to get their IP
     sendIpQuery(steamID);
 }
 
 void SteamVpnBridge::onUserLeft(CSteamID steamID) {
     std::cout << "User left: " << steamID.ConvertToUint64() << std::endl;
+    peerStats_.removePeer(steamID.ConvertToUint64());
     
     std::lock_guard<std::mutex> lock(routingMutex_);
     for (auto it = routingTable_.begin(); it != routingTable_.end(); ) {
-        if (it->second == steamID) {
+        if (it->second.steamID == steamID) {
             it = routingTable_.erase(it);
         } else {
             ++it;
         }
     }
+    for (auto it = routingTableV6_.begin(); it != routingTableV6_.end(); ) {
+        if (it->second.steamID == steamID) {
+            it = routingTableV6_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    learnedV6Count_.erase(steamID);
+    invalidateFlows();
+}
+
+int SteamVpnBridge::selectTunMtu(int configuredMtu) {
+    int dataSize = transport_->getMtuDataSize();
+    maxPacketSize_.store(dataSize - static_cast<int>(sizeof(VpnMessageHeader)), std::memory_order_relaxed);
+
+    int mtu = calculateTunMtu(dataSize);
+    if (configuredMtu > 0 && configuredMtu < mtu) {
+        std::cout << "[MTU] Using config MTU (" << configuredMtu
+                  << ") instead of calculated (" << mtu << ")" << std::endl;
+        mtu = configuredMtu;
+    }
+    return mtu;
+}
+
+void SteamVpnBridge::applyTunMtu(int mtu) {
+    int mtu6 = std::max(mtu, IPV6_MIN_MTU);
+    uint16_t mss = calculateTcpMss(mtu);
+    uint16_t mss6 = static_cast<uint16_t>(calculateTcpMss(mtu6) - 20);
+    // 数据路径随时读取，各值单独生效；切换瞬间 MTU 与 MSS 不一致无害
+    tunMtu_.store(mtu, std::memory_order_relaxed);
+    tunMtu6_.store(mtu6, std::memory_order_relaxed);
+    maxTcpMss_.store(mss, std::memory_order_relaxed);
+    maxTcpMss6_.store(mss6, std::memory_order_relaxed);
+    std::cout << "[MTU] Clamping TCP MSS to: " << mss << " (IPv6: " << mss6 << ")" << std::endl;
+}
+
+int SteamVpnBridge::reconfigureMtu(int configuredMtu) {
+    int mtu = pendingTunMtu(configuredMtu);
+    if (mtu == 0) return getTunMtu();
+    return setTunDeviceMtu(mtu) ? mtu : -1;
+}
+
+int SteamVpnBridge::pendingTunMtu(int configuredMtu) {
+    if (!running_ || !tunDevice_) return 0;
+
+    int mtu = selectTunMtu(configuredMtu);
+    return mtu == tunMtu_.load(std::memory_order_relaxed) ? 0 : mtu;
+}
+
+bool SteamVpnBridge::setTunDeviceMtu(int mtu) {
+    std::lock_guard<std::mutex> lock(tunDeviceMutex_);
+    // Stopped (or stopping) since the MTU was picked
+    if (!running_ || !tunDevice_) return false;
+    if (!tunDevice_->set_mtu(mtu)) {
+        std::cerr << "Failed to set TUN device MTU: " << tunDevice_->get_last_error() << std::endl;
+        return false;
+    }
+    std::cout << "TUN device MTU changed to: " << mtu << std::endl;
+    applyTunMtu(mtu);
+    return true;
+}
+
+int SteamVpnBridge::getTunMtu() const {
+    return running_ ? tunMtu_.load(std::memory_order_relaxed) : 0;
+}
+
+void SteamVpnBridge::setRxInFlightLimit(size_t bytes) {
+    rxBudget_.setMaxBytes(bytes);
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    stats_.rxInFlightLimitBytes = bytes;
 }
 
 SteamVpnBridge::Statistics SteamVpnBridge::getStatistics() const {
     std::lock_guard<std::mutex> lock(statsMutex_);
-    return stats_;
+    Statistics result = stats_;
+    result.flowCacheHits = flowCache_.hits();
+    result.flowCacheMisses = flowCache_.misses();
+    result.rxQueueDepth = rxQueue_.size();
+    result.rxQueueHighWater = rxQueueHighWater_.load(std::memory_order_relaxed);
+    result.rxInFlightBytes = rxBudget_.bytes();
+    result.rxInFlightPeakBytes = rxBudget_.peakBytes();
+    return result;
+}
+
+void SteamVpnBridge::updatePeerLink(CSteamID steamID, const PeerLinkMetrics& link) {
+    peerStats_.updateLink(steamID.ConvertToUint64(), link);
+}
+
+void SteamVpnBridge::samplePeerRates() {
+    peerStats_.sampleRates(std::chrono::steady_clock::now());
+}
+
+std::vector<PeerStatsTable::Snapshot> SteamVpnBridge::getPeerStatistics() const {
+    return peerStats_.snapshot();
+}
+
+void SteamVpnBridge::setTraceSampleEvery(uint32_t every) {
+    tracer_.setSampleEvery(every);
+}
+
+uint32_t SteamVpnBridge::getTraceSampleEvery() const {
+    return tracer_.sampleEvery();
+}
+
+std::string SteamVpnBridge::dumpPacketTrace(uint64_t localSteamId, bool clear, size_t* eventCount) {
+    return tracer_.dumpChromeTrace(localSteamId, clear, eventCount);
+}
+
+std::string SteamVpnBridge::dumpFlightRecorder(size_t* recordCount) const {
+    return flightRecorder_.dumpPcapng(recordCount);
+}
+
+int SteamVpnBridge::openCapture(const CaptureFilter& filter, uint32_t snaplen) {
+    return capture_.open(filter, snaplen);
+}
+
+void SteamVpnBridge::closeCapture(int session) {
+    capture_.close(session);
+}
+
+size_t SteamVpnBridge::pollCapture(int session, PacketCapture::Record* out, size_t maxRecords, uint64_t* dropped) {
+    if (dropped) *dropped = capture_.takeDropped(session);
+    return capture_.poll(session, out, maxRecords);
 }
 
-void SteamVpnBridge::sendVpnMessage(VpnMessageType type, const uint8_t* payload, 
+bool SteamVpnBridge::sendVpnMessage(VpnMessageType type, const uint8_t* payload, 
                                      size_t payloadLength, CSteamID targetSteamID, bool reliable) {
     std::vector<uint8_t> message;
     VpnMessageHeader header;
@@ -353,13 +993,13 @@ void SteamVpnBridge::sendVpnMessage(VpnMessageType type, const uint8_t* payload,
         memcpy(message.data() + sizeof(VpnMessageHeader), payload, payloadLength);
     }
     
-    int flags = reliable ? k_nSteamNetworkingSend_Reliable : 
-                           (k_nSteamNetworkingSend_UnreliableNoNagle | k_nSteamNetworkingSend_NoDelay);
-    steamManager_->sendMessageToUser(targetSteamID, message.data(), 
+    int flags = reliable ? TRANSPORT_SEND_RELIABLE : 
+                           (TRANSPORT_SEND_NO_NAGLE | TRANSPORT_SEND_NO_DELAY);
+    return transport_->sendToPeer(targetSteamID.ConvertToUint64(), message.data(), 
         static_cast<uint32_t>(message.size()), flags);
 }
 
-void SteamVpnBridge::broadcastVpnMessage(VpnMessageType type, const uint8_t* payload, 
+int SteamVpnBridge::broadcastVpnMessage(VpnMessageType type, const uint8_t* payload, 
                                           size_t payloadLength, bool reliable) {
     std::vector<uint8_t> message;
     VpnMessageHeader header;
@@ -372,14 +1012,15 @@ void SteamVpnBridge::broadcastVpnMessage(VpnMessageType type, const uint8_t* pay
         memcpy(message.data() + sizeof(VpnMessageHeader), payload, payloadLength);
     }
     
-    int flags = reliable ? k_nSteamNetworkingSend_Reliable : 
-                           (k_nSteamNetworkingSend_UnreliableNoNagle | k_nSteamNetworkingSend_NoDelay);
-    steamManager_->broadcastMessage(message.data(), static_cast<uint32_t>(message.size()), flags);
+    int flags = reliable ? TRANSPORT_SEND_RELIABLE : 
+                           (TRANSPORT_SEND_NO_NAGLE | TRANSPORT_SEND_NO_DELAY);
+    return transport_->broadcast(message.data(), static_cast<uint32_t>(message.size()), flags);
 }
 
 void SteamVpnBridge::sendIpQuery(CSteamID target) {
-    IpQueryPayload payload;
+    IpQueryPayload payload{};
     payload.ipAddress = localIP_;  // Include local IP
+    payload.ipv6Address = localIPv6_;
     // Fill payload if needed, currently empty/NodeID only
     
     if (target == k_steamIDNil) {
@@ -392,8 +1033,9 @@ void SteamVpnBridge::sendIpQuery(CSteamID target) {
 }
 
 void SteamVpnBridge::sendIpResponse(CSteamID target) {
-    IpResponsePayload payload;
+    IpResponsePayload payload{};
     payload.ipAddress = localIP_;
+    payload.ipv6Address = localIPv6_;
     // NodeID could be added here if we were using it
     
     std::cout << "[VPN] Sending IP Response to " << target.ConvertToUint64() << std::endl;
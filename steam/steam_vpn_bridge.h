@@ -1,6 +1,7 @@
 #ifndef STEAM_VPN_BRIDGE_H
 #define STEAM_VPN_BRIDGE_H
 
+#include <array>
 #include <memory>
 #include <thread>
 #include <atomic>
@@ -9,25 +10,37 @@
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <condition_variable>
 #include <steam_api.h>
 #include <isteamnetworkingmessages.h>
 
 #include "../tun/tun_interface.h"
+#include "../transport/transport_interface.h"
+#include "../transport/message_handle.h"
 #include "../vpn/vpn_protocol.h"
-
-// Forward declarations
-class SteamNetworkingManager;
+#include "../vpn/flow_cache.h"
+#include "../vpn/peer_stats.h"
+#include "../vpn/packet_tracer.h"
+#include "../vpn/flight_recorder.h"
+#include "../vpn/packet_capture.h"
+#include "../core/spsc_ring.h"
+#include "../core/stage_timing.h"
+#include "../config/config_manager.h"
 
 /**
  * @brief Steam VPN桥接器（ISteamNetworkingMessages 版本）
  * 
  * 负责在虚拟网卡和Steam网络之间转发IP数据包
- * 使用 ISteamNetworkingMessages 实现无连接的消息传递
- * 使用 Steam Fake IP 进行寻址
+ * 通过 TransportInterface 收发消息（默认为 ISteamNetworkingMessages）
+ * 使用传输层分配的地址（Steam Fake IP）进行寻址
+ *
+ * 接收方向：IP_PACKET 在轮询线程上完成解析和 MSS 钳制后，连同消息句柄放入 SPSC 环形队列，
+ * 由专用的 TUN 写线程直接从传输层缓冲区批量写入再归还消息（不复制），
+ * TUN 写入不会阻塞 Steam 接收队列的排空。在途消息的总字节数受 InFlightBudget 限制。
  */
 class SteamVpnBridge {
 public:
-    SteamVpnBridge(SteamNetworkingManager* steamManager);
+    explicit SteamVpnBridge(TransportInterface* transport);
     ~SteamVpnBridge();
 
     /**
@@ -56,11 +69,53 @@ public:
      */
     std::string getLocalIP() const;
 
+    /**
+     * @brief 获取本地 IPv6 ULA 地址
+     */
+    std::string getLocalIPv6() const;
+
+    /**
+     * @brief 运行中修改 TUN MTU（重新设置设备 MTU 并更新 MSS 钳制值）
+     * @param configuredMtu 配置的 MTU，0 表示按传输层计算；大于计算值时使用计算值
+     * @return 生效的 MTU；未运行时返回 0（下次启动时生效），设置失败返回 -1
+     */
+    int reconfigureMtu(int configuredMtu);
+
+    /**
+     * @brief reconfigureMtu 的两步拆分：先取需要切换到的 MTU，再设置设备
+     * @return 需要设置的 MTU；未运行或与当前 MTU 相同时返回 0
+     */
+    int pendingTunMtu(int configuredMtu);
+
+    /**
+     * @brief 设置设备 MTU 并更新 MSS 钳制值
+     *
+     * 会阻塞（Windows 上调用 netsh，可能耗时数秒），可在事件循环之外的线程调用。
+     * 与 start()/stop() 互斥：stop() 等待进行中的修改完成后才关闭设备。
+     * @return true 成功，false 失败或桥接器已停止（MTU 保持不变）
+     */
+    bool setTunDeviceMtu(int mtu);
+
+    /**
+     * @brief 当前 TUN MTU，未运行时返回 0
+     */
+    int getTunMtu() const;
+
+    /**
+     * @brief 修改接收在途字节上限（已占用的不会被收回）
+     */
+    void setRxInFlightLimit(size_t bytes);
+
     /**
      * @brief 获取TUN设备名称
      */
     std::string getTunDeviceName() const;
 
+    /**
+     * @brief 路由代数，路由表或成员变化时递增
+     */
+    uint32_t getRouteGeneration() const;
+
     /**
      * @brief 获取路由表 (Empty in FakeIP mode)
      */
@@ -68,11 +123,18 @@ public:
 
     /**
      * @brief 处理来自Steam的VPN消息（使用 SteamID 标识发送者）
-     * @param data 消息数据
+     * @param data 消息数据（IP 包可能被原地改写，例如 MSS 钳制）
      * @param length 消息长度
      * @param senderSteamID 发送者的 Steam ID
      */
-    void handleVpnMessage(const uint8_t* data, size_t length, CSteamID senderSteamID);
+    void handleVpnMessage(uint8_t* data, size_t length, CSteamID senderSteamID);
+
+    /**
+     * @brief 处理来自传输层的消息（接收轮询线程调用）
+     * @param message 消息句柄，IP 包放入 TUN 写队列时句柄被移走，写入后归还；
+     *        其他消息同步处理，句柄留给调用方归还
+     */
+    void handleVpnMessage(MessageHandle& message);
 
     /**
      * @brief 当新用户加入时
@@ -86,6 +148,11 @@ public:
      */
     void onUserLeft(CSteamID steamID);
 
+    /**
+     * @brief 使所有缓存的转发决策失效（路由或成员变化时调用）
+     */
+    void invalidateFlows();
+
     /**
      * @brief 获取统计信息
      */
@@ -95,28 +162,137 @@ public:
         uint64_t bytesSent;
         uint64_t bytesReceived;
         uint64_t packetsDropped;
+        uint64_t tcpMssClamped;     // 被钳制 MSS 的 TCP SYN/SYN-ACK 数量
+        uint64_t oversizePackets;   // 超过隧道 MTU 的数据包数量
+        uint64_t icmpFragNeededSent; // 本地生成的 ICMP "需要分片" / ICMPv6 "包过大" 回复数量
+        uint64_t ipv6Unroutable;    // 无法路由而丢弃的 IPv6 包（组播、未知目的地址）
+        uint64_t flowCacheHits;     // 转发决策缓存命中次数
+        uint64_t flowCacheMisses;   // 转发决策缓存未命中次数
+        uint64_t rxQueueDrops;      // TUN 写队列已满而丢弃的入站包
+        uint64_t rxQueueHighWater;  // TUN 写队列占用的最高值
+        uint64_t rxQueueDepth;      // TUN 写队列当前占用
+        uint64_t rxQueueCapacity;
+        uint64_t tunWriteBatches;   // TUN 批量写入次数（包数 / 批次 = 平均批大小）
+        uint64_t rxInFlightBytes;   // 已接收、尚未写入 TUN 并归还的字节数
+        uint64_t rxInFlightPeakBytes;
+        uint64_t rxInFlightLimitBytes;
+        uint64_t rxInFlightRejected; // 超出在途预算而丢弃的入站包
     };
     Statistics getStatistics() const;
 
+    /**
+     * @brief 更新节点的链路指标（控制路径，按采样间隔调用）
+     */
+    void updatePeerLink(CSteamID steamID, const PeerLinkMetrics& link);
+
+    /**
+     * @brief 根据计数器增量计算每个节点的速率（与 updatePeerLink 同一采样间隔调用）
+     */
+    void samplePeerRates();
+
+    /**
+     * @brief 获取每个节点的流量计数、按原因分类的丢包和链路指标
+     * @note 广播包只计入全局统计
+     */
+    std::vector<PeerStatsTable::Snapshot> getPeerStatistics() const;
+
+    /**
+     * @brief 设置抽样追踪频率：每 every 个发往节点的 IP 包追踪一个，0 表示关闭
+     * @note 不支持追踪的旧版本节点会丢弃被追踪的包
+     */
+    void setTraceSampleEvery(uint32_t every);
+    uint32_t getTraceSampleEvery() const;
+
+    /**
+     * @brief 以 Chrome trace 格式导出本节点记录的追踪事件
+     * @param localSteamId 本地 Steam ID，用作进程标识
+     * @param clear 导出后清空
+     * @param eventCount 输出导出的事件数量
+     */
+    std::string dumpPacketTrace(uint64_t localSteamId, bool clear, size_t* eventCount = nullptr);
+
+    /**
+     * @brief 以 pcapng 格式导出飞行记录器中最近的数据包头部
+     * @param recordCount 输出导出的包数量
+     */
+    std::string dumpFlightRecorder(size_t* recordCount = nullptr) const;
+
+    /**
+     * @brief 打开一个抓包会话
+     * @param snaplen 每个包保留的字节数，0 表示完整保留
+     * @return 会话 ID，会话已满时返回 -1
+     */
+    int openCapture(const CaptureFilter& filter, uint32_t snaplen);
+    void closeCapture(int session);
+
+    /**
+     * @brief 取出抓包会话中已捕获的包
+     * @param dropped 输出上次调用以来因队列满而丢弃的记录数
+     */
+    size_t pollCapture(int session, PacketCapture::Record* out, size_t maxRecords, uint64_t* dropped = nullptr);
+
 private:
     // TUN设备读取线程
     void tunReadThread();
 
-    // 发送 VPN 消息（使用 ISteamNetworkingMessages）
-    void sendVpnMessage(VpnMessageType type, const uint8_t* payload, size_t payloadLength, 
+    // TUN设备写入线程（从接收队列取包批量写入）
+    void tunWriteThread();
+
+    // 归还接收队列中剩余的消息（不写入）
+    void drainRxQueue();
+
+    // 处理一个已分类的出站数据包（MSS 钳制、MTU 检查、转发）
+    void processTunPacket(uint8_t* packet, size_t length, const PacketMeta& meta);
+
+    // 按传输层计算的上限和配置值选择 TUN MTU，同时记录传输层可承载的最大包长
+    int selectTunMtu(int configuredMtu);
+    // 更新 MTU 及对应的 MSS 钳制值
+    void applyTunMtu(int mtu);
+
+    // 处理传输层无法承载的数据包，返回 true 表示已丢弃
+    bool handleOversizePacket(const uint8_t* packet, size_t length);
+
+    // 解析转发决策（路由表、FakeIP 回退、广播检查），返回 FlowCache::Flags
+    uint8_t resolveFlow(const uint8_t* packet, size_t length, const PacketMeta& meta, uint64_t& peer);
+
+    // 按缓存的转发决策发送数据包
+    void dispatchFlow(FlowCache::Entry& flow, const uint8_t* packet, size_t length);
+
+    // 带背压控制地将 IP 包发送给指定节点，返回 false 表示已丢弃
+    // sendCredit: 在重新查询待发送字节数之前还可发送的字节数（按流缓存）
+    bool forwardToPeer(CSteamID targetSteamID, const uint8_t* packet, size_t length,
+                       uint32_t& sendCredit);
+
+    // 以 IP_PACKET_TRACED 发送被抽样的包，并记录发送端的各跳时间
+    bool sendTracedPacket(CSteamID targetSteamID, const uint8_t* packet, size_t length);
+
+    // 更新路由表项，变化时使转发缓存失效
+    void updateRoute(CSteamID& slot, CSteamID steamID);
+    // 记录 IP_QUERY/IP_RESPONSE 通告的 IPv4 地址及同时通告的 ULA（调用方持有 routingMutex_）
+    void setAdvertisedIpv4Route(uint32_t address, const Ipv6Address& ipv6Address, CSteamID steamID);
+
+    // 从收到的 IPv6 包学习邻居地址（如对端的链路本地地址）
+    void learnIpv6Neighbor(const uint8_t* packet, size_t length, CSteamID senderSteamID);
+    // 记录 IP_QUERY/IP_RESPONSE 通告的 IPv6 地址（调用方持有 routingMutex_）
+    void setAdvertisedIpv6Route(const Ipv6Address& address, CSteamID steamID);
+
+    // 发送 VPN 消息（通过传输层），sendVpnMessage 返回是否提交成功，broadcastVpnMessage 返回发送的节点数量
+    bool sendVpnMessage(VpnMessageType type, const uint8_t* payload, size_t payloadLength, 
                         CSteamID targetSteamID, bool reliable = true);
-    void broadcastVpnMessage(VpnMessageType type, const uint8_t* payload, size_t payloadLength, 
+    int broadcastVpnMessage(VpnMessageType type, const uint8_t* payload, size_t payloadLength, 
                              bool reliable = true);
 
     // IP Query/Response
     void sendIpQuery(CSteamID target = k_steamIDNil);
     void sendIpResponse(CSteamID target);
 
-    // Steam网络管理器
-    SteamNetworkingManager* steamManager_;
+    // 传输层
+    TransportInterface* transport_;
 
     // TUN设备
     std::unique_ptr<tun::TunInterface> tunDevice_;
+    // 保护设备的创建、替换、关闭和 MTU 修改；读写线程在关闭前已退出，不加此锁
+    std::mutex tunDeviceMutex_;
 
     // 运行状态
     std::atomic<bool> running_;
@@ -124,18 +300,96 @@ private:
     // TUN读取线程
     std::unique_ptr<std::thread> tunReadThread_;
 
+    // 接收队列：轮询线程 -> TUN 写线程
+    struct RxPacket {
+        MessageHandle message;      // 写入后释放，归还传输层缓冲区
+        const uint8_t* packet;      // 指向 message.data() 内的 IP 包
+        size_t length;
+        uint64_t traceId = 0;       // 抽样追踪 id，0 表示未追踪
+#ifdef CONNECTTOOL_STAGE_TIMING
+        uint64_t enqueuedNs = 0;    // 入队时间，用于统计队列等待
+#endif
+    };
+    SpscRing<RxPacket> rxQueue_;
+    InFlightBudget rxBudget_;
+    std::unique_ptr<std::thread> tunWriteThread_;
+    std::atomic<uint64_t> rxQueueHighWater_;
+    std::atomic<bool> writerSleeping_;
+    std::mutex writerMutex_;
+    std::condition_variable writerCv_;
+
     // IP地址池配置
     uint32_t localIP_;
 
+    // 本地 IPv6 ULA 地址（未配置时全零）
+    Ipv6Address localIPv6_;
+
+    // 当前 TUN MTU 及对应的 TCP MSS 上限（IPv6 链路 MTU 不低于 1280）
+    // 运行中可由 reconfigureMtu 修改，数据路径以 relaxed 读取
+    std::atomic<int> tunMtu_;
+    std::atomic<int> tunMtu6_;
+    std::atomic<uint16_t> maxTcpMss_;
+    std::atomic<uint16_t> maxTcpMss6_;
+    // 单条传输层消息可承载的最大 IP 包（MTU_DataSize 减去 VPN 消息头）
+    std::atomic<int> maxPacketSize_;
+
+    // 发送背压参数所在的配置（仅 TUN 读取线程访问）
+    ConfigCache txConfig_;
+
     // Routing Table: FakeIP -> SteamID
     // Used to resolve destination SteamID when Steam's internal resolution fails
     // or for optimization.
-    std::map<uint32_t, CSteamID> routingTable_;
+    // ipv6Address 是同一条 IP_QUERY/IP_RESPONSE 通告的 ULA，查询路由表时无需再扫描 IPv6 表
+    struct Ipv4Route {
+        CSteamID steamID;
+        Ipv6Address ipv6Address{};
+    };
+    std::map<uint32_t, Ipv4Route> routingTable_;
+    // IPv6 Routing Table: ULA / learned neighbor address -> SteamID
+    // learned 表示地址来自对端的数据包而非 IP_QUERY/IP_RESPONSE 通告，这类路由不覆盖已有路由
+    struct Ipv6Route {
+        CSteamID steamID;
+        bool learned = false;
+    };
+    std::map<Ipv6Address, Ipv6Route> routingTableV6_;
+    // 每个节点已学到的 IPv6 地址数（受 MAX_IPV6_NEIGHBORS_PER_PEER 限制）
+    std::map<CSteamID, size_t> learnedV6Count_;
     mutable std::mutex routingMutex_;
 
+    // 转发决策缓存（仅 TUN 读取线程访问），路由代数变化时条目失效
+    FlowCache flowCache_;
+    std::atomic<uint32_t> routeGeneration_;
+
+    // 已在路由表中核对过的 (节点, IPv6 源地址)（仅接收轮询线程访问），路由代数变化时失效
+    // 已知邻居的包因此不必获取 routingMutex_
+    struct KnownIpv6Source {
+        uint64_t peer = 0;
+        Ipv6Address address{};
+        uint32_t generation = 0;
+    };
+    static constexpr size_t KNOWN_IPV6_SOURCE_SLOTS = 256;
+    std::array<KnownIpv6Source, KNOWN_IPV6_SOURCE_SLOTS> knownIpv6Sources_;
+
     // 统计信息
     Statistics stats_;
     mutable std::mutex statsMutex_;
+
+    // 每个节点的统计（固定槽位，数据路径无锁）
+    PeerStatsTable peerStats_;
+
+    // 飞行记录器：每个记录点只由一个线程写入
+    FlightRecorder flightRecorder_;
+
+    // 抓包会话：过滤在数据路径上进行，客户端跟不上时丢弃记录而不阻塞转发
+    PacketCapture capture_;
+
+    // 抽样包追踪；txTrace_ 为 TUN 读取线程正在处理的包的追踪上下文
+    PacketTracer tracer_;
+    struct TxTrace {
+        uint64_t traceId = 0;       // 0 表示当前包未被抽样
+        int64_t readUs = 0;         // 本批读取完成的时间，0 表示本批未启用追踪
+        int64_t classifiedUs = 0;
+    } txTrace_;
 };
 
 #endif // STEAM_VPN_BRIDGE_H
\ No newline at end of file
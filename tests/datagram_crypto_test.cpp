@@ -0,0 +1,135 @@
+#include "transport/datagram_crypto.h"
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+    struct Sealed {
+        std::vector<uint8_t> header;
+        std::vector<uint8_t> body;  // ciphertext followed by the tag
+    };
+
+    Sealed sealMessage(const uint8_t* key, uint64_t counter, const std::vector<uint8_t>& plaintext) {
+        Sealed sealed;
+        sealed.header = {0x43, 0x54, 0x44, 0x55, 1, 0, 0, 0};
+        sealed.body.resize(plaintext.size() + DatagramCrypto::TAG_SIZE);
+        EXPECT_TRUE(DatagramCrypto::seal(key, counter, sealed.header.data(), sealed.header.size(),
+                                         plaintext.data(), plaintext.size(), sealed.body.data()));
+        return sealed;
+    }
+
+    bool openMessage(const uint8_t* key, uint64_t counter, const Sealed& sealed, std::vector<uint8_t>& plaintext) {
+        plaintext.assign(sealed.body.size() - DatagramCrypto::TAG_SIZE, 0);
+        return DatagramCrypto::open(key, counter, sealed.header.data(), sealed.header.size(), sealed.body.data(),
+                                    sealed.body.size(), plaintext.data());
+    }
+
+    std::vector<uint8_t> samplePayload(size_t length) {
+        std::vector<uint8_t> payload(length);
+        for (size_t i = 0; i < length; ++i) payload[i] = static_cast<uint8_t>(i * 7 + 3);
+        return payload;
+    }
+
+    class DatagramCryptoTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            ASSERT_TRUE(DatagramCrypto::randomBytes(key_, sizeof(key_)));
+            memcpy(otherKey_, key_, sizeof(key_));
+            otherKey_[0] ^= 1;
+        }
+
+        uint8_t key_[DatagramCrypto::KEY_SIZE];
+        uint8_t otherKey_[DatagramCrypto::KEY_SIZE];
+    };
+
+} // anonymous namespace
+
+TEST_F(DatagramCryptoTest, RoundTrip) {
+    for (size_t length : {0, 1, 8, 63, 64, 1200, 1400}) {
+        auto payload = samplePayload(length);
+        Sealed sealed = sealMessage(key_, 42, payload);
+        if (length >= 8) {
+            EXPECT_NE(0, memcmp(sealed.body.data(), payload.data(), 8)) << "length " << length;
+        }
+
+        std::vector<uint8_t> opened;
+        ASSERT_TRUE(openMessage(key_, 42, sealed, opened)) << "length " << length;
+        EXPECT_EQ(opened, payload);
+    }
+}
+
+TEST_F(DatagramCryptoTest, InPlace) {
+    auto payload = samplePayload(300);
+    std::vector<uint8_t> header = {1, 2, 3, 4};
+    std::vector<uint8_t> buffer = payload;
+    buffer.resize(payload.size() + DatagramCrypto::TAG_SIZE);
+
+    ASSERT_TRUE(DatagramCrypto::seal(key_, 7, header.data(), header.size(), buffer.data(), payload.size(),
+                                     buffer.data()));
+    ASSERT_TRUE(DatagramCrypto::open(key_, 7, header.data(), header.size(), buffer.data(), buffer.size(),
+                                     buffer.data()));
+    buffer.resize(payload.size());
+    EXPECT_EQ(buffer, payload);
+}
+
+TEST_F(DatagramCryptoTest, RejectsTampering) {
+    auto payload = samplePayload(100);
+    Sealed sealed = sealMessage(key_, 9, payload);
+    std::vector<uint8_t> opened;
+
+    for (size_t i = 0; i < sealed.body.size(); ++i) {
+        Sealed modified = sealed;
+        modified.body[i] ^= 0x80;
+        EXPECT_FALSE(openMessage(key_, 9, modified, opened)) << "body byte " << i;
+    }
+    for (size_t i = 0; i < sealed.header.size(); ++i) {
+        Sealed modified = sealed;
+        modified.header[i] ^= 0x01;
+        EXPECT_FALSE(openMessage(key_, 9, modified, opened)) << "header byte " << i;
+    }
+    EXPECT_FALSE(openMessage(key_, 10, sealed, opened));
+    EXPECT_FALSE(openMessage(otherKey_, 9, sealed, opened));
+    EXPECT_TRUE(openMessage(key_, 9, sealed, opened));
+}
+
+TEST_F(DatagramCryptoTest, RejectsTruncated) {
+    uint8_t header[4] = {};
+    uint8_t buffer[DatagramCrypto::TAG_SIZE] = {};
+    EXPECT_FALSE(DatagramCrypto::open(key_, 1, header, sizeof(header), buffer, DatagramCrypto::TAG_SIZE - 1,
+                                      buffer));
+}
+
+TEST(ReplayWindow, AcceptsEachCounterOnce) {
+    DatagramCrypto::ReplayWindow window;
+    EXPECT_FALSE(window.accept(0));
+    EXPECT_TRUE(window.accept(1));
+    EXPECT_FALSE(window.accept(1));
+    EXPECT_TRUE(window.accept(3));
+    EXPECT_TRUE(window.accept(2));
+    EXPECT_FALSE(window.accept(2));
+    EXPECT_FALSE(window.accept(3));
+}
+
+TEST(ReplayWindow, AcceptsReorderingInsideTheWindow) {
+    DatagramCrypto::ReplayWindow window;
+    EXPECT_TRUE(window.accept(100));
+    for (uint64_t counter = 99; counter > 36; --counter) {
+        EXPECT_TRUE(window.accept(counter)) << counter;
+    }
+    EXPECT_FALSE(window.accept(36));    // 64 behind the highest
+    EXPECT_FALSE(window.accept(50));
+}
+
+TEST(ReplayWindow, LargeJumpClearsHistory) {
+    DatagramCrypto::ReplayWindow window;
+    EXPECT_TRUE(window.accept(5));
+    EXPECT_TRUE(window.accept(1000));
+    EXPECT_FALSE(window.accept(5));
+    EXPECT_TRUE(window.accept(999));
+    EXPECT_FALSE(window.accept(1000));
+
+    window.reset();
+    EXPECT_TRUE(window.accept(5));
+}
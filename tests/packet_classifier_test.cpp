@@ -0,0 +1,92 @@
+#include "vpn/packet_classifier.h"
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+    bool sameMeta(const PacketMeta& a, const PacketMeta& b) {
+        return a.srcIP == b.srcIP && a.dstIP == b.dstIP && a.srcPort == b.srcPort && a.dstPort == b.dstPort &&
+               a.version == b.version && a.protocol == b.protocol && a.dscp == b.dscp &&
+               a.headerLength == b.headerLength;
+    }
+
+    // Mostly plausible IPv4/IPv6 headers with random options, fragments and truncation
+    std::vector<uint8_t> randomPacket(std::mt19937& rng) {
+        size_t length = rng() % 80;
+        std::vector<uint8_t> packet(length);
+        for (auto& b : packet) b = static_cast<uint8_t>(rng());
+        if (length == 0) return packet;
+
+        switch (rng() % 4) {
+            case 0:
+            case 1:
+                packet[0] = static_cast<uint8_t>(0x40 | (5 + rng() % 11));
+                if (length > 9) packet[9] = (rng() & 1) ? 6 : 17;
+                if (length > 7 && (rng() % 4)) packet[6] = packet[7] = 0;
+                break;
+            case 2:
+                packet[0] = static_cast<uint8_t>(0x60 | (rng() & 0x0F));
+                if (length > 6) packet[6] = (rng() & 1) ? 6 : 17;
+                break;
+            default:
+                break;
+        }
+        return packet;
+    }
+
+} // anonymous namespace
+
+TEST(PacketClassifier, BatchMatchesPerPacket) {
+    std::mt19937 rng(42);
+    for (int round = 0; round < 2000; ++round) {
+        size_t count = rng() % 33;
+        std::vector<std::vector<uint8_t>> storage;
+        std::vector<const uint8_t*> packets;
+        std::vector<size_t> lengths;
+        for (size_t i = 0; i < count; ++i) {
+            storage.push_back(randomPacket(rng));
+        }
+        for (const auto& packet : storage) {
+            packets.push_back(packet.data());
+            lengths.push_back(packet.size());
+        }
+
+        std::vector<PacketMeta> batch(count);
+        PacketClassifier::classifyBatch(packets.data(), lengths.data(), count, batch.data());
+        for (size_t i = 0; i < count; ++i) {
+            PacketMeta single;
+            PacketClassifier::classify(packets[i], lengths[i], single);
+            ASSERT_TRUE(sameMeta(single, batch[i])) << "round " << round << " packet " << i;
+        }
+    }
+}
+
+TEST(PacketClassifier, ExtractsIpv4Fields) {
+    uint8_t packet[28] = {0x45, 0xB8, 0, 28, 0, 0, 0x40, 0, 64, 17, 0, 0,
+                          10, 0, 0, 1, 10, 0, 0, 2, 0x9C, 0x40, 0x01, 0xBB};
+    PacketMeta meta;
+    PacketClassifier::classify(packet, sizeof(packet), meta);
+
+    EXPECT_EQ(meta.version, 4);
+    EXPECT_EQ(meta.srcIP, 0x0A000001u);
+    EXPECT_EQ(meta.dstIP, 0x0A000002u);
+    EXPECT_EQ(meta.protocol, 17);
+    EXPECT_EQ(meta.srcPort, 40000);
+    EXPECT_EQ(meta.dstPort, 443);
+    EXPECT_EQ(meta.dscp, 46);
+    EXPECT_EQ(meta.headerLength, 20);
+}
+
+TEST(PacketClassifier, NonFirstFragmentHasNoPorts) {
+    uint8_t packet[28] = {0x45, 0, 0, 28, 0, 0, 0x00, 0x10, 64, 6, 0, 0,
+                          10, 0, 0, 1, 10, 0, 0, 2, 0x9C, 0x40, 0x01, 0xBB};
+    PacketMeta meta;
+    PacketClassifier::classify(packet, sizeof(packet), meta);
+
+    EXPECT_EQ(meta.version, 4);
+    EXPECT_EQ(meta.srcPort, 0);
+    EXPECT_EQ(meta.dstPort, 0);
+}
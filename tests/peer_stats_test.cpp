@@ -0,0 +1,67 @@
+#include "vpn/peer_stats.h"
+
+#include <gtest/gtest.h>
+#include <map>
+
+namespace {
+
+    constexpr uint64_t STEAM_ID_BASE = 76561198000000000ULL;
+
+    std::map<uint64_t, PeerStatsTable::Snapshot> snapshotById(const PeerStatsTable& table) {
+        std::map<uint64_t, PeerStatsTable::Snapshot> result;
+        for (const auto& snap : table.snapshot()) result[snap.steamId] = snap;
+        return result;
+    }
+
+} // anonymous namespace
+
+TEST(PeerStatsTable, CountsPerPeer) {
+    PeerStatsTable table;
+    table.addPeer(STEAM_ID_BASE + 1);
+    table.recordSent(STEAM_ID_BASE + 1, 100);
+    table.recordReceived(STEAM_ID_BASE + 1, 60);
+    table.recordDrop(STEAM_ID_BASE + 1, PeerDropReason::SendFailed);
+    table.recordSent(STEAM_ID_BASE + 2, 100);   // No slot, not counted
+
+    auto peers = snapshotById(table);
+    ASSERT_EQ(peers.size(), 1u);
+    const auto& snap = peers[STEAM_ID_BASE + 1];
+    EXPECT_EQ(snap.txPackets, 1u);
+    EXPECT_EQ(snap.txBytes, 100u);
+    EXPECT_EQ(snap.rxBytes, 60u);
+    EXPECT_EQ(snap.drops[static_cast<size_t>(PeerDropReason::SendFailed)], 1u);
+}
+
+TEST(PeerStatsTable, ChurnKeepsLivePeersAndCounters) {
+    // A full lobby whose remaining seats turn over many times: every removal
+    // leaves a tombstone that a later join has to reuse
+    PeerStatsTable table;
+    constexpr uint64_t RESIDENTS = 240;
+    for (uint64_t i = 0; i < RESIDENTS; ++i) {
+        table.addPeer(STEAM_ID_BASE + i);
+        for (uint64_t n = 0; n <= i; ++n) table.recordSent(STEAM_ID_BASE + i, 10);
+    }
+    for (uint64_t i = 0; i < 5000; ++i) {
+        uint64_t visitor = STEAM_ID_BASE + 100000 + i;
+        table.addPeer(visitor);
+        table.recordReceived(visitor, 1);
+        table.removePeer(visitor);
+    }
+
+    auto peers = snapshotById(table);
+    ASSERT_EQ(peers.size(), RESIDENTS);
+    for (uint64_t i = 0; i < RESIDENTS; ++i) {
+        auto it = peers.find(STEAM_ID_BASE + i);
+        ASSERT_NE(it, peers.end()) << i;
+        EXPECT_EQ(it->second.txPackets, i + 1);
+        EXPECT_EQ(it->second.txBytes, (i + 1) * 10);
+        EXPECT_EQ(it->second.rxPackets, 0u);
+    }
+
+    // Still usable after the churn: lookups hit and new peers get slots
+    table.recordSent(STEAM_ID_BASE + 7, 10);
+    table.addPeer(STEAM_ID_BASE + 999999);
+    peers = snapshotById(table);
+    EXPECT_EQ(peers[STEAM_ID_BASE + 7].txPackets, 9u);
+    EXPECT_EQ(peers.size(), RESIDENTS + 1);
+}
@@ -0,0 +1,132 @@
+#include "vpn/vpn_checksum.h"
+
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace {
+
+    uint16_t readU16(const uint8_t* p) {
+        return static_cast<uint16_t>((p[0] << 8) | p[1]);
+    }
+
+    void writeU16(uint8_t* p, uint16_t value) {
+        p[0] = static_cast<uint8_t>(value >> 8);
+        p[1] = static_cast<uint8_t>(value & 0xFF);
+    }
+
+    std::vector<uint8_t> randomBytes(std::mt19937& rng, size_t length) {
+        std::vector<uint8_t> data(length);
+        for (auto& b : data) b = static_cast<uint8_t>(rng());
+        return data;
+    }
+
+} // anonymous namespace
+
+TEST(VpnChecksum, KnownIpv4HeaderChecksum) {
+    uint8_t header[20] = {0x45, 0x00, 0x00, 0x73, 0x00, 0x00, 0x40, 0x00, 0x40, 0x11,
+                          0x00, 0x00, 0xC0, 0xA8, 0x00, 0x01, 0xC0, 0xA8, 0x00, 0xC7};
+    EXPECT_EQ(VpnChecksum::compute(header, sizeof(header)), 0xB861);
+
+    writeU16(header + 10, 0xB861);
+    EXPECT_EQ(VpnChecksum::compute(header, sizeof(header)), 0);
+}
+
+TEST(VpnChecksum, SimdMatchesScalarAllLengthsAndOffsets) {
+    std::mt19937 rng(1);
+    auto buffer = randomBytes(rng, 2100);
+    for (size_t offset = 0; offset < 33; ++offset) {
+        for (size_t length = 0; length + offset <= buffer.size(); length += (length < 256 ? 1 : 37)) {
+            const uint8_t* data = buffer.data() + offset;
+            ASSERT_EQ(VpnChecksum::accumulate(data, length), VpnChecksum::accumulateScalar(data, length))
+                << VpnChecksum::activeImplementation() << " offset " << offset << " length " << length;
+        }
+    }
+}
+
+TEST(VpnChecksum, SimdMatchesScalarWithRunningSum) {
+    std::mt19937 rng(2);
+    for (int round = 0; round < 2000; ++round) {
+        auto data = randomBytes(rng, 64 + rng() % 1500);
+        uint32_t sum = rng() & 0xFFFF;
+        ASSERT_EQ(VpnChecksum::accumulate(data.data(), data.size(), sum),
+                  VpnChecksum::accumulateScalar(data.data(), data.size(), sum));
+    }
+}
+
+TEST(VpnChecksum, SimdMatchesScalarOnSaturatedLanes) {
+    // All-ones words push every vector lane to its limit before the periodic flush
+    std::vector<uint8_t> data(4 * 1024 * 1024 + 7, 0xFF);
+    EXPECT_EQ(VpnChecksum::accumulate(data.data(), data.size()),
+              VpnChecksum::accumulateScalar(data.data(), data.size()));
+
+    std::vector<uint8_t> zeros(4096, 0);
+    EXPECT_EQ(VpnChecksum::accumulate(zeros.data(), zeros.size()), 0u);
+}
+
+TEST(VpnChecksum, ChainedSumsMatchSingleBuffer) {
+    std::mt19937 rng(3);
+    auto data = randomBytes(rng, 1501);
+    for (size_t split = 0; split <= data.size(); split += 2) {
+        uint32_t sum = VpnChecksum::accumulate(data.data(), split);
+        sum = VpnChecksum::accumulate(data.data() + split, data.size() - split, sum);
+        ASSERT_EQ(VpnChecksum::finish(sum), VpnChecksum::compute(data.data(), data.size())) << "split " << split;
+    }
+}
+
+TEST(VpnChecksum, Update16MatchesRecompute) {
+    std::mt19937 rng(4);
+    for (int round = 0; round < 20000; ++round) {
+        auto data = randomBytes(rng, 40);
+        writeU16(data.data() + 10, 0);
+        writeU16(data.data() + 10, VpnChecksum::compute(data.data(), data.size()));
+
+        size_t field = 2 * (rng() % 20);
+        if (field == 10) field = 12;
+        uint16_t oldValue = readU16(data.data() + field);
+        uint16_t newValue = (round % 8 == 0) ? static_cast<uint16_t>(round % 16 == 0 ? 0 : 0xFFFF)
+                                             : static_cast<uint16_t>(rng());
+        writeU16(data.data() + field, newValue);
+        VpnChecksum::update16(data.data() + 10, oldValue, newValue);
+
+        ASSERT_EQ(VpnChecksum::compute(data.data(), data.size()), 0) << "round " << round;
+    }
+}
+
+TEST(VpnChecksum, Update32MatchesRecompute) {
+    std::mt19937 rng(5);
+    for (int round = 0; round < 20000; ++round) {
+        auto data = randomBytes(rng, 20);
+        writeU16(data.data() + 10, 0);
+        writeU16(data.data() + 10, VpnChecksum::compute(data.data(), data.size()));
+
+        // Rewrite the source address, as NAT would
+        uint32_t oldValue = (static_cast<uint32_t>(readU16(data.data() + 12)) << 16) | readU16(data.data() + 14);
+        uint32_t newValue = rng();
+        writeU16(data.data() + 12, static_cast<uint16_t>(newValue >> 16));
+        writeU16(data.data() + 14, static_cast<uint16_t>(newValue & 0xFFFF));
+        VpnChecksum::update32(data.data() + 10, oldValue, newValue);
+
+        ASSERT_EQ(VpnChecksum::compute(data.data(), data.size()), 0) << "round " << round;
+    }
+}
+
+TEST(VpnChecksum, PseudoHeaderV4) {
+    // 10.0.0.1 -> 10.0.0.2, UDP, length 8
+    uint8_t pseudo[12] = {10, 0, 0, 1, 10, 0, 0, 2, 0, 17, 0, 8};
+    EXPECT_EQ(VpnChecksum::pseudoHeaderV4(0x0A000001, 0x0A000002, 17, 8),
+              VpnChecksum::accumulateScalar(pseudo, sizeof(pseudo)));
+}
+
+TEST(VpnChecksum, PseudoHeaderV6) {
+    std::mt19937 rng(6);
+    auto src = randomBytes(rng, 16);
+    auto dst = randomBytes(rng, 16);
+    std::vector<uint8_t> pseudo(src);
+    pseudo.insert(pseudo.end(), dst.begin(), dst.end());
+    uint8_t tail[8] = {0, 1, 0x23, 0x45, 0, 0, 0, 58};
+    pseudo.insert(pseudo.end(), tail, tail + sizeof(tail));
+
+    EXPECT_EQ(VpnChecksum::pseudoHeaderV6(src.data(), dst.data(), 0x12345, 58),
+              VpnChecksum::accumulateScalar(pseudo.data(), pseudo.size()));
+}
@@ -0,0 +1,219 @@
+#include "vpn/vpn_utils.h"
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+    constexpr uint8_t PROTO_TCP = 6;
+    constexpr uint8_t TCP_SYN = 0x02;
+    constexpr uint8_t TCP_ACK = 0x10;
+
+    const uint8_t SRC_V4[4] = {10, 0, 0, 1};
+    const uint8_t DST_V4[4] = {10, 0, 0, 2};
+    const uint8_t SRC_V6[16] = {0xfd, 0x12, 0x34, 0x56, 0x78, 0x9a, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+    const uint8_t DST_V6[16] = {0xfd, 0x12, 0x34, 0x56, 0x78, 0x9a, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2};
+
+    uint16_t readU16(const uint8_t* p) {
+        return static_cast<uint16_t>((p[0] << 8) | p[1]);
+    }
+
+    void writeU16(uint8_t* p, uint16_t value) {
+        p[0] = static_cast<uint8_t>(value >> 8);
+        p[1] = static_cast<uint8_t>(value & 0xFF);
+    }
+
+    size_t ipHeaderLength(const std::vector<uint8_t>& packet) {
+        return (packet[0] >> 4) == 4 ? static_cast<size_t>(packet[0] & 0x0F) * 4 : IPV6_HEADER_SIZE;
+    }
+
+    // Reference ones' complement sum, independent of the code under test
+    uint32_t sum16(const uint8_t* data, size_t length, uint32_t sum = 0) {
+        for (size_t i = 0; i + 1 < length; i += 2) {
+            sum += readU16(data + i);
+        }
+        if (length & 1) sum += static_cast<uint32_t>(data[length - 1]) << 8;
+        return sum;
+    }
+
+    uint16_t finish(uint32_t sum) {
+        while (sum >> 16) {
+            sum = (sum & 0xFFFF) + (sum >> 16);
+        }
+        return static_cast<uint16_t>(~sum);
+    }
+
+    // Pseudo-header plus segment
+    uint32_t segmentSum(const std::vector<uint8_t>& packet) {
+        size_t ipLength = ipHeaderLength(packet);
+        size_t tcpLength = packet.size() - ipLength;
+        uint32_t pseudo = PROTO_TCP + static_cast<uint32_t>(tcpLength);
+        if ((packet[0] >> 4) == 4) {
+            pseudo = sum16(packet.data() + 12, 8, pseudo);
+        } else {
+            pseudo = sum16(packet.data() + 8, 32, pseudo);
+        }
+        return sum16(packet.data() + ipLength, tcpLength, pseudo);
+    }
+
+    // A segment carrying a valid checksum sums to 0xFFFF
+    bool checksumValid(const std::vector<uint8_t>& packet) {
+        return finish(segmentSum(packet)) == 0;
+    }
+
+    /**
+     * @brief Build a TCP segment with the given options and a valid checksum
+     * @param options TCP options, padded by the caller to a multiple of 4 bytes
+     */
+    std::vector<uint8_t> buildTcp(uint8_t version, uint8_t flags, const std::vector<uint8_t>& options,
+                                  size_t payloadLength = 5) {
+        size_t ipLength = version == 4 ? 20 : IPV6_HEADER_SIZE;
+        size_t tcpLength = 20 + options.size();
+        std::vector<uint8_t> packet(ipLength + tcpLength + payloadLength, 0);
+
+        uint8_t* ip = packet.data();
+        if (version == 4) {
+            ip[0] = 0x45;
+            writeU16(ip + 2, static_cast<uint16_t>(packet.size()));
+            ip[8] = 64;
+            ip[9] = PROTO_TCP;
+            memcpy(ip + 12, SRC_V4, 4);
+            memcpy(ip + 16, DST_V4, 4);
+            writeU16(ip + 10, finish(sum16(ip, 20)));
+        } else {
+            ip[0] = 0x60;
+            writeU16(ip + 4, static_cast<uint16_t>(tcpLength + payloadLength));
+            ip[6] = PROTO_TCP;
+            ip[7] = 64;
+            memcpy(ip + 8, SRC_V6, 16);
+            memcpy(ip + 24, DST_V6, 16);
+        }
+
+        uint8_t* tcp = ip + ipLength;
+        writeU16(tcp, 50000);
+        writeU16(tcp + 2, 443);
+        writeU16(tcp + 4, 0x1234);
+        writeU16(tcp + 6, 0x5678);
+        tcp[12] = static_cast<uint8_t>((tcpLength / 4) << 4);
+        tcp[13] = flags;
+        writeU16(tcp + 14, 65535);
+        memcpy(tcp + 20, options.data(), options.size());
+        for (size_t i = 0; i < payloadLength; ++i) {
+            tcp[tcpLength + i] = static_cast<uint8_t>(0xA0 + i);
+        }
+        writeU16(tcp + 16, finish(segmentSum(packet)));
+        return packet;
+    }
+
+    const std::vector<uint8_t> MSS_FIRST = {2, 4, 0x05, 0xB4, 1, 1, 4, 2};      // MSS 1460 at offset 20
+    const std::vector<uint8_t> MSS_AFTER_NOP = {1, 2, 4, 0x05, 0xB4, 1, 1, 0};  // MSS value at odd offset 23
+
+    uint16_t mssAt(const std::vector<uint8_t>& packet, size_t optionOffset) {
+        return readU16(packet.data() + ipHeaderLength(packet) + optionOffset + 2);
+    }
+
+} // anonymous namespace
+
+TEST(ClampTcpMss, RewritesIpv4SynAtEvenOffset) {
+    auto packet = buildTcp(4, TCP_SYN, MSS_FIRST);
+    ASSERT_TRUE(checksumValid(packet));
+
+    EXPECT_TRUE(VpnUtils::clampTcpMss(packet.data(), packet.size(), 1200));
+    EXPECT_EQ(mssAt(packet, 20), 1200);
+    EXPECT_TRUE(checksumValid(packet));
+}
+
+TEST(ClampTcpMss, RewritesIpv4SynAtOddOffset) {
+    auto packet = buildTcp(4, TCP_SYN, MSS_AFTER_NOP);
+    ASSERT_TRUE(checksumValid(packet));
+
+    EXPECT_TRUE(VpnUtils::clampTcpMss(packet.data(), packet.size(), 1200));
+    EXPECT_EQ(mssAt(packet, 21), 1200);
+    EXPECT_TRUE(checksumValid(packet));
+}
+
+TEST(ClampTcpMss, RewritesIpv4SynAck) {
+    auto packet = buildTcp(4, TCP_SYN | TCP_ACK, MSS_AFTER_NOP);
+
+    EXPECT_TRUE(VpnUtils::clampTcpMss(packet.data(), packet.size(), 1000));
+    EXPECT_EQ(mssAt(packet, 21), 1000);
+    EXPECT_TRUE(checksumValid(packet));
+}
+
+TEST(ClampTcpMss, RewritesIpv6SynAtEvenOffset) {
+    auto packet = buildTcp(6, TCP_SYN, MSS_FIRST);
+    ASSERT_TRUE(checksumValid(packet));
+
+    EXPECT_TRUE(VpnUtils::clampTcpMss(packet.data(), packet.size(), 1180));
+    EXPECT_EQ(mssAt(packet, 20), 1180);
+    EXPECT_TRUE(checksumValid(packet));
+}
+
+TEST(ClampTcpMss, RewritesIpv6SynAtOddOffset) {
+    auto packet = buildTcp(6, TCP_SYN, MSS_AFTER_NOP);
+    ASSERT_TRUE(checksumValid(packet));
+
+    EXPECT_TRUE(VpnUtils::clampTcpMss(packet.data(), packet.size(), 1180));
+    EXPECT_EQ(mssAt(packet, 21), 1180);
+    EXPECT_TRUE(checksumValid(packet));
+}
+
+TEST(ClampTcpMss, OddOffsetChecksumAcrossMssValues) {
+    // Exercise carries through both straddled words
+    for (uint32_t mss = 1; mss <= 0xFFFF; mss += 251) {
+        std::vector<uint8_t> options = MSS_AFTER_NOP;
+        options[3] = static_cast<uint8_t>(0xFF);
+        options[4] = static_cast<uint8_t>(0xFF);
+        auto packet = buildTcp(4, TCP_SYN, options, 0);
+
+        ASSERT_TRUE(VpnUtils::clampTcpMss(packet.data(), packet.size(), static_cast<uint16_t>(mss)));
+        ASSERT_EQ(mssAt(packet, 21), mss);
+        ASSERT_TRUE(checksumValid(packet)) << "mss " << mss;
+    }
+}
+
+TEST(ClampTcpMss, LeavesSmallerMssAlone) {
+    auto packet = buildTcp(4, TCP_SYN, MSS_FIRST);
+    auto original = packet;
+
+    EXPECT_FALSE(VpnUtils::clampTcpMss(packet.data(), packet.size(), 1460));
+    EXPECT_EQ(packet, original);
+}
+
+TEST(ClampTcpMss, IgnoresNonSynPackets) {
+    for (uint8_t version : {4, 6}) {
+        auto packet = buildTcp(version, TCP_ACK, MSS_FIRST);
+        auto original = packet;
+
+        EXPECT_FALSE(VpnUtils::clampTcpMss(packet.data(), packet.size(), 1000));
+        EXPECT_EQ(packet, original);
+    }
+}
+
+TEST(ClampTcpMss, IgnoresSynWithoutMssOption) {
+    auto packet = buildTcp(4, TCP_SYN, {1, 1, 4, 2});
+    auto original = packet;
+
+    EXPECT_FALSE(VpnUtils::clampTcpMss(packet.data(), packet.size(), 1000));
+    EXPECT_EQ(packet, original);
+}
+
+TEST(ClampTcpMss, IgnoresNonFirstFragment) {
+    auto packet = buildTcp(4, TCP_SYN, MSS_FIRST);
+    writeU16(packet.data() + 6, 0x0010);
+    auto original = packet;
+
+    EXPECT_FALSE(VpnUtils::clampTcpMss(packet.data(), packet.size(), 1000));
+    EXPECT_EQ(packet, original);
+}
+
+TEST(ClampTcpMss, IgnoresTruncatedOptions) {
+    auto packet = buildTcp(4, TCP_SYN, MSS_FIRST, 0);
+    // Header claims options the buffer does not hold
+    packet.resize(packet.size() - 4);
+    auto original = packet;
+
+    EXPECT_FALSE(VpnUtils::clampTcpMss(packet.data(), packet.size(), 1000));
+    EXPECT_EQ(packet, original);
+}
@@ -0,0 +1,91 @@
+#include "datagram_crypto.h"
+#include <cstring>
+#include <memory>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+namespace {
+
+    constexpr size_t NONCE_SIZE = 12;
+
+    struct CipherContextDeleter {
+        void operator()(EVP_CIPHER_CTX* ctx) const { EVP_CIPHER_CTX_free(ctx); }
+    };
+
+    // 每个线程复用一个上下文，避免每个数据报都分配
+    EVP_CIPHER_CTX* threadContext() {
+        thread_local std::unique_ptr<EVP_CIPHER_CTX, CipherContextDeleter> ctx(EVP_CIPHER_CTX_new());
+        return ctx.get();
+    }
+
+    void buildNonce(uint64_t counter, uint8_t nonce[NONCE_SIZE]) {
+        memset(nonce, 0, 4);
+        for (int i = 0; i < 8; ++i) {
+            nonce[4 + i] = static_cast<uint8_t>(counter >> (56 - 8 * i));
+        }
+    }
+
+} // anonymous namespace
+
+namespace DatagramCrypto {
+
+    bool randomBytes(uint8_t* out, size_t length) {
+        return RAND_bytes(out, static_cast<int>(length)) == 1;
+    }
+
+    bool seal(const uint8_t* key, uint64_t counter, const uint8_t* aad, size_t aadLength,
+              const uint8_t* plaintext, size_t length, uint8_t* out) {
+        EVP_CIPHER_CTX* ctx = threadContext();
+        if (!ctx) return false;
+
+        uint8_t nonce[NONCE_SIZE];
+        buildNonce(counter, nonce);
+        int written = 0;
+        int finalLength = 0;
+        return EVP_EncryptInit_ex(ctx, EVP_chacha20_poly1305(), nullptr, key, nonce) == 1 &&
+               EVP_EncryptUpdate(ctx, nullptr, &written, aad, static_cast<int>(aadLength)) == 1 &&
+               EVP_EncryptUpdate(ctx, out, &written, plaintext, static_cast<int>(length)) == 1 &&
+               EVP_EncryptFinal_ex(ctx, out + written, &finalLength) == 1 &&
+               EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, static_cast<int>(TAG_SIZE), out + length) == 1;
+    }
+
+    bool open(const uint8_t* key, uint64_t counter, const uint8_t* aad, size_t aadLength,
+              const uint8_t* ciphertext, size_t length, uint8_t* out) {
+        if (length < TAG_SIZE) return false;
+        EVP_CIPHER_CTX* ctx = threadContext();
+        if (!ctx) return false;
+
+        size_t dataLength = length - TAG_SIZE;
+        // 解密可能原地进行，先取出标签
+        uint8_t tag[TAG_SIZE];
+        memcpy(tag, ciphertext + dataLength, TAG_SIZE);
+
+        uint8_t nonce[NONCE_SIZE];
+        buildNonce(counter, nonce);
+        int written = 0;
+        int finalLength = 0;
+        return EVP_DecryptInit_ex(ctx, EVP_chacha20_poly1305(), nullptr, key, nonce) == 1 &&
+               EVP_DecryptUpdate(ctx, nullptr, &written, aad, static_cast<int>(aadLength)) == 1 &&
+               EVP_DecryptUpdate(ctx, out, &written, ciphertext, static_cast<int>(dataLength)) == 1 &&
+               EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, static_cast<int>(TAG_SIZE), tag) == 1 &&
+               EVP_DecryptFinal_ex(ctx, out + written, &finalLength) == 1;
+    }
+
+    bool ReplayWindow::accept(uint64_t counter) {
+        if (counter == 0) return false;
+        if (counter > highest_) {
+            uint64_t shift = counter - highest_;
+            bitmap_ = shift >= 64 ? 0 : bitmap_ << shift;
+            bitmap_ |= 1;
+            highest_ = counter;
+            return true;
+        }
+        uint64_t offset = highest_ - counter;
+        if (offset >= 64) return false;
+        uint64_t bit = uint64_t{1} << offset;
+        if (bitmap_ & bit) return false;
+        bitmap_ |= bit;
+        return true;
+    }
+
+} // namespace DatagramCrypto
@@ -0,0 +1,64 @@
+#ifndef DATAGRAM_CRYPTO_H
+#define DATAGRAM_CRYPTO_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 直连数据报的 AEAD 加密（ChaCha20-Poly1305，OpenSSL 实现）
+ *
+ * 每个方向使用接收方生成、经 Steam 可靠通道下发的 256 位密钥。
+ * 96 位 nonce 由 32 位零和 64 位发送计数器组成，同一密钥下计数器不得重复；
+ * 接收方用 ReplayWindow 拒绝重放。
+ */
+namespace DatagramCrypto {
+
+    constexpr size_t KEY_SIZE = 32;
+    constexpr size_t TAG_SIZE = 16;
+
+    /**
+     * @brief 用系统 CSPRNG 填充随机字节（密钥、令牌）
+     * @return false 表示随机数源不可用
+     */
+    bool randomBytes(uint8_t* out, size_t length);
+
+    /**
+     * @brief 加密并认证
+     * @param counter 发送计数器，同一密钥下唯一
+     * @param aad 仅认证不加密的数据（数据报头部）
+     * @param out 输出 length + TAG_SIZE 字节，可以与 plaintext 相同
+     */
+    bool seal(const uint8_t* key, uint64_t counter, const uint8_t* aad, size_t aadLength,
+              const uint8_t* plaintext, size_t length, uint8_t* out);
+
+    /**
+     * @brief 验证并解密
+     * @param length 密文长度（含 TAG_SIZE 字节的认证标签）
+     * @param out 输出 length - TAG_SIZE 字节，可以与 ciphertext 相同
+     * @return false 表示认证失败，out 内容无效
+     */
+    bool open(const uint8_t* key, uint64_t counter, const uint8_t* aad, size_t aadLength,
+              const uint8_t* ciphertext, size_t length, uint8_t* out);
+
+    /**
+     * @brief 重放窗口（RFC 6479 风格，窗口 64 个计数器）
+     *
+     * 只应在认证成功后调用 accept。计数器 0 保留不用。
+     */
+    class ReplayWindow {
+    public:
+        /**
+         * @return true 表示计数器首次出现并已记录
+         */
+        bool accept(uint64_t counter);
+
+        void reset() { highest_ = 0; bitmap_ = 0; }
+
+    private:
+        uint64_t highest_ = 0;
+        uint64_t bitmap_ = 0;   // 第 i 位对应 highest_ - i
+    };
+
+} // namespace DatagramCrypto
+
+#endif // DATAGRAM_CRYPTO_H
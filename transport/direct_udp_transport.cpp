@@ -0,0 +1,970 @@
+#include "direct_udp_transport.h"
+#include "datagram_crypto.h"
+#include "../vpn/vpn_protocol.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <arpa/inet.h>
+#endif
+
+namespace {
+
+    // 数据报格式：magic(4, 大端) | type(1) | reserved(3) | token(8) | counter(8) | 密文 | tag(16)
+    // 头部作为附加认证数据；信标不加密，token 字段为发送方 Steam ID，counter 字段为随机数
+    constexpr uint32_t DIRECT_UDP_MAGIC = 0x43544455;  // "CTDU"
+    constexpr size_t DIRECT_UDP_HEADER_SIZE = 24;
+    constexpr size_t DIRECT_UDP_OVERHEAD = DIRECT_UDP_HEADER_SIZE + DatagramCrypto::TAG_SIZE;
+
+    constexpr uint8_t DATAGRAM_DATA = 1;        // payload: VPN 消息
+    constexpr uint8_t DATAGRAM_PROBE = 2;       // payload: 探测随机数（每个探测包不同）
+    constexpr uint8_t DATAGRAM_PROBE_ACK = 3;   // payload: 回显的探测随机数
+    constexpr uint8_t DATAGRAM_LAN_BEACON = 4;
+
+    static_assert(UDP_DATAGRAM_KEY_SIZE == DatagramCrypto::KEY_SIZE, "key size mismatch");
+
+    constexpr size_t DATAGRAM_POOL_SIZE = 256;
+    constexpr size_t MAX_LEARNED_CANDIDATES = 16;
+    constexpr size_t MAX_OUTSTANDING_PROBES = 32;
+
+    constexpr auto MAINTENANCE_INTERVAL = std::chrono::milliseconds(50);
+    constexpr auto PROBE_INTERVAL = std::chrono::milliseconds(200);
+    constexpr auto OFFER_TIMEOUT = std::chrono::seconds(10);
+    constexpr auto PUNCH_TIMEOUT = std::chrono::seconds(5);
+    constexpr auto KEEPALIVE_INTERVAL = std::chrono::seconds(2);
+    constexpr auto PATH_TIMEOUT = std::chrono::seconds(10);
+    constexpr auto RETRY_DELAY = std::chrono::seconds(30);
+    constexpr auto BEACON_INTERVAL = std::chrono::seconds(2);
+    constexpr auto NONCE_ROTATE_INTERVAL = std::chrono::seconds(30);
+    constexpr auto ECHO_RETRY = std::chrono::seconds(10);
+    constexpr int MAX_BEACONS_PER_POLL = 16;
+
+    void writeHeader(uint8_t* packet, uint8_t type, uint64_t token, uint64_t counter) {
+        packet[0] = static_cast<uint8_t>(DIRECT_UDP_MAGIC >> 24);
+        packet[1] = static_cast<uint8_t>(DIRECT_UDP_MAGIC >> 16);
+        packet[2] = static_cast<uint8_t>(DIRECT_UDP_MAGIC >> 8);
+        packet[3] = static_cast<uint8_t>(DIRECT_UDP_MAGIC);
+        packet[4] = type;
+        packet[5] = packet[6] = packet[7] = 0;
+        memcpy(packet + 8, &token, sizeof(token));
+        memcpy(packet + 16, &counter, sizeof(counter));
+    }
+
+    bool readHeader(const uint8_t* packet, size_t length, uint8_t& type, uint64_t& token, uint64_t& counter) {
+        if (length < DIRECT_UDP_HEADER_SIZE) return false;
+        uint32_t magic = (static_cast<uint32_t>(packet[0]) << 24) | (static_cast<uint32_t>(packet[1]) << 16) |
+                         (static_cast<uint32_t>(packet[2]) << 8) | packet[3];
+        if (magic != DIRECT_UDP_MAGIC) return false;
+        type = packet[4];
+        memcpy(&token, packet + 8, sizeof(token));
+        memcpy(&counter, packet + 16, sizeof(counter));
+        return true;
+    }
+
+    /**
+     * @brief 组装并加密一个数据报
+     * @param packet 输出缓冲区，至少 DIRECT_UDP_OVERHEAD + length 字节
+     * @return 数据报长度，加密失败返回 0
+     */
+    size_t sealDatagram(uint8_t* packet, uint8_t type, uint64_t token, const uint8_t* key, uint64_t counter,
+                        const void* payload, size_t length) {
+        writeHeader(packet, type, token, counter);
+        if (!DatagramCrypto::seal(key, counter, packet, DIRECT_UDP_HEADER_SIZE, static_cast<const uint8_t*>(payload),
+                                  length, packet + DIRECT_UDP_HEADER_SIZE)) {
+            return 0;
+        }
+        return DIRECT_UDP_OVERHEAD + length;
+    }
+
+    void writeCandidate(const asio::ip::udp::endpoint& endpoint, UdpCandidate& candidate) {
+        auto bytes = endpoint.address().to_v4().to_bytes();
+        candidate.family = 4;
+        candidate.reserved = 0;
+        candidate.port = htons(endpoint.port());
+        memcpy(candidate.address, bytes.data(), bytes.size());
+    }
+
+    bool readCandidate(const UdpCandidate& candidate, asio::ip::udp::endpoint& endpoint) {
+        if (candidate.family != 4) return false;
+        asio::ip::address_v4::bytes_type bytes;
+        memcpy(bytes.data(), candidate.address, bytes.size());
+        endpoint = asio::ip::udp::endpoint(asio::ip::address_v4(bytes), ntohs(candidate.port));
+        return true;
+    }
+
+    int64_t nowMicroseconds() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    bool isVpnMessage(const uint8_t* data, size_t size, VpnMessageType type) {
+        return size >= sizeof(VpnMessageHeader) && data[0] == static_cast<uint8_t>(type);
+    }
+
+    // 被抽样追踪的包与普通 IP 包走同一路径
+    bool isIpPacket(const uint8_t* data, size_t size) {
+        return isVpnMessage(data, size, VpnMessageType::IP_PACKET) ||
+               isVpnMessage(data, size, VpnMessageType::IP_PACKET_TRACED);
+    }
+
+} // anonymous namespace
+
+DirectUdpTransport::DirectUdpTransport(TransportInterface* fallback, uint16_t port)
+    : fallback_(fallback)
+    , requestedPort_(port)
+    , localPort_(0)
+    , socket_(ioContext_)
+    , open_(false)
+    , beaconSocket_(ioContext_)
+    , lanDiscovery_(false)
+    , lanPort_(0)
+    , beaconNonce_(0)
+    , previousBeaconNonce_(0)
+    , rng_(std::random_device{}())
+    , datagramPool_(new Datagram[DATAGRAM_POOL_SIZE])
+{
+    memset(&stats_, 0, sizeof(stats_));
+    freeDatagrams_.reserve(DATAGRAM_POOL_SIZE);
+    for (size_t i = 0; i < DATAGRAM_POOL_SIZE; ++i) {
+        freeDatagrams_.push_back(&datagramPool_[i]);
+    }
+}
+
+DirectUdpTransport::~DirectUdpTransport() {
+    stop();
+}
+
+bool DirectUdpTransport::start() {
+    if (open_) return true;
+
+    std::unique_lock<std::shared_mutex> socketLock(socketMutex_);
+    asio::error_code ec;
+    socket_.open(asio::ip::udp::v4(), ec);
+    if (!ec) socket_.bind(Endpoint(asio::ip::address_v4::any(), requestedPort_), ec);
+    if (!ec) socket_.non_blocking(true, ec);
+    if (ec) {
+        std::cerr << "[DirectUdp] Failed to open UDP port " << requestedPort_ << ": " << ec.message()
+                  << ", using Steam only" << std::endl;
+        socket_.close(ec);
+        return false;
+    }
+
+    localPort_ = socket_.local_endpoint(ec).port();
+    gatherLocalCandidates();
+    open_ = true;
+
+    std::cout << "[DirectUdp] Listening on UDP port " << localPort_ << " with "
+              << localCandidates_.size() << " candidate(s)" << std::endl;
+    return true;
+}
+
+bool DirectUdpTransport::startLanDiscovery(uint16_t port) {
+    if (!open_) return false;
+    if (lanDiscovery_) return true;
+
+    std::unique_lock<std::shared_mutex> socketLock(socketMutex_);
+    asio::error_code ec;
+    beaconSocket_.open(asio::ip::udp::v4(), ec);
+    // 同一台机器上的多个实例共享信标端口
+    if (!ec) beaconSocket_.set_option(asio::socket_base::reuse_address(true), ec);
+    if (!ec) beaconSocket_.bind(Endpoint(asio::ip::address_v4::any(), port), ec);
+    if (!ec) beaconSocket_.non_blocking(true, ec);
+    // 信标从数据端口发出，来源地址即为局域网直连地址
+    if (!ec) socket_.set_option(asio::socket_base::broadcast(true), ec);
+    if (ec) {
+        std::cerr << "[DirectUdp] Failed to open LAN discovery port " << port << ": " << ec.message() << std::endl;
+        beaconSocket_.close(ec);
+        return false;
+    }
+    socketLock.unlock();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lanPort_ = port;
+        do {
+            beaconNonce_ = rng_();
+        } while (beaconNonce_ == 0);
+        nextBeacon_ = Clock::time_point{};
+        nonceRotateAt_ = Clock::now() + NONCE_ROTATE_INTERVAL;
+    }
+    lanDiscovery_ = true;
+
+    std::cout << "[DirectUdp] LAN discovery on UDP port " << port << std::endl;
+    return true;
+}
+
+void DirectUdpTransport::stop() {
+    if (!open_.exchange(false)) return;
+    lanDiscovery_ = false;
+
+    {
+        // 等待其他线程上正在进行的收发完成；之后它们看到 open_ 为 false 不再使用套接字
+        std::unique_lock<std::shared_mutex> socketLock(socketMutex_);
+        asio::error_code ec;
+        socket_.close(ec);
+        beaconSocket_.close(ec);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    peers_.clear();
+    tokenToPeer_.clear();
+    lanSightings_.clear();
+    localPort_ = 0;
+}
+
+void DirectUdpTransport::gatherLocalCandidates() {
+    localCandidates_.clear();
+    // 回环地址用于同一台机器上的多个进程
+    localCandidates_.emplace_back(asio::ip::address_v4::loopback(), localPort_);
+
+    asio::error_code ec;
+    asio::ip::udp::resolver resolver(ioContext_);
+    auto results = resolver.resolve(asio::ip::udp::v4(), asio::ip::host_name(), "", ec);
+    if (ec) return;
+
+    for (const auto& entry : results) {
+        asio::ip::address address = entry.endpoint().address();
+        if (!address.is_v4() || address.is_loopback()) continue;
+
+        Endpoint candidate(address, localPort_);
+        if (std::find(localCandidates_.begin(), localCandidates_.end(), candidate) == localCandidates_.end() &&
+            localCandidates_.size() < MAX_UDP_CANDIDATES) {
+            localCandidates_.push_back(candidate);
+        }
+    }
+}
+
+DirectUdpTransport::PeerPath& DirectUdpTransport::pathFor(PeerId peer) {
+    return peers_[peer];
+}
+
+void DirectUdpTransport::setState(PeerId peer, PeerPath& path, PathState state) {
+    Clock::time_point now = Clock::now();
+    if (state == PathState::Direct && path.state != PathState::Direct) {
+        stats_.pathsEstablished++;
+        std::cout << "[DirectUdp] Direct path to " << peer << " via "
+                  << path.active.address().to_string() << ":" << path.active.port() << std::endl;
+    } else if (state == PathState::Failed) {
+        if (path.state == PathState::Direct) {
+            stats_.pathsLost++;
+            std::cout << "[DirectUdp] Direct path to " << peer
+                      << " lost, falling back to Steam" << std::endl;
+        } else if (path.state == PathState::Punching) {
+            std::cout << "[DirectUdp] Hole punching to " << peer
+                      << " failed, using Steam" << std::endl;
+        }
+        path.retryAt = now + RETRY_DELAY;
+    }
+    path.state = state;
+    path.stateSince = now;
+}
+
+void DirectUdpTransport::offerCandidates(PeerId peer, PeerPath& path, uint8_t flags, Outbox& outbox) {
+    if (path.localToken == 0) {
+        // 令牌和密钥都交给对端，使用 CSPRNG 生成
+        uint64_t token = 0;
+        while (token == 0 || tokenToPeer_.count(token)) {
+            if (!DatagramCrypto::randomBytes(reinterpret_cast<uint8_t*>(&token), sizeof(token)) ||
+                !DatagramCrypto::randomBytes(path.localKey, sizeof(path.localKey))) {
+                std::cerr << "[DirectUdp] No secure random source, not offering a direct path" << std::endl;
+                return;
+            }
+        }
+        path.localToken = token;
+        path.replay.reset();
+        tokenToPeer_[token] = peer;
+    }
+
+    UdpCandidatesPayload payload{};
+    payload.token = path.localToken;
+    payload.flags = flags;
+    memcpy(payload.key, path.localKey, sizeof(payload.key));
+    payload.count = static_cast<uint8_t>(std::min(localCandidates_.size(), MAX_UDP_CANDIDATES));
+    for (uint8_t i = 0; i < payload.count; ++i) {
+        writeCandidate(localCandidates_[i], payload.candidates[i]);
+    }
+
+    size_t payloadLength = offsetof(UdpCandidatesPayload, candidates) + payload.count * sizeof(UdpCandidate);
+    std::vector<uint8_t> message(sizeof(VpnMessageHeader) + payloadLength);
+    VpnMessageHeader header;
+    header.type = VpnMessageType::UDP_CANDIDATES;
+    header.length = htons(static_cast<uint16_t>(payloadLength));
+    memcpy(message.data(), &header, sizeof(header));
+    memcpy(message.data() + sizeof(header), &payload, payloadLength);
+    outbox.messages.emplace_back(peer, std::move(message));
+
+    if (path.state == PathState::Idle || path.state == PathState::Failed) {
+        setState(peer, path, PathState::Offered);
+    }
+}
+
+void DirectUdpTransport::handleCandidates(PeerId peer, const uint8_t* payload, size_t length, Outbox& outbox) {
+    // 不带密钥的候选地址（旧版本）无法建立加密路径
+    if (!open_ || length < offsetof(UdpCandidatesPayload, candidates)) return;
+
+    UdpCandidatesPayload offer{};
+    memcpy(&offer, payload, std::min(length, sizeof(offer)));
+    size_t count = std::min<size_t>(offer.count, MAX_UDP_CANDIDATES);
+    count = std::min(count, (length - offsetof(UdpCandidatesPayload, candidates)) / sizeof(UdpCandidate));
+
+    std::vector<Endpoint> candidates;
+    bool sameHost = true;
+    for (size_t i = 0; i < count; ++i) {
+        Endpoint candidate;
+        if (!readCandidate(offer.candidates[i], candidate)) continue;
+        candidates.push_back(candidate);
+
+        if (!candidate.address().is_loopback()) {
+            sameHost = false;
+            for (const auto& local : localCandidates_) {
+                if (local.address() == candidate.address()) sameHost = true;
+            }
+        }
+    }
+    // 回环候选只在双方位于同一台机器时有意义
+    if (!sameHost) {
+        candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+            [](const Endpoint& e) { return e.address().is_loopback(); }), candidates.end());
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    PeerPath& path = pathFor(peer);
+    bool tokenChanged = path.remoteToken != offer.token ||
+                        memcmp(path.remoteKey, offer.key, sizeof(offer.key)) != 0;
+    if (tokenChanged) {
+        // 新密钥下计数器从头开始
+        path.remoteToken = offer.token;
+        memcpy(path.remoteKey, offer.key, sizeof(offer.key));
+        path.sendCounter = 0;
+        path.probes.clear();
+    }
+    path.candidates = std::move(candidates);
+
+    if (offer.flags & UDP_CANDIDATES_FLAG_REPLY) {
+        offerCandidates(peer, path, 0, outbox);
+    }
+    if (path.state != PathState::Direct || tokenChanged) {
+        setState(peer, path, PathState::Punching);
+        path.lastProbe = Clock::time_point{};
+    }
+}
+
+void DirectUdpTransport::sendProbe(PeerPath& path, const Endpoint& to, Outbox& outbox) {
+    if (path.remoteToken == 0) return;
+
+    // 记录探测的目标和随机数，应答必须来自该地址并回显同一随机数
+    if (path.probes.size() >= MAX_OUTSTANDING_PROBES) {
+        path.probes.erase(path.probes.begin());
+    }
+    uint64_t nonce = rng_();
+    path.probes.push_back({to, nonce, nowMicroseconds()});
+    sendControl(path, to, DATAGRAM_PROBE, nonce, outbox);
+}
+
+void DirectUdpTransport::sendControl(PeerPath& path, const Endpoint& to, uint8_t type, uint64_t nonce,
+                                     Outbox& outbox) {
+    uint8_t packet[DIRECT_UDP_OVERHEAD + sizeof(uint64_t)];
+    size_t length = sealDatagram(packet, type, path.remoteToken, path.remoteKey, ++path.sendCounter,
+                                 &nonce, sizeof(nonce));
+    if (length == 0) return;
+    outbox.datagrams.emplace_back(to, std::vector<uint8_t>(packet, packet + length));
+}
+
+void DirectUdpTransport::flushOutbox(Outbox& outbox) {
+    if (!outbox.datagrams.empty()) {
+        std::shared_lock<std::shared_mutex> socketLock(socketMutex_);
+        if (open_) {
+            for (const auto& datagram : outbox.datagrams) {
+                asio::error_code ec;
+                socket_.send_to(asio::buffer(datagram.second), datagram.first, 0, ec);
+            }
+        }
+    }
+    for (const auto& message : outbox.messages) {
+        fallback_->sendToPeer(message.first, message.second.data(), static_cast<uint32_t>(message.second.size()),
+                              TRANSPORT_SEND_RELIABLE);
+    }
+    outbox.datagrams.clear();
+    outbox.messages.clear();
+}
+
+bool DirectUdpTransport::handleDatagram(Datagram* datagram, size_t length, const Endpoint& from,
+                                        TransportMessage& out, Outbox& outbox) {
+    uint8_t type;
+    uint64_t token;
+    uint64_t counter;
+    uint8_t key[DatagramCrypto::KEY_SIZE];
+    PeerId peer = INVALID_PEER_ID;
+    if (readHeader(datagram->data, length, type, token, counter) && length >= DIRECT_UDP_OVERHEAD) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = tokenToPeer_.find(token);
+        if (it != tokenToPeer_.end()) {
+            peer = it->second;
+            memcpy(key, pathFor(peer).localKey, sizeof(key));
+        }
+    }
+
+    // 解密在锁外进行；认证通过之前不改变任何路径状态
+    uint8_t* payload = datagram->data + DIRECT_UDP_HEADER_SIZE;
+    size_t payloadLength = length - DIRECT_UDP_OVERHEAD;
+    bool authentic = peer != INVALID_PEER_ID &&
+        DatagramCrypto::open(key, counter, datagram->data, DIRECT_UDP_HEADER_SIZE, payload,
+                             length - DIRECT_UDP_HEADER_SIZE, payload);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = tokenToPeer_.find(token);
+    if (!authentic || it == tokenToPeer_.end() || it->second != peer) {
+        stats_.invalidDatagrams++;
+        return false;
+    }
+    PeerPath& path = pathFor(peer);
+    if (!path.replay.accept(counter)) {
+        stats_.invalidDatagrams++;
+        return false;
+    }
+    Clock::time_point now = Clock::now();
+    path.lastReceived = now;
+
+    switch (type) {
+        case DATAGRAM_PROBE: {
+            if (payloadLength < sizeof(uint64_t) || path.remoteToken == 0) return false;
+            uint64_t nonce;
+            memcpy(&nonce, payload, sizeof(nonce));
+            sendControl(path, from, DATAGRAM_PROBE_ACK, nonce, outbox);
+
+            // 对端经 NAT 映射后的地址（peer-reflexive）
+            if (std::find(path.candidates.begin(), path.candidates.end(), from) == path.candidates.end() &&
+                path.candidates.size() < MAX_LEARNED_CANDIDATES) {
+                path.candidates.push_back(from);
+            }
+            return false;
+        }
+        case DATAGRAM_PROBE_ACK: {
+            if (payloadLength < sizeof(uint64_t)) return false;
+            uint64_t nonce;
+            memcpy(&nonce, payload, sizeof(nonce));
+            // 只接受我们探测过的地址、回显对应随机数的应答
+            auto probe = std::find_if(path.probes.begin(), path.probes.end(), [&](const ProbeRecord& record) {
+                return record.nonce == nonce && record.to == from;
+            });
+            if (probe == path.probes.end()) {
+                stats_.invalidDatagrams++;
+                return false;
+            }
+            int64_t sentUs = probe->sentUs;
+            path.probes.erase(probe);
+
+            // 已经走局域网路径时不被其他路径的应答切走
+            bool onLan = path.state == PathState::Direct && path.lanVerified && path.active == path.lanEndpoint;
+            if (!onLan) {
+                if (path.state == PathState::Direct && path.lanVerified && from == path.lanEndpoint) {
+                    std::cout << "[DirectUdp] Switched " << peer << " to LAN path "
+                              << from.address().to_string() << ":" << from.port() << std::endl;
+                }
+                path.active = from;
+            }
+            if (from == path.active) {
+                path.rttMs = static_cast<int>((nowMicroseconds() - sentUs) / 1000);
+            }
+            if (path.state != PathState::Direct) setState(peer, path, PathState::Direct);
+            return false;
+        }
+        case DATAGRAM_DATA: {
+            // 对端持有我们的密钥，说明路径可用；只接受已知的候选地址，其他来源只收数据不切换路径
+            bool known = std::find(path.candidates.begin(), path.candidates.end(), from) != path.candidates.end() ||
+                         (path.lanVerified && from == path.lanEndpoint);
+            if (path.state != PathState::Direct && path.remoteToken != 0 && known) {
+                path.active = from;
+                setState(peer, path, PathState::Direct);
+            }
+            stats_.directPacketsReceived++;
+            stats_.directBytesReceived += payloadLength;
+            path.packetsReceived++;
+
+            out.data = payload;
+            out.size = static_cast<uint32_t>(payloadLength);
+            out.sender = peer;
+            out.handle = datagram;
+            out.receivedAtUs = transportTimestampUs();
+            return true;
+        }
+        default:
+            stats_.invalidDatagrams++;
+            return false;
+    }
+}
+
+void DirectUdpTransport::maintain(Clock::time_point now, Outbox& outbox) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (auto& pair : peers_) {
+        PeerId peer = pair.first;
+        PeerPath& path = pair.second;
+
+        switch (path.state) {
+            case PathState::Offered:
+                if (now - path.stateSince > OFFER_TIMEOUT) setState(peer, path, PathState::Failed);
+                break;
+            case PathState::Punching:
+                if (now - path.stateSince > PUNCH_TIMEOUT) {
+                    setState(peer, path, PathState::Failed);
+                } else if (now - path.lastProbe >= PROBE_INTERVAL) {
+                    for (const auto& candidate : path.candidates) {
+                        sendProbe(path, candidate, outbox);
+                    }
+                    if (path.lanVerified &&
+                        std::find(path.candidates.begin(), path.candidates.end(), path.lanEndpoint) ==
+                            path.candidates.end()) {
+                        sendProbe(path, path.lanEndpoint, outbox);
+                    }
+                    path.lastProbe = now;
+                }
+                break;
+            case PathState::Direct:
+                if (now - path.lastReceived > PATH_TIMEOUT) {
+                    setState(peer, path, PathState::Failed);
+                } else if (now - path.lastProbe >= KEEPALIVE_INTERVAL) {
+                    sendProbe(path, path.active, outbox);
+                    // 已确认位于同一局域网但仍走其他路径时，继续探测局域网地址
+                    if (path.lanVerified && path.active != path.lanEndpoint) {
+                        sendProbe(path, path.lanEndpoint, outbox);
+                    }
+                    path.lastProbe = now;
+                }
+                break;
+            case PathState::Idle:
+            case PathState::Failed:
+                break;
+        }
+    }
+
+    if (lanDiscovery_ && now >= nextBeacon_) {
+        sendBeacon(now, outbox);
+    }
+}
+
+void DirectUdpTransport::sendBeacon(Clock::time_point now, Outbox& outbox) {
+    if (now >= nonceRotateAt_) {
+        previousBeaconNonce_ = beaconNonce_;
+        do {
+            beaconNonce_ = rng_();
+        } while (beaconNonce_ == 0);
+        nonceRotateAt_ = now + NONCE_ROTATE_INTERVAL;
+    }
+
+    uint8_t packet[DIRECT_UDP_HEADER_SIZE];
+    writeHeader(packet, DATAGRAM_LAN_BEACON, fallback_->getLocalId(), beaconNonce_);
+
+    outbox.datagrams.emplace_back(Endpoint(asio::ip::address_v4::broadcast(), lanPort_),
+                                  std::vector<uint8_t>(packet, packet + sizeof(packet)));
+    stats_.beaconsSent++;
+    nextBeacon_ = now + BEACON_INTERVAL;
+}
+
+void DirectUdpTransport::drainBeacons(Outbox& outbox) {
+    uint8_t buffer[64];
+    for (int i = 0; i < MAX_BEACONS_PER_POLL; ++i) {
+        Endpoint from;
+        asio::error_code ec;
+        size_t length = beaconSocket_.receive_from(asio::buffer(buffer, sizeof(buffer)), from, 0, ec);
+        if (ec) break;
+        handleBeacon(buffer, length, from, outbox);
+    }
+}
+
+void DirectUdpTransport::handleBeacon(const uint8_t* data, size_t length, const Endpoint& from, Outbox& outbox) {
+    uint8_t type;
+    uint64_t steamId;
+    uint64_t nonce;
+    if (!readHeader(data, length, type, steamId, nonce) || type != DATAGRAM_LAN_BEACON) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.invalidDatagrams++;
+        return;
+    }
+
+    PeerId peer = steamId;
+    if (peer == fallback_->getLocalId()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.beaconsReceived++;
+
+        // 只与通信过的节点确认，避免向局域网内的陌生 Steam 用户发消息；
+        // 未知节点的信标会在其成为已知节点后的下一次广播时处理
+        auto pathIt = peers_.find(peer);
+        if (pathIt == peers_.end()) return;
+        if (pathIt->second.lanVerified && pathIt->second.lanEndpoint == from) return;
+
+        Clock::time_point now = Clock::now();
+        LanSighting& sighting = lanSightings_[peer];
+        if (sighting.nonce == nonce) {
+            if (sighting.conflicted) return;
+            if (sighting.endpoint != from) {
+                // 同一随机数出现在两个地址上，至少一个是重放；该随机数不再确认，等待对端换新
+                sighting.conflicted = true;
+                stats_.invalidDatagrams++;
+                return;
+            }
+            if (now - sighting.echoedAt < ECHO_RETRY) return;
+        }
+        sighting.endpoint = from;
+        sighting.nonce = nonce;
+        sighting.echoedAt = now;
+        sighting.conflicted = false;
+    }
+    queueBeaconEcho(peer, nonce, 0, from, outbox);
+}
+
+bool DirectUdpTransport::isOwnEndpoint(const Endpoint& endpoint) {
+    if (endpoint.port() != localPort_) return false;
+    for (const auto& local : localCandidates_) {
+        if (local.address() == endpoint.address()) return true;
+    }
+    // 主机名解析不一定列出所有网卡地址：能绑定即为本机地址
+    asio::ip::udp::socket probe(ioContext_);
+    asio::error_code ec;
+    probe.open(asio::ip::udp::v4(), ec);
+    if (!ec) probe.bind(Endpoint(endpoint.address(), 0), ec);
+    return !ec;
+}
+
+void DirectUdpTransport::queueBeaconEcho(PeerId peer, uint64_t nonce, uint8_t flags, const Endpoint& endpoint,
+                                         Outbox& outbox) {
+    std::vector<uint8_t> message(sizeof(VpnMessageHeader) + sizeof(LanBeaconEchoPayload));
+    VpnMessageHeader header;
+    header.type = VpnMessageType::LAN_BEACON_ECHO;
+    header.length = htons(static_cast<uint16_t>(sizeof(LanBeaconEchoPayload)));
+    LanBeaconEchoPayload payload{};
+    payload.nonce = nonce;
+    payload.flags = flags;
+    writeCandidate(endpoint, payload.endpoint);
+    memcpy(message.data(), &header, sizeof(header));
+    memcpy(message.data() + sizeof(header), &payload, sizeof(payload));
+    outbox.messages.emplace_back(peer, std::move(message));
+}
+
+void DirectUdpTransport::handleBeaconEcho(PeerId peer, const uint8_t* payload, size_t length, Outbox& outbox) {
+    if (!lanDiscovery_ || length < sizeof(LanBeaconEchoPayload)) return;
+
+    LanBeaconEchoPayload echo;
+    memcpy(&echo, payload, sizeof(echo));
+    Endpoint endpoint;
+    if (!readCandidate(echo.endpoint, endpoint)) return;
+
+    if (!(echo.flags & LAN_BEACON_FLAG_CONFIRMED)) {
+        // 对端收到了我们的信标：确认随机数是我们广播的，且信标来自我们自己的数据端口
+        bool ours;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ours = echo.nonce != 0 && (echo.nonce == beaconNonce_ || echo.nonce == previousBeaconNonce_);
+        }
+        if (ours && isOwnEndpoint(endpoint)) {
+            queueBeaconEcho(peer, echo.nonce, LAN_BEACON_FLAG_CONFIRMED, endpoint, outbox);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = lanSightings_.find(peer);
+    if (it == lanSightings_.end() || it->second.conflicted || it->second.nonce != echo.nonce ||
+        it->second.endpoint != endpoint) {
+        return;
+    }
+
+    PeerPath& path = pathFor(peer);
+    path.lanEndpoint = it->second.endpoint;
+    lanSightings_.erase(it);
+    if (!path.lanVerified) {
+        path.lanVerified = true;
+        stats_.lanPeersVerified++;
+        std::cout << "[DirectUdp] Peer " << peer << " is on the LAN at "
+                  << path.lanEndpoint.address().to_string() << ":" << path.lanEndpoint.port() << std::endl;
+    }
+
+    if (path.state == PathState::Direct) {
+        // 已有直连路径：探测局域网地址，应答到达后切换
+        if (path.active != path.lanEndpoint) {
+            sendProbe(path, path.lanEndpoint, outbox);
+        }
+    } else if (path.state != PathState::Punching) {
+        // 不必等待 IP 流量或重试间隔，立即协商
+        offerCandidates(peer, path, UDP_CANDIDATES_FLAG_REPLY, outbox);
+    }
+}
+
+bool DirectUdpTransport::consumeControlMessage(const TransportMessage& message, Outbox& outbox) {
+    if (isVpnMessage(message.data, message.size, VpnMessageType::UDP_CANDIDATES)) {
+        handleCandidates(message.sender, message.data + sizeof(VpnMessageHeader),
+                         message.size - sizeof(VpnMessageHeader), outbox);
+        return true;
+    }
+    if (isVpnMessage(message.data, message.size, VpnMessageType::LAN_BEACON_ECHO)) {
+        handleBeaconEcho(message.sender, message.data + sizeof(VpnMessageHeader),
+                         message.size - sizeof(VpnMessageHeader), outbox);
+        return true;
+    }
+    return false;
+}
+
+bool DirectUdpTransport::sendToPeer(PeerId peer, const void* data, uint32_t size, int flags) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    bool reliable = (flags & TRANSPORT_SEND_RELIABLE) != 0;
+    if (!open_ || reliable || !isIpPacket(bytes, size) ||
+        size + DIRECT_UDP_OVERHEAD > sizeof(Datagram::data)) {
+        return fallback_->sendToPeer(peer, data, size, flags);
+    }
+
+    Endpoint target;
+    uint64_t token = 0;
+    uint64_t counter = 0;
+    uint8_t key[DatagramCrypto::KEY_SIZE];
+    Outbox outbox;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        PeerPath& path = pathFor(peer);
+        Clock::time_point now = Clock::now();
+        if (path.state == PathState::Direct) {
+            target = path.active;
+            token = path.remoteToken;
+            counter = ++path.sendCounter;
+            memcpy(key, path.remoteKey, sizeof(key));
+        } else if (path.state == PathState::Idle ||
+                   (path.state == PathState::Failed && now >= path.retryAt)) {
+            // 第一次有 IP 流量时开始协商
+            offerCandidates(peer, path, UDP_CANDIDATES_FLAG_REPLY, outbox);
+        }
+    }
+    flushOutbox(outbox);
+
+    if (token != 0) {
+        uint8_t packet[sizeof(Datagram::data)];
+        size_t length = sealDatagram(packet, DATAGRAM_DATA, token, key, counter, data, size);
+
+        asio::error_code ec = asio::error::not_connected;
+        if (length != 0) {
+            std::shared_lock<std::shared_mutex> socketLock(socketMutex_);
+            if (open_) socket_.send_to(asio::buffer(packet, length), target, 0, ec);
+        }
+        if (!ec) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.directPacketsSent++;
+            stats_.directBytesSent += size;
+            pathFor(peer).packetsSent++;
+            return true;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.fallbackPacketsSent++;
+    }
+    return fallback_->sendToPeer(peer, data, size, flags);
+}
+
+int DirectUdpTransport::broadcast(const void* data, uint32_t size, int flags) {
+    return fallback_->broadcast(data, size, flags);
+}
+
+int DirectUdpTransport::receiveBatch(TransportMessage* messages, int maxMessages) {
+    if (maxMessages <= 0) return 0;
+
+    int count = 0;
+    Outbox outbox;
+    {
+        // 锁顺序：socketMutex_ 在外，mutex_ 在内；持锁期间不发送，统一在 flushOutbox 中发出
+        std::shared_lock<std::shared_mutex> socketLock(socketMutex_);
+        if (open_) count = receiveDirect(messages, maxMessages, outbox);
+    }
+
+    int received = fallback_->receiveBatch(messages + count, maxMessages - count);
+
+    // 取走协商消息，其余消息保持顺序
+    int end = count + received;
+    int kept = count;
+    for (int i = count; i < end; ++i) {
+        TransportMessage& message = messages[i];
+        if (consumeControlMessage(message, outbox)) {
+            fallback_->release(&message, 1);
+            continue;
+        }
+        if (kept != i) messages[kept] = message;
+        kept++;
+    }
+    flushOutbox(outbox);
+    return kept;
+}
+
+int DirectUdpTransport::receiveDirect(TransportMessage* messages, int maxMessages, Outbox& outbox) {
+    Clock::time_point now = Clock::now();
+    if (now >= nextMaintenance_) {
+        maintain(now, outbox);
+        nextMaintenance_ = now + MAINTENANCE_INTERVAL;
+    }
+    if (lanDiscovery_) drainBeacons(outbox);
+
+    // 给后备传输层保留一半配额，避免直连流量饿死 Steam 消息
+    int udpBudget = std::max(1, maxMessages / 2);
+    int count = 0;
+    while (count < udpBudget) {
+        Datagram* datagram = acquireDatagram();
+        if (!datagram) break;
+
+        Endpoint from;
+        asio::error_code ec;
+        size_t length = socket_.receive_from(asio::buffer(datagram->data, sizeof(datagram->data)), from, 0, ec);
+        if (ec) {
+            // would_block：已取空
+            releaseDatagram(datagram);
+            break;
+        }
+        if (!handleDatagram(datagram, length, from, messages[count], outbox)) {
+            releaseDatagram(datagram);
+            continue;
+        }
+        count++;
+    }
+    return count;
+}
+
+void DirectUdpTransport::release(TransportMessage* messages, int count) {
+    // 连续的后备传输层消息一次归还
+    int runStart = 0;
+    for (int i = 0; i < count; ++i) {
+        if (isOwnDatagram(messages[i].handle)) {
+            if (i > runStart) fallback_->release(messages + runStart, i - runStart);
+            releaseDatagram(static_cast<Datagram*>(messages[i].handle));
+            messages[i].handle = nullptr;
+            runStart = i + 1;
+        }
+    }
+    if (count > runStart) fallback_->release(messages + runStart, count - runStart);
+}
+
+void DirectUdpTransport::flush() {
+    // 直连数据报已在 sendToPeer 中发出
+    fallback_->flush();
+}
+
+bool DirectUdpTransport::isOwnDatagram(const void* handle) const {
+    const Datagram* datagram = static_cast<const Datagram*>(handle);
+    return datagram >= datagramPool_.get() && datagram < datagramPool_.get() + DATAGRAM_POOL_SIZE;
+}
+
+DirectUdpTransport::Datagram* DirectUdpTransport::acquireDatagram() {
+    std::lock_guard<std::mutex> lock(poolMutex_);
+    if (freeDatagrams_.empty()) return nullptr;
+    Datagram* datagram = freeDatagrams_.back();
+    freeDatagrams_.pop_back();
+    return datagram;
+}
+
+void DirectUdpTransport::releaseDatagram(Datagram* datagram) {
+    std::lock_guard<std::mutex> lock(poolMutex_);
+    freeDatagrams_.push_back(datagram);
+}
+
+bool DirectUdpTransport::isDirect(PeerId peer) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(peer);
+    return it != peers_.end() && it->second.state == PathState::Direct;
+}
+
+int DirectUdpTransport::getPendingSendBytes(PeerId peer) const {
+    // 直连数据报由系统缓冲，没有可查询的排队量
+    if (isDirect(peer)) return 0;
+    return fallback_->getPendingSendBytes(peer);
+}
+
+int DirectUdpTransport::getPeerRtt(PeerId peer) const {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = peers_.find(peer);
+        if (it != peers_.end() && it->second.state == PathState::Direct && it->second.rttMs >= 0) {
+            return it->second.rttMs;
+        }
+    }
+    return fallback_->getPeerRtt(peer);
+}
+
+PeerId DirectUdpTransport::getLocalId() const {
+    return fallback_->getLocalId();
+}
+
+uint32_t DirectUdpTransport::getLocalAddress() const {
+    return fallback_->getLocalAddress();
+}
+
+PeerId DirectUdpTransport::resolveAddress(uint32_t ip) const {
+    return fallback_->resolveAddress(ip);
+}
+
+int DirectUdpTransport::getMtuDataSize() const {
+    // 隧道 MTU 仍以后备传输层为准，路径切换时无需改变
+    return fallback_->getMtuDataSize();
+}
+
+DirectUdpTransport::PeerPathInfo DirectUdpTransport::describePath(PeerId peer, const PeerPath& path) const {
+    PeerPathInfo info;
+    info.peer = peer;
+    info.kind = PathKind::Steam;
+    info.directRttMs = -1;
+    info.fallbackRttMs = -1;
+    info.latencySavedMs = 0;
+    info.packetsSent = path.packetsSent;
+    info.packetsReceived = path.packetsReceived;
+    if (path.state == PathState::Direct) {
+        info.kind = (path.lanVerified && path.active == path.lanEndpoint) ? PathKind::Lan : PathKind::Direct;
+        info.endpoint = path.active.address().to_string() + ":" + std::to_string(path.active.port());
+        info.directRttMs = path.rttMs;
+    }
+    return info;
+}
+
+DirectUdpTransport::PathKind DirectUdpTransport::getPathKind(PeerId peer) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(peer);
+    if (it == peers_.end()) return PathKind::Steam;
+    return describePath(peer, it->second).kind;
+}
+
+bool DirectUdpTransport::getPeerPath(PeerId peer, PeerPathInfo& info) const {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = peers_.find(peer);
+        if (it == peers_.end()) return false;
+        info = describePath(peer, it->second);
+    }
+    // 后备传输层的 RTT 在锁外查询
+    info.fallbackRttMs = fallback_->getPeerRtt(peer);
+    if (info.kind != PathKind::Steam && info.directRttMs >= 0 && info.fallbackRttMs >= 0) {
+        info.latencySavedMs = std::max(0, info.fallbackRttMs - info.directRttMs);
+    }
+    return true;
+}
+
+std::vector<DirectUdpTransport::PeerPathInfo> DirectUdpTransport::getPeerPaths() const {
+    std::vector<PeerPathInfo> paths;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        paths.reserve(peers_.size());
+        for (const auto& pair : peers_) {
+            paths.push_back(describePath(pair.first, pair.second));
+        }
+    }
+    for (auto& info : paths) {
+        info.fallbackRttMs = fallback_->getPeerRtt(info.peer);
+        if (info.kind != PathKind::Steam && info.directRttMs >= 0 && info.fallbackRttMs >= 0) {
+            info.latencySavedMs = std::max(0, info.fallbackRttMs - info.directRttMs);
+        }
+    }
+    return paths;
+}
+
+DirectUdpTransport::Statistics DirectUdpTransport::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
@@ -0,0 +1,266 @@
+#ifndef DIRECT_UDP_TRANSPORT_H
+#define DIRECT_UDP_TRANSPORT_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <asio.hpp>
+#include "transport_interface.h"
+#include "datagram_crypto.h"
+
+/**
+ * @brief 直连 UDP 传输层（装饰器）
+ *
+ * 通过后备传输层（Steam）的可靠 VPN 消息（UDP_CANDIDATES）交换候选地址和
+ * 会话令牌，双方同时向对方的候选地址发送探测包完成打洞。路径建立后，
+ * 发往该节点的 IP_PACKET（含 IP_PACKET_TRACED）不可靠消息直接走 UDP，其余消息以及路径不可用时
+ * 自动回退到后备传输层。
+ *
+ * 每个数据报都携带接收方下发的 64 位令牌，并用接收方随候选地址下发的密钥
+ * 以 ChaCha20-Poly1305 加密认证（见 DatagramCrypto）。令牌不匹配、认证失败
+ * 或计数器重放的数据报直接丢弃，且不会改变路径状态。
+ *
+ * 候选地址包括本机各 IPv4 地址和回环地址（同一台机器上的两个进程也可直连），
+ * 以及从对端探测包中学到的地址。
+ *
+ * 启用局域网发现后，定期从数据端口向局域网广播信标（Steam ID + 随机数）。
+ * 收到信标的一方通过 Steam 把随机数发回信标声称的 Steam ID（LAN_BEACON_ECHO），
+ * 对方确认后才把信标来源地址当作该节点的局域网地址，并优先使用该路径。
+ */
+class DirectUdpTransport : public TransportInterface {
+public:
+    /**
+     * @brief 直连统计
+     */
+    struct Statistics {
+        uint64_t directPacketsSent;
+        uint64_t directPacketsReceived;
+        uint64_t directBytesSent;
+        uint64_t directBytesReceived;
+        uint64_t fallbackPacketsSent;   // 没有可用直连路径、走后备传输层的 IP 包
+        uint64_t invalidDatagrams;      // 令牌或格式错误的数据报
+        uint64_t pathsEstablished;
+        uint64_t pathsLost;
+        uint64_t beaconsSent;
+        uint64_t beaconsReceived;
+        uint64_t lanPeersVerified;      // 经 Steam 确认位于同一局域网的节点
+    };
+
+    /**
+     * @brief 节点当前使用的路径
+     */
+    enum class PathKind {
+        Steam,      // 后备传输层
+        Direct,     // 打洞得到的直连 UDP
+        Lan         // 同一局域网内的直连 UDP
+    };
+
+    /**
+     * @brief 单个节点的路径信息
+     */
+    struct PeerPathInfo {
+        PeerId peer;
+        PathKind kind;
+        std::string endpoint;           // 直连时的对端地址，否则为空
+        int directRttMs;                // 直连 RTT，未知为 -1
+        int fallbackRttMs;              // 后备传输层 RTT，未知为 -1
+        int latencySavedMs;             // 直连相对后备传输层节省的 RTT
+        uint64_t packetsSent;           // 经直连发送的 IP 包
+        uint64_t packetsReceived;       // 经直连收到的 IP 包
+    };
+
+    /**
+     * @param fallback 后备传输层，生命周期需长于本对象
+     * @param port 本地 UDP 端口，0 表示由系统分配
+     */
+    DirectUdpTransport(TransportInterface* fallback, uint16_t port = 0);
+    ~DirectUdpTransport() override;
+
+    DirectUdpTransport(const DirectUdpTransport&) = delete;
+    DirectUdpTransport& operator=(const DirectUdpTransport&) = delete;
+
+    /**
+     * @brief 绑定 UDP 端口并收集本机候选地址
+     * @return false 表示无法绑定，此时所有消息都走后备传输层
+     */
+    bool start();
+
+    /**
+     * @brief 开始局域网发现（需先 start）
+     * @param port 信标端口，同一局域网内的所有节点需一致
+     * @return false 表示无法绑定信标端口，直连仍可正常使用
+     */
+    bool startLanDiscovery(uint16_t port);
+
+    /**
+     * @brief 关闭 UDP 端口，之后所有消息都走后备传输层
+     */
+    void stop();
+
+    /**
+     * @brief 是否已与指定节点建立直连路径
+     */
+    bool isDirect(PeerId peer) const;
+
+    /**
+     * @brief 获取本地 UDP 端口（未启动返回 0）
+     */
+    uint16_t getLocalPort() const { return localPort_; }
+
+    /**
+     * @brief 获取指定节点当前使用的路径
+     */
+    PathKind getPathKind(PeerId peer) const;
+
+    /**
+     * @brief 获取指定节点的路径信息
+     * @return false 表示从未与该节点通信
+     */
+    bool getPeerPath(PeerId peer, PeerPathInfo& info) const;
+
+    /**
+     * @brief 获取所有已知节点的路径信息
+     */
+    std::vector<PeerPathInfo> getPeerPaths() const;
+
+    Statistics getStatistics() const;
+
+    bool sendToPeer(PeerId peer, const void* data, uint32_t size, int flags) override;
+    int broadcast(const void* data, uint32_t size, int flags) override;
+    int receiveBatch(TransportMessage* messages, int maxMessages) override;
+    void release(TransportMessage* messages, int count) override;
+    void flush() override;
+    int getPendingSendBytes(PeerId peer) const override;
+    int getPeerRtt(PeerId peer) const override;
+    PeerId getLocalId() const override;
+    uint32_t getLocalAddress() const override;
+    PeerId resolveAddress(uint32_t ip) const override;
+    int getMtuDataSize() const override;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    using Endpoint = asio::ip::udp::endpoint;
+
+    enum class PathState {
+        Idle,       // 尚未协商
+        Offered,    // 已发送候选地址，等待对端
+        Punching,   // 正在向候选地址发送探测包
+        Direct,     // 直连可用
+        Failed      // 打洞失败或路径中断，retryAt 之后重试
+    };
+
+    // 尚未收到应答的探测包
+    struct ProbeRecord {
+        Endpoint to;
+        uint64_t nonce;
+        int64_t sentUs;
+    };
+
+    struct PeerPath {
+        PathState state = PathState::Idle;
+        uint64_t localToken = 0;            // 对端发给我们的数据报携带此令牌
+        uint64_t remoteToken = 0;           // 我们发给对端的数据报携带此令牌
+        uint8_t localKey[DatagramCrypto::KEY_SIZE] = {};   // 解密对端发来的数据报
+        uint8_t remoteKey[DatagramCrypto::KEY_SIZE] = {};  // 加密发给对端的数据报
+        uint64_t sendCounter = 0;           // 最近一次使用的发送计数器（remoteKey 下）
+        DatagramCrypto::ReplayWindow replay;
+        std::vector<Endpoint> candidates;
+        std::vector<ProbeRecord> probes;
+        Endpoint active;
+        Clock::time_point stateSince;
+        Clock::time_point lastProbe;
+        Clock::time_point lastReceived;
+        Clock::time_point retryAt;
+        int rttMs = -1;
+        Endpoint lanEndpoint;               // 经确认的局域网地址
+        bool lanVerified = false;
+        uint64_t packetsSent = 0;
+        uint64_t packetsReceived = 0;
+    };
+
+    // 收到但尚未确认的局域网信标
+    struct LanSighting {
+        Endpoint endpoint;
+        uint64_t nonce = 0;
+        Clock::time_point echoedAt;
+        bool conflicted = false;    // 同一随机数来自不同地址（重放），该随机数作废
+    };
+
+    // 接收缓冲区（receiveBatch 返回的 UDP 消息指向这里，release 时归还）
+    struct Datagram {
+        uint8_t data[2048];
+    };
+
+    // 持有 mutex_ 时生成的待发消息，释放锁后由 flushOutbox 统一发出
+    struct Outbox {
+        std::vector<std::pair<Endpoint, std::vector<uint8_t>>> datagrams;
+        std::vector<std::pair<PeerId, std::vector<uint8_t>>> messages;   // 经后备传输层可靠发送
+    };
+
+    PeerPath& pathFor(PeerId peer);
+    int receiveDirect(TransportMessage* messages, int maxMessages, Outbox& outbox);
+    void offerCandidates(PeerId peer, PeerPath& path, uint8_t flags, Outbox& outbox);
+    void handleCandidates(PeerId peer, const uint8_t* payload, size_t length, Outbox& outbox);
+    bool handleDatagram(Datagram* datagram, size_t length, const Endpoint& from, TransportMessage& out,
+                        Outbox& outbox);
+    void sendProbe(PeerPath& path, const Endpoint& to, Outbox& outbox);
+    void sendControl(PeerPath& path, const Endpoint& to, uint8_t type, uint64_t nonce, Outbox& outbox);
+    void flushOutbox(Outbox& outbox);
+    void maintain(Clock::time_point now, Outbox& outbox);
+    void gatherLocalCandidates();
+    void setState(PeerId peer, PeerPath& path, PathState state);
+    void sendBeacon(Clock::time_point now, Outbox& outbox);
+    void drainBeacons(Outbox& outbox);
+    void handleBeacon(const uint8_t* data, size_t length, const Endpoint& from, Outbox& outbox);
+    void handleBeaconEcho(PeerId peer, const uint8_t* payload, size_t length, Outbox& outbox);
+    void queueBeaconEcho(PeerId peer, uint64_t nonce, uint8_t flags, const Endpoint& endpoint, Outbox& outbox);
+    bool isOwnEndpoint(const Endpoint& endpoint);
+    bool consumeControlMessage(const TransportMessage& message, Outbox& outbox);
+    PeerPathInfo describePath(PeerId peer, const PeerPath& path) const;
+
+    bool isOwnDatagram(const void* handle) const;
+    Datagram* acquireDatagram();
+    void releaseDatagram(Datagram* datagram);
+
+    TransportInterface* fallback_;
+    uint16_t requestedPort_;
+    uint16_t localPort_;
+
+    asio::io_context ioContext_;
+    asio::ip::udp::socket socket_;
+    std::atomic<bool> open_;
+    // 收发持共享锁并检查 open_；start/startLanDiscovery/stop 持独占锁打开或关闭套接字
+    std::shared_mutex socketMutex_;
+    std::vector<Endpoint> localCandidates_;
+
+    // 局域网发现
+    asio::ip::udp::socket beaconSocket_;
+    std::atomic<bool> lanDiscovery_;
+    uint16_t lanPort_;
+    uint64_t beaconNonce_;
+    uint64_t previousBeaconNonce_;
+    Clock::time_point nextBeacon_;
+    Clock::time_point nonceRotateAt_;
+    std::map<PeerId, LanSighting> lanSightings_;
+
+    mutable std::mutex mutex_;
+    std::map<PeerId, PeerPath> peers_;
+    std::unordered_map<uint64_t, PeerId> tokenToPeer_;
+    std::mt19937_64 rng_;
+    Statistics stats_;
+    Clock::time_point nextMaintenance_;
+
+    std::unique_ptr<Datagram[]> datagramPool_;
+    std::vector<Datagram*> freeDatagrams_;
+    std::mutex poolMutex_;
+};
+
+#endif // DIRECT_UDP_TRANSPORT_H
@@ -0,0 +1,261 @@
+#include "emulated_transport.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+    // Pareto 长尾时延的形状参数
+    constexpr double PARETO_SHAPE = 2.5;
+
+    std::chrono::steady_clock::duration fromMilliseconds(double ms) {
+        return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double, std::milli>(std::max(ms, 0.0)));
+    }
+
+} // anonymous namespace
+
+EmulatedTransport::EmulatedTransport(TransportInterface* inner, const NetworkScenario& scenario)
+    : inner_(inner)
+    , scenario_(scenario)
+    , rng_(scenario.seed)
+    , nextSequence_(0)
+    , lastBroadcastPeers_(0)
+    , running_(true)
+{
+    memset(&stats_, 0, sizeof(stats_));
+    scheduler_ = std::thread(&EmulatedTransport::schedulerThread, this);
+    std::cout << "[EmulatedTransport] Network emulation enabled, scenario: " << scenario_.name << std::endl;
+}
+
+EmulatedTransport::~EmulatedTransport() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (scheduler_.joinable()) {
+        scheduler_.join();
+    }
+}
+
+EmulatedTransport::LinkState& EmulatedTransport::linkFor(PeerId target) {
+    auto it = links_.find(target);
+    if (it == links_.end()) {
+        LinkState state;
+        state.profile = &scenario_.linkFor(target);
+        it = links_.emplace(target, state).first;
+    }
+    return it->second;
+}
+
+bool EmulatedTransport::sampleLoss(LinkState& link) {
+    const LinkProfile& profile = *link.profile;
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    // Gilbert-Elliott: 先转移状态，再按当前状态的丢包率判定
+    if (link.badState) {
+        if (uniform(rng_) < profile.lossBadToGood) link.badState = false;
+    } else {
+        if (uniform(rng_) < profile.lossGoodToBad) link.badState = true;
+    }
+    double lossRate = link.badState ? profile.lossInBad : profile.lossInGood;
+    return lossRate > 0.0 && uniform(rng_) < lossRate;
+}
+
+EmulatedTransport::Clock::duration EmulatedTransport::sampleDelay(const LinkProfile& profile) {
+    double delayMs = profile.delayMs;
+    if (profile.jitterMs > 0.0) {
+        switch (profile.distribution) {
+            case LinkProfile::DelayDistribution::Constant:
+                break;
+            case LinkProfile::DelayDistribution::Uniform: {
+                std::uniform_real_distribution<double> jitter(-profile.jitterMs, profile.jitterMs);
+                delayMs += jitter(rng_);
+                break;
+            }
+            case LinkProfile::DelayDistribution::Normal: {
+                std::normal_distribution<double> jitter(0.0, profile.jitterMs);
+                delayMs += jitter(rng_);
+                break;
+            }
+            case LinkProfile::DelayDistribution::Pareto: {
+                std::uniform_real_distribution<double> uniform(0.0, 1.0);
+                double u = 1.0 - uniform(rng_);  // (0, 1]
+                delayMs += profile.jitterMs * (std::pow(u, -1.0 / PARETO_SHAPE) - 1.0);
+                break;
+            }
+        }
+    }
+    return fromMilliseconds(delayMs);
+}
+
+bool EmulatedTransport::schedule(PeerId target, const void* data, uint32_t size, int flags) {
+    LinkState& link = linkFor(target);
+    const LinkProfile& profile = *link.profile;
+    bool reliable = (flags & TRANSPORT_SEND_RELIABLE) != 0;
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    Clock::time_point now = Clock::now();
+
+    stats_.messagesSent++;
+
+    if (!reliable && profile.queueLimitBytes > 0 &&
+        link.queuedBytes + static_cast<int64_t>(size) > profile.queueLimitBytes) {
+        stats_.queueDrops++;
+        return false;
+    }
+
+    // 令牌桶（虚拟调度形式）：桶满时最多可以提前 burst 字节
+    Clock::time_point departure = now;
+    if (profile.rateBytesPerSec > 0) {
+        auto burstCredit = fromMilliseconds(1000.0 * profile.burstBytes / profile.rateBytesPerSec);
+        link.nextFree = std::max(link.nextFree, now - burstCredit);
+        departure = std::max(now, link.nextFree);
+        link.nextFree += fromMilliseconds(1000.0 * size / profile.rateBytesPerSec);
+    }
+
+    // 丢包在限速之后判定：被丢弃的包同样占用了链路带宽
+    if (!reliable && sampleLoss(link)) {
+        stats_.lost++;
+        return true;
+    }
+
+    Clock::time_point deliverAt = departure + sampleDelay(profile);
+    bool reorder = !reliable && profile.reorderRate > 0.0 && uniform(rng_) < profile.reorderRate;
+    if (reorder) {
+        deliverAt += fromMilliseconds(profile.reorderDelayMs);
+        stats_.reordered++;
+    } else {
+        // 抖动本身不打乱顺序，只有显式乱序才会被后续包超越
+        deliverAt = std::max(deliverAt, link.lastDelivery);
+        link.lastDelivery = deliverAt;
+    }
+
+    int copies = 1;
+    if (!reliable && profile.duplicateRate > 0.0 && uniform(rng_) < profile.duplicateRate) {
+        copies = 2;
+        stats_.duplicated++;
+    }
+
+    for (int i = 0; i < copies; ++i) {
+        Pending pending;
+        pending.deliverAt = deliverAt;
+        pending.sequence = nextSequence_++;
+        pending.target = target;
+        pending.flags = flags;
+        pending.data.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+        queue_.push(std::move(pending));
+        link.queuedBytes += size;
+    }
+    return true;
+}
+
+bool EmulatedTransport::sendToPeer(PeerId peer, const void* data, uint32_t size, int flags) {
+    bool accepted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        accepted = schedule(peer, data, size, flags);
+    }
+    cv_.notify_one();
+    return accepted;
+}
+
+int EmulatedTransport::broadcast(const void* data, uint32_t size, int flags) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        schedule(INVALID_PEER_ID, data, size, flags);
+    }
+    cv_.notify_one();
+    return lastBroadcastPeers_.load(std::memory_order_relaxed);
+}
+
+void EmulatedTransport::schedulerThread() {
+    std::vector<Pending> due;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        if (queue_.empty()) {
+            cv_.wait(lock);
+            continue;
+        }
+
+        Clock::time_point next = queue_.top().deliverAt;
+        if (Clock::now() < next) {
+            cv_.wait_until(lock, next);
+            continue;
+        }
+
+        Clock::time_point now = Clock::now();
+        while (!queue_.empty() && queue_.top().deliverAt <= now) {
+            // priority_queue::top 只读，取出前需要 const_cast 才能移动数据
+            Pending pending = std::move(const_cast<Pending&>(queue_.top()));
+            queue_.pop();
+            linkFor(pending.target).queuedBytes -= static_cast<int64_t>(pending.data.size());
+            due.push_back(std::move(pending));
+        }
+        stats_.messagesDelivered += due.size();
+
+        // 在锁外调用内层传输
+        lock.unlock();
+        for (const Pending& pending : due) {
+            uint32_t size = static_cast<uint32_t>(pending.data.size());
+            if (pending.target == INVALID_PEER_ID) {
+                lastBroadcastPeers_.store(inner_->broadcast(pending.data.data(), size, pending.flags),
+                                          std::memory_order_relaxed);
+            } else {
+                inner_->sendToPeer(pending.target, pending.data.data(), size, pending.flags);
+            }
+        }
+        inner_->flush();
+        due.clear();
+        lock.lock();
+    }
+}
+
+int EmulatedTransport::receiveBatch(TransportMessage* messages, int maxMessages) {
+    return inner_->receiveBatch(messages, maxMessages);
+}
+
+void EmulatedTransport::release(TransportMessage* messages, int count) {
+    inner_->release(messages, count);
+}
+
+int EmulatedTransport::getPendingSendBytes(PeerId peer) const {
+    int64_t queued = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = links_.find(peer);
+        if (it != links_.end()) queued = it->second.queuedBytes;
+    }
+    return inner_->getPendingSendBytes(peer) + static_cast<int>(queued);
+}
+
+int EmulatedTransport::getPeerRtt(PeerId peer) const {
+    int rtt = inner_->getPeerRtt(peer);
+    if (rtt < 0) return rtt;
+    // 内层 RTT 不经过仿真层，按对称链路加上往返两次基础时延
+    const LinkProfile& profile = scenario_.linkFor(peer);
+    return rtt + static_cast<int>(2 * profile.delayMs);
+}
+
+PeerId EmulatedTransport::getLocalId() const {
+    return inner_->getLocalId();
+}
+
+uint32_t EmulatedTransport::getLocalAddress() const {
+    return inner_->getLocalAddress();
+}
+
+PeerId EmulatedTransport::resolveAddress(uint32_t ip) const {
+    return inner_->resolveAddress(ip);
+}
+
+int EmulatedTransport::getMtuDataSize() const {
+    return inner_->getMtuDataSize();
+}
+
+EmulatedTransport::Statistics EmulatedTransport::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
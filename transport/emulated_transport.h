@@ -0,0 +1,119 @@
+#ifndef EMULATED_TRANSPORT_H
+#define EMULATED_TRANSPORT_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <vector>
+#include "transport_interface.h"
+#include "network_scenario.h"
+
+/**
+ * @brief 网络仿真传输层（装饰器）
+ *
+ * 包装任意传输层实现，在发送方向按场景对每条链路施加时延/抖动、
+ * Gilbert-Elliott 丢包、乱序、重复和令牌桶限速。接收方向直接透传。
+ *
+ * 可靠消息（TRANSPORT_SEND_RELIABLE）只受时延和限速影响，
+ * 不会被丢弃、乱序或重复，与 Steam 的可靠通道语义一致。
+ * 广播使用场景的默认链路；由于投递被推迟，broadcast 返回最近一次
+ * 实际广播的节点数量。
+ */
+class EmulatedTransport : public TransportInterface {
+public:
+    /**
+     * @brief 仿真统计
+     */
+    struct Statistics {
+        uint64_t messagesSent;      // 提交给仿真层的消息
+        uint64_t messagesDelivered; // 交给内层传输发送的消息（含重复）
+        uint64_t lost;              // 被丢包模型丢弃
+        uint64_t queueDrops;        // 超过排队上限被丢弃
+        uint64_t duplicated;        // 额外产生的重复消息
+        uint64_t reordered;         // 被额外延迟以产生乱序的消息
+    };
+
+    /**
+     * @param inner 被包装的传输层，生命周期需长于本对象
+     * @param scenario 仿真场景
+     */
+    EmulatedTransport(TransportInterface* inner, const NetworkScenario& scenario);
+    ~EmulatedTransport() override;
+
+    EmulatedTransport(const EmulatedTransport&) = delete;
+    EmulatedTransport& operator=(const EmulatedTransport&) = delete;
+
+    bool sendToPeer(PeerId peer, const void* data, uint32_t size, int flags) override;
+    int broadcast(const void* data, uint32_t size, int flags) override;
+    int receiveBatch(TransportMessage* messages, int maxMessages) override;
+    void release(TransportMessage* messages, int count) override;
+    int getPendingSendBytes(PeerId peer) const override;
+    int getPeerRtt(PeerId peer) const override;
+    PeerId getLocalId() const override;
+    uint32_t getLocalAddress() const override;
+    PeerId resolveAddress(uint32_t ip) const override;
+    int getMtuDataSize() const override;
+
+    /**
+     * @brief 获取当前场景名称
+     */
+    const std::string& getScenarioName() const { return scenario_.name; }
+
+    Statistics getStatistics() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // 每条链路的仿真状态
+    struct LinkState {
+        const LinkProfile* profile = nullptr;
+        bool badState = false;              // Gilbert-Elliott 当前状态
+        Clock::time_point nextFree;         // 令牌桶：下一个字节可以离开的时间
+        Clock::time_point lastDelivery;     // 保持未乱序消息的先后顺序
+        int64_t queuedBytes = 0;            // 已提交但尚未交给内层的字节数
+    };
+
+    // 等待投递的消息
+    struct Pending {
+        Clock::time_point deliverAt;
+        uint64_t sequence;                  // 同一时刻按提交顺序投递
+        PeerId target;                      // INVALID_PEER_ID 表示广播
+        int flags;
+        std::vector<uint8_t> data;
+
+        bool operator>(const Pending& other) const {
+            if (deliverAt != other.deliverAt) return deliverAt > other.deliverAt;
+            return sequence > other.sequence;
+        }
+    };
+
+    // 按链路参数调度一条消息，调用方需持有 mutex_
+    bool schedule(PeerId target, const void* data, uint32_t size, int flags);
+    LinkState& linkFor(PeerId target);
+    bool sampleLoss(LinkState& link);
+    Clock::duration sampleDelay(const LinkProfile& profile);
+    void schedulerThread();
+
+    TransportInterface* inner_;
+    NetworkScenario scenario_;
+    std::mt19937_64 rng_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::priority_queue<Pending, std::vector<Pending>, std::greater<Pending>> queue_;
+    std::map<PeerId, LinkState> links_;
+    uint64_t nextSequence_;
+    Statistics stats_;
+    std::atomic<int> lastBroadcastPeers_;
+    bool running_;
+    std::thread scheduler_;
+};
+
+#endif // EMULATED_TRANSPORT_H
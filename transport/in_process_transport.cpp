@@ -0,0 +1,168 @@
+#include "in_process_transport.h"
+#include <cstring>
+
+namespace {
+
+    // 与 Steam 不可靠消息的上限（STEAM_UNRELIABLE_MSG_SIZE_LIMIT）相同，隧道 MTU 的计算结果一致
+    constexpr int IN_PROCESS_MTU_DATA_SIZE = 1200;
+
+} // anonymous namespace
+
+// ============================================================================
+// InProcessHub
+// ============================================================================
+
+size_t InProcessHub::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return endpoints_.size();
+}
+
+void InProcessHub::attach(InProcessTransport* endpoint) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    endpoints_[endpoint->getLocalId()] = endpoint;
+}
+
+void InProcessHub::detach(InProcessTransport* endpoint) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = endpoints_.find(endpoint->getLocalId());
+    if (it != endpoints_.end() && it->second == endpoint) {
+        endpoints_.erase(it);
+    }
+}
+
+InProcessTransport* InProcessHub::find(PeerId id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = endpoints_.find(id);
+    return it != endpoints_.end() ? it->second : nullptr;
+}
+
+bool InProcessHub::deliver(PeerId sender, PeerId target, const void* data, uint32_t size, int flags) {
+    // 持有 hub 锁直到入队完成，保证目标端点不会在投递期间析构
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = endpoints_.find(target);
+    if (it == endpoints_.end()) return false;
+    return it->second->enqueue(sender, data, size, (flags & TRANSPORT_SEND_RELIABLE) != 0);
+}
+
+int InProcessHub::deliverToAll(PeerId sender, const void* data, uint32_t size, int flags) {
+    bool reliable = (flags & TRANSPORT_SEND_RELIABLE) != 0;
+    int count = 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& pair : endpoints_) {
+        if (pair.first == sender) continue;
+        pair.second->enqueue(sender, data, size, reliable);
+        count++;
+    }
+    return count;
+}
+
+PeerId InProcessHub::resolve(uint32_t address) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& pair : endpoints_) {
+        if (pair.second->getLocalAddress() == address) {
+            return pair.first;
+        }
+    }
+    return INVALID_PEER_ID;
+}
+
+// ============================================================================
+// InProcessTransport
+// ============================================================================
+
+InProcessTransport::InProcessTransport(std::shared_ptr<InProcessHub> hub, PeerId localId,
+                                       uint32_t localAddress, size_t queueCapacityBytes)
+    : hub_(std::move(hub))
+    , localId_(localId)
+    , localAddress_(localAddress)
+    , queueCapacityBytes_(queueCapacityBytes)
+    , queuedBytes_(0)
+    , droppedMessages_(0)
+{
+    hub_->attach(this);
+}
+
+InProcessTransport::~InProcessTransport() {
+    hub_->detach(this);
+}
+
+bool InProcessTransport::sendToPeer(PeerId peer, const void* data, uint32_t size, int flags) {
+    return hub_->deliver(localId_, peer, data, size, flags);
+}
+
+int InProcessTransport::broadcast(const void* data, uint32_t size, int flags) {
+    return hub_->deliverToAll(localId_, data, size, flags);
+}
+
+bool InProcessTransport::enqueue(PeerId sender, const void* data, uint32_t size, bool reliable) {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    if (!reliable && queuedBytes_ + size > queueCapacityBytes_) {
+        droppedMessages_++;
+        return false;
+    }
+
+    auto message = std::make_unique<Message>();
+    message->data.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+    message->sender = sender;
+    message->enqueuedAtUs = transportTimestampUs();
+    queue_.push_back(std::move(message));
+    queuedBytes_ += size;
+    return true;
+}
+
+int InProcessTransport::receiveBatch(TransportMessage* messages, int maxMessages) {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    int count = 0;
+    while (count < maxMessages && !queue_.empty()) {
+        // 所有权转交给 TransportMessage，直到 release
+        Message* message = queue_.front().release();
+        queue_.pop_front();
+        queuedBytes_ -= message->data.size();
+
+        messages[count].data = message->data.data();
+        messages[count].size = static_cast<uint32_t>(message->data.size());
+        messages[count].sender = message->sender;
+        messages[count].handle = message;
+        messages[count].receivedAtUs = message->enqueuedAtUs;
+        count++;
+    }
+    return count;
+}
+
+void InProcessTransport::release(TransportMessage* messages, int count) {
+    for (int i = 0; i < count; ++i) {
+        delete static_cast<Message*>(messages[i].handle);
+        messages[i].handle = nullptr;
+    }
+}
+
+size_t InProcessTransport::queuedBytes() const {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    return queuedBytes_;
+}
+
+int InProcessTransport::getPendingSendBytes(PeerId peer) const {
+    std::lock_guard<std::mutex> lock(hub_->mutex_);
+    auto it = hub_->endpoints_.find(peer);
+    if (it == hub_->endpoints_.end()) return 0;
+    return static_cast<int>(it->second->queuedBytes());
+}
+
+int InProcessTransport::getPeerRtt(PeerId peer) const {
+    // 同一进程内没有网络时延
+    return hub_->find(peer) ? 0 : -1;
+}
+
+PeerId InProcessTransport::resolveAddress(uint32_t ip) const {
+    return hub_->resolve(ip);
+}
+
+int InProcessTransport::getMtuDataSize() const {
+    return IN_PROCESS_MTU_DATA_SIZE;
+}
+
+uint64_t InProcessTransport::getDroppedMessages() const {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    return droppedMessages_;
+}
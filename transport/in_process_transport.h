@@ -0,0 +1,109 @@
+#ifndef IN_PROCESS_TRANSPORT_H
+#define IN_PROCESS_TRANSPORT_H
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "transport_interface.h"
+
+class InProcessTransport;
+
+/**
+ * @brief 进程内传输层的交换中心
+ *
+ * 同一个 hub 上的所有端点互相可达，相当于一个房间。用于在单个进程中
+ * 连接多个 VPN 桥接实例（测试、基准测试），不需要 Steam 客户端。
+ */
+class InProcessHub {
+public:
+    InProcessHub() = default;
+
+    InProcessHub(const InProcessHub&) = delete;
+    InProcessHub& operator=(const InProcessHub&) = delete;
+
+    /**
+     * @brief 已注册的端点数量
+     */
+    size_t size() const;
+
+private:
+    friend class InProcessTransport;
+
+    void attach(InProcessTransport* endpoint);
+    void detach(InProcessTransport* endpoint);
+    InProcessTransport* find(PeerId id) const;
+
+    bool deliver(PeerId sender, PeerId target, const void* data, uint32_t size, int flags);
+    int deliverToAll(PeerId sender, const void* data, uint32_t size, int flags);
+    PeerId resolve(uint32_t address) const;
+
+    mutable std::mutex mutex_;
+    std::map<PeerId, InProcessTransport*> endpoints_;
+};
+
+/**
+ * @brief 进程内传输层端点
+ *
+ * 发送时将消息复制到目标端点的接收队列。接收队列超过容量时丢弃不可靠消息，
+ * 可靠消息始终入队。getPendingSendBytes 返回目标端点尚未取走的字节数，
+ * 使发送方的背压控制与 Steam 下行为一致。
+ */
+class InProcessTransport : public TransportInterface {
+public:
+    /**
+     * @param hub 交换中心，端点析构前保持有效
+     * @param localId 本机节点标识
+     * @param localAddress 本机 IPv4 地址（Host Byte Order），用作 FakeIP
+     * @param queueCapacityBytes 接收队列容量
+     */
+    InProcessTransport(std::shared_ptr<InProcessHub> hub, PeerId localId, uint32_t localAddress,
+                       size_t queueCapacityBytes = 4 * 1024 * 1024);
+    ~InProcessTransport() override;
+
+    InProcessTransport(const InProcessTransport&) = delete;
+    InProcessTransport& operator=(const InProcessTransport&) = delete;
+
+    bool sendToPeer(PeerId peer, const void* data, uint32_t size, int flags) override;
+    int broadcast(const void* data, uint32_t size, int flags) override;
+    int receiveBatch(TransportMessage* messages, int maxMessages) override;
+    void release(TransportMessage* messages, int count) override;
+    int getPendingSendBytes(PeerId peer) const override;
+    int getPeerRtt(PeerId peer) const override;
+    PeerId getLocalId() const override { return localId_; }
+    uint32_t getLocalAddress() const override { return localAddress_; }
+    PeerId resolveAddress(uint32_t ip) const override;
+    int getMtuDataSize() const override;
+
+    /**
+     * @brief 因接收队列已满而丢弃的消息数量
+     */
+    uint64_t getDroppedMessages() const;
+
+private:
+    friend class InProcessHub;
+
+    struct Message {
+        std::vector<uint8_t> data;
+        PeerId sender;
+        int64_t enqueuedAtUs;
+    };
+
+    // 由 hub 调用，将消息放入本端点的接收队列
+    bool enqueue(PeerId sender, const void* data, uint32_t size, bool reliable);
+    size_t queuedBytes() const;
+
+    std::shared_ptr<InProcessHub> hub_;
+    PeerId localId_;
+    uint32_t localAddress_;
+    size_t queueCapacityBytes_;
+
+    mutable std::mutex queueMutex_;
+    std::deque<std::unique_ptr<Message>> queue_;
+    size_t queuedBytes_;
+    uint64_t droppedMessages_;
+};
+
+#endif // IN_PROCESS_TRANSPORT_H
@@ -0,0 +1,177 @@
+#ifndef MESSAGE_HANDLE_H
+#define MESSAGE_HANDLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "transport_interface.h"
+
+/**
+ * @brief 在途消息预算
+ *
+ * 限制尚未归还给传输层的接收消息占用的字节数。传输层缓冲区（如 ISteamNetworkingMessage）
+ * 在归还前一直占用内存，下游处理变慢时由预算拒绝新消息，而不是无限堆积。
+ * 线程安全。
+ */
+class InFlightBudget {
+public:
+    explicit InFlightBudget(size_t maxBytes) : maxBytes_(maxBytes) {}
+
+    InFlightBudget(const InFlightBudget&) = delete;
+    InFlightBudget& operator=(const InFlightBudget&) = delete;
+
+    /**
+     * @brief 占用 bytes 字节
+     * @return false 表示超出上限，未占用
+     */
+    bool tryAcquire(size_t bytes) {
+        size_t current = bytes_.load(std::memory_order_relaxed);
+        do {
+            if (current + bytes > maxBytes_.load(std::memory_order_relaxed)) {
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        } while (!bytes_.compare_exchange_weak(current, current + bytes, std::memory_order_relaxed));
+
+        messages_.fetch_add(1, std::memory_order_relaxed);
+        size_t peak = peakBytes_.load(std::memory_order_relaxed);
+        while (current + bytes > peak &&
+               !peakBytes_.compare_exchange_weak(peak, current + bytes, std::memory_order_relaxed)) {
+        }
+        return true;
+    }
+
+    /**
+     * @brief 归还 tryAcquire 占用的字节
+     */
+    void release(size_t bytes) {
+        bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+        messages_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 修改上限，已占用的字节不受影响，超出新上限时拒绝新消息直到归还
+     */
+    void setMaxBytes(size_t maxBytes) { maxBytes_.store(maxBytes, std::memory_order_relaxed); }
+
+    size_t maxBytes() const { return maxBytes_.load(std::memory_order_relaxed); }
+    size_t bytes() const { return bytes_.load(std::memory_order_relaxed); }
+    size_t messages() const { return messages_.load(std::memory_order_relaxed); }
+    size_t peakBytes() const { return peakBytes_.load(std::memory_order_relaxed); }
+    uint64_t rejected() const { return rejected_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<size_t> maxBytes_;
+    std::atomic<size_t> bytes_{0};
+    std::atomic<size_t> messages_{0};
+    std::atomic<size_t> peakBytes_{0};
+    std::atomic<uint64_t> rejected_{0};
+};
+
+/**
+ * @brief 接收消息的所有权句柄（只能移动）
+ *
+ * 包装传输层拥有的缓冲区，析构或 reset 时调用释放回调归还消息，
+ * 并归还占用的在途预算。句柄可以跨线程传递，数据在归还之前保持有效，
+ * 因此接收管线可以一直引用传输层的缓冲区直到 TUN 写入完成，中间不需要复制。
+ */
+class MessageHandle {
+public:
+    using ReleaseFn = void (*)(void* context, TransportMessage& message);
+
+    MessageHandle() noexcept : message_{}, release_(nullptr), context_(nullptr), budget_(nullptr) {}
+
+    MessageHandle(const TransportMessage& message, ReleaseFn release, void* context) noexcept
+        : message_(message), release_(release), context_(context), budget_(nullptr) {}
+
+    /**
+     * @brief 通过 transport->release 归还的句柄
+     */
+    MessageHandle(TransportInterface* transport, const TransportMessage& message) noexcept
+        : MessageHandle(message, &releaseToTransport, transport) {}
+
+    MessageHandle(MessageHandle&& other) noexcept
+        : message_(other.message_), release_(other.release_), context_(other.context_), budget_(other.budget_) {
+        other.release_ = nullptr;
+        other.budget_ = nullptr;
+    }
+
+    MessageHandle& operator=(MessageHandle&& other) noexcept {
+        if (this != &other) {
+            reset();
+            message_ = other.message_;
+            release_ = other.release_;
+            context_ = other.context_;
+            budget_ = other.budget_;
+            other.release_ = nullptr;
+            other.budget_ = nullptr;
+        }
+        return *this;
+    }
+
+    MessageHandle(const MessageHandle&) = delete;
+    MessageHandle& operator=(const MessageHandle&) = delete;
+
+    ~MessageHandle() { reset(); }
+
+    /**
+     * @brief 是否持有消息
+     */
+    explicit operator bool() const { return release_ != nullptr; }
+
+    uint8_t* data() const { return message_.data; }
+    uint32_t size() const { return message_.size; }
+    PeerId sender() const { return message_.sender; }
+    int64_t receivedAtUs() const { return message_.receivedAtUs; }
+
+    /**
+     * @brief 将消息计入在途预算，句柄释放时自动归还
+     * @return false 表示超出预算（句柄仍持有消息，由调用方决定丢弃）
+     */
+    bool charge(InFlightBudget& budget) {
+        if (budget_) return true;
+        if (!budget.tryAcquire(message_.size)) return false;
+        budget_ = &budget;
+        return true;
+    }
+
+    /**
+     * @brief 立即归还消息
+     */
+    void reset() {
+        if (budget_) {
+            budget_->release(message_.size);
+            budget_ = nullptr;
+        }
+        if (release_) {
+            ReleaseFn release = release_;
+            release_ = nullptr;
+            release(context_, message_);
+        }
+    }
+
+    /**
+     * @brief 放弃所有权但不调用释放回调，由调用方负责归还（用于批量 release）
+     */
+    TransportMessage detach() {
+        if (budget_) {
+            budget_->release(message_.size);
+            budget_ = nullptr;
+        }
+        release_ = nullptr;
+        return message_;
+    }
+
+private:
+    static void releaseToTransport(void* context, TransportMessage& message) {
+        static_cast<TransportInterface*>(context)->release(&message, 1);
+    }
+
+    TransportMessage message_;
+    ReleaseFn release_;
+    void* context_;
+    InFlightBudget* budget_;
+};
+
+#endif // MESSAGE_HANDLE_H
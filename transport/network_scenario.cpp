@@ -0,0 +1,120 @@
+#include "network_scenario.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <simdjson.h>
+
+namespace {
+
+    bool parseDistribution(std::string_view name, LinkProfile::DelayDistribution& out) {
+        if (name == "constant") out = LinkProfile::DelayDistribution::Constant;
+        else if (name == "uniform") out = LinkProfile::DelayDistribution::Uniform;
+        else if (name == "normal") out = LinkProfile::DelayDistribution::Normal;
+        else if (name == "pareto") out = LinkProfile::DelayDistribution::Pareto;
+        else return false;
+        return true;
+    }
+
+    // 只覆盖出现的字段
+    void parseLink(simdjson::ondemand::object object, LinkProfile& link) {
+        auto readDouble = [&object](const char* key, double& value) {
+            auto field = object[key].get_double();
+            if (!field.error()) value = field.value();
+        };
+        auto readKilobytes = [&object](const char* key, int64_t& value) {
+            auto field = object[key].get_double();
+            if (!field.error()) value = static_cast<int64_t>(field.value() * 1024);
+        };
+
+        readDouble("delay_ms", link.delayMs);
+        readDouble("jitter_ms", link.jitterMs);
+
+        auto distribution = object["distribution"].get_string();
+        if (!distribution.error() && !parseDistribution(distribution.value(), link.distribution)) {
+            throw std::runtime_error("unknown delay distribution: " + std::string(distribution.value()));
+        }
+
+        // "loss" 是无记忆丢包的简写
+        auto loss = object["loss"].get_double();
+        if (!loss.error()) {
+            link.lossGoodToBad = 0.0;
+            link.lossInGood = loss.value();
+        }
+        readDouble("loss_p", link.lossGoodToBad);
+        readDouble("loss_r", link.lossBadToGood);
+        readDouble("loss_good", link.lossInGood);
+        readDouble("loss_bad", link.lossInBad);
+
+        readDouble("reorder_rate", link.reorderRate);
+        readDouble("reorder_delay_ms", link.reorderDelayMs);
+        readDouble("duplicate_rate", link.duplicateRate);
+
+        auto rate = object["rate_mb"].get_double();
+        if (!rate.error()) link.rateBytesPerSec = static_cast<int64_t>(rate.value() * 1024 * 1024);
+        readKilobytes("burst_kb", link.burstBytes);
+        readKilobytes("queue_limit_kb", link.queueLimitBytes);
+    }
+
+} // anonymous namespace
+
+const LinkProfile& NetworkScenario::linkFor(uint64_t peerSteamId) const {
+    auto it = peerLinks.find(peerSteamId);
+    return it != peerLinks.end() ? it->second : defaultLink;
+}
+
+bool NetworkScenario::loadFromFile(const std::string& path, std::vector<NetworkScenario>& scenarios,
+                                   std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "Cannot open scenario file: " + path;
+        return false;
+    }
+    std::ostringstream content;
+    content << file.rdbuf();
+    return parse(content.str(), scenarios, error);
+}
+
+bool NetworkScenario::parse(const std::string& json, std::vector<NetworkScenario>& scenarios,
+                            std::string& error) {
+    try {
+        simdjson::ondemand::parser parser;
+        simdjson::padded_string padded(json);
+        simdjson::ondemand::document doc = parser.iterate(padded);
+
+        std::vector<NetworkScenario> result;
+        for (auto element : doc["scenarios"].get_array()) {
+            simdjson::ondemand::object object = element.get_object();
+            NetworkScenario scenario;
+
+            auto name = object["name"].get_string();
+            if (!name.error()) scenario.name = std::string(name.value());
+
+            auto seed = object["seed"].get_uint64();
+            if (!seed.error()) scenario.seed = seed.value();
+
+            auto link = object["link"].get_object();
+            if (!link.error()) parseLink(link.value(), scenario.defaultLink);
+
+            auto peers = object["peers"].get_object();
+            if (!peers.error()) {
+                for (auto field : peers.value()) {
+                    std::string_view key = field.unescaped_key();
+                    LinkProfile peerLink = scenario.defaultLink;
+                    parseLink(field.value().get_object(), peerLink);
+                    scenario.peerLinks[std::stoull(std::string(key))] = peerLink;
+                }
+            }
+
+            result.push_back(std::move(scenario));
+        }
+
+        scenarios = std::move(result);
+        return true;
+    } catch (const simdjson::simdjson_error& e) {
+        error = std::string("Scenario parse error: ") + e.what();
+        return false;
+    } catch (const std::exception& e) {
+        error = std::string("Scenario parse error: ") + e.what();
+        return false;
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef NETWORK_SCENARIO_H
+#define NETWORK_SCENARIO_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 单条链路（本机 -> 某个节点）的网络损伤参数
+ */
+struct LinkProfile {
+    // 时延分布
+    enum class DelayDistribution {
+        Constant,   // 固定为 delayMs
+        Uniform,    // delayMs ± jitterMs 均匀分布
+        Normal,     // 均值 delayMs，标准差 jitterMs
+        Pareto      // delayMs + 长尾抖动（形状参数 2.5，尺度 jitterMs）
+    };
+
+    double delayMs = 0.0;           // 单向基础时延
+    double jitterMs = 0.0;          // 抖动
+    DelayDistribution distribution = DelayDistribution::Constant;
+
+    // Gilbert-Elliott 丢包模型
+    double lossGoodToBad = 0.0;     // 好状态 -> 坏状态的转移概率 (p)
+    double lossBadToGood = 1.0;     // 坏状态 -> 好状态的转移概率 (r)
+    double lossInGood = 0.0;        // 好状态下的丢包率
+    double lossInBad = 1.0;         // 坏状态下的丢包率
+
+    double reorderRate = 0.0;       // 额外延迟（从而被后续包超越）的概率
+    double reorderDelayMs = 0.0;    // 被乱序的包额外增加的时延
+    double duplicateRate = 0.0;     // 重复发送的概率
+
+    // 令牌桶限速，模拟 k_ESteamNetworkingConfig_SendRateMax
+    int64_t rateBytesPerSec = 0;    // 0 表示不限速
+    int64_t burstBytes = 16 * 1024; // 桶容量
+    int64_t queueLimitBytes = 0;    // 排队字节上限，超出时丢弃不可靠消息；0 表示不限
+};
+
+/**
+ * @brief 网络仿真场景
+ */
+struct NetworkScenario {
+    std::string name;
+    uint64_t seed = 1;                          // 随机数种子，保证可重复
+    LinkProfile defaultLink;                    // 未单独配置的链路
+    std::map<uint64_t, LinkProfile> peerLinks;  // 按目标 SteamID 配置的链路
+
+    /**
+     * @brief 获取发往指定节点的链路参数
+     */
+    const LinkProfile& linkFor(uint64_t peerSteamId) const;
+
+    /**
+     * @brief 从 JSON 场景文件加载所有场景
+     * @param path 文件路径
+     * @param scenarios 输出
+     * @param error 失败时的错误信息
+     * @return true 成功，false 失败
+     *
+     * 文件格式：
+     * {
+     *   "scenarios": [{
+     *     "name": "lossy-wifi", "seed": 7,
+     *     "link": { "delay_ms": 30, "jitter_ms": 5, "distribution": "normal",
+     *               "loss_p": 0.01, "loss_r": 0.3, "loss_good": 0, "loss_bad": 0.5,
+     *               "reorder_rate": 0.01, "reorder_delay_ms": 10, "duplicate_rate": 0.001,
+     *               "rate_mb": 10, "burst_kb": 64, "queue_limit_kb": 4096 },
+     *     "peers": { "76561198000000000": { ...同 link... } }
+     *   }]
+     * }
+     * peers 中的链路以 link 为基础，只覆盖出现的字段。
+     */
+    static bool loadFromFile(const std::string& path, std::vector<NetworkScenario>& scenarios,
+                             std::string& error);
+
+    /**
+     * @brief 从 JSON 字符串解析所有场景，格式同 loadFromFile
+     */
+    static bool parse(const std::string& json, std::vector<NetworkScenario>& scenarios,
+                      std::string& error);
+};
+
+#endif // NETWORK_SCENARIO_H
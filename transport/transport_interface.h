@@ -0,0 +1,118 @@
+#ifndef TRANSPORT_INTERFACE_H
+#define TRANSPORT_INTERFACE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 节点标识（Steam ID 的 64 位值），0 表示无效
+ *
+ * 传输层不依赖 Steam SDK，Steam 相关代码以 CSteamID(peer) / ConvertToUint64() 转换。
+ */
+using PeerId = uint64_t;
+constexpr PeerId INVALID_PEER_ID = 0;
+
+// 发送标志，取值与 k_nSteamNetworkingSend_* 相同，Steam 传输层原样传给 Steam
+constexpr int TRANSPORT_SEND_UNRELIABLE = 0;
+constexpr int TRANSPORT_SEND_NO_NAGLE = 1;
+constexpr int TRANSPORT_SEND_NO_DELAY = 4;
+constexpr int TRANSPORT_SEND_RELIABLE = 8;
+
+/**
+ * @brief 传输层时间戳（steady_clock 微秒），用于 TransportMessage::receivedAtUs
+ */
+inline int64_t transportTimestampUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief 传输层收到的一条消息
+ *
+ * data 在调用 TransportInterface::release 之前保持有效。
+ */
+struct TransportMessage {
+    uint8_t* data;      // 消息内容（可原地修改）
+    uint32_t size;      // 消息长度
+    PeerId sender;      // 发送方
+    void* handle;       // 传输层内部句柄，由 release 使用
+    int64_t receivedAtUs; // 到达传输层的时间（transportTimestampUs），0 表示未知
+};
+
+/**
+ * @brief 传输层接口
+ *
+ * VPN 桥接和消息处理器通过此接口收发消息，不直接依赖 Steam 网络接口。
+ * 节点以 PeerId 标识；flags 使用 TRANSPORT_SEND_* 标志位。
+ */
+class TransportInterface {
+public:
+    virtual ~TransportInterface() = default;
+
+    /**
+     * @brief 发送消息给指定节点
+     * @return true 已提交发送，false 失败
+     */
+    virtual bool sendToPeer(PeerId peer, const void* data, uint32_t size, int flags) = 0;
+
+    /**
+     * @brief 广播消息给所有节点（不包括本机）
+     * @return 发送的节点数量
+     */
+    virtual int broadcast(const void* data, uint32_t size, int flags) = 0;
+
+    /**
+     * @brief 批量接收消息
+     * @param messages 输出缓冲区
+     * @param maxMessages 最多接收的消息数量
+     * @return 接收的消息数量
+     * @note 接收到的消息必须通过 release 归还
+     */
+    virtual int receiveBatch(TransportMessage* messages, int maxMessages) = 0;
+
+    /**
+     * @brief 归还 receiveBatch 返回的消息
+     */
+    virtual void release(TransportMessage* messages, int count) = 0;
+
+    /**
+     * @brief 立即发出已排队的消息
+     *
+     * 批量发送的传输层会暂存 sendToPeer 提交的消息，调用方在一批消息提交完后调用。
+     * 可靠消息不需要 flush。默认实现不做任何事。
+     */
+    virtual void flush() {}
+
+    /**
+     * @brief 获取发往指定节点、尚未发出的字节数（用于背压控制）
+     */
+    virtual int getPendingSendBytes(PeerId peer) const = 0;
+
+    /**
+     * @brief 获取到指定节点的往返时延（毫秒），未知返回 -1
+     */
+    virtual int getPeerRtt(PeerId peer) const = 0;
+
+    /**
+     * @brief 获取本机节点标识
+     */
+    virtual PeerId getLocalId() const = 0;
+
+    /**
+     * @brief 获取传输层分配的本机 IPv4 地址（Host Byte Order），未分配返回 0
+     */
+    virtual uint32_t getLocalAddress() const = 0;
+
+    /**
+     * @brief 将 IPv4 地址解析为节点标识，失败返回 INVALID_PEER_ID
+     */
+    virtual PeerId resolveAddress(uint32_t ip) const = 0;
+
+    /**
+     * @brief 获取单条不可靠消息的最大数据长度
+     */
+    virtual int getMtuDataSize() const = 0;
+};
+
+#endif // TRANSPORT_INTERFACE_H
@@ -42,6 +42,24 @@ public:
      */
     virtual int read(uint8_t* buffer, size_t size) = 0;
 
+    /**
+     * @brief 批量读取数据包
+     * @param buffers 每个数据包的缓冲区
+     * @param size 每个缓冲区的大小
+     * @param lengths 输出：每个数据包的长度
+     * @param maxPackets 最多读取的数据包数量
+     * @return 读取的数据包数量，失败返回 -1
+     * @note 第一个包的等待语义与 read 相同，之后只取走已就绪的包，不再等待。
+     *       默认实现每次只读取一个包。
+     */
+    virtual int read_batch(uint8_t* const* buffers, size_t size, size_t* lengths, int maxPackets) {
+        if (maxPackets <= 0) return 0;
+        int bytesRead = read(buffers[0], size);
+        if (bytesRead <= 0) return bytesRead;
+        lengths[0] = static_cast<size_t>(bytesRead);
+        return 1;
+    }
+
     /**
      * @brief 写入数据包
      * @param buffer 数据缓冲区
@@ -50,6 +68,22 @@ public:
      */
     virtual int write(const uint8_t* buffer, size_t size) = 0;
 
+    /**
+     * @brief 批量写入数据包
+     * @param buffers 每个数据包的数据
+     * @param sizes 每个数据包的长度
+     * @param count 数据包数量
+     * @return 成功写入的数据包数量
+     * @note 默认实现逐个调用 write
+     */
+    virtual int write_batch(const uint8_t* const* buffers, const size_t* sizes, int count) {
+        int written = 0;
+        for (int i = 0; i < count; ++i) {
+            if (write(buffers[i], sizes[i]) > 0) written++;
+        }
+        return written;
+    }
+
     /**
      * @brief 获取设备名称
      */
@@ -63,6 +97,15 @@ public:
      */
     virtual bool set_ip(const std::string& ip, const std::string& netmask) = 0;
 
+    /**
+     * @brief 设置设备 IPv6 地址
+     * @param ip IPv6 地址字符串（如 "fd12:3456:789a::1"）
+     * @param prefixLength 前缀长度（如 64）
+     * @return true 成功，false 失败（平台不支持时返回 false）
+     * @note IPv6 要求链路 MTU 至少为 1280，实现应同时设置 IPv6 子接口 MTU
+     */
+    virtual bool set_ipv6(const std::string& ip, int prefixLength) { return false; }
+
     /**
      * @brief 设置 MTU
      * @param mtu 最大传输单元
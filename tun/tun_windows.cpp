@@ -114,10 +114,12 @@ public:
     bool is_open() const override;
 
     int read(uint8_t* buffer, size_t size) override;
+    int read_batch(uint8_t* const* buffers, size_t size, size_t* lengths, int maxPackets) override;
     int write(const uint8_t* buffer, size_t size) override;
 
     std::string get_device_name() const override;
     bool set_ip(const std::string& ip, const std::string& netmask) override;
+    bool set_ipv6(const std::string& ip, int prefixLength) override;
     bool set_mtu(int mtu) override;
     bool set_up(bool up) override;
     bool set_non_blocking(bool nonBlocking) override;
@@ -343,6 +345,31 @@ int TunWindows::read(uint8_t* buffer, size_t size) {
     return static_cast<int>(copySize);
 }
 
+int TunWindows::read_batch(uint8_t* const* buffers, size_t size, size_t* lengths, int maxPackets) {
+    if (maxPackets <= 0) return 0;
+
+    // 第一个包沿用 read() 的等待语义
+    int bytesRead = read(buffers[0], size);
+    if (bytesRead <= 0) return bytesRead;
+    lengths[0] = static_cast<size_t>(bytesRead);
+
+    // 之后只取走环形缓冲区中已就绪的包
+    int count = 1;
+    while (count < maxPackets) {
+        DWORD packetSize;
+        BYTE* packet = WintunReceivePacket(session_, &packetSize);
+        if (!packet) break;
+
+        DWORD copySize = (packetSize < size) ? packetSize : static_cast<DWORD>(size);
+        memcpy(buffers[count], packet, copySize);
+        WintunReleaseReceivePacket(session_, packet);
+
+        lengths[count] = copySize;
+        count++;
+    }
+    return count;
+}
+
 int TunWindows::write(const uint8_t* buffer, size_t size) {
     if (!session_) {
         return -1;
@@ -419,6 +446,50 @@ bool TunWindows::set_ip(const std::string& ip, const std::string& netmask) {
     return true;
 }
 
+bool TunWindows::set_ipv6(const std::string& ip, int prefixLength) {
+    if (!adapter_) {
+        setError("Adapter not open");
+        return false;
+    }
+
+    struct in6_addr addr;
+    if (inet_pton(AF_INET6, ip.c_str(), &addr) != 1) {
+        setError("Invalid IPv6 address: " + ip);
+        return false;
+    }
+
+    MIB_UNICASTIPADDRESS_ROW addressRow;
+    InitializeUnicastIpAddressEntry(&addressRow);
+
+    addressRow.InterfaceLuid = adapterLuid_;
+    addressRow.Address.Ipv6.sin6_family = AF_INET6;
+    addressRow.Address.Ipv6.sin6_addr = addr;
+    addressRow.OnLinkPrefixLength = static_cast<UINT8>(prefixLength);
+    addressRow.DadState = IpDadStatePreferred;
+
+    DeleteUnicastIpAddressEntry(&addressRow);
+
+    DWORD result = CreateUnicastIpAddressEntry(&addressRow);
+    if (result != NO_ERROR && result != ERROR_OBJECT_ALREADY_EXISTS) {
+        std::ostringstream oss;
+        oss << "Failed to set IPv6 address (Error " << result << ")";
+        setError(oss.str());
+        return false;
+    }
+
+    // IPv6 子接口 MTU 不能低于 1280，否则 Windows 会禁用该接口上的 IPv6
+    int mtu6 = mtu_ < 1280 ? 1280 : mtu_;
+    std::ostringstream cmd;
+    cmd << "netsh interface ipv6 set subinterface \"" << deviceName_
+        << "\" mtu=" << mtu6 << " store=persistent";
+    if (system(cmd.str().c_str()) != 0) {
+        std::cerr << "Warning: failed to set IPv6 MTU via netsh" << std::endl;
+    }
+
+    std::cout << "Set IPv6 address: " << ip << "/" << prefixLength << " (MTU " << mtu6 << ")" << std::endl;
+    return true;
+}
+
 bool TunWindows::set_mtu(int mtu) {
     if (!adapter_) {
         setError("Adapter not open");
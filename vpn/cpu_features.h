@@ -0,0 +1,56 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+/**
+ * @brief Runtime CPU feature detection for the SIMD data-path kernels
+ *
+ * Kernels are compiled for the baseline target and select their AVX2 variant
+ * at runtime. VPN_SIMD_X86 is only defined on x86-64, where SSE2 is always
+ * available.
+ */
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define VPN_SIMD_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC accepts AVX2 intrinsics without /arch:AVX2, GCC/Clang need a per-function target
+#if defined(VPN_SIMD_X86) && !defined(_MSC_VER)
+#define VPN_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define VPN_TARGET_AVX2
+#endif
+
+namespace CpuFeatures {
+
+#ifdef VPN_SIMD_X86
+    inline bool supportsAvx2() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx) return false;
+        // OS must save YMM state
+        if ((_xgetbv(0) & 0x6) != 0x6) return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#else
+    inline bool supportsAvx2() {
+        return false;
+    }
+#endif
+
+} // namespace CpuFeatures
+
+#endif // CPU_FEATURES_H
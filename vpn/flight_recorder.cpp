@@ -0,0 +1,196 @@
+#include "flight_recorder.h"
+
+namespace {
+
+    // pcapng block types and options (draft-ietf-opsawg-pcapng)
+    constexpr uint32_t PCAPNG_SECTION_HEADER = 0x0A0D0D0A;
+    constexpr uint32_t PCAPNG_INTERFACE_DESCRIPTION = 0x00000001;
+    constexpr uint32_t PCAPNG_ENHANCED_PACKET = 0x00000006;
+    constexpr uint32_t PCAPNG_BYTE_ORDER_MAGIC = 0x1A2B3C4D;
+    constexpr uint16_t PCAPNG_OPT_END = 0;
+    constexpr uint16_t PCAPNG_OPT_COMMENT = 1;
+    constexpr uint16_t PCAPNG_SHB_USERAPPL = 4;
+    constexpr uint16_t PCAPNG_IF_NAME = 2;
+    constexpr uint16_t PCAPNG_EPB_FLAGS = 2;
+    constexpr uint32_t PCAPNG_EPB_INBOUND = 1;
+    constexpr uint32_t PCAPNG_EPB_OUTBOUND = 2;
+    constexpr uint16_t LINKTYPE_RAW = 101;     // Bare IPv4/IPv6 packets
+
+    // Blocks are written in host byte order, readers detect it from the byte-order magic
+    template <typename T>
+    void append(std::string& out, T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void pad(std::string& out) {
+        out.append((4 - out.size() % 4) % 4, '\0');
+    }
+
+    void appendOption(std::string& out, uint16_t code, const void* data, size_t length) {
+        append(out, code);
+        append(out, static_cast<uint16_t>(length));
+        out.append(static_cast<const char*>(data), length);
+        pad(out);
+    }
+
+    void appendOption(std::string& out, uint16_t code, const std::string& value) {
+        appendOption(out, code, value.data(), value.size());
+    }
+
+    // Starts a block, finishBlock fills in the length once the body is written
+    size_t beginBlock(std::string& out, uint32_t type) {
+        size_t start = out.size();
+        append(out, type);
+        append(out, uint32_t{0});
+        return start;
+    }
+
+    void finishBlock(std::string& out, size_t start) {
+        append(out, uint32_t{0});
+        uint32_t length = static_cast<uint32_t>(out.size() - start);
+        memcpy(&out[start + 4], &length, sizeof(length));
+        memcpy(&out[out.size() - 4], &length, sizeof(length));
+    }
+
+    bool isInbound(FlightPoint point) {
+        return point == FlightPoint::SteamReceive || point == FlightPoint::TunWrite;
+    }
+
+} // anonymous namespace
+
+constexpr size_t FlightRecorder::kCapacity;
+constexpr size_t FlightRecorder::kHeaderBytes;
+
+const char* flightPointName(FlightPoint point) {
+    switch (point) {
+        case FlightPoint::TunRead: return "tun_read";
+        case FlightPoint::SteamSend: return "steam_send";
+        case FlightPoint::SteamReceive: return "steam_receive";
+        case FlightPoint::TunWrite: return "tun_write";
+        case FlightPoint::Count: break;
+    }
+    return "unknown";
+}
+
+const char* flightDropName(FlightDrop drop) {
+    switch (drop) {
+        case FlightDrop::None: return "none";
+        case FlightDrop::NoRoute: return "no_route";
+        case FlightDrop::Oversize: return "oversize";
+        case FlightDrop::Backpressure: return "backpressure";
+        case FlightDrop::SendFailed: return "send_failed";
+        case FlightDrop::RxQueueFull: return "rx_queue_full";
+        case FlightDrop::RxInFlightLimit: return "rx_inflight_limit";
+        case FlightDrop::Count: break;
+    }
+    return "unknown";
+}
+
+FlightRecorder::FlightRecorder() {
+    for (auto& ring : rings_) {
+        ring.slots.reset(new Slot[kCapacity]);
+    }
+}
+
+std::vector<FlightRecorder::Record> FlightRecorder::snapshot() const {
+    std::vector<Record> records;
+    records.reserve(kCapacity * kPointCount);
+
+    for (size_t point = 0; point < kPointCount; ++point) {
+        const Ring& ring = rings_[point];
+        uint64_t end = ring.head.load(std::memory_order_acquire);
+        uint64_t begin = end > kCapacity ? end - kCapacity : 0;
+        for (uint64_t index = begin; index < end; ++index) {
+            const Slot& slot = ring.slots[index & (kCapacity - 1)];
+            uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence != 2 * index + 2) continue;   // Being written, or already overwritten
+
+            Record record;
+            record.timestampUs = slot.timestampUs.load(std::memory_order_relaxed);
+            record.peer = slot.peer.load(std::memory_order_relaxed);
+            uint64_t info = slot.info.load(std::memory_order_relaxed);
+            uint64_t words[kHeaderWords];
+            for (size_t i = 0; i < kHeaderWords; ++i) {
+                words[i] = slot.header[i].load(std::memory_order_relaxed);
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) != sequence) continue;
+
+            record.length = static_cast<uint32_t>(info);
+            record.point = static_cast<FlightPoint>(point);
+            record.drop = static_cast<FlightDrop>((info & kDropMask) >> kDropShift);
+            record.captured = static_cast<uint8_t>(info >> kCapturedShift);
+            memcpy(record.header, words, sizeof(record.header));
+            records.push_back(record);
+        }
+    }
+
+    std::stable_sort(records.begin(), records.end(), [](const Record& a, const Record& b) {
+        return a.timestampUs < b.timestampUs;
+    });
+    return records;
+}
+
+std::string FlightRecorder::dumpPcapng(size_t* recordCount) const {
+    std::vector<Record> records = snapshot();
+    if (recordCount) *recordCount = records.size();
+
+    std::string out;
+    out.reserve(256 + records.size() * (48 + kHeaderBytes + 48));
+
+    size_t block = beginBlock(out, PCAPNG_SECTION_HEADER);
+    append(out, PCAPNG_BYTE_ORDER_MAGIC);
+    append(out, uint16_t{1});      // Major version
+    append(out, uint16_t{0});      // Minor version
+    append(out, int64_t{-1});      // Section length unknown
+    appendOption(out, PCAPNG_SHB_USERAPPL, std::string("ConnectTool flight recorder"));
+    append(out, PCAPNG_OPT_END);
+    append(out, uint16_t{0});
+    finishBlock(out, block);
+
+    // Interface ids follow FlightPoint, timestamps use the default microsecond resolution
+    for (size_t point = 0; point < kPointCount; ++point) {
+        block = beginBlock(out, PCAPNG_INTERFACE_DESCRIPTION);
+        append(out, LINKTYPE_RAW);
+        append(out, uint16_t{0});
+        append(out, static_cast<uint32_t>(kHeaderBytes));
+        appendOption(out, PCAPNG_IF_NAME, std::string(flightPointName(static_cast<FlightPoint>(point))));
+        append(out, PCAPNG_OPT_END);
+        append(out, uint16_t{0});
+        finishBlock(out, block);
+    }
+
+    std::string comment;
+    for (const Record& record : records) {
+        uint64_t timestamp = static_cast<uint64_t>(record.timestampUs);
+        block = beginBlock(out, PCAPNG_ENHANCED_PACKET);
+        append(out, static_cast<uint32_t>(record.point));
+        append(out, static_cast<uint32_t>(timestamp >> 32));
+        append(out, static_cast<uint32_t>(timestamp));
+        append(out, static_cast<uint32_t>(record.captured));
+        append(out, record.length);
+        out.append(reinterpret_cast<const char*>(record.header), record.captured);
+        pad(out);
+
+        uint32_t flags = isInbound(record.point) ? PCAPNG_EPB_INBOUND : PCAPNG_EPB_OUTBOUND;
+        appendOption(out, PCAPNG_EPB_FLAGS, &flags, sizeof(flags));
+
+        comment.clear();
+        if (record.peer != 0) {
+            comment += "peer ";
+            comment += std::to_string(record.peer);
+        }
+        if (record.drop != FlightDrop::None) {
+            comment += comment.empty() ? "dropped: " : ", dropped: ";
+            comment += flightDropName(record.drop);
+        }
+        if (!comment.empty()) {
+            appendOption(out, PCAPNG_OPT_COMMENT, comment);
+        }
+        append(out, PCAPNG_OPT_END);
+        append(out, uint16_t{0});
+        finishBlock(out, block);
+    }
+    return out;
+}
@@ -0,0 +1,166 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "trace_clock.h"
+
+/**
+ * @brief Where on the data path a packet was recorded
+ */
+enum class FlightPoint : uint8_t {
+    TunRead = 0,    // Read from the TUN device (TUN read thread)
+    SteamSend,      // Handed to the transport, or the reason it was not (TUN read thread)
+    SteamReceive,   // Received from the transport, and whether it was queued (receive poll thread)
+    TunWrite,       // Written to the TUN device (TUN write thread)
+    Count
+};
+
+/**
+ * @brief Why a recorded packet went no further
+ */
+enum class FlightDrop : uint8_t {
+    None = 0,
+    NoRoute,        // No peer for the destination address
+    Oversize,       // Larger than the tunnel MTU with DF set
+    Backpressure,   // Send queue stayed above the limit
+    SendFailed,     // Transport rejected the message
+    RxQueueFull,    // TUN write queue full
+    RxInFlightLimit,// In-flight receive budget exhausted
+    Count
+};
+
+const char* flightPointName(FlightPoint point);
+const char* flightDropName(FlightDrop drop);
+
+/**
+ * @brief Always-on ring of recent packet headers, dumped as pcapng on demand
+ *
+ * Every packet that passes a FlightPoint leaves a record with a timestamp,
+ * the peer, the drop reason and the first kHeaderBytes bytes of the IP packet
+ * (enough for IPv4/IPv6 plus a TCP or UDP header). Each point has its own
+ * ring of kCapacity records written by exactly one thread, so recording is a
+ * handful of relaxed stores: no read-modify-write, no lock, no allocation.
+ * Each slot is published through a sequence number (seqlock); readers copy
+ * the rings on the control path and skip slots that are being rewritten.
+ *
+ * Timestamps come from TraceClock; callers usually take one per batch.
+ */
+class FlightRecorder {
+public:
+    static constexpr size_t kCapacity = 4096;   // Records per point, power of two
+    static constexpr size_t kHeaderBytes = 64;
+    static constexpr size_t kPointCount = static_cast<size_t>(FlightPoint::Count);
+
+    struct Record {
+        int64_t timestampUs;    // TraceClock
+        uint64_t peer;          // 0 when unknown (TunRead) or broadcast
+        uint32_t length;        // Original packet length
+        FlightPoint point;
+        FlightDrop drop;
+        uint8_t captured;       // Header bytes kept
+        uint8_t header[kHeaderBytes];
+    };
+
+    FlightRecorder();
+
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    /**
+     * @brief Record one packet (data path, only the point's own thread)
+     */
+    void record(FlightPoint point, int64_t timestampUs, uint64_t peer, const uint8_t* packet, size_t length,
+                FlightDrop drop = FlightDrop::None) {
+        Ring& ring = rings_[static_cast<size_t>(point)];
+        uint64_t index = ring.head.load(std::memory_order_relaxed);
+        Slot& slot = ring.slots[index & (kCapacity - 1)];
+
+        size_t captured = std::min(length, kHeaderBytes);
+        uint64_t words[kHeaderWords] = {};
+        memcpy(words, packet, captured);
+
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.timestampUs.store(timestampUs, std::memory_order_relaxed);
+        slot.peer.store(peer, std::memory_order_relaxed);
+        slot.info.store(packInfo(static_cast<uint32_t>(length), drop, captured), std::memory_order_relaxed);
+        for (size_t i = 0; i < kHeaderWords; ++i) {
+            slot.header[i].store(words[i], std::memory_order_relaxed);
+        }
+        slot.sequence.store(2 * index + 2, std::memory_order_release);
+        ring.head.store(index + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Set the drop reason of the point's latest record (only the point's own thread)
+     *
+     * For outcomes that are only known after the packet has been handed on.
+     */
+    void markLastDropped(FlightPoint point, FlightDrop drop) {
+        Ring& ring = rings_[static_cast<size_t>(point)];
+        uint64_t head = ring.head.load(std::memory_order_relaxed);
+        if (head == 0) return;
+        uint64_t index = head - 1;
+        Slot& slot = ring.slots[index & (kCapacity - 1)];
+
+        uint64_t info = slot.info.load(std::memory_order_relaxed);
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.info.store((info & ~kDropMask) | (static_cast<uint64_t>(drop) << kDropShift), std::memory_order_relaxed);
+        slot.sequence.store(2 * index + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copy of all rings, ordered by time
+     */
+    std::vector<Record> snapshot() const;
+
+    /**
+     * @brief Render the rings as a pcapng file
+     *
+     * One raw-IP interface per FlightPoint (named after it), one enhanced
+     * packet block per record with its direction in epb_flags and the peer and
+     * drop reason in a comment.
+     *
+     * @param recordCount receives the number of packets written
+     */
+    std::string dumpPcapng(size_t* recordCount = nullptr) const;
+
+private:
+    static constexpr size_t kHeaderWords = kHeaderBytes / sizeof(uint64_t);
+    static constexpr int kDropShift = 32;
+    static constexpr int kCapturedShift = 40;
+    static constexpr uint64_t kDropMask = 0xFFull << kDropShift;
+
+    static uint64_t packInfo(uint32_t length, FlightDrop drop, size_t captured) {
+        return length | (static_cast<uint64_t>(drop) << kDropShift) |
+               (static_cast<uint64_t>(captured) << kCapturedShift);
+    }
+
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};  // 2 * index + 1 while written, 2 * index + 2 once complete
+        std::atomic<int64_t> timestampUs{0};
+        std::atomic<uint64_t> peer{0};
+        std::atomic<uint64_t> info{0};      // length | drop << 32 | captured << 40
+        std::array<std::atomic<uint64_t>, kHeaderWords> header{};
+    };
+
+    // Each ring is written by one thread, keep their heads on separate cache lines
+    struct alignas(64) Ring {
+        std::unique_ptr<Slot[]> slots;
+        std::atomic<uint64_t> head{0};
+    };
+
+    std::array<Ring, kPointCount> rings_;
+};
+
+#endif // FLIGHT_RECORDER_H
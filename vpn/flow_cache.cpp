@@ -0,0 +1,94 @@
+#include "flow_cache.h"
+#include <cstring>
+
+namespace {
+
+    uint64_t readU64(const uint8_t* p) {
+        uint64_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+} // anonymous namespace
+
+bool FlowKey::operator==(const FlowKey& other) const {
+    return srcPort == other.srcPort && dstPort == other.dstPort &&
+           protocol == other.protocol && version == other.version &&
+           dstIP == other.dstIP && srcIP == other.srcIP;
+}
+
+FlowCache::FlowCache(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    slots_.resize(size);
+    mask_ = size - 1;
+    clear();
+}
+
+bool FlowCache::buildKey(const PacketMeta& meta, const uint8_t* packet, FlowKey& key) {
+    memset(&key, 0, sizeof(key));
+    key.version = meta.version;
+    key.protocol = meta.protocol;
+    key.srcPort = meta.srcPort;
+    key.dstPort = meta.dstPort;
+
+    if (meta.version == 4) {
+        key.srcIP[10] = key.srcIP[11] = 0xFF;
+        key.dstIP[10] = key.dstIP[11] = 0xFF;
+        for (int i = 0; i < 4; ++i) {
+            key.srcIP[12 + i] = static_cast<uint8_t>(meta.srcIP >> (24 - i * 8));
+            key.dstIP[12 + i] = static_cast<uint8_t>(meta.dstIP >> (24 - i * 8));
+        }
+        return true;
+    }
+    if (meta.version == 6) {
+        memcpy(key.srcIP.data(), packet + 8, IPV6_ADDR_SIZE);
+        memcpy(key.dstIP.data(), packet + 24, IPV6_ADDR_SIZE);
+        return true;
+    }
+    return false;
+}
+
+uint64_t FlowCache::hashKey(const FlowKey& key) {
+    uint64_t h = mix(readU64(key.dstIP.data() + 8) ^ readU64(key.dstIP.data()));
+    h = mix(h ^ readU64(key.srcIP.data() + 8) ^ readU64(key.srcIP.data()));
+    h = mix(h ^ (static_cast<uint64_t>(key.srcPort) << 32) ^ (static_cast<uint64_t>(key.dstPort) << 16) ^
+            (static_cast<uint64_t>(key.protocol) << 8) ^ key.version);
+    return h;
+}
+
+FlowCache::Entry* FlowCache::lookup(const FlowKey& key, uint32_t generation) {
+    Entry& slot = slots_[hashKey(key) & mask_];
+    if (slot.valid && slot.generation == generation && slot.key == key) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return &slot;
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+FlowCache::Entry* FlowCache::insert(const FlowKey& key, uint32_t generation, uint64_t peerSteamId,
+                                    uint8_t trafficClass, uint8_t flags) {
+    Entry& slot = slots_[hashKey(key) & mask_];
+    slot.key = key;
+    slot.generation = generation;
+    slot.peerSteamId = peerSteamId;
+    slot.sendCredit = 0;
+    slot.trafficClass = trafficClass;
+    slot.flags = flags;
+    slot.valid = true;
+    return &slot;
+}
+
+void FlowCache::clear() {
+    for (auto& slot : slots_) {
+        slot.valid = false;
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef FLOW_CACHE_H
+#define FLOW_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "vpn_protocol.h"
+#include "packet_classifier.h"
+
+/**
+ * @brief 5-tuple flow key
+ * IPv4 addresses are stored as IPv4-mapped IPv6 addresses (::ffff:a.b.c.d)
+ */
+struct FlowKey {
+    Ipv6Address srcIP;
+    Ipv6Address dstIP;
+    uint16_t srcPort;       // 0 for protocols without ports and non-first fragments
+    uint16_t dstPort;
+    uint8_t protocol;       // IPv4 protocol / IPv6 next header
+    uint8_t version;        // 4 or 6
+
+    bool operator==(const FlowKey& other) const;
+};
+
+/**
+ * @brief Forwarding decision cache for the TUN read path
+ *
+ * Direct-mapped table keyed on the 5-tuple. Each slot stores the resolved
+ * destination peer, the packet's traffic class and send flags, so established
+ * flows take a single hash probe per packet instead of parsing, routing lookup,
+ * FakeIP fallback and broadcast checks.
+ *
+ * Entries are tagged with the route generation they were resolved under; when
+ * routes or members change the caller bumps its generation counter and stale
+ * entries miss on their next lookup.
+ *
+ * Not thread-safe: owned by the TUN read thread. Hit/miss counters may be read
+ * from any thread.
+ */
+class FlowCache {
+public:
+    enum Flags : uint8_t {
+        FLOW_UNICAST   = 1 << 0,    // Send to peerSteamId
+        FLOW_BROADCAST = 1 << 1,    // Send to every room member
+        FLOW_DROP      = 1 << 2,    // No route, drop
+        FLOW_IPV6      = 1 << 3,    // IPv6 flow (drops count as ipv6Unroutable)
+    };
+
+    struct alignas(64) Entry {
+        FlowKey key;
+        uint32_t generation;
+        uint64_t peerSteamId;       // Resolved destination (FLOW_UNICAST only)
+        uint32_t sendCredit;        // Bytes that may be sent before re-checking backpressure
+        uint8_t trafficClass;       // DSCP of the first packet of the flow
+        uint8_t flags;
+        bool valid;
+    };
+
+    /**
+     * @param capacity Number of slots, rounded up to a power of two
+     */
+    explicit FlowCache(size_t capacity = 4096);
+
+    /**
+     * @brief Build the flow key of a classified IP packet
+     * @param meta Fields extracted by PacketClassifier
+     * @param packet Packet, only read for IPv6 addresses
+     * @return false if the packet is not a parseable IPv4/IPv6 packet
+     */
+    static bool buildKey(const PacketMeta& meta, const uint8_t* packet, FlowKey& key);
+
+    /**
+     * @brief Look up a flow resolved under the current route generation
+     * @return Cached entry, or nullptr on miss / stale entry
+     */
+    Entry* lookup(const FlowKey& key, uint32_t generation);
+
+    /**
+     * @brief Store a resolved decision, replacing whatever occupied the slot
+     * @return Pointer to the stored entry
+     */
+    Entry* insert(const FlowKey& key, uint32_t generation, uint64_t peerSteamId,
+                  uint8_t trafficClass, uint8_t flags);
+
+    /**
+     * @brief Drop all entries
+     */
+    void clear();
+
+    uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    static uint64_t hashKey(const FlowKey& key);
+
+    std::vector<Entry> slots_;
+    size_t mask_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
+
+#endif // FLOW_CACHE_H
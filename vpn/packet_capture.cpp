@@ -0,0 +1,244 @@
+#include "packet_capture.h"
+#include "packet_classifier.h"
+#include "trace_clock.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    constexpr int PROTO_ICMP = 1;
+    constexpr int PROTO_TCP = 6;
+    constexpr int PROTO_UDP = 17;
+    constexpr int PROTO_ICMPV6 = 58;
+
+    bool parseNumber(const std::string& token, uint64_t max, uint64_t& value) {
+        if (token.empty() || token.size() > 20) return false;
+        value = 0;
+        for (char c : token) {
+            if (c < '0' || c > '9') return false;
+            uint64_t digit = static_cast<uint64_t>(c - '0');
+            if (value > (UINT64_MAX - digit) / 10) return false;
+            value = value * 10 + digit;
+        }
+        return value <= max;
+    }
+
+    void drain(SpscRing<PacketCapture::Record>& ring) {
+        std::vector<PacketCapture::Record> scratch(16);
+        while (ring.popBatch(scratch.data(), scratch.size()) > 0) {}
+    }
+
+} // anonymous namespace
+
+constexpr size_t PacketCapture::kMaxSessions;
+constexpr size_t PacketCapture::kQueueCapacity;
+constexpr uint32_t PacketCapture::kMaxSnaplen;
+
+bool CaptureFilter::compile(const std::string& expression, CaptureFilter& filter, std::string& error) {
+    filter = CaptureFilter{};
+    bool directionSet = false;
+    bool protocolSet = false;
+
+    std::vector<std::string> tokens;
+    std::istringstream stream(expression);
+    for (std::string token; stream >> token;) {
+        std::transform(token.begin(), token.end(), token.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        tokens.push_back(token);
+    }
+
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        const std::string& token = tokens[i];
+        auto setProtocol = [&](int protocol, uint8_t version) {
+            if (protocolSet && filter.protocol != protocol) {
+                error = "conflicting protocols";
+                return false;
+            }
+            protocolSet = true;
+            filter.protocol = protocol;
+            if (version) filter.version = version;
+            return true;
+        };
+        auto argument = [&](const char* what, uint64_t max, uint64_t& value) {
+            if (i + 1 >= tokens.size() || !parseNumber(tokens[i + 1], max, value)) {
+                error = std::string("'") + token + "' needs " + what;
+                return false;
+            }
+            ++i;
+            return true;
+        };
+        uint64_t value = 0;
+
+        if (token == "and" || token == "&&") {
+            continue;
+        } else if (token == "or" || token == "||" || token == "not" || token == "!") {
+            error = "only 'and' is supported";
+            return false;
+        } else if (token == "inbound" || token == "outbound") {
+            uint8_t direction = static_cast<uint8_t>(token == "inbound" ? CaptureDirection::Inbound
+                                                                        : CaptureDirection::Outbound);
+            if (directionSet && filter.directions != direction) {
+                error = "conflicting directions";
+                return false;
+            }
+            directionSet = true;
+            filter.directions = direction;
+        } else if (token == "peer") {
+            if (!argument("a Steam ID", UINT64_MAX, value)) return false;
+            if (value == 0) {
+                error = "'peer' needs a Steam ID";
+                return false;
+            }
+            filter.peer = value;
+        } else if (token == "ip" || token == "ip6") {
+            uint8_t version = token == "ip" ? 4 : 6;
+            if (filter.version && filter.version != version) {
+                error = "conflicting IP versions";
+                return false;
+            }
+            filter.version = version;
+        } else if (token == "tcp") {
+            if (!setProtocol(PROTO_TCP, 0)) return false;
+        } else if (token == "udp") {
+            if (!setProtocol(PROTO_UDP, 0)) return false;
+        } else if (token == "icmp") {
+            if (!setProtocol(PROTO_ICMP, 4)) return false;
+        } else if (token == "icmp6") {
+            if (!setProtocol(PROTO_ICMPV6, 6)) return false;
+        } else if (token == "proto") {
+            if (!argument("a protocol number", 255, value) || !setProtocol(static_cast<int>(value), 0)) return false;
+        } else if (token == "port") {
+            if (!argument("a port number", 65535, value)) return false;
+            filter.port = static_cast<int>(value);
+        } else {
+            error = "unknown primitive '" + token + "'";
+            return false;
+        }
+    }
+
+    if (filter.port >= 0 && protocolSet && filter.protocol != PROTO_TCP && filter.protocol != PROTO_UDP) {
+        error = "'port' only applies to tcp and udp";
+        return false;
+    }
+    if ((filter.protocol == PROTO_ICMP && filter.version == 6) ||
+        (filter.protocol == PROTO_ICMPV6 && filter.version == 4)) {
+        error = "conflicting IP versions";
+        return false;
+    }
+    return true;
+}
+
+bool CaptureFilter::matches(CaptureDirection direction, uint64_t peerSteamId, const uint8_t* packet,
+                            size_t length) const {
+    if (!(directions & static_cast<uint8_t>(direction))) return false;
+    if (peer != 0 && peerSteamId != peer) return false;
+    if (version == 0 && protocol < 0 && port < 0) return true;
+
+    PacketMeta meta;
+    PacketClassifier::classify(packet, length, meta);
+    if (meta.version == 0) return false;
+    if (version != 0 && meta.version != version) return false;
+    if (protocol >= 0 && meta.protocol != protocol) return false;
+    if (port >= 0) {
+        if (meta.protocol != PROTO_TCP && meta.protocol != PROTO_UDP) return false;
+        if (meta.srcPort != port && meta.dstPort != port) return false;
+    }
+    return true;
+}
+
+int PacketCapture::open(const CaptureFilter& filter, uint32_t snaplen) {
+    uint32_t active = activeSessions_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < kMaxSessions; ++i) {
+        if (active & (1u << i)) continue;
+        Session& session = sessions_[i];
+
+        // No producer is inside a closed session, everything can be reset
+        if (!session.outbound) {
+            session.outbound = std::make_unique<SpscRing<Record>>(kQueueCapacity);
+            session.inbound = std::make_unique<SpscRing<Record>>(kQueueCapacity);
+        }
+        drain(*session.outbound);
+        drain(*session.inbound);
+        session.filter = filter;
+        session.snaplen = snaplen == 0 ? kMaxSnaplen : std::min(snaplen, kMaxSnaplen);
+        session.droppedOutbound.store(0, std::memory_order_relaxed);
+        session.droppedInbound.store(0, std::memory_order_relaxed);
+        session.reportedDropped = 0;
+
+        session.active.store(true);
+        activeSessions_.fetch_or(1u << i);
+        return static_cast<int>(i);
+    }
+    return -1;
+}
+
+void PacketCapture::close(int id) {
+    if (id < 0 || static_cast<size_t>(id) >= kMaxSessions) return;
+    Session& session = sessions_[id];
+    session.active.store(false);
+    activeSessions_.fetch_and(~(1u << id));
+    // Pairs with the increment in offerSlow: afterwards no producer can see the session active
+    while (session.users.load() != 0) {
+        std::this_thread::yield();
+    }
+}
+
+size_t PacketCapture::poll(int id, Record* out, size_t maxRecords) {
+    if (id < 0 || static_cast<size_t>(id) >= kMaxSessions) return 0;
+    Session& session = sessions_[id];
+    if (!session.outbound) return 0;
+
+    // Split the room between directions so a busy one cannot starve the other
+    size_t count = session.outbound->popBatch(out, maxRecords / 2);
+    count += session.inbound->popBatch(out + count, maxRecords - count);
+    count += session.outbound->popBatch(out + count, maxRecords - count);
+    return count;
+}
+
+uint64_t PacketCapture::takeDropped(int id) {
+    if (id < 0 || static_cast<size_t>(id) >= kMaxSessions) return 0;
+    Session& session = sessions_[id];
+    uint64_t total = session.droppedOutbound.load(std::memory_order_relaxed) +
+                     session.droppedInbound.load(std::memory_order_relaxed);
+    uint64_t dropped = total - session.reportedDropped;
+    session.reportedDropped = total;
+    return dropped;
+}
+
+void PacketCapture::offerSlow(CaptureDirection direction, uint64_t peer, const uint8_t* packet, size_t length) {
+    uint32_t active = activeSessions_.load(std::memory_order_acquire);
+    bool outbound = direction == CaptureDirection::Outbound;
+    // Filled on the first match and shared by all sessions; too large for the stack
+    thread_local std::unique_ptr<Record> record(new Record);
+    bool filled = false;
+
+    for (size_t i = 0; i < kMaxSessions; ++i) {
+        if (!(active & (1u << i))) continue;
+        Session& session = sessions_[i];
+
+        session.users.fetch_add(1);
+        if (session.active.load() && session.filter.matches(direction, peer, packet, length)) {
+            if (!filled) {
+                filled = true;
+                record->timestampUs = TraceClock::now();
+                record->peer = peer;
+                record->length = static_cast<uint32_t>(length);
+                record->direction = direction;
+                memcpy(record->data, packet, std::min<size_t>(length, kMaxSnaplen));
+            }
+            record->captured = static_cast<uint16_t>(std::min<size_t>(length, session.snaplen));
+
+            SpscRing<Record>& ring = outbound ? *session.outbound : *session.inbound;
+            if (!ring.tryPush(*record)) {
+                std::atomic<uint64_t>& dropped = outbound ? session.droppedOutbound : session.droppedInbound;
+                dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+        }
+        session.users.fetch_sub(1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,132 @@
+#ifndef PACKET_CAPTURE_H
+#define PACKET_CAPTURE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "../core/spsc_ring.h"
+
+enum class CaptureDirection : uint8_t {
+    Outbound = 1,   // TUN -> peer
+    Inbound = 2,    // Peer -> TUN
+};
+
+/**
+ * @brief Compiled capture filter
+ *
+ * Compiled from a tcpdump-like expression of primitives joined by "and":
+ *
+ *   inbound | outbound           direction
+ *   peer <steam id>              packets to or from one peer
+ *   ip | ip6                     IP version
+ *   tcp | udp | icmp | icmp6     protocol
+ *   proto <number>               protocol by number
+ *   port <number>                TCP/UDP source or destination port
+ *
+ * An empty expression matches everything. "or" and "not" are not supported,
+ * so a filter is a fixed set of field comparisons.
+ */
+struct CaptureFilter {
+    uint8_t directions = static_cast<uint8_t>(CaptureDirection::Outbound) |
+                         static_cast<uint8_t>(CaptureDirection::Inbound);
+    uint64_t peer = 0;          // 0 matches any peer
+    uint8_t version = 0;        // 4 or 6, 0 matches both
+    int protocol = -1;          // IPv4 protocol / IPv6 next header, -1 matches any
+    int port = -1;              // -1 matches any
+
+    /**
+     * @brief Compile an expression
+     * @return false with a message in error if the expression is invalid
+     */
+    static bool compile(const std::string& expression, CaptureFilter& filter, std::string& error);
+
+    bool matches(CaptureDirection direction, uint64_t peer, const uint8_t* packet, size_t length) const;
+};
+
+/**
+ * @brief Live packet capture sessions fed from the data path
+ *
+ * Up to kMaxSessions captures run at once. Each session has its own compiled
+ * filter, snap length and one SPSC queue per direction (outbound is produced
+ * by the TUN read thread, inbound by the receive poll thread); the control
+ * path drains them. When a queue is full the record is dropped and counted,
+ * forwarding never waits for a capture client.
+ *
+ * With no session open offer() costs one relaxed load. Sessions are recycled
+ * rather than freed: closing one waits until no producer is inside it, so its
+ * filter and queues can be reset for the next capture.
+ */
+class PacketCapture {
+public:
+    static constexpr size_t kMaxSessions = 4;
+    static constexpr size_t kQueueCapacity = 256;   // Records per session and direction
+    static constexpr uint32_t kMaxSnaplen = 2048;   // Covers any packet that fits the tunnel
+
+    struct Record {
+        int64_t timestampUs;    // TraceClock
+        uint64_t peer;          // 0 for broadcast
+        uint32_t length;        // Original packet length
+        uint16_t captured;
+        CaptureDirection direction;
+        uint8_t data[kMaxSnaplen];
+    };
+
+    PacketCapture() = default;
+
+    PacketCapture(const PacketCapture&) = delete;
+    PacketCapture& operator=(const PacketCapture&) = delete;
+
+    /**
+     * @brief Offer a packet to every open session (data path, one thread per direction)
+     */
+    void offer(CaptureDirection direction, uint64_t peer, const uint8_t* packet, size_t length) {
+        if (activeSessions_.load(std::memory_order_relaxed) == 0) return;
+        offerSlow(direction, peer, packet, length);
+    }
+
+    // Control path (one thread)
+
+    /**
+     * @brief Open a session
+     * @param snaplen Bytes kept per packet, 0 or more than kMaxSnaplen means kMaxSnaplen
+     * @return Session id, -1 if all sessions are in use
+     */
+    int open(const CaptureFilter& filter, uint32_t snaplen);
+
+    void close(int session);
+
+    /**
+     * @brief Take up to maxRecords captured packets, oldest first per direction
+     */
+    size_t poll(int session, Record* out, size_t maxRecords);
+
+    /**
+     * @brief Records dropped because a queue was full since the previous call
+     */
+    uint64_t takeDropped(int session);
+
+private:
+    struct Session {
+        std::atomic<bool> active{false};
+        std::atomic<int> users{0};      // Producers currently inside offerSlow
+        CaptureFilter filter;
+        uint32_t snaplen = kMaxSnaplen;
+        std::unique_ptr<SpscRing<Record>> outbound;
+        std::unique_ptr<SpscRing<Record>> inbound;
+        // One writer each (the direction's producer thread)
+        std::atomic<uint64_t> droppedOutbound{0};
+        std::atomic<uint64_t> droppedInbound{0};
+        uint64_t reportedDropped = 0;   // Control path
+    };
+
+    void offerSlow(CaptureDirection direction, uint64_t peer, const uint8_t* packet, size_t length);
+
+    std::array<Session, kMaxSessions> sessions_;
+    std::atomic<uint32_t> activeSessions_{0};   // Bit per open session
+};
+
+#endif // PACKET_CAPTURE_H
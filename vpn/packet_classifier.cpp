@@ -0,0 +1,67 @@
+#include "packet_classifier.h"
+#include <cstring>
+
+namespace {
+
+    constexpr uint8_t IP_PROTO_TCP = 6;
+    constexpr uint8_t IP_PROTO_UDP = 17;
+    constexpr size_t IPV6_HEADER_SIZE = 40;
+
+    uint16_t readU16(const uint8_t* p) {
+        return static_cast<uint16_t>((p[0] << 8) | p[1]);
+    }
+
+    uint32_t readU32(const uint8_t* p) {
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+               (static_cast<uint32_t>(p[2]) << 8) | p[3];
+    }
+
+    bool hasPorts(uint8_t protocol) {
+        return protocol == IP_PROTO_TCP || protocol == IP_PROTO_UDP;
+    }
+
+} // anonymous namespace
+
+namespace PacketClassifier {
+
+    void classify(const uint8_t* packet, size_t length, PacketMeta& out) {
+        memset(&out, 0, sizeof(out));
+        if (length < 1) return;
+
+        uint8_t version = (packet[0] >> 4) & 0x0F;
+        size_t headerLen = 0;
+        bool firstFragment = true;
+
+        if (version == 4) {
+            if (length < 20) return;
+            headerLen = static_cast<size_t>(packet[0] & 0x0F) * 4;
+            if (headerLen < 20) return;
+            out.srcIP = readU32(packet + 12);
+            out.dstIP = readU32(packet + 16);
+            out.protocol = packet[9];
+            out.dscp = packet[1] >> 2;
+            firstFragment = (readU16(packet + 6) & 0x1FFF) == 0;
+        } else if (version == 6) {
+            if (length < IPV6_HEADER_SIZE) return;
+            headerLen = IPV6_HEADER_SIZE;
+            out.protocol = packet[6];
+            out.dscp = static_cast<uint8_t>(((packet[0] & 0x0F) << 2) | (packet[1] >> 6));
+        } else {
+            return;
+        }
+
+        out.version = version;
+        out.headerLength = static_cast<uint8_t>(headerLen);
+        if (firstFragment && hasPorts(out.protocol) && length >= headerLen + 4) {
+            out.srcPort = readU16(packet + headerLen);
+            out.dstPort = readU16(packet + headerLen + 2);
+        }
+    }
+
+    void classifyBatch(const uint8_t* const* packets, const size_t* lengths, size_t count, PacketMeta* out) {
+        for (size_t i = 0; i < count; ++i) {
+            classify(packets[i], lengths[i], out[i]);
+        }
+    }
+
+} // namespace PacketClassifier
@@ -0,0 +1,46 @@
+#ifndef PACKET_CLASSIFIER_H
+#define PACKET_CLASSIFIER_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Header fields extracted from one IP packet
+ */
+struct PacketMeta {
+    uint32_t srcIP;         // IPv4 source (Host Byte Order), 0 for IPv6
+    uint32_t dstIP;         // IPv4 destination (Host Byte Order), 0 for IPv6
+    uint16_t srcPort;       // TCP/UDP ports, 0 if absent or non-first fragment
+    uint16_t dstPort;
+    uint8_t version;        // 4 or 6, 0 if the packet is not parseable
+    uint8_t protocol;       // IPv4 protocol / IPv6 next header
+    uint8_t dscp;           // Differentiated Services Code Point
+    uint8_t headerLength;   // IP header length in bytes
+};
+
+/**
+ * @brief Batch packet classification
+ *
+ * Extracts version, protocol, addresses, ports and DSCP for a whole batch of
+ * packets with a scalar loop. An AVX2 gather kernel measured about twice as
+ * slow on a 32-packet batch; it lives in bench/packet_classifier_bench.cpp.
+ */
+namespace PacketClassifier {
+
+    /**
+     * @brief Classify a batch of packets
+     * @param packets Packet pointers
+     * @param lengths Packet lengths
+     * @param count Number of packets
+     * @param out Output, one entry per packet
+     */
+    void classifyBatch(const uint8_t* const* packets, const size_t* lengths, size_t count, PacketMeta* out);
+
+    /**
+     * @brief Classify a single packet (scalar)
+     */
+    void classify(const uint8_t* packet, size_t length, PacketMeta& out);
+
+} // namespace PacketClassifier
+
+#endif // PACKET_CLASSIFIER_H
@@ -0,0 +1,172 @@
+#include "packet_tracer.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <random>
+
+namespace {
+
+    constexpr int kTxThread = 1;
+    constexpr int kRxThread = 2;
+
+    bool isSenderHop(TraceHop hop) {
+        return hop <= TraceHop::SteamSend;
+    }
+
+    void appendHex(std::string& out, uint64_t value) {
+        char buffer[24];
+        std::snprintf(buffer, sizeof(buffer), "\"0x%016" PRIx64 "\"", value);
+        out += buffer;
+    }
+
+    // Common fields of one trace event, the caller closes the object
+    void appendEventHead(std::string& out, const char* name, const char* phase, uint32_t pid, int tid,
+                         int64_t timestampUs) {
+        out += out.back() == '[' ? "\n{\"name\":\"" : ",\n{\"name\":\"";
+        out += name;
+        out += "\",\"cat\":\"packet\",\"ph\":\"";
+        out += phase;
+        out += "\",\"pid\":";
+        out += std::to_string(pid);
+        out += ",\"tid\":";
+        out += std::to_string(tid);
+        out += ",\"ts\":";
+        out += std::to_string(timestampUs);
+    }
+
+    void appendMetadata(std::string& out, const char* name, uint32_t pid, int tid, const std::string& value) {
+        out += out.back() == '[' ? "\n{\"name\":\"" : ",\n{\"name\":\"";
+        out += name;
+        out += "\",\"ph\":\"M\",\"pid\":";
+        out += std::to_string(pid);
+        out += ",\"tid\":";
+        out += std::to_string(tid);
+        out += ",\"args\":{\"name\":\"";
+        out += value;
+        out += "\"}}";
+    }
+
+} // anonymous namespace
+
+constexpr size_t PacketTracer::kCapacity;
+
+const char* traceHopName(TraceHop hop) {
+    switch (hop) {
+        case TraceHop::TunRead: return "tun_read";
+        case TraceHop::Classify: return "classify";
+        case TraceHop::Enqueue: return "enqueue";
+        case TraceHop::SteamSend: return "steam_send";
+        case TraceHop::SteamReceive: return "steam_receive";
+        case TraceHop::Dispatch: return "dispatch";
+        case TraceHop::TunWrite: return "tun_write";
+        case TraceHop::Count: break;
+    }
+    return "unknown";
+}
+
+PacketTracer::PacketTracer()
+    : slots_(new Slot[kCapacity]) {
+    std::random_device random;
+    idPrefix_ = static_cast<uint64_t>(random() | 1u) << 32;
+}
+
+void PacketTracer::record(uint64_t traceId, TraceHop hop, int64_t timestampUs, uint64_t peer, uint32_t length,
+                          int64_t remoteSentAtUs) {
+    uint64_t index = head_.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots_[index & (kCapacity - 1)];
+
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.traceId.store(traceId, std::memory_order_relaxed);
+    slot.timestampUs.store(timestampUs, std::memory_order_relaxed);
+    slot.peer.store(peer, std::memory_order_relaxed);
+    slot.remoteSentAtUs.store(remoteSentAtUs, std::memory_order_relaxed);
+    slot.length.store(length, std::memory_order_relaxed);
+    slot.hop.store(static_cast<uint8_t>(hop), std::memory_order_relaxed);
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+std::vector<PacketTracer::Event> PacketTracer::snapshot() const {
+    uint64_t end = head_.load(std::memory_order_acquire);
+    uint64_t begin = std::max(end > kCapacity ? end - kCapacity : 0, clearedAt_.load(std::memory_order_relaxed));
+
+    std::vector<Event> events;
+    events.reserve(static_cast<size_t>(end - begin));
+    for (uint64_t index = begin; index < end; ++index) {
+        const Slot& slot = slots_[index & (kCapacity - 1)];
+        uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != 2 * index + 2) continue;   // Still being written, or already overwritten
+
+        Event event;
+        event.traceId = slot.traceId.load(std::memory_order_relaxed);
+        event.timestampUs = slot.timestampUs.load(std::memory_order_relaxed);
+        event.peer = slot.peer.load(std::memory_order_relaxed);
+        event.remoteSentAtUs = slot.remoteSentAtUs.load(std::memory_order_relaxed);
+        event.length = slot.length.load(std::memory_order_relaxed);
+        event.hop = static_cast<TraceHop>(slot.hop.load(std::memory_order_relaxed));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence) continue;
+        events.push_back(event);
+    }
+    return events;
+}
+
+void PacketTracer::clear() {
+    clearedAt_.store(head_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+std::string PacketTracer::dumpChromeTrace(uint64_t localSteamId, bool clear, size_t* eventCount) {
+    std::vector<Event> events = snapshot();
+    if (clear) this->clear();
+    if (eventCount) *eventCount = events.size();
+
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        return a.traceId != b.traceId ? a.traceId < b.traceId : a.hop < b.hop;
+    });
+
+    uint32_t pid = static_cast<uint32_t>(localSteamId);
+    std::string out;
+    out.reserve(256 + events.size() * 200);
+    out += "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    appendMetadata(out, "process_name", pid, kTxThread, "ConnectTool " + std::to_string(localSteamId));
+    appendMetadata(out, "thread_name", pid, kTxThread, "tx");
+    appendMetadata(out, "thread_name", pid, kRxThread, "rx");
+
+    // One slice per pair of consecutive hops of a packet on the same side
+    for (size_t i = 1; i < events.size(); ++i) {
+        const Event& from = events[i - 1];
+        const Event& to = events[i];
+        if (from.traceId != to.traceId || isSenderHop(from.hop) != isSenderHop(to.hop)) continue;
+
+        int tid = isSenderHop(to.hop) ? kTxThread : kRxThread;
+        appendEventHead(out, traceHopName(to.hop), "X", pid, tid, from.timestampUs);
+        out += ",\"dur\":";
+        out += std::to_string(std::max<int64_t>(0, to.timestampUs - from.timestampUs));
+        out += ",\"args\":{\"trace_id\":";
+        appendHex(out, to.traceId);
+        out += ",\"peer\":\"";
+        out += std::to_string(to.peer);
+        out += "\",\"bytes\":";
+        out += std::to_string(to.length);
+        if (from.hop == TraceHop::SteamReceive && from.remoteSentAtUs != 0) {
+            // Only meaningful as far as the two nodes' wall clocks agree
+            out += ",\"one_way_us\":";
+            out += std::to_string(from.timestampUs - from.remoteSentAtUs);
+        }
+        out += "}}";
+
+        // Flow arrow from the sender's steam_send slice to the receiver's dispatch slice
+        if (to.hop == TraceHop::SteamSend || from.hop == TraceHop::SteamReceive) {
+            bool start = to.hop == TraceHop::SteamSend;
+            appendEventHead(out, "packet", start ? "s" : "f", pid, tid, from.timestampUs);
+            out += ",\"id\":";
+            appendHex(out, to.traceId);
+            out += start ? "}" : ",\"bp\":\"e\"}";
+        }
+    }
+
+    out += "\n]}\n";
+    return out;
+}
@@ -0,0 +1,126 @@
+#ifndef PACKET_TRACER_H
+#define PACKET_TRACER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "trace_clock.h"
+
+/**
+ * @brief Points on the data path where a sampled packet is timestamped
+ */
+enum class TraceHop : uint8_t {
+    TunRead = 0,    // Sender: read_batch returned the packet
+    Classify,       // Sender: header fields extracted
+    Enqueue,        // Sender: routed, handed to the transport
+    SteamSend,      // Sender: transport accepted the message
+    SteamReceive,   // Receiver: message arrived at the transport
+    Dispatch,       // Receiver: parsed and queued for the TUN writer
+    TunWrite,       // Receiver: written to the TUN device
+    Count
+};
+
+const char* traceHopName(TraceHop hop);
+
+/**
+ * @brief Sampled per-packet tracing
+ *
+ * The TUN read thread picks one in sampleEvery() outbound packets and gives it
+ * a trace id, which travels to the peer in a PacketTraceExtension. Both ends
+ * record a hop event for every point the packet passes into a fixed ring of
+ * kCapacity events; the oldest events are overwritten.
+ *
+ * Any thread may record: a slot is claimed with one fetch_add and published
+ * through a per-slot sequence number (seqlock), so writers never block and
+ * never allocate. Readers copy the ring on the control path and skip slots
+ * that are being rewritten.
+ *
+ * Timestamps come from TraceClock, so dumps from different nodes line up as
+ * closely as their wall clocks do.
+ */
+class PacketTracer {
+public:
+    static constexpr size_t kCapacity = 8192;   // Power of two
+
+    struct Event {
+        uint64_t traceId;
+        int64_t timestampUs;        // TraceClock
+        uint64_t peer;              // Destination (sender hops) or source (receiver hops) Steam ID
+        int64_t remoteSentAtUs;     // SteamReceive: the sender's Enqueue time, 0 otherwise
+        uint32_t length;            // IP packet bytes
+        TraceHop hop;
+    };
+
+    PacketTracer();
+
+    PacketTracer(const PacketTracer&) = delete;
+    PacketTracer& operator=(const PacketTracer&) = delete;
+
+    // Control path
+    void setSampleEvery(uint32_t every) { sampleEvery_.store(every, std::memory_order_relaxed); }
+    uint32_t sampleEvery() const { return sampleEvery_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Trace id for one in sampleEvery() calls, 0 otherwise
+     * @note TUN read thread only
+     */
+    uint64_t sample() {
+        uint32_t every = sampleEvery_.load(std::memory_order_relaxed);
+        if (every == 0 || ++sampleCounter_ < every) return 0;
+        sampleCounter_ = 0;
+        return idPrefix_ | ++nextId_;
+    }
+
+    void record(uint64_t traceId, TraceHop hop, int64_t timestampUs, uint64_t peer, uint32_t length,
+                int64_t remoteSentAtUs = 0);
+
+    /**
+     * @brief Copy of the recorded events, oldest first
+     */
+    std::vector<Event> snapshot() const;
+
+    /**
+     * @brief Forget everything recorded so far
+     */
+    void clear();
+
+    /**
+     * @brief Render the ring in Chrome trace event format
+     *
+     * Each node is one process (pid = Steam account id), with a "tx" and an
+     * "rx" thread holding one slice per hop. The steam_send slice of a sender
+     * and the dispatch slice of its receiver are joined by a flow event keyed
+     * on the trace id, so concatenating the traceEvents of two nodes' dumps
+     * shows packets crossing between them.
+     *
+     * @param eventCount receives the number of hop events rendered
+     */
+    std::string dumpChromeTrace(uint64_t localSteamId, bool clear, size_t* eventCount = nullptr);
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};  // 2 * index + 1 while written, 2 * index + 2 once complete
+        std::atomic<uint64_t> traceId{0};
+        std::atomic<int64_t> timestampUs{0};
+        std::atomic<uint64_t> peer{0};
+        std::atomic<int64_t> remoteSentAtUs{0};
+        std::atomic<uint32_t> length{0};
+        std::atomic<uint8_t> hop{0};
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<uint64_t> head_{0};         // Next event index
+    std::atomic<uint64_t> clearedAt_{0};    // Events before this index are not reported
+
+    std::atomic<uint32_t> sampleEvery_{0};
+    // TUN read thread only
+    uint32_t sampleCounter_ = 0;
+    uint64_t idPrefix_;                     // Random upper 32 bits, keeps ids from different nodes apart
+    uint32_t nextId_ = 0;
+};
+
+#endif // PACKET_TRACER_H
@@ -0,0 +1,171 @@
+#include "peer_stats.h"
+
+namespace {
+
+    uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    constexpr size_t reasonIndex(PeerDropReason reason) {
+        return static_cast<size_t>(reason);
+    }
+
+} // anonymous namespace
+
+constexpr size_t PeerStatsTable::kSlots;
+
+PeerStatsTable::PeerStatsTable()
+    : lastSample_(std::chrono::steady_clock::now()) {
+}
+
+size_t PeerStatsTable::hashSlot(uint64_t steamId) {
+    return static_cast<size_t>(mix(steamId)) & (kSlots - 1);
+}
+
+PeerStatsTable::Slot* PeerStatsTable::find(uint64_t steamId) {
+    if (steamId == kEmpty || steamId == kTombstone) return nullptr;
+    size_t index = hashSlot(steamId);
+    for (size_t probe = 0; probe < kSlots; ++probe) {
+        Slot& slot = slots_[(index + probe) & (kSlots - 1)];
+        uint64_t key = slot.key.load(std::memory_order_acquire);
+        if (key == steamId) return &slot;
+        if (key == kEmpty) return nullptr;
+    }
+    return nullptr;
+}
+
+PeerStatsTable::Slot* PeerStatsTable::claim(uint64_t steamId) {
+    if (Slot* existing = find(steamId)) return existing;
+    if (steamId == kEmpty || steamId == kTombstone) return nullptr;
+
+    size_t index = hashSlot(steamId);
+    for (size_t probe = 0; probe < kSlots; ++probe) {
+        Slot& slot = slots_[(index + probe) & (kSlots - 1)];
+        uint64_t key = slot.key.load(std::memory_order_relaxed);
+        if (key == kEmpty || key == kTombstone) {
+            resetSlot(slot);
+            // Counters are zeroed before the key becomes visible to the data path
+            slot.key.store(steamId, std::memory_order_release);
+            live_++;
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+void PeerStatsTable::resetSlot(Slot& slot) {
+    slot.txPackets.store(0, std::memory_order_relaxed);
+    slot.txBytes.store(0, std::memory_order_relaxed);
+    slot.rxPackets.store(0, std::memory_order_relaxed);
+    slot.rxBytes.store(0, std::memory_order_relaxed);
+    for (auto& drop : slot.drops) {
+        drop.store(0, std::memory_order_relaxed);
+    }
+    slot.lastTxPackets = slot.lastTxBytes = slot.lastRxPackets = slot.lastRxBytes = 0;
+    slot.txPacketsPerSec = slot.txBytesPerSec = slot.rxPacketsPerSec = slot.rxBytesPerSec = 0;
+    slot.link = PeerLinkMetrics{};
+}
+
+void PeerStatsTable::addPeer(uint64_t steamId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    claim(steamId);
+}
+
+void PeerStatsTable::removePeer(uint64_t steamId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (Slot* slot = find(steamId)) {
+        // A tombstone keeps later probes going past this slot
+        slot->key.store(kTombstone, std::memory_order_release);
+        if (--live_ == 0) {
+            // No probe path left to preserve, so misses stop at the first slot again
+            for (auto& other : slots_) {
+                other.key.store(kEmpty, std::memory_order_release);
+            }
+        }
+    }
+}
+
+void PeerStatsTable::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& slot : slots_) {
+        slot.key.store(kEmpty, std::memory_order_release);
+        resetSlot(slot);
+    }
+    live_ = 0;
+}
+
+void PeerStatsTable::updateLink(uint64_t steamId, const PeerLinkMetrics& link) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (Slot* slot = claim(steamId)) {
+        slot->link = link;
+    }
+}
+
+void PeerStatsTable::sampleRates(std::chrono::steady_clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    double seconds = std::chrono::duration<double>(now - lastSample_).count();
+    lastSample_ = now;
+    if (seconds <= 0) return;
+
+    auto rate = [seconds](uint64_t current, uint64_t& last) {
+        double value = current >= last ? static_cast<double>(current - last) / seconds : 0.0;
+        last = current;
+        return value;
+    };
+    for (auto& slot : slots_) {
+        uint64_t key = slot.key.load(std::memory_order_relaxed);
+        if (key == kEmpty || key == kTombstone) continue;
+        slot.txPacketsPerSec = rate(slot.txPackets.load(std::memory_order_relaxed), slot.lastTxPackets);
+        slot.txBytesPerSec = rate(slot.txBytes.load(std::memory_order_relaxed), slot.lastTxBytes);
+        slot.rxPacketsPerSec = rate(slot.rxPackets.load(std::memory_order_relaxed), slot.lastRxPackets);
+        slot.rxBytesPerSec = rate(slot.rxBytes.load(std::memory_order_relaxed), slot.lastRxBytes);
+    }
+}
+
+std::vector<PeerStatsTable::Snapshot> PeerStatsTable::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Snapshot> result;
+    for (const auto& slot : slots_) {
+        uint64_t key = slot.key.load(std::memory_order_relaxed);
+        if (key == kEmpty || key == kTombstone) continue;
+        Snapshot snap{};
+        snap.steamId = key;
+        snap.txPackets = slot.txPackets.load(std::memory_order_relaxed);
+        snap.txBytes = slot.txBytes.load(std::memory_order_relaxed);
+        snap.rxPackets = slot.rxPackets.load(std::memory_order_relaxed);
+        snap.rxBytes = slot.rxBytes.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < reasonIndex(PeerDropReason::Count); ++i) {
+            snap.drops[i] = slot.drops[i].load(std::memory_order_relaxed);
+        }
+        snap.txPacketsPerSec = slot.txPacketsPerSec;
+        snap.txBytesPerSec = slot.txBytesPerSec;
+        snap.rxPacketsPerSec = slot.rxPacketsPerSec;
+        snap.rxBytesPerSec = slot.rxBytesPerSec;
+        snap.link = slot.link;
+        result.push_back(snap);
+    }
+    return result;
+}
+
+void PeerStatsTable::recordSent(uint64_t steamId, size_t bytes) {
+    if (Slot* slot = find(steamId)) {
+        slot->txPackets.fetch_add(1, std::memory_order_relaxed);
+        slot->txBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+}
+
+void PeerStatsTable::recordReceived(uint64_t steamId, size_t bytes) {
+    if (Slot* slot = find(steamId)) {
+        slot->rxPackets.fetch_add(1, std::memory_order_relaxed);
+        slot->rxBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+}
+
+void PeerStatsTable::recordDrop(uint64_t steamId, PeerDropReason reason) {
+    if (Slot* slot = find(steamId)) {
+        slot->drops[reasonIndex(reason)].fetch_add(1, std::memory_order_relaxed);
+    }
+}
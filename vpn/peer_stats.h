@@ -0,0 +1,125 @@
+#ifndef PEER_STATS_H
+#define PEER_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Why a packet to or from a peer was dropped
+ */
+enum class PeerDropReason : uint8_t {
+    Backpressure = 0,   // Send queue stayed above the limit
+    SendFailed,         // Transport rejected the message
+    RxQueueFull,        // TUN write queue full
+    RxInFlightLimit,    // In-flight receive budget exhausted
+    Count
+};
+
+/**
+ * @brief Link state of one peer, sampled from the transport once per interval
+ */
+struct PeerLinkMetrics {
+    enum class Path : uint8_t { Unknown, Steam, Relayed, DirectUdp, Lan };
+
+    bool connected = false;
+    int ping = -1;                  // ms
+    float qualityLocal = -1.0f;     // Fraction of packets delivered, 0..1, -1 unknown
+    float qualityRemote = -1.0f;
+    int pendingBytes = 0;           // Queued for sending (reliable + unreliable)
+    float outBytesPerSec = 0.0f;    // Steam's own rate estimates
+    float inBytesPerSec = 0.0f;
+    Path path = Path::Unknown;
+};
+
+/**
+ * @brief Per-peer traffic counters in fixed slots
+ *
+ * Open-addressed table of kSlots entries keyed by Steam ID. Slots are claimed
+ * and released on the control path (member join/leave, link sampling) under a
+ * mutex; the data path only probes keys and bumps relaxed atomic counters, so
+ * it never locks or allocates. Packets for peers without a slot are not
+ * counted per peer (the global counters still see them).
+ *
+ * Removed peers leave tombstones so probes keep going past them. Live slots are
+ * never moved: claim() reuses the first tombstone on a key's probe path, and
+ * tombstones only turn back into empty slots once the last peer is removed.
+ *
+ * Rates are derived from counter deltas by sampleRates(), which the owner calls
+ * once per sampling interval together with updateLink().
+ */
+class PeerStatsTable {
+public:
+    static constexpr size_t kSlots = 256;   // Steam lobbies hold up to 250 members
+
+    struct Snapshot {
+        uint64_t steamId;
+        uint64_t txPackets;
+        uint64_t txBytes;
+        uint64_t rxPackets;
+        uint64_t rxBytes;
+        uint64_t drops[static_cast<size_t>(PeerDropReason::Count)];
+        double txPacketsPerSec;
+        double txBytesPerSec;
+        double rxPacketsPerSec;
+        double rxBytesPerSec;
+        PeerLinkMetrics link;
+    };
+
+    PeerStatsTable();
+
+    PeerStatsTable(const PeerStatsTable&) = delete;
+    PeerStatsTable& operator=(const PeerStatsTable&) = delete;
+
+    // Control path
+    void addPeer(uint64_t steamId);
+    void removePeer(uint64_t steamId);
+    void clear();
+    void updateLink(uint64_t steamId, const PeerLinkMetrics& link);
+    void sampleRates(std::chrono::steady_clock::time_point now);
+    std::vector<Snapshot> snapshot() const;
+
+    // Data path, lock-free
+    void recordSent(uint64_t steamId, size_t bytes);
+    void recordReceived(uint64_t steamId, size_t bytes);
+    void recordDrop(uint64_t steamId, PeerDropReason reason);
+
+private:
+    static constexpr uint64_t kEmpty = 0;
+    static constexpr uint64_t kTombstone = 1;   // Not a valid Steam ID
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> key{kEmpty};
+        std::atomic<uint64_t> txPackets{0};
+        std::atomic<uint64_t> txBytes{0};
+        std::atomic<uint64_t> rxPackets{0};
+        std::atomic<uint64_t> rxBytes{0};
+        std::atomic<uint64_t> drops[static_cast<size_t>(PeerDropReason::Count)] = {};
+
+        // Sampling state, guarded by mutex_
+        uint64_t lastTxPackets = 0;
+        uint64_t lastTxBytes = 0;
+        uint64_t lastRxPackets = 0;
+        uint64_t lastRxBytes = 0;
+        double txPacketsPerSec = 0;
+        double txBytesPerSec = 0;
+        double rxPacketsPerSec = 0;
+        double rxBytesPerSec = 0;
+        PeerLinkMetrics link;
+    };
+
+    static size_t hashSlot(uint64_t steamId);
+    Slot* find(uint64_t steamId);
+    Slot* claim(uint64_t steamId);      // Caller holds mutex_
+    void resetSlot(Slot& slot);
+
+    Slot slots_[kSlots];
+    size_t live_ = 0;                   // Guarded by mutex_
+    std::chrono::steady_clock::time_point lastSample_;
+    mutable std::mutex mutex_;
+};
+
+#endif // PEER_STATS_H
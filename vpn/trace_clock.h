@@ -0,0 +1,34 @@
+#ifndef TRACE_CLOCK_H
+#define TRACE_CLOCK_H
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Clock shared by packet traces and the flight recorder
+ *
+ * steady_clock shifted to Unix microseconds once per process: monotonic
+ * within a node, and comparable across nodes as far as their wall clocks agree.
+ */
+class TraceClock {
+public:
+    static int64_t now() {
+        return fromSteadyUs(steadyUs());
+    }
+
+    // Converts a steady_clock timestamp (e.g. TransportMessage::receivedAtUs)
+    static int64_t fromSteadyUs(int64_t steadyUs) {
+        static const int64_t offsetUs =
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count() - TraceClock::steadyUs();
+        return steadyUs + offsetUs;
+    }
+
+private:
+    static int64_t steadyUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+#endif // TRACE_CLOCK_H
@@ -0,0 +1,186 @@
+#include "vpn_checksum.h"
+#include "cpu_features.h"
+
+namespace {
+
+    // Below this the scalar loop is faster than setting up vector accumulators
+    // (crossover between 128 and 256 bytes in bench/vpn_checksum_bench.cpp)
+    constexpr size_t SIMD_MIN_LENGTH = 256;
+
+    uint16_t readU16(const uint8_t* p) {
+        return static_cast<uint16_t>((p[0] << 8) | p[1]);
+    }
+
+    uint32_t fold(uint64_t sum) {
+        while (sum >> 16) {
+            sum = (sum & 0xFFFF) + (sum >> 16);
+        }
+        return static_cast<uint32_t>(sum);
+    }
+
+    uint16_t swapBytes(uint32_t value) {
+        return static_cast<uint16_t>(((value & 0xFF) << 8) | ((value >> 8) & 0xFF));
+    }
+
+#ifdef VPN_SIMD_X86
+
+    // The vector kernels add 16-bit words in native (little-endian) order into
+    // 32-bit lanes; the ones'-complement sum is byte-order independent (RFC 1071
+    // section 2), so the folded result only needs a final byte swap. Each lane
+    // gains at most 0xFFFF per block, so lanes are flushed before they can wrap.
+    constexpr size_t SIMD_FLUSH_BLOCKS = 32768;
+
+    uint64_t sumSse2(const uint8_t* data, size_t blocks) {
+        const __m128i lowMask = _mm_set1_epi32(0xFFFF);
+        uint64_t total = 0;
+
+        while (blocks > 0) {
+            size_t chunk = blocks < SIMD_FLUSH_BLOCKS ? blocks : SIMD_FLUSH_BLOCKS;
+            __m128i accLow = _mm_setzero_si128();
+            __m128i accHigh = _mm_setzero_si128();
+            for (size_t i = 0; i < chunk; ++i) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+                accLow = _mm_add_epi32(accLow, _mm_and_si128(v, lowMask));
+                accHigh = _mm_add_epi32(accHigh, _mm_srli_epi32(v, 16));
+                data += 16;
+            }
+
+            alignas(16) uint32_t lanes[8];
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes), accLow);
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes + 4), accHigh);
+            for (uint32_t lane : lanes) total += lane;
+            blocks -= chunk;
+        }
+        return total;
+    }
+
+    VPN_TARGET_AVX2
+    uint64_t sumAvx2(const uint8_t* data, size_t blocks) {
+        const __m256i lowMask = _mm256_set1_epi32(0xFFFF);
+        uint64_t total = 0;
+
+        while (blocks > 0) {
+            size_t chunk = blocks < SIMD_FLUSH_BLOCKS ? blocks : SIMD_FLUSH_BLOCKS;
+            __m256i accLow = _mm256_setzero_si256();
+            __m256i accHigh = _mm256_setzero_si256();
+            for (size_t i = 0; i < chunk; ++i) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+                accLow = _mm256_add_epi32(accLow, _mm256_and_si256(v, lowMask));
+                accHigh = _mm256_add_epi32(accHigh, _mm256_srli_epi32(v, 16));
+                data += 32;
+            }
+
+            alignas(32) uint32_t lanes[16];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), accLow);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes + 8), accHigh);
+            for (uint32_t lane : lanes) total += lane;
+            blocks -= chunk;
+        }
+        return total;
+    }
+
+#endif // VPN_SIMD_X86
+
+    using SumFn = uint64_t (*)(const uint8_t*, size_t);
+
+    struct Dispatch {
+        SumFn fn;           // nullptr: scalar only
+        size_t blockSize;
+        const char* name;
+    };
+
+    const Dispatch& selectImplementation() {
+        static const Dispatch dispatch = []() -> Dispatch {
+#ifdef VPN_SIMD_X86
+            if (CpuFeatures::supportsAvx2()) {
+                return {sumAvx2, 32, "avx2"};
+            }
+            return {sumSse2, 16, "sse2"};
+#else
+            return {nullptr, 0, "scalar"};
+#endif
+        }();
+        return dispatch;
+    }
+
+} // anonymous namespace
+
+namespace VpnChecksum {
+
+    uint32_t accumulateScalar(const uint8_t* data, size_t length, uint32_t sum) {
+        uint64_t total = sum;
+        size_t i = 0;
+        for (; i + 1 < length; i += 2) {
+            total += readU16(data + i);
+        }
+        if (length & 1) {
+            total += static_cast<uint32_t>(data[length - 1]) << 8;
+        }
+        return fold(total);
+    }
+
+    uint32_t accumulate(const uint8_t* data, size_t length, uint32_t sum) {
+        if (length < SIMD_MIN_LENGTH) {
+            return accumulateScalar(data, length, sum);
+        }
+        const Dispatch& impl = selectImplementation();
+        if (!impl.fn) {
+            return accumulateScalar(data, length, sum);
+        }
+
+        size_t blocks = length / impl.blockSize;
+        size_t bulk = blocks * impl.blockSize;
+        uint32_t bulkSum = swapBytes(fold(impl.fn(data, blocks)));
+
+        // bulk is a multiple of the block size, so the tail starts on a word boundary
+        return accumulateScalar(data + bulk, length - bulk, fold(static_cast<uint64_t>(sum) + bulkSum));
+    }
+
+    uint16_t finish(uint32_t sum) {
+        return static_cast<uint16_t>(~fold(sum));
+    }
+
+    uint16_t compute(const uint8_t* data, size_t length) {
+        return finish(accumulate(data, length));
+    }
+
+    uint32_t pseudoHeaderV4(uint32_t srcIP, uint32_t dstIP, uint8_t protocol, uint16_t length) {
+        uint64_t sum = 0;
+        sum += srcIP >> 16;
+        sum += srcIP & 0xFFFF;
+        sum += dstIP >> 16;
+        sum += dstIP & 0xFFFF;
+        sum += protocol;
+        sum += length;
+        return fold(sum);
+    }
+
+    uint32_t pseudoHeaderV6(const uint8_t* srcIP, const uint8_t* dstIP, uint32_t length, uint8_t nextHeader) {
+        uint32_t sum = accumulateScalar(srcIP, 16);
+        sum = accumulateScalar(dstIP, 16, sum);
+        uint64_t total = sum;
+        total += length >> 16;
+        total += length & 0xFFFF;
+        total += nextHeader;
+        return fold(total);
+    }
+
+    void update16(uint8_t* checksum, uint16_t oldValue, uint16_t newValue) {
+        uint32_t sum = static_cast<uint16_t>(~readU16(checksum));
+        sum += static_cast<uint16_t>(~oldValue);
+        sum += newValue;
+        uint16_t result = static_cast<uint16_t>(~fold(sum));
+        checksum[0] = static_cast<uint8_t>(result >> 8);
+        checksum[1] = static_cast<uint8_t>(result & 0xFF);
+    }
+
+    void update32(uint8_t* checksum, uint32_t oldValue, uint32_t newValue) {
+        update16(checksum, static_cast<uint16_t>(oldValue >> 16), static_cast<uint16_t>(newValue >> 16));
+        update16(checksum, static_cast<uint16_t>(oldValue & 0xFFFF), static_cast<uint16_t>(newValue & 0xFFFF));
+    }
+
+    const char* activeImplementation() {
+        return selectImplementation().name;
+    }
+
+} // namespace VpnChecksum
@@ -0,0 +1,75 @@
+#ifndef VPN_CHECKSUM_H
+#define VPN_CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Internet checksum (RFC 1071) for packet rewriting
+ *
+ * Sums are 32-bit ones'-complement accumulators that can be chained across
+ * buffers and pseudo-headers; finish() folds and inverts the result. Every
+ * buffer except the last one in a chain must have an even length. Large
+ * buffers are summed with SSE2/AVX2 on x86-64, selected once at runtime.
+ */
+namespace VpnChecksum {
+
+    /**
+     * @brief Add a buffer of 16-bit big-endian words to a running sum
+     * @param sum Running sum from previous calls or a pseudo-header
+     * @return Sum folded to 16 bits (not inverted)
+     */
+    uint32_t accumulate(const uint8_t* data, size_t length, uint32_t sum = 0);
+
+    /**
+     * @brief Scalar reference implementation of accumulate
+     */
+    uint32_t accumulateScalar(const uint8_t* data, size_t length, uint32_t sum = 0);
+
+    /**
+     * @brief Fold a running sum and return its ones'-complement, ready to store
+     */
+    uint16_t finish(uint32_t sum);
+
+    /**
+     * @brief Checksum of a single buffer (IPv4 header, ICMP message)
+     */
+    uint16_t compute(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Sum of the IPv4 TCP/UDP pseudo-header
+     * @param srcIP Source address (Host Byte Order)
+     * @param dstIP Destination address (Host Byte Order)
+     * @param length Upper-layer length (header + payload)
+     */
+    uint32_t pseudoHeaderV4(uint32_t srcIP, uint32_t dstIP, uint8_t protocol, uint16_t length);
+
+    /**
+     * @brief Sum of the IPv6 upper-layer pseudo-header (RFC 8200 section 8.1)
+     * @param srcIP 16-byte source address
+     * @param dstIP 16-byte destination address
+     * @param length Upper-layer packet length
+     * @param nextHeader Upper-layer protocol
+     */
+    uint32_t pseudoHeaderV6(const uint8_t* srcIP, const uint8_t* dstIP, uint32_t length, uint8_t nextHeader);
+
+    /**
+     * @brief Incrementally update a stored checksum after a 16-bit field changed
+     * @param checksum Pointer to the checksum field in the packet
+     * @note RFC 1624 eqn. 3: HC' = ~(~HC + ~m + m')
+     */
+    void update16(uint8_t* checksum, uint16_t oldValue, uint16_t newValue);
+
+    /**
+     * @brief Incrementally update a stored checksum after a 32-bit field (e.g. an IPv4 address) changed
+     */
+    void update32(uint8_t* checksum, uint32_t oldValue, uint32_t newValue);
+
+    /**
+     * @brief Name of the bulk implementation selected for this CPU ("avx2", "sse2" or "scalar")
+     */
+    const char* activeImplementation();
+
+} // namespace VpnChecksum
+
+#endif // VPN_CHECKSUM_H
@@ -25,6 +25,31 @@ constexpr size_t VPN_MESSAGE_OVERHEAD = 35;
 // 1200 - 35 - 65 = 1100 (65 bytes safety margin)
 constexpr int RECOMMENDED_MTU = 1100;
 
+// Largest locally generated ICMP error (RFC 1812: at most 576 bytes)
+constexpr size_t ICMP_ERROR_MAX_SIZE = 576;
+
+// IPv6 requires a link MTU of at least 1280 bytes (RFC 8200). Packets between
+// the IPv4 tunnel MTU and this size rely on Steam fragmenting the message.
+constexpr int IPV6_MIN_MTU = 1280;
+constexpr size_t IPV6_HEADER_SIZE = 40;
+constexpr size_t IPV6_ADDR_SIZE = 16;
+
+// Largest locally generated ICMPv6 error (RFC 4443: must not exceed the minimum MTU)
+constexpr size_t ICMPV6_ERROR_MAX_SIZE = 1280;
+
+// Upper bound for IPv6 neighbors learned from one peer's traffic (link-local and
+// temporary addresses seen on the wire); addresses announced in IP_QUERY /
+// IP_RESPONSE do not count against it
+constexpr size_t MAX_IPV6_NEIGHBORS_PER_PEER = 16;
+
+// Direct UDP candidate exchange
+constexpr size_t MAX_UDP_CANDIDATES = 8;
+constexpr uint8_t UDP_CANDIDATES_FLAG_REPLY = 0x01;    // Sender wants our candidates back
+constexpr size_t UDP_DATAGRAM_KEY_SIZE = 32;            // Per-direction datagram key
+
+// LAN discovery: beacon nonces are confirmed over the Steam channel
+constexpr uint8_t LAN_BEACON_FLAG_CONFIRMED = 0x01;     // Nonce matches a beacon we sent
+
 // Node ID Size (SHA-256 = 32 bytes = 256 bits)
 constexpr size_t NODE_ID_SIZE = 32;
 
@@ -32,6 +57,7 @@ constexpr size_t NODE_ID_SIZE = 32;
 // Type Definitions
 // ============================================================================
 using NodeID = std::array<uint8_t, NODE_ID_SIZE>;
+using Ipv6Address = std::array<uint8_t, IPV6_ADDR_SIZE>;
 
 // ============================================================================
 // VPN Message Types
@@ -43,6 +69,13 @@ enum class VpnMessageType : uint8_t {
     // IP Discovery Protocol
     IP_QUERY = 4,               // Query for IP address
     IP_RESPONSE = 5,            // Response with IP address
+
+    // Direct UDP path negotiation (consumed by the transport layer, reliable)
+    UDP_CANDIDATES = 6,         // Direct UDP candidate endpoints and session token
+    LAN_BEACON_ECHO = 7,        // Echo of a LAN beacon nonce, or its confirmation
+
+    // Sampled packet tracing
+    IP_PACKET_TRACED = 8,       // PacketTraceExtension followed by the IP packet
 };
 
 // ============================================================================
@@ -74,6 +107,7 @@ struct VpnPacketWrapper {
 struct IpQueryPayload {
     uint32_t ipAddress;     // Sender's IP Address (Network Byte Order)
     NodeID senderNodeId;    // Sender's Node ID
+    Ipv6Address ipv6Address; // Sender's IPv6 ULA (all zero if none, absent from older peers)
 };
 
 /**
@@ -83,11 +117,63 @@ struct IpQueryPayload {
 struct IpResponsePayload {
     uint32_t ipAddress;     // Local FakeIP (Network Byte Order)
     NodeID nodeId;          // Sender's Node ID
+    Ipv6Address ipv6Address; // Local IPv6 ULA (all zero if none, absent from older peers)
     // SteamID is implicit in the message source
 };
 
+/**
+ * @brief Direct UDP candidate endpoint
+ */
+struct UdpCandidate {
+    uint8_t family;         // 4 or 6
+    uint8_t reserved;
+    uint16_t port;          // Network Byte Order
+    uint8_t address[IPV6_ADDR_SIZE]; // IPv4 uses the first 4 bytes (Network Byte Order)
+};
+
+/**
+ * @brief Direct UDP Candidates Payload
+ * Only the first `count` candidates are sent. The key is only ever sent over
+ * the Steam channel, which is encrypted and authenticated by Steam.
+ */
+struct UdpCandidatesPayload {
+    uint64_t token;         // Token the receiver must put in datagrams sent to us
+    uint8_t flags;          // UDP_CANDIDATES_FLAG_*
+    uint8_t count;          // Number of candidates that follow
+    uint8_t key[UDP_DATAGRAM_KEY_SIZE]; // ChaCha20-Poly1305 key for datagrams sent to us
+    UdpCandidate candidates[MAX_UDP_CANDIDATES];
+};
+
+/**
+ * @brief LAN Beacon Echo Payload
+ * Sent to the Steam ID a beacon claimed to come from; the owner answers with
+ * LAN_BEACON_FLAG_CONFIRMED only if the nonce is one it broadcast and the
+ * endpoint is its own data port, so a beacon replayed from another address
+ * is never confirmed
+ */
+struct LanBeaconEchoPayload {
+    uint64_t nonce;         // Nonce from the beacon
+    uint8_t flags;          // LAN_BEACON_FLAG_*
+    UdpCandidate endpoint;  // Source address the beacon was received from
+};
+
+/**
+ * @brief Packet Trace Extension
+ * Precedes the IP packet in IP_PACKET_TRACED messages (host byte order, all
+ * supported platforms are little-endian). Peers that predate tracing drop
+ * these messages, so sampling is off unless configured.
+ */
+struct PacketTraceExtension {
+    uint64_t traceId;       // Chosen by the sender, unique per sampled packet
+    int64_t sentAtUs;       // Sender's TraceClock (Unix microseconds) when handed to the transport
+};
+
 #pragma pack(pop)
 
+// Payload sizes sent by peers that predate IPv6 support
+constexpr size_t IP_QUERY_PAYLOAD_V4_SIZE = sizeof(IpQueryPayload) - IPV6_ADDR_SIZE;
+constexpr size_t IP_RESPONSE_PAYLOAD_V4_SIZE = sizeof(IpResponsePayload) - IPV6_ADDR_SIZE;
+
 // ============================================================================
 // Node Information
 // ============================================================================
@@ -112,6 +198,7 @@ struct RouteEntry {
     std::string name;           // User Name
     bool isLocal;               // Is Local Node
     NodeID nodeId;              // Node ID
+    Ipv6Address ipv6Address;    // IPv6 ULA (all zero if unknown)
 };
 
 #endif // VPN_PROTOCOL_H
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "vpn_utils.h"
+#include "vpn_checksum.h"
 #include <iostream>
 #include <cstring>
 
@@ -9,6 +10,31 @@
 #include <arpa/inet.h>
 #endif
 
+namespace {
+
+    constexpr uint8_t IP_PROTO_ICMP = 1;
+    constexpr uint8_t IP_PROTO_TCP = 6;
+    constexpr uint16_t IP_FLAG_DF = 0x4000;
+    constexpr uint8_t ICMP_DEST_UNREACH = 3;
+    constexpr uint8_t ICMP_FRAG_NEEDED = 4;
+    constexpr uint8_t IP_PROTO_ICMPV6 = 58;
+    constexpr uint8_t ICMPV6_PACKET_TOO_BIG = 2;
+    constexpr uint8_t TCP_FLAG_SYN = 0x02;
+    constexpr uint8_t TCP_OPT_END = 0;
+    constexpr uint8_t TCP_OPT_NOP = 1;
+    constexpr uint8_t TCP_OPT_MSS = 2;
+
+    uint16_t readU16(const uint8_t* p) {
+        return static_cast<uint16_t>((p[0] << 8) | p[1]);
+    }
+
+    void writeU16(uint8_t* p, uint16_t value) {
+        p[0] = static_cast<uint8_t>(value >> 8);
+        p[1] = static_cast<uint8_t>(value & 0xFF);
+    }
+
+} // anonymous namespace
+
 namespace VpnUtils {
 
     int calculateTunMtu(int steamMtuDataSize) {
@@ -70,4 +96,264 @@ namespace VpnUtils {
         return false;
     }
 
+    uint16_t calculateTcpMss(int mtu) {
+        // IPv4 header (20) + TCP header (20)
+        int mss = mtu - 40;
+        if (mss < 536) mss = 536;
+        return static_cast<uint16_t>(mss);
+    }
+
+    bool clampTcpMss(uint8_t* packet, size_t length, uint16_t maxMss) {
+        size_t ipHeaderLen = 0;
+        uint8_t version = getIpVersion(packet, length);
+        if (version == 4) {
+            if (packet[9] != IP_PROTO_TCP) return false;
+            // Only the first fragment carries the TCP header
+            if ((readU16(packet + 6) & 0x1FFF) != 0) return false;
+            ipHeaderLen = static_cast<size_t>(packet[0] & 0x0F) * 4;
+            if (ipHeaderLen < 20) return false;
+        } else if (version == 6) {
+            // SYNs carry no extension headers in practice
+            if (packet[6] != IP_PROTO_TCP) return false;
+            ipHeaderLen = IPV6_HEADER_SIZE;
+        } else {
+            return false;
+        }
+        if (length < ipHeaderLen + 20) return false;
+
+        uint8_t* tcp = packet + ipHeaderLen;
+        if (!(tcp[13] & TCP_FLAG_SYN)) return false;
+
+        size_t tcpHeaderLen = static_cast<size_t>(tcp[12] >> 4) * 4;
+        if (tcpHeaderLen <= 20 || length < ipHeaderLen + tcpHeaderLen) return false;
+
+        size_t offset = 20;
+        while (offset < tcpHeaderLen) {
+            uint8_t kind = tcp[offset];
+            if (kind == TCP_OPT_END) break;
+            if (kind == TCP_OPT_NOP) {
+                offset++;
+                continue;
+            }
+            if (offset + 1 >= tcpHeaderLen) break;
+            uint8_t optLen = tcp[offset + 1];
+            if (optLen < 2 || offset + optLen > tcpHeaderLen) break;
+
+            if (kind == TCP_OPT_MSS && optLen == 4) {
+                uint8_t* mssField = tcp + offset + 2;
+                uint16_t mss = readU16(mssField);
+                if (mss <= maxMss) return false;
+
+                // The checksum works on 16-bit words of the segment. An MSS value at an
+                // odd offset straddles two words, so patch both of them.
+                size_t fieldOffset = offset + 2;
+                if ((fieldOffset & 1) == 0) {
+                    writeU16(mssField, maxMss);
+                    VpnChecksum::update16(tcp + 16, mss, maxMss);
+                } else {
+                    uint8_t* word0 = tcp + fieldOffset - 1;
+                    uint8_t* word1 = tcp + fieldOffset + 1;
+                    uint16_t old0 = readU16(word0);
+                    uint16_t old1 = readU16(word1);
+                    writeU16(mssField, maxMss);
+                    VpnChecksum::update16(tcp + 16, old0, readU16(word0));
+                    VpnChecksum::update16(tcp + 16, old1, readU16(word1));
+                }
+                return true;
+            }
+            offset += optLen;
+        }
+        return false;
+    }
+
+    bool isIpv4DontFragment(const uint8_t* packet, size_t length) {
+        if (length < 20) return false;
+        uint8_t version = (packet[0] >> 4) & 0x0F;
+        if (version != 4) return false;
+        return (readU16(packet + 6) & IP_FLAG_DF) != 0;
+    }
+
+    size_t buildIcmpFragNeeded(const uint8_t* packet, size_t length, uint16_t mtu,
+                               uint8_t* out, size_t outSize) {
+        if (length < 20) return 0;
+        uint8_t version = (packet[0] >> 4) & 0x0F;
+        if (version != 4) return 0;
+
+        size_t ipHeaderLen = static_cast<size_t>(packet[0] & 0x0F) * 4;
+        if (ipHeaderLen < 20 || length < ipHeaderLen) return 0;
+
+        // Never answer ICMP errors with ICMP errors (RFC 1122 3.2.2)
+        if (packet[9] == IP_PROTO_ICMP) {
+            if (length < ipHeaderLen + 1) return 0;
+            uint8_t icmpType = packet[ipHeaderLen];
+            if (icmpType != 0 && icmpType != 8) return 0;
+        }
+
+        // Only the first fragment gets a reply
+        if ((readU16(packet + 6) & 0x1FFF) != 0) return 0;
+
+        // Quote as much of the original datagram as fits into 576 bytes
+        size_t quoteLen = length;
+        if (quoteLen > ICMP_ERROR_MAX_SIZE - 28) quoteLen = ICMP_ERROR_MAX_SIZE - 28;
+        size_t totalLen = 20 + 8 + quoteLen;
+        if (outSize < totalLen) return 0;
+
+        // IPv4 header: reply appears to come from the original destination
+        uint8_t* ip = out;
+        memset(ip, 0, 20);
+        ip[0] = 0x45;
+        writeU16(ip + 2, static_cast<uint16_t>(totalLen));
+        ip[8] = 64;
+        ip[9] = IP_PROTO_ICMP;
+        memcpy(ip + 12, packet + 16, 4);
+        memcpy(ip + 16, packet + 12, 4);
+        writeU16(ip + 10, VpnChecksum::compute(ip, 20));
+
+        // ICMP header + quoted original datagram
+        uint8_t* icmp = out + 20;
+        icmp[0] = ICMP_DEST_UNREACH;
+        icmp[1] = ICMP_FRAG_NEEDED;
+        writeU16(icmp + 2, 0);
+        writeU16(icmp + 4, 0);
+        writeU16(icmp + 6, mtu);
+        memcpy(icmp + 8, packet, quoteLen);
+        writeU16(icmp + 2, VpnChecksum::compute(icmp, 8 + quoteLen));
+
+        return totalLen;
+    }
+
+    uint8_t getIpVersion(const uint8_t* packet, size_t length) {
+        if (length < 1) return 0;
+        uint8_t version = (packet[0] >> 4) & 0x0F;
+        if (version == 4 && length >= 20) return 4;
+        if (version == 6 && length >= IPV6_HEADER_SIZE) return 6;
+        return 0;
+    }
+
+    bool extractDestIPv6(const uint8_t* packet, size_t length, Ipv6Address& out) {
+        if (getIpVersion(packet, length) != 6) return false;
+        memcpy(out.data(), packet + 24, IPV6_ADDR_SIZE);
+        return true;
+    }
+
+    bool extractSourceIPv6(const uint8_t* packet, size_t length, Ipv6Address& out) {
+        if (getIpVersion(packet, length) != 6) return false;
+        memcpy(out.data(), packet + 8, IPV6_ADDR_SIZE);
+        return true;
+    }
+
+    bool isIpv6Multicast(const Ipv6Address& ip) {
+        return ip[0] == 0xFF;
+    }
+
+    bool isIpv6Unspecified(const Ipv6Address& ip) {
+        for (uint8_t b : ip) {
+            if (b != 0) return false;
+        }
+        return true;
+    }
+
+    bool isIpv6Unicast(const Ipv6Address& ip) {
+        return !isIpv6Multicast(ip) && !isIpv6Unspecified(ip);
+    }
+
+    std::string ipv6ToString(const Ipv6Address& ip) {
+        char buffer[INET6_ADDRSTRLEN];
+        struct in6_addr addr;
+        memcpy(&addr, ip.data(), IPV6_ADDR_SIZE);
+        inet_ntop(AF_INET6, &addr, buffer, INET6_ADDRSTRLEN);
+        return std::string(buffer);
+    }
+
+    bool stringToIpv6(const std::string& ipStr, Ipv6Address& out) {
+        struct in6_addr addr;
+        if (inet_pton(AF_INET6, ipStr.c_str(), &addr) == 1) {
+            memcpy(out.data(), &addr, IPV6_ADDR_SIZE);
+            return true;
+        }
+        return false;
+    }
+
+    Ipv6Address deriveUlaAddress(const std::string& salt, uint64_t nodeKey) {
+        // FNV-1a, good enough to spread salts and Steam IDs over the ID space
+        auto fnv1a = [](uint64_t hash, const uint8_t* data, size_t length) {
+            for (size_t i = 0; i < length; ++i) {
+                hash ^= data[i];
+                hash *= 0x100000001B3ULL;
+            }
+            return hash;
+        };
+        constexpr uint64_t FNV_OFFSET = 0xCBF29CE484222325ULL;
+
+        // fdXX:XXXX:XXXX:0000::/64 - Global ID from the shared salt (RFC 4193)
+        uint64_t globalId = fnv1a(FNV_OFFSET, reinterpret_cast<const uint8_t*>(salt.data()), salt.size());
+
+        uint8_t keyBytes[8];
+        for (int i = 0; i < 8; ++i) {
+            keyBytes[i] = static_cast<uint8_t>(nodeKey >> (56 - i * 8));
+        }
+        uint64_t interfaceId = fnv1a(globalId, keyBytes, sizeof(keyBytes));
+
+        Ipv6Address ip{};
+        ip[0] = 0xFD;
+        for (int i = 0; i < 5; ++i) {
+            ip[1 + i] = static_cast<uint8_t>(globalId >> (32 - i * 8));
+        }
+        for (int i = 0; i < 8; ++i) {
+            ip[8 + i] = static_cast<uint8_t>(interfaceId >> (56 - i * 8));
+        }
+        // Avoid the all-zero Subnet-Router anycast interface ID
+        if (ip[15] == 0) ip[15] = 1;
+        return ip;
+    }
+
+    size_t buildIcmpv6PacketTooBig(const uint8_t* packet, size_t length, uint32_t mtu,
+                                   uint8_t* out, size_t outSize) {
+        if (getIpVersion(packet, length) != 6) return 0;
+
+        Ipv6Address src;
+        Ipv6Address dst;
+        extractSourceIPv6(packet, length, src);
+        extractDestIPv6(packet, length, dst);
+
+        // RFC 4443 2.4: never answer unspecified/multicast sources or ICMPv6 errors.
+        // Multicast is not forwarded through the tunnel, so it gets no reply either.
+        if (!isIpv6Unicast(src) || isIpv6Multicast(dst)) return 0;
+        if (packet[6] == IP_PROTO_ICMPV6) {
+            if (length < IPV6_HEADER_SIZE + 1) return 0;
+            if (packet[IPV6_HEADER_SIZE] < 128) return 0;
+        }
+
+        // Quote as much of the original packet as fits into the IPv6 minimum MTU
+        size_t quoteLen = length;
+        if (quoteLen > ICMPV6_ERROR_MAX_SIZE - IPV6_HEADER_SIZE - 8) {
+            quoteLen = ICMPV6_ERROR_MAX_SIZE - IPV6_HEADER_SIZE - 8;
+        }
+        size_t icmpLen = 8 + quoteLen;
+        size_t totalLen = IPV6_HEADER_SIZE + icmpLen;
+        if (outSize < totalLen) return 0;
+
+        // IPv6 header: reply appears to come from the original destination
+        uint8_t* ip = out;
+        memset(ip, 0, IPV6_HEADER_SIZE);
+        ip[0] = 0x60;
+        writeU16(ip + 4, static_cast<uint16_t>(icmpLen));
+        ip[6] = IP_PROTO_ICMPV6;
+        ip[7] = 64;
+        memcpy(ip + 8, dst.data(), IPV6_ADDR_SIZE);
+        memcpy(ip + 24, src.data(), IPV6_ADDR_SIZE);
+
+        uint8_t* icmp = out + IPV6_HEADER_SIZE;
+        icmp[0] = ICMPV6_PACKET_TOO_BIG;
+        icmp[1] = 0;
+        writeU16(icmp + 2, 0);
+        writeU16(icmp + 4, static_cast<uint16_t>(mtu >> 16));
+        writeU16(icmp + 6, static_cast<uint16_t>(mtu & 0xFFFF));
+        memcpy(icmp + 8, packet, quoteLen);
+        uint32_t pseudo = VpnChecksum::pseudoHeaderV6(ip + 8, ip + 24, static_cast<uint32_t>(icmpLen), IP_PROTO_ICMPV6);
+        writeU16(icmp + 2, VpnChecksum::finish(VpnChecksum::accumulate(icmp, icmpLen, pseudo)));
+
+        return totalLen;
+    }
+
 } // namespace VpnUtils
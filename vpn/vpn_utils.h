@@ -37,11 +37,108 @@ namespace VpnUtils {
      */
     uint32_t extractSourceIP(const uint8_t* packet, size_t length);
 
+    /**
+     * @brief Get IP version of a packet
+     * @return 4 or 6 if the packet holds a complete fixed header, 0 otherwise
+     */
+    uint8_t getIpVersion(const uint8_t* packet, size_t length);
+
+    /**
+     * @brief Extract destination address from an IPv6 packet
+     * @return false if the packet is not IPv6
+     */
+    bool extractDestIPv6(const uint8_t* packet, size_t length, Ipv6Address& out);
+
+    /**
+     * @brief Extract source address from an IPv6 packet
+     * @return false if the packet is not IPv6
+     */
+    bool extractSourceIPv6(const uint8_t* packet, size_t length, Ipv6Address& out);
+
+    /**
+     * @brief Check if IPv6 address is multicast (ff00::/8)
+     */
+    bool isIpv6Multicast(const Ipv6Address& ip);
+
+    /**
+     * @brief Check if IPv6 address is the unspecified address (::)
+     */
+    bool isIpv6Unspecified(const Ipv6Address& ip);
+
+    /**
+     * @brief Check if IPv6 address is a routable unicast address (not multicast, not ::)
+     */
+    bool isIpv6Unicast(const Ipv6Address& ip);
+
+    /**
+     * @brief Convert IPv6 address to string
+     */
+    std::string ipv6ToString(const Ipv6Address& ip);
+
+    /**
+     * @brief Convert string to IPv6 address
+     * @return false if the string is not a valid IPv6 address
+     */
+    bool stringToIpv6(const std::string& ipStr, Ipv6Address& out);
+
+    /**
+     * @brief Derive the node's IPv6 ULA address
+     * @param salt Shared secret, selects the fdXX:XXXX:XXXX::/64 prefix (RFC 4193)
+     * @param nodeKey Per-node key (Steam ID), selects the interface ID
+     */
+    Ipv6Address deriveUlaAddress(const std::string& salt, uint64_t nodeKey);
+
     /**
      * @brief Check if IP is a broadcast address
      */
     bool isBroadcastAddress(uint32_t ip, uint32_t baseIP, uint32_t subnetMask);
 
+    /**
+     * @brief Calculate the largest TCP MSS that fits into the given MTU
+     * @param mtu Tunnel MTU
+     * @return MSS value (MTU - IPv4 header - TCP header), subtract 20 more for IPv6
+     */
+    uint16_t calculateTcpMss(int mtu);
+
+    /**
+     * @brief Clamp the MSS option of a TCP SYN / SYN-ACK packet in place
+     * @param packet IP packet, rewritten in place
+     * @param length Packet length
+     * @param maxMss Largest MSS allowed through the tunnel
+     * @return true if the MSS option was rewritten
+     * @note The TCP checksum is patched incrementally (RFC 1624)
+     */
+    bool clampTcpMss(uint8_t* packet, size_t length, uint16_t maxMss);
+
+    /**
+     * @brief Check if packet is IPv4 with the Don't Fragment bit set
+     */
+    bool isIpv4DontFragment(const uint8_t* packet, size_t length);
+
+    /**
+     * @brief Build an ICMP "fragmentation needed" (type 3 code 4) reply for an oversize packet
+     * @param packet Original IPv4 packet that does not fit the tunnel
+     * @param length Original packet length
+     * @param mtu Next-hop MTU to report to the sender
+     * @param out Output buffer for the ICMP packet (ICMP_ERROR_MAX_SIZE bytes is always enough)
+     * @param outSize Output buffer size
+     * @return Length of the ICMP packet, or 0 if no reply should be generated
+     */
+    size_t buildIcmpFragNeeded(const uint8_t* packet, size_t length, uint16_t mtu,
+                               uint8_t* out, size_t outSize);
+
+    /**
+     * @brief Build an ICMPv6 Packet Too Big (type 2) reply for an oversize packet
+     * @param packet Original IPv6 packet that does not fit the tunnel
+     * @param length Original packet length
+     * @param mtu MTU to report to the sender
+     * @param out Output buffer (ICMPV6_ERROR_MAX_SIZE bytes is always enough)
+     * @param outSize Output buffer size
+     * @return Length of the ICMPv6 packet, or 0 if no reply should be generated
+     */
+    size_t buildIcmpv6PacketTooBig(const uint8_t* packet, size_t length, uint32_t mtu,
+                                   uint8_t* out, size_t outSize);
+
 } // namespace VpnUtils
 
 #endif // VPN_UTILS_H